@@ -6,25 +6,60 @@
  * 
  * Features:
  * - Secure HTTPS communication
+ * - One keep-alive connection shared by all endpoints, TLS session resumption
+ * - Reconnect with exponential backoff
  * - JSON data formatting
  * - API key authentication
  * - Command reception and processing
- * - Alert transmission
+ * - Alert transmission; command results carry the command id as the
+ *   station's acknowledgement
  * - Error handling and retry logic
- * - Rate limiting
- * - Data compression
+ * - Token-bucket rate limiting per request class; alerts are never held
+ *   back, throttled telemetry is handed back to be merged into the next batch
+ * - gzip compression (DeflateWriter) of telemetry batches and bulk uploads
+ *   from API_COMPRESS_MIN_BYTES (JSON, text) or API_COMPRESS_MIN_BINARY_BYTES
+ *   (MessagePack); off for good once the dashboard refuses it
+ * - Request bodies live in a fixed arena and endpoints in the queue slot;
+ *   JSON documents are serialized straight into the arena (no String copy,
+ *   no heap allocation when a request is queued)
+ * - URLs are formatted into a fixed buffer and response bodies streamed into
+ *   one of API_RESPONSE_MAX_BYTES, then copied into the response once on the
+ *   network task; a longer body is counted and reported as an error, with no
+ *   data, rather than handed on cut
+ * - Network task with a bounded priority queue: alerts, then command
+ *   polls, then telemetry, then bulk uploads; lowest class and oldest
+ *   dropped first when full,
+ *   alerts never dropped (failed alerts are retried, then handed to the
+ *   undelivered-alert handler, e.g. the SD spool)
+ * - Retry-After on a 429 or 503 holds the request's class for that long;
+ *   alerts retry after it, and are handed off once out of retries
  * 
  * API Endpoints:
- * - POST /api/data - Send sensor data and ML predictions
+ * - POST /api/data - Send sensor data and ML predictions (JSON or MessagePack);
+ *   the response carries any queued commands
  * - GET /api/commands - Receive remote commands
  * - POST /api/alerts - Send threat alerts
  * - GET /api/status - Check system status
+ * - GET <url> - Download a model file (UPDATE_MODEL command), streamed
  * 
  * Usage:
  * 1. Initialize with APIManager::init()
  * 2. Send data with APIManager::sendData()
  * 3. Get commands with APIManager::getCommand()
  * 4. Send alerts with APIManager::sendAlert()
+ * 5. Check connection reuse with APIManager::getConnectionStats()
+ * 
+ * Asynchronous Usage (loop() never waits for the network):
+ * 1. Start the network task with APIManager::begin()
+ * 2. Queue requests with sendDataAsync(), getCommandAsync(), sendAlertAsync()
+ *    or downloadAsync(); each returns at once (resendAlertAsync() replays a
+ *    stored alert body, sendBulkAsync() uploads backlog at the lowest priority).
+ *    sendDataAsync() and sendBulkAsync() also take a JsonDocument, which is
+ *    serialized into the queue, so the caller can reuse a static document
+ * 3. Call APIManager::poll() from loop(); completion callbacks run there
+ * 4. Check the queue with APIManager::getQueueStats(), the rate limiter
+ *    with APIManager::getRateStats() and compression with getCompressionStats()
+ * Once the task runs, only the network task may use the synchronous calls.
  */
 
 #ifndef API_MANAGER_H
@@ -32,8 +67,9 @@
 
 #include "EV_Secure_Config.h"
 #include <HTTPClient.h>
-#include <WiFiClientSecure.h>
 #include <ArduinoJson.h>
+#include "ResumableTLSClient.h"
+#include "DeflateWriter.h"
 
 // API endpoints
 #define API_DATA_ENDPOINT "/api/data"
@@ -48,13 +84,46 @@
 #define HTTP_UNAUTHORIZED 401
 #define HTTP_FORBIDDEN 403
 #define HTTP_NOT_FOUND 404
+#define HTTP_UNSUPPORTED_MEDIA_TYPE 415
+#define HTTP_TOO_MANY_REQUESTS 429     // Also reported for requests the rate limiter held back
 #define HTTP_INTERNAL_ERROR 500
+#define HTTP_SERVICE_UNAVAILABLE 503
 
-// Rate limiting
-#define MAX_REQUESTS_PER_MINUTE 10
+// Rate limiting: one token bucket per request class (tokens per minute, burst).
+// Telemetry and bulk together stay within 10 uploads per minute.
+#define API_RATE_ALERT 20              // Alerts always go; an empty bucket borrows from a lower class
+#define API_BURST_ALERT 10
+#define API_RATE_COMMAND 6             // Command polls (downloads are not limited)
+#define API_BURST_COMMAND 2
+#define API_RATE_TELEMETRY 4           // Live batches (1/min) plus threat flushes and retries
+#define API_BURST_TELEMETRY 3
+#define API_RATE_BULK 6                // Spooled backlog and log uploads
+#define API_BURST_BULK 2
 #define REQUEST_TIMEOUT_MS 10000
+#define API_URL_MAX_LEN 192          // Server URL plus endpoint and query
+#define API_RESPONSE_MAX_BYTES 2048  // Response body kept; the rest is read and discarded
 #define RETRY_ATTEMPTS 3
 #define RETRY_DELAY_MS 1000
+#define API_RETRY_AFTER_MAX_MS 300000  // Longest Retry-After honoured (seconds form only)
+
+// Connection reuse
+#define API_BACKOFF_MIN_MS 1000      // First reconnect delay after a failed connect
+#define API_BACKOFF_MAX_MS 60000     // Delay cap (doubles per failure, plus up to 25% jitter)
+
+// Network task and request queue
+#define API_TASK_CORE 0              // Arduino loop() runs on core 1
+#define API_TASK_PRIORITY 1          // Blocks on sockets most of the time
+#define API_TASK_STACK 8192          // mbedTLS handshake needs about 6 KB
+#define API_TASK_IDLE_MS 1000        // Wake-up interval while a retry is pending
+#define API_QUEUE_SLOTS 8            // Queued, in flight or awaiting poll()
+#define API_QUEUE_ALERT_RESERVE 2    // Slots only alerts may take
+#define API_QUEUE_MAX_BYTES 16384    // Body arena: request bodies held by the queue
+#define API_JSON_ALERT_BYTES 512     // Alert document (fixed capacity, on the stack)
+#define API_JSON_COMMAND_BYTES 512   // Parsed command document
+#define API_COMPRESS_MIN_BYTES 1024  // JSON and text telemetry and bulk bodies from this size are sent gzip-compressed
+#define API_COMPRESS_MIN_BINARY_BYTES 256  // Same for MessagePack and other binary bodies
+#define API_COMPRESS_REJECTIONS 3    // 400/500s to gzip bodies, answered 2xx as is, before compression goes off
+#define API_COMPRESS_BUFFER 8192     // Compressed body; one that does not fit or shrink is sent as is
 
 // Command types
 enum CommandType {
@@ -70,8 +139,113 @@ enum CommandType {
 struct APIResponse {
   bool success;
   int statusCode;
-  String data;
-  String error;
+  String data;                  // Body (empty when it was over API_RESPONSE_MAX_BYTES)
+  String error;                 // Set on failure, or with success when the body was over the limit
+  unsigned long retryAfterMs;   // Retry-After of a 429 or 503 (0: none)
+};
+
+// Queued request classes, served in this order
+enum APIRequestClass {
+  API_CLASS_ALERT,            // Never dropped
+  API_CLASS_COMMAND,          // Command polls (dropped after telemetry) and downloads (never dropped)
+  API_CLASS_TELEMETRY,        // Dropped before commands; throttled batches are handed back
+  API_CLASS_BULK,             // Backlog; dropped first, waits for a token in the queue
+  API_CLASS_COUNT
+};
+
+// Completion callback (runs in poll()) and download body handler (runs on the network task)
+typedef void (*APICallback)(const APIResponse& response, void* context);
+typedef bool (*APIStreamHandler)(Stream& body, int length, void* context);
+
+// Alert body that could not be delivered (runs in poll() or in sendAlertAsync())
+typedef void (*APIUndeliveredHandler)(const uint8_t* body, size_t length);
+
+// Request queue statistics
+struct APIQueueStats {
+  uint32_t depth;             // Requests waiting (including alerts waiting to retry)
+  uint32_t max_depth;
+  uint32_t queued_bytes;      // Request bodies held by the queue
+  uint32_t enqueued;
+  uint32_t completed;         // Finished (successful or not)
+  uint32_t failed;
+  uint32_t retries;           // Failed alerts queued again
+  uint32_t dropped;           // Evicted by newer requests (telemetry first)
+  uint32_t rejected;          // Refused: no slot or no room in the body arena
+  uint32_t avg_wait_ms;       // Enqueue to start
+  uint32_t avg_flight_ms;     // Start to response
+  uint32_t max_flight_ms;
+  uint32_t largest_free;      // Longest free range of the body arena now
+  uint32_t fragmented;        // Bodies that fit in the free bytes but in no single range
+};
+
+// Token bucket of one request class
+struct APIRateBucket {
+  uint32_t rate_per_min;
+  uint32_t burst;
+  uint32_t milli_tokens;      // Tokens x 1000
+  unsigned long refilled;     // millis() the tokens are counted up to
+  unsigned long held_until;   // Retry-After from the server (0: not held)
+};
+
+// Rate limiter statistics of one request class
+struct APIRateStats {
+  uint32_t admitted;
+  uint32_t deferred;          // Held back: telemetry merged into the next batch, others waited in the queue
+  uint32_t bypassed;          // Alerts sent with their own bucket empty
+  uint32_t tokens;            // Whole tokens available now
+};
+
+// Body compression statistics (network task)
+struct APICompressionStats {
+  uint32_t compressed;        // Bodies sent gzip-compressed
+  uint32_t skipped;           // Large enough, but sent as is (did not shrink or fit)
+  uint32_t raw_bytes;         // Size of the compressed bodies before compression
+  uint32_t sent_bytes;        // ... and as sent
+  uint32_t cycles_per_kb;     // Compression time per KB of input, skipped bodies included
+  bool enabled;
+};
+
+// Request queue slot
+struct APIQueueSlot {
+  uint8_t state;              // API_SLOT_*
+  uint8_t cls;                // APIRequestClass
+  uint8_t attempts;
+  bool handOff;               // Alert goes to the undelivered handler if it finally fails
+  uint32_t seq;
+  char endpoint[API_URL_MAX_LEN];  // Path, or the full URL of a download
+  const char* method;
+  const char* contentType;
+  uint8_t* body;              // Copy in the body arena, owned by the slot
+  size_t length;
+  APIStreamHandler handler;   // Downloads only
+  APICallback callback;
+  void* context;
+  unsigned long enqueued;
+  unsigned long started;
+  unsigned long notBefore;    // Retry time
+  APIResponse response;
+};
+
+// Callback of a request evicted from the queue, delivered by poll()
+struct APIDroppedRequest {
+  APICallback callback;
+  void* context;
+};
+
+// Connection statistics
+struct ConnectionStats {
+  uint32_t requests;          // Requests that reached the server or failed in flight
+  uint32_t failures;          // Requests without an HTTP response
+  uint32_t reused;            // Requests sent on an already open connection
+  uint32_t connects;          // Connection attempts
+  uint32_t handshakes;        // Completed TLS handshakes
+  uint32_t resumed;           // Handshakes that resumed the saved session
+  uint32_t avg_rtt_ms;        // Mean request time, send to end of body
+  uint32_t avg_handshake_ms;
+  uint32_t min_free_heap;     // Lowest free heap since boot
+  uint32_t max_alloc_heap;    // Largest free heap block (well below free heap: fragmented)
+  uint32_t backoff_ms;        // Current reconnect delay (0 while healthy)
+  uint32_t cut_responses;     // Response bodies longer than API_RESPONSE_MAX_BYTES
 };
 
 // Command structure
@@ -82,18 +256,95 @@ struct Command {
   bool processed;
 };
 
+// serializeJson() target writing into a request body in the queue arena
+class APIBodyWriter : public Print {
+public:
+  APIBodyWriter(uint8_t* buffer, size_t size) : _buffer(buffer), _size(size), _length(0) {}
+  
+  using Print::write;
+  size_t write(uint8_t c) override {
+    return write(&c, 1);
+  }
+  size_t write(const uint8_t* data, size_t size) override {
+    size = min(size, _size - _length);
+    memcpy(_buffer + _length, data, size);
+    _length += size;
+    return size;
+  }
+  size_t length() const {
+    return _length;
+  }
+  
+private:
+  uint8_t* _buffer;
+  size_t _size;
+  size_t _length;
+};
+
+// Response body sink for HTTPClient::writeToStream(): keeps the first
+// API_RESPONSE_MAX_BYTES and takes the rest without storing it, so the body is
+// always read to its end and the connection stays usable
+class APIResponseBuffer : public Stream {
+public:
+  APIResponseBuffer(char* buffer, size_t size) : _buffer(buffer), _size(size), _length(0), _cut(false) {
+    _buffer[0] = 0;
+  }
+  
+  using Print::write;
+  size_t write(uint8_t c) override {
+    return write(&c, 1);
+  }
+  size_t write(const uint8_t* data, size_t size) override {
+    size_t kept = min(size, _size - 1 - _length);
+    memcpy(_buffer + _length, data, kept);
+    _length += kept;
+    _buffer[_length] = 0;
+    _cut = _cut || kept < size;
+    return size;
+  }
+  int available() override {
+    return 0;
+  }
+  int read() override {
+    return -1;
+  }
+  int peek() override {
+    return -1;
+  }
+  size_t length() const {
+    return _length;
+  }
+  bool cut() const {
+    return _cut;
+  }
+  
+private:
+  char* _buffer;
+  size_t _size;
+  size_t _length;
+  bool _cut;
+};
+
 class APIManager {
 public:
   static bool init();
   static bool sendData(const String& jsonData);
+  static bool sendData(const uint8_t* data, size_t length, const char* contentType);
   static String getCommand();
   static bool sendAlert(const String& alertType, const String& details);
   static bool checkConnection();
   static APIResponse makeRequest(const String& endpoint, const String& method, const String& data);
+  static APIResponse makeRequest(const char* endpoint, const char* method, const uint8_t* data, size_t length,
+                                 const char* contentType, const char* contentEncoding = nullptr);
+  static Stream* beginDownload(const char* endpoint, int* contentLength);
+  static void endDownload();
   static void setAPIKey(const String& apiKey);
   static void setServerURL(const String& serverURL);
   static void enableSSL(bool enable);
-  static void setRateLimit(int requestsPerMinute);
+  static void setRateLimit(APIRequestClass cls, uint32_t perMinute, uint32_t burst);
+  static unsigned long getRateWait(APIRequestClass cls);
+  static void enableCompression(bool enable);
+  static size_t compressMinBytes(const char* contentType);
   
   // Command processing
   static Command parseCommand(const String& commandJson);
@@ -104,44 +355,181 @@ public:
   static bool isConnected();
   static int getRequestCount();
   static String getLastError();
+  static int getLastStatusCode();
   static void resetErrorCount();
+  static ConnectionStats getConnectionStats();
+  static void resetConnectionStats();
+  static void printConnectionStats();
+  static APIRateStats getRateStats(APIRequestClass cls);
+  static APICompressionStats getCompressionStats();
+  
+  // Asynchronous requests (network task)
+  static bool begin();
+  static bool sendDataAsync(const uint8_t* data, size_t length, const char* contentType,
+                            APICallback callback, void* context);
+  static bool sendDataAsync(const JsonDocument& doc, APICallback callback, void* context);
+  static bool getCommandAsync(APICallback callback, void* context);
+  static bool sendAlertAsync(const String& alertType, const String& details,
+                             APICallback callback = nullptr, void* context = nullptr);
+  static bool sendCommandResultAsync(const String& commandId, bool executed, const String& details,
+                                     APICallback callback = nullptr, void* context = nullptr);
+  static bool sendBulkAsync(const uint8_t* data, size_t length, const char* contentType,
+                            APICallback callback, void* context);
+  static bool sendBulkAsync(const JsonDocument& doc, APICallback callback, void* context);
+  static bool resendAlertAsync(const uint8_t* json, size_t length, APICallback callback, void* context);
+  static bool downloadAsync(const String& endpoint, APIStreamHandler handler,
+                            APICallback callback, void* context);
+  static void setUndeliveredAlertHandler(APIUndeliveredHandler handler);
+  static void poll();
+  static APIQueueStats getQueueStats();
+  static void resetQueueStats();
   
 private:
   static bool _initialized;
   static String _apiKey;
   static String _serverURL;
   static bool _sslEnabled;
-  static int _requestCount;
-  static unsigned long _lastRequestTime;
-  static unsigned long _requestWindowStart;
   static String _lastError;
-  static WiFiClientSecure _secureClient;
+  static int _lastStatusCode;
+  static ResumableTLSClient _secureClient;
+  static WiFiClient _plainClient;
   static HTTPClient _httpClient;
+  static char _responseBody[API_RESPONSE_MAX_BYTES + 1];
+  
+  // Connection manager
+  static String _serverHost;
+  static uint16_t _serverPort;
+  static unsigned long _backoffMs;
+  static unsigned long _nextConnectMillis;
+  static ConnectionStats _connStats;
+  static uint32_t _rttTotalMs;
+  static uint32_t _handshakeBase;
+  static uint32_t _resumedBase;
+  static uint32_t _handshakeMillisBase;
+  static volatile bool _connectionOpen;
+  
+  // Network task and request queue
+  static TaskHandle_t _task;
+  static portMUX_TYPE _queueMux;
+  static APIQueueSlot _slots[API_QUEUE_SLOTS];
+  static uint8_t _arena[API_QUEUE_MAX_BYTES];
+  static APIDroppedRequest _dropped[API_QUEUE_SLOTS];
+  static int _droppedCount;
+  static uint32_t _nextSeq;
+  static APIQueueStats _queueStats;
+  static uint32_t _waitTotalMs;
+  static uint32_t _flightTotalMs;
+  static APIUndeliveredHandler _undeliveredHandler;
+  
+  // Rate limiter
+  static portMUX_TYPE _rateMux;
+  static APIRateBucket _buckets[API_CLASS_COUNT];
+  static APIRateStats _rateStats[API_CLASS_COUNT];
+  
+  // Body compression (network task)
+  static bool _compression;
+  static bool _compressionAccepted;
+  static int _compressionRejections;
+  static uint8_t _compressed[API_COMPRESS_BUFFER];
+  static APICompressionStats _compressStats;
+  static uint64_t _compressCycles;
+  static uint64_t _compressInput;
   
   // Helper methods
-  static String _buildURL(const String& endpoint);
+  static bool _formatURL(char* url, size_t size, const char* endpoint);
+  static void _setClientHeaders();
+  static bool _parseServerURL();
+  static WiFiClient& _client();
+  static bool _ensureConnection(String& error);
+  static void _scheduleReconnect();
   static String _buildHeaders();
-  static bool _checkRateLimit();
-  static void _updateRateLimit();
-  static String _formatSensorData(const SensorData& sensorData);
-  static String _formatMLPrediction(const MLPrediction& mlResult);
-  static String _formatSystemState(SystemState state);
+  static bool _admit(APIRequestClass cls);
+  static void _refill(APIRateBucket& bucket);
+  static unsigned long _heldFor(APIRateBucket& bucket);
+  static void _holdClass(APIRequestClass cls, unsigned long ms);
+  static size_t _formatSensorData(const SensorData& sensorData, char* out, size_t size);
+  static size_t _formatMLPrediction(const MLPrediction& mlResult, char* out, size_t size);
+  static size_t _formatSystemState(SystemState state, char* out, size_t size);
   static CommandType _parseCommandType(const String& type);
+  static void _formatAlert(JsonDocument& doc, const String& alertType, const String& details);
+  static bool _enqueueAlert(const JsonDocument& doc, APICallback callback, void* context);
   static void _logError(const String& error);
-  static bool _retryRequest(const String& endpoint, const String& method, const String& data, APIResponse& response);
+  
+  // Queue helpers
+  static bool _enqueue(APIRequestClass cls, const char* endpoint, const char* method, const uint8_t* data,
+                       size_t length, const char* contentType, APIStreamHandler handler,
+                       APICallback callback, void* context, bool handOff = false);
+  static bool _enqueueJson(APIRequestClass cls, const char* endpoint, const JsonDocument& doc,
+                           APICallback callback, void* context, bool handOff = false);
+  static int _openSlot(APIRequestClass cls, const char* endpoint, size_t length);
+  static void _submitSlot(int index, APIRequestClass cls, const char* endpoint, const char* method,
+                          const char* contentType, APIStreamHandler handler, APICallback callback,
+                          void* context, bool handOff);
+  static int _reserveSlot(APIRequestClass cls, size_t length);
+  static int _arenaFit(size_t length, uint32_t* largest);
+  static int _nextRequest();
+  static void _execute(APIQueueSlot& slot);
+  static size_t _compressBody(const APIQueueSlot& slot);
+  static void _finish(APIQueueSlot& slot);
+  static bool _retryable(int status);
+  static void _taskLoop(void* param);
 };
 
+// Queue slot states
+#define API_SLOT_FREE 0
+#define API_SLOT_RESERVED 1          // Being filled by the enqueuing task
+#define API_SLOT_QUEUED 2
+#define API_SLOT_IN_FLIGHT 3
+#define API_SLOT_DONE 4              // Waiting for poll()
+#define API_SLOT_DELIVERING 5        // Callback running in poll()
+
 // Implementation
 bool APIManager::_initialized = false;
 String APIManager::_apiKey = API_KEY;
 String APIManager::_serverURL = DASHBOARD_URL;
 bool APIManager::_sslEnabled = SSL_ENABLED;
-int APIManager::_requestCount = 0;
-unsigned long APIManager::_lastRequestTime = 0;
-unsigned long APIManager::_requestWindowStart = 0;
 String APIManager::_lastError = "";
-WiFiClientSecure APIManager::_secureClient;
+int APIManager::_lastStatusCode = 0;
+ResumableTLSClient APIManager::_secureClient;
+WiFiClient APIManager::_plainClient;
 HTTPClient APIManager::_httpClient;
+char APIManager::_responseBody[API_RESPONSE_MAX_BYTES + 1];
+String APIManager::_serverHost = "";
+uint16_t APIManager::_serverPort = 443;
+unsigned long APIManager::_backoffMs = 0;
+unsigned long APIManager::_nextConnectMillis = 0;
+ConnectionStats APIManager::_connStats = {};
+uint32_t APIManager::_rttTotalMs = 0;
+uint32_t APIManager::_handshakeBase = 0;
+uint32_t APIManager::_resumedBase = 0;
+uint32_t APIManager::_handshakeMillisBase = 0;
+volatile bool APIManager::_connectionOpen = false;
+TaskHandle_t APIManager::_task = nullptr;
+portMUX_TYPE APIManager::_queueMux = portMUX_INITIALIZER_UNLOCKED;
+APIQueueSlot APIManager::_slots[API_QUEUE_SLOTS];
+uint8_t APIManager::_arena[API_QUEUE_MAX_BYTES];
+APIDroppedRequest APIManager::_dropped[API_QUEUE_SLOTS];
+int APIManager::_droppedCount = 0;
+uint32_t APIManager::_nextSeq = 0;
+APIQueueStats APIManager::_queueStats = {};
+uint32_t APIManager::_waitTotalMs = 0;
+uint32_t APIManager::_flightTotalMs = 0;
+APIUndeliveredHandler APIManager::_undeliveredHandler = nullptr;
+portMUX_TYPE APIManager::_rateMux = portMUX_INITIALIZER_UNLOCKED;
+APIRateBucket APIManager::_buckets[API_CLASS_COUNT] = {
+  {API_RATE_ALERT, API_BURST_ALERT, API_BURST_ALERT * 1000, 0, 0},
+  {API_RATE_COMMAND, API_BURST_COMMAND, API_BURST_COMMAND * 1000, 0, 0},
+  {API_RATE_TELEMETRY, API_BURST_TELEMETRY, API_BURST_TELEMETRY * 1000, 0, 0},
+  {API_RATE_BULK, API_BURST_BULK, API_BURST_BULK * 1000, 0, 0}
+};
+APIRateStats APIManager::_rateStats[API_CLASS_COUNT] = {};
+bool APIManager::_compression = true;
+bool APIManager::_compressionAccepted = false;
+int APIManager::_compressionRejections = 0;
+uint8_t APIManager::_compressed[API_COMPRESS_BUFFER];
+APICompressionStats APIManager::_compressStats = {};
+uint64_t APIManager::_compressCycles = 0;
+uint64_t APIManager::_compressInput = 0;
 
 bool APIManager::init() {
   if (_initialized) {
@@ -150,45 +538,52 @@ bool APIManager::init() {
   
   Serial.println("Initializing API Manager...");
   
+  if (!_parseServerURL()) {
+    Serial.println("Invalid server URL: " + _serverURL);
+    return false;
+  }
+  
   // Configure SSL if enabled
   if (_sslEnabled) {
     _secureClient.setInsecure(); // For development - use proper certificates in production
-    _httpClient.begin(_secureClient, _buildURL(""));
-  } else {
-    _httpClient.begin(_buildURL(""));
   }
   
-  // Set timeout
+  // Keep the connection open between requests; set timeout
+  _httpClient.setReuse(true);
   _httpClient.setTimeout(REQUEST_TIMEOUT_MS);
   
-  // Test connection
+  // Test connection (this also opens the connection later requests reuse)
+  _initialized = true;
   if (!checkConnection()) {
-    Serial.println("API connection test failed");
+    Serial.println("API connection test failed: " + _lastError);
+    _initialized = false;
     return false;
   }
   
-  _initialized = true;
   Serial.println("API Manager initialized successfully");
   return true;
 }
 
 bool APIManager::sendData(const String& jsonData) {
+  return sendData((const uint8_t*)jsonData.c_str(), jsonData.length(), "application/json");
+}
+
+bool APIManager::sendData(const uint8_t* data, size_t length, const char* contentType) {
   if (!_initialized) {
     return false;
   }
   
   // Check rate limit
-  if (!_checkRateLimit()) {
+  if (!_admit(API_CLASS_TELEMETRY)) {
     _logError("Rate limit exceeded");
     return false;
   }
   
   // Make request
-  APIResponse response = makeRequest(API_DATA_ENDPOINT, "POST", jsonData);
+  APIResponse response = makeRequest(API_DATA_ENDPOINT, "POST", data, length, contentType);
   
   if (response.success) {
     Serial.println("Data sent successfully");
-    _updateRateLimit();
     return true;
   } else {
     _logError("Failed to send data: " + response.error);
@@ -202,7 +597,7 @@ String APIManager::getCommand() {
   }
   
   // Check rate limit
-  if (!_checkRateLimit()) {
+  if (!_admit(API_CLASS_COMMAND)) {
     return "";
   }
   
@@ -210,7 +605,6 @@ String APIManager::getCommand() {
   APIResponse response = makeRequest(API_COMMANDS_ENDPOINT, "GET", "");
   
   if (response.success && response.data.length() > 0) {
-    _updateRateLimit();
     return response.data;
   }
   
@@ -222,19 +616,13 @@ bool APIManager::sendAlert(const String& alertType, const String& details) {
     return false;
   }
   
-  // Create alert JSON
-  DynamicJsonDocument doc(512);
-  doc["device_id"] = DEVICE_ID;
-  doc["alert_type"] = alertType;
-  doc["details"] = details;
-  doc["timestamp"] = millis();
-  doc["severity"] = "high";
-  
-  String jsonString;
-  serializeJson(doc, jsonString);
-  
-  // Make request
-  APIResponse response = makeRequest(API_ALERTS_ENDPOINT, "POST", jsonString);
+  // Always admitted; counted against the alert bucket
+  _admit(API_CLASS_ALERT);
+  StaticJsonDocument<API_JSON_ALERT_BYTES> doc;
+  _formatAlert(doc, alertType, details);
+  char json[API_JSON_ALERT_BYTES];
+  size_t length = serializeJson(doc, json, sizeof(json));
+  APIResponse response = makeRequest(API_ALERTS_ENDPOINT, "POST", (const uint8_t*)json, length, "application/json");
   
   if (response.success) {
     Serial.println("Alert sent successfully");
@@ -251,66 +639,169 @@ bool APIManager::checkConnection() {
   }
   
   APIResponse response = makeRequest(API_STATUS_ENDPOINT, "GET", "");
+  if (!response.success) {
+    _logError(response.error);
+  }
   return response.success;
 }
 
 APIResponse APIManager::makeRequest(const String& endpoint, const String& method, const String& data) {
+  return makeRequest(endpoint.c_str(), method.c_str(), (const uint8_t*)data.c_str(), data.length(),
+                     "application/json");
+}
+
+APIResponse APIManager::makeRequest(const char* endpoint, const char* method, const uint8_t* data, size_t length,
+                                    const char* contentType, const char* contentEncoding) {
   APIResponse response;
   response.success = false;
   response.statusCode = 0;
   response.data = "";
   response.error = "";
+  response.retryAfterMs = 0;
+  _lastStatusCode = 0;
   
   if (!_initialized) {
     response.error = "API Manager not initialized";
     return response;
   }
   
-  // Build URL
-  String url = _buildURL(endpoint);
-  
-  // Configure HTTP client
-  if (_sslEnabled) {
-    _httpClient.begin(_secureClient, url);
-  } else {
-    _httpClient.begin(url);
+  char url[API_URL_MAX_LEN];
+  if (!_formatURL(url, sizeof(url), endpoint)) {
+    response.error = "URL too long";
+    return response;
   }
+  _setClientHeaders();
   
-  // Set headers
-  _httpClient.addHeader("Content-Type", "application/json");
-  _httpClient.addHeader("Authorization", "Bearer " + _apiKey);
-  _httpClient.addHeader("User-Agent", "EV-Secure-ESP32/" + String(DEVICE_VERSION));
-  
-  // Make request
+  // A keep-alive connection the server closed while idle fails before anything
+  // is sent; that request is retried once on a fresh (resumed) connection
   int httpCode = 0;
-  if (method == "GET") {
-    httpCode = _httpClient.GET();
-  } else if (method == "POST") {
-    httpCode = _httpClient.POST(data);
-  } else if (method == "PUT") {
-    httpCode = _httpClient.PUT(data);
-  } else if (method == "DELETE") {
-    httpCode = _httpClient.sendRequest("DELETE");
+  unsigned long start = millis();
+  for (int attempt = 0; attempt < 2; attempt++) {
+    String error;
+    bool reused = _client().connected();
+    if (!_ensureConnection(error)) {
+      response.error = error;
+      return response;
+    }
+    
+    // Configure HTTP client on the open connection
+    _httpClient.begin(_client(), url);
+    
+    // Set headers
+    _httpClient.addHeader("Content-Type", contentType);
+    if (contentEncoding) {
+      _httpClient.addHeader("Content-Encoding", contentEncoding);
+    }
+    
+    // Make request
+    if (strcmp(method, "GET") == 0) {
+      httpCode = _httpClient.GET();
+    } else if (strcmp(method, "POST") == 0) {
+      httpCode = _httpClient.POST((uint8_t*)data, length);
+    } else if (strcmp(method, "PUT") == 0) {
+      httpCode = _httpClient.PUT((uint8_t*)data, length);
+    } else if (strcmp(method, "DELETE") == 0) {
+      httpCode = _httpClient.sendRequest("DELETE");
+    }
+    
+    if (!(reused && httpCode == HTTPC_ERROR_SEND_HEADER_FAILED)) {
+      break;
+    }
+    _httpClient.end();
+    _client().stop();
   }
   
   response.statusCode = httpCode;
+  _lastStatusCode = httpCode;
   
   if (httpCode > 0) {
-    response.data = _httpClient.getString();
+    // Streamed into the fixed buffer; the String is made once at its final size.
+    // A cut body is not handed on: JSON parsed from it would be incomplete
+    APIResponseBuffer body(_responseBody, sizeof(_responseBody));
+    if (_httpClient.getSize() != 0) {
+      _httpClient.writeToStream(&body);
+    }
+    if (body.cut()) {
+      _connStats.cut_responses++;
+    } else {
+      response.data = _responseBody;
+    }
     
     if (httpCode >= 200 && httpCode < 300) {
+      // The request itself went through; sending it again would duplicate it
       response.success = true;
+      if (body.cut()) {
+        response.error = "Response body over " + String(API_RESPONSE_MAX_BYTES) + " bytes - dropped";
+      }
     } else {
-      response.error = "HTTP " + String(httpCode) + ": " + response.data;
+      response.error = "HTTP " + String(httpCode) + ": " + String(_responseBody);
+    }
+    
+    // Seconds only; the HTTP-date form needs a wall clock the station may not have
+    if (httpCode == HTTP_TOO_MANY_REQUESTS || httpCode == HTTP_SERVICE_UNAVAILABLE) {
+      String retryAfter = _httpClient.header("Retry-After");
+      if (retryAfter.length() > 0 && retryAfter[0] >= '0' && retryAfter[0] <= '9') {
+        response.retryAfterMs = min(retryAfter.toInt() * 1000UL, (unsigned long)API_RETRY_AFTER_MAX_MS);
+      }
     }
   } else {
     response.error = "Connection failed: " + String(_httpClient.errorToString(httpCode));
   }
   
+  // end() leaves the socket open unless the server answered "Connection: close"
   _httpClient.end();
+  _connStats.requests++;
+  _rttTotalMs += millis() - start;
+  if (httpCode <= 0) {
+    _connStats.failures++;
+    _client().stop();
+  }
+  _connectionOpen = _client().connected();
   return response;
 }
 
+Stream* APIManager::beginDownload(const char* endpoint, int* contentLength) {
+  // Body is read straight from the socket (model files do not fit in a String)
+  if (!_initialized) {
+    return nullptr;
+  }
+  
+  String error;
+  if (!_ensureConnection(error)) {
+    _logError("Download failed: " + error);
+    return nullptr;
+  }
+  
+  char url[API_URL_MAX_LEN];
+  if (!_formatURL(url, sizeof(url), endpoint)) {
+    _logError("Download failed: URL too long");
+    return nullptr;
+  }
+  _setClientHeaders();
+  _httpClient.begin(_client(), url);
+  
+  int httpCode = _httpClient.GET();
+  if (httpCode != HTTP_OK) {
+    _logError("Download failed: " + String(endpoint) + " (HTTP " + String(httpCode) + ")");
+    _httpClient.end();
+    _client().stop();
+    return nullptr;
+  }
+  
+  if (contentLength) {
+    *contentLength = _httpClient.getSize();
+  }
+  return _httpClient.getStreamPtr();
+}
+
+void APIManager::endDownload() {
+  // The reader may stop early (rejected model); unread body bytes would be
+  // taken as the next response, so drop the connection (the next request resumes)
+  _httpClient.end();
+  _client().stop();
+  _connectionOpen = false;
+}
+
 void APIManager::setAPIKey(const String& apiKey) {
   _apiKey = apiKey;
   Serial.println("API key updated");
@@ -318,17 +809,61 @@ void APIManager::setAPIKey(const String& apiKey) {
 
 void APIManager::setServerURL(const String& serverURL) {
   _serverURL = serverURL;
+  _client().stop();
+  _parseServerURL();
   Serial.println("Server URL updated: " + serverURL);
 }
 
 void APIManager::enableSSL(bool enable) {
+  _client().stop();
   _sslEnabled = enable;
+  _parseServerURL();
   Serial.println("SSL " + String(enable ? "enabled" : "disabled"));
 }
 
-void APIManager::setRateLimit(int requestsPerMinute) {
-  // This would update the rate limiting configuration
-  Serial.println("Rate limit set to: " + String(requestsPerMinute) + " requests/minute");
+void APIManager::setRateLimit(APIRequestClass cls, uint32_t perMinute, uint32_t burst) {
+  if (cls >= API_CLASS_COUNT) {
+    return;
+  }
+  
+  portENTER_CRITICAL(&_rateMux);
+  APIRateBucket& bucket = _buckets[cls];
+  _refill(bucket);
+  bucket.rate_per_min = perMinute;
+  bucket.burst = burst;
+  bucket.milli_tokens = min(bucket.milli_tokens, burst * 1000);
+  portEXIT_CRITICAL(&_rateMux);
+  Serial.println("Rate limit of class " + String(cls) + " set to " + String(perMinute) +
+                 " requests/minute, burst " + String(burst));
+}
+
+void APIManager::enableCompression(bool enable) {
+  _compression = enable;
+  _compressionRejections = 0;
+  Serial.println("Compression " + String(enable ? "enabled" : "disabled"));
+}
+
+size_t APIManager::compressMinBytes(const char* contentType) {
+  // JSON and CSV repeat their keys and digits, so small bodies gain little;
+  // MessagePack batches are already dense and never reach the JSON threshold
+  bool text = contentType && (strstr(contentType, "json") || strncmp(contentType, "text/", 5) == 0);
+  return text ? API_COMPRESS_MIN_BYTES : API_COMPRESS_MIN_BINARY_BYTES;
+}
+
+unsigned long APIManager::getRateWait(APIRequestClass cls) {
+  // Time until the class has a whole token (0: a request would be admitted now)
+  portENTER_CRITICAL(&_rateMux);
+  APIRateBucket& bucket = _buckets[cls];
+  _refill(bucket);
+  uint32_t missing = bucket.milli_tokens >= 1000 ? 0 : 1000 - bucket.milli_tokens;
+  uint32_t rate = bucket.rate_per_min;
+  unsigned long held = _heldFor(bucket);
+  portEXIT_CRITICAL(&_rateMux);
+  
+  if (missing == 0) {
+    return held;
+  }
+  return max(held, rate ? (missing * 60 + rate - 1) / rate : (unsigned long)API_BACKOFF_MAX_MS);
 }
 
 // Command processing methods
@@ -344,7 +879,7 @@ Command APIManager::parseCommand(const String& commandJson) {
     return command;
   }
   
-  DynamicJsonDocument doc(512);
+  StaticJsonDocument<API_JSON_COMMAND_BYTES> doc;
   DeserializationError error = deserializeJson(doc, commandJson);
   
   if (error) {
@@ -405,27 +940,362 @@ bool APIManager::isConnected() {
 }
 
 int APIManager::getRequestCount() {
-  return _requestCount;
+  int count = 0;
+  portENTER_CRITICAL(&_rateMux);
+  for (int cls = 0; cls < API_CLASS_COUNT; cls++) {
+    count += _rateStats[cls].admitted;
+  }
+  portEXIT_CRITICAL(&_rateMux);
+  return count;
 }
 
 String APIManager::getLastError() {
   return _lastError;
 }
 
+int APIManager::getLastStatusCode() {
+  return _lastStatusCode;
+}
+
 void APIManager::resetErrorCount() {
-  _requestCount = 0;
   _lastError = "";
 }
 
+ConnectionStats APIManager::getConnectionStats() {
+  ConnectionStats stats = _connStats;
+  stats.handshakes = _secureClient.getHandshakeCount() - _handshakeBase;
+  stats.resumed = _secureClient.getResumedCount() - _resumedBase;
+  stats.avg_rtt_ms = stats.requests ? _rttTotalMs / stats.requests : 0;
+  stats.avg_handshake_ms = stats.handshakes ?
+    (_secureClient.getHandshakeMillis() - _handshakeMillisBase) / stats.handshakes : 0;
+  stats.min_free_heap = ESP.getMinFreeHeap();
+  stats.max_alloc_heap = ESP.getMaxAllocHeap();
+  stats.backoff_ms = _backoffMs;
+  return stats;
+}
+
+void APIManager::resetConnectionStats() {
+  memset(&_connStats, 0, sizeof(_connStats));
+  _rttTotalMs = 0;
+  _handshakeBase = _secureClient.getHandshakeCount();
+  _resumedBase = _secureClient.getResumedCount();
+  _handshakeMillisBase = _secureClient.getHandshakeMillis();
+  memset(&_compressStats, 0, sizeof(_compressStats));
+  _compressCycles = 0;
+  _compressInput = 0;
+}
+
+void APIManager::printConnectionStats() {
+  ConnectionStats stats = getConnectionStats();
+  Serial.println("Connection: " + _serverHost + ":" + String(_serverPort) +
+                 (_connectionOpen ? " (open)" : " (closed)"));
+  Serial.println("  Requests: " + String(stats.requests) + ", reused " + String(stats.reused) +
+                 ", failed " + String(stats.failures) + ", avg " + String(stats.avg_rtt_ms) + " ms");
+  Serial.println("  Handshakes: " + String(stats.handshakes) + " (" + String(stats.resumed) + " resumed), avg " +
+                 String(stats.avg_handshake_ms) + " ms, connects " + String(stats.connects));
+  Serial.println("  Min free heap: " + String(stats.min_free_heap) + " bytes, largest block " +
+                 String(stats.max_alloc_heap) + " bytes, backoff " + String(stats.backoff_ms) + " ms");
+  if (stats.cut_responses > 0) {
+    Serial.println("  Responses cut at " + String(API_RESPONSE_MAX_BYTES) + " bytes: " + String(stats.cut_responses));
+  }
+  
+  if (_task) {
+    APIQueueStats queue = getQueueStats();
+    Serial.println("  Queue: " + String(queue.depth) + " waiting (max " + String(queue.max_depth) + ", " +
+                   String(queue.queued_bytes) + " bytes), wait " + String(queue.avg_wait_ms) + " ms, in flight " +
+                   String(queue.avg_flight_ms) + " ms (max " + String(queue.max_flight_ms) + ")");
+    Serial.println("  Queued " + String(queue.enqueued) + ", done " + String(queue.completed) + ", failed " +
+                   String(queue.failed) + ", retried " + String(queue.retries) + ", dropped " +
+                   String(queue.dropped) + ", rejected " + String(queue.rejected));
+    Serial.println("  Body arena: " + String(API_QUEUE_MAX_BYTES - queue.queued_bytes) + " bytes free, longest range " +
+                   String(queue.largest_free) + ", fragmented " + String(queue.fragmented));
+  }
+  
+  APICompressionStats gzip = getCompressionStats();
+  Serial.println("  Compression: " + String(gzip.enabled ? "on" : "off") + ", " + String(gzip.compressed) +
+                 " bodies, " + String(gzip.raw_bytes) + " -> " + String(gzip.sent_bytes) + " bytes (" +
+                 String(gzip.sent_bytes ? (float)gzip.raw_bytes / gzip.sent_bytes : 0.0f, 2) + "x), skipped " +
+                 String(gzip.skipped) + ", " + String(gzip.cycles_per_kb) + " cycles/KB");
+  
+  static const char* const names[API_CLASS_COUNT] = {"alert", "command", "telemetry", "bulk"};
+  for (int cls = 0; cls < API_CLASS_COUNT; cls++) {
+    APIRateStats rate = getRateStats((APIRequestClass)cls);
+    Serial.println("  Rate " + String(names[cls]) + ": " + String(_buckets[cls].rate_per_min) + "/min (burst " +
+                   String(_buckets[cls].burst) + ", " + String(rate.tokens) + " left), admitted " +
+                   String(rate.admitted) + ", deferred " + String(rate.deferred) +
+                   (cls == API_CLASS_ALERT ? ", bypassed " + String(rate.bypassed) : String("")));
+  }
+}
+
+APIRateStats APIManager::getRateStats(APIRequestClass cls) {
+  portENTER_CRITICAL(&_rateMux);
+  _refill(_buckets[cls]);
+  APIRateStats stats = _rateStats[cls];
+  stats.tokens = _buckets[cls].milli_tokens / 1000;
+  portEXIT_CRITICAL(&_rateMux);
+  return stats;
+}
+
+APICompressionStats APIManager::getCompressionStats() {
+  APICompressionStats stats = _compressStats;
+  stats.cycles_per_kb = _compressInput ? _compressCycles * 1024 / _compressInput : 0;
+  stats.enabled = _compression;
+  return stats;
+}
+
+// Asynchronous requests
+
+bool APIManager::begin() {
+  if (_task) {
+    return true;
+  }
+  
+  BaseType_t created = xTaskCreatePinnedToCore(_taskLoop, "api_net", API_TASK_STACK, nullptr,
+                                               API_TASK_PRIORITY, &_task, API_TASK_CORE);
+  if (created != pdPASS) {
+    _task = nullptr;
+    Serial.println("Failed to start API network task");
+    return false;
+  }
+  
+  Serial.println("API network task started on core " + String(API_TASK_CORE));
+  return true;
+}
+
+bool APIManager::sendDataAsync(const uint8_t* data, size_t length, const char* contentType,
+                               APICallback callback, void* context) {
+  return _enqueue(API_CLASS_TELEMETRY, API_DATA_ENDPOINT, "POST", data, length, contentType,
+                  nullptr, callback, context);
+}
+
+bool APIManager::sendDataAsync(const JsonDocument& doc, APICallback callback, void* context) {
+  return _enqueueJson(API_CLASS_TELEMETRY, API_DATA_ENDPOINT, doc, callback, context);
+}
+
+bool APIManager::getCommandAsync(APICallback callback, void* context) {
+  return _enqueue(API_CLASS_COMMAND, API_COMMANDS_ENDPOINT, "GET", nullptr, 0, "application/json",
+                  nullptr, callback, context);
+}
+
+bool APIManager::sendAlertAsync(const String& alertType, const String& details,
+                                APICallback callback, void* context) {
+  StaticJsonDocument<API_JSON_ALERT_BYTES> doc;
+  _formatAlert(doc, alertType, details);
+  return _enqueueAlert(doc, callback, context);
+}
+
+bool APIManager::sendCommandResultAsync(const String& commandId, bool executed, const String& details,
+                                        APICallback callback, void* context) {
+  // COMMAND_EXECUTED / COMMAND_ERROR with the command id: the dashboard keeps
+  // resending the command until this arrives
+  StaticJsonDocument<API_JSON_ALERT_BYTES> doc;
+  _formatAlert(doc, executed ? "COMMAND_EXECUTED" : "COMMAND_ERROR", details);
+  if (commandId.length() > 0) {
+    doc["command_id"] = commandId;
+  }
+  return _enqueueAlert(doc, callback, context);
+}
+
+bool APIManager::_enqueueAlert(const JsonDocument& doc, APICallback callback, void* context) {
+  // An alert that cannot be queued goes to the undelivered handler (the spool)
+  if (_enqueueJson(API_CLASS_ALERT, API_ALERTS_ENDPOINT, doc, callback, context, true)) {
+    return true;
+  }
+  
+  if (_undeliveredHandler) {
+    char json[API_JSON_ALERT_BYTES];
+    size_t length = serializeJson(doc, json, sizeof(json));
+    _undeliveredHandler((const uint8_t*)json, length);
+  }
+  return false;
+}
+
+bool APIManager::sendBulkAsync(const uint8_t* data, size_t length, const char* contentType,
+                               APICallback callback, void* context) {
+  return _enqueue(API_CLASS_BULK, API_DATA_ENDPOINT, "POST", data, length, contentType,
+                  nullptr, callback, context);
+}
+
+bool APIManager::sendBulkAsync(const JsonDocument& doc, APICallback callback, void* context) {
+  return _enqueueJson(API_CLASS_BULK, API_DATA_ENDPOINT, doc, callback, context);
+}
+
+bool APIManager::resendAlertAsync(const uint8_t* json, size_t length, APICallback callback, void* context) {
+  // The caller still holds the body, so a failure is only reported, not handed off
+  return _enqueue(API_CLASS_ALERT, API_ALERTS_ENDPOINT, "POST", json, length, "application/json",
+                  nullptr, callback, context);
+}
+
+bool APIManager::downloadAsync(const String& endpoint, APIStreamHandler handler,
+                               APICallback callback, void* context) {
+  return _enqueue(API_CLASS_COMMAND, endpoint.c_str(), "GET", nullptr, 0, "application/json",
+                  handler, callback, context);
+}
+
+void APIManager::setUndeliveredAlertHandler(APIUndeliveredHandler handler) {
+  _undeliveredHandler = handler;
+}
+
+void APIManager::poll() {
+  // Callbacks of evicted requests first; the slot they held is already reused
+  for (;;) {
+    APIDroppedRequest dropped;
+    portENTER_CRITICAL(&_queueMux);
+    bool any = _droppedCount > 0;
+    if (any) {
+      dropped = _dropped[0];
+      memmove(_dropped, _dropped + 1, (_droppedCount - 1) * sizeof(APIDroppedRequest));
+      _droppedCount--;
+    }
+    portEXIT_CRITICAL(&_queueMux);
+    if (!any) {
+      break;
+    }
+    
+    if (dropped.callback) {
+      APIResponse response = {false, 0, "", "Dropped (request queue full)", 0};
+      dropped.callback(response, dropped.context);
+    }
+  }
+  
+  // Finished requests in the order they were queued
+  for (;;) {
+    int index = -1;
+    portENTER_CRITICAL(&_queueMux);
+    for (int i = 0; i < API_QUEUE_SLOTS; i++) {
+      if (_slots[i].state == API_SLOT_DONE && (index < 0 || (int32_t)(_slots[i].seq - _slots[index].seq) < 0)) {
+        index = i;
+      }
+    }
+    if (index >= 0) {
+      _slots[index].state = API_SLOT_DELIVERING;
+    }
+    portEXIT_CRITICAL(&_queueMux);
+    if (index < 0) {
+      break;
+    }
+    
+    APIQueueSlot& slot = _slots[index];
+    int status = slot.response.statusCode;
+    if (slot.handOff && !slot.response.success && _undeliveredHandler && _retryable(status)) {
+      // Out of retries on a network or server error or 429; another 4xx would be refused again
+      _undeliveredHandler(slot.body, slot.length);
+    }
+    if (slot.callback) {
+      slot.callback(slot.response, slot.context);
+    }
+    slot.response.data = "";
+    slot.response.error = "";
+    
+    // The body's arena range is free once the slot is
+    portENTER_CRITICAL(&_queueMux);
+    _queueStats.queued_bytes -= slot.length;
+    slot.body = nullptr;
+    slot.state = API_SLOT_FREE;
+    portEXIT_CRITICAL(&_queueMux);
+  }
+}
+
+APIQueueStats APIManager::getQueueStats() {
+  portENTER_CRITICAL(&_queueMux);
+  APIQueueStats stats = _queueStats;
+  uint32_t started = stats.completed + stats.retries;
+  stats.avg_wait_ms = started ? _waitTotalMs / started : 0;
+  stats.avg_flight_ms = started ? _flightTotalMs / started : 0;
+  _arenaFit(0, &stats.largest_free);
+  portEXIT_CRITICAL(&_queueMux);
+  return stats;
+}
+
+void APIManager::resetQueueStats() {
+  // Depth and queued bytes describe the queue now and are kept
+  portENTER_CRITICAL(&_queueMux);
+  _queueStats.max_depth = _queueStats.depth;
+  _queueStats.enqueued = 0;
+  _queueStats.completed = 0;
+  _queueStats.failed = 0;
+  _queueStats.retries = 0;
+  _queueStats.dropped = 0;
+  _queueStats.rejected = 0;
+  _queueStats.max_flight_ms = 0;
+  _queueStats.fragmented = 0;
+  _waitTotalMs = 0;
+  _flightTotalMs = 0;
+  portEXIT_CRITICAL(&_queueMux);
+}
+
 // Private helper methods
 
-String APIManager::_buildURL(const String& endpoint) {
-  String url = _serverURL;
-  if (!url.endsWith("/") && !endpoint.startsWith("/")) {
-    url += "/";
+bool APIManager::_formatURL(char* url, size_t size, const char* endpoint) {
+  // Into the caller's buffer: no String concatenation per request
+  const char* separator = (!_serverURL.endsWith("/") && endpoint[0] != '/') ? "/" : "";
+  int length = snprintf(url, size, "%s%s%s", _serverURL.c_str(), separator, endpoint);
+  return length > 0 && (size_t)length < size;
+}
+
+void APIManager::_setClientHeaders() {
+  // Kept by HTTPClient across begin()/end(); the token String keeps its
+  // capacity, so setting it per request does not allocate
+  _httpClient.setUserAgent("EV-Secure-ESP32/" DEVICE_VERSION);
+  _httpClient.setAuthorizationType("Bearer");
+  _httpClient.setAuthorization(_apiKey.c_str());
+  static const char* responseHeaders[] = {"Retry-After"};
+  _httpClient.collectHeaders(responseHeaders, 1);
+}
+
+bool APIManager::_parseServerURL() {
+  // scheme://host[:port][/path]
+  int hostStart = _serverURL.indexOf("://");
+  hostStart = hostStart < 0 ? 0 : hostStart + 3;
+  int hostEnd = _serverURL.indexOf('/', hostStart);
+  String authority = hostEnd < 0 ? _serverURL.substring(hostStart) : _serverURL.substring(hostStart, hostEnd);
+  
+  int colon = authority.indexOf(':');
+  _serverHost = colon < 0 ? authority : authority.substring(0, colon);
+  _serverPort = colon < 0 ? (_sslEnabled ? 443 : 80) : authority.substring(colon + 1).toInt();
+  return _serverHost.length() > 0 && _serverPort > 0;
+}
+
+WiFiClient& APIManager::_client() {
+  if (_sslEnabled) {
+    return _secureClient;
   }
-  url += endpoint;
-  return url;
+  return _plainClient;
+}
+
+bool APIManager::_ensureConnection(String& error) {
+  WiFiClient& client = _client();
+  if (client.connected()) {
+    _connStats.reused++;
+    return true;
+  }
+  
+  // After a failed connect, fail fast until the backoff expires instead of
+  // blocking the loop for a full timeout on every call
+  if (_backoffMs > 0 && (long)(millis() - _nextConnectMillis) < 0) {
+    error = "Reconnect in " + String(_nextConnectMillis - millis()) + " ms";
+    return false;
+  }
+  if (WiFi.status() != WL_CONNECTED) {
+    error = "WiFi not connected";
+    return false;
+  }
+  
+  _connStats.connects++;
+  if (!client.connect(_serverHost.c_str(), _serverPort, REQUEST_TIMEOUT_MS)) {
+    _scheduleReconnect();
+    error = "Cannot connect to " + _serverHost + " (retry in " + String(_backoffMs) + " ms)";
+    return false;
+  }
+  
+  _backoffMs = 0;
+  return true;
+}
+
+void APIManager::_scheduleReconnect() {
+  // Exponential backoff with jitter so stations do not reconnect in lockstep
+  _backoffMs = _backoffMs == 0 ? API_BACKOFF_MIN_MS : min(_backoffMs * 2, (unsigned long)API_BACKOFF_MAX_MS);
+  _nextConnectMillis = millis() + _backoffMs + random(_backoffMs / 4 + 1);
 }
 
 String APIManager::_buildHeaders() {
@@ -436,25 +1306,76 @@ String APIManager::_buildHeaders() {
   return headers;
 }
 
-bool APIManager::_checkRateLimit() {
-  unsigned long currentTime = millis();
-  
-  // Reset window if needed
-  if (currentTime - _requestWindowStart > 60000) { // 1 minute window
-    _requestCount = 0;
-    _requestWindowStart = currentTime;
+bool APIManager::_admit(APIRequestClass cls) {
+  // Takes a token when the request is sent, whether or not it then succeeds
+  portENTER_CRITICAL(&_rateMux);
+  _refill(_buckets[cls]);
+  bool admitted = _buckets[cls].milli_tokens >= 1000 && _heldFor(_buckets[cls]) == 0;
+  if (admitted) {
+    _buckets[cls].milli_tokens -= 1000;
+  } else if (cls == API_CLASS_ALERT) {
+    // Alerts are never held back; the lowest class with a token pays instead
+    admitted = true;
+    _rateStats[cls].bypassed++;
+    for (int lower = API_CLASS_COUNT - 1; lower > API_CLASS_ALERT; lower--) {
+      _refill(_buckets[lower]);
+      if (_buckets[lower].milli_tokens >= 1000) {
+        _buckets[lower].milli_tokens -= 1000;
+        break;
+      }
+    }
   }
   
-  return _requestCount < MAX_REQUESTS_PER_MINUTE;
+  if (admitted) {
+    _rateStats[cls].admitted++;
+  } else {
+    _rateStats[cls].deferred++;
+  }
+  portEXIT_CRITICAL(&_rateMux);
+  return admitted;
 }
 
-void APIManager::_updateRateLimit() {
-  _requestCount++;
-  _lastRequestTime = millis();
+unsigned long APIManager::_heldFor(APIRateBucket& bucket) {
+  // Called with _rateMux held
+  if (bucket.held_until == 0) {
+    return 0;
+  }
+  long left = (long)(bucket.held_until - millis());
+  if (left <= 0) {
+    bucket.held_until = 0;
+    return 0;
+  }
+  return left;
 }
 
-String APIManager::_formatSensorData(const SensorData& sensorData) {
-  DynamicJsonDocument doc(512);
+void APIManager::_holdClass(APIRequestClass cls, unsigned long ms) {
+  // The server asked for a pause (Retry-After); a later, shorter one does not shorten it
+  portENTER_CRITICAL(&_rateMux);
+  APIRateBucket& bucket = _buckets[cls];
+  if (ms > _heldFor(bucket)) {
+    bucket.held_until = max(millis() + ms, 1UL);
+  }
+  portEXIT_CRITICAL(&_rateMux);
+}
+
+void APIManager::_refill(APIRateBucket& bucket) {
+  // Called with _rateMux held. Only the time the added tokens cover is
+  // consumed, so frequent calls do not lose fractions of a token
+  unsigned long now = millis();
+  uint32_t full = bucket.burst * 1000;
+  if (bucket.rate_per_min == 0 || bucket.milli_tokens >= full) {
+    bucket.refilled = now;
+    bucket.milli_tokens = min(bucket.milli_tokens, full);
+    return;
+  }
+  
+  uint32_t added = (uint64_t)(now - bucket.refilled) * bucket.rate_per_min / 60;
+  bucket.refilled += (uint64_t)added * 60 / bucket.rate_per_min;
+  bucket.milli_tokens = min(bucket.milli_tokens + added, full);
+}
+
+size_t APIManager::_formatSensorData(const SensorData& sensorData, char* out, size_t size) {
+  StaticJsonDocument<JSON_OBJECT_SIZE(6)> doc;
   doc["current"] = sensorData.current;
   doc["voltage"] = sensorData.voltage;
   doc["power"] = sensorData.power;
@@ -462,30 +1383,24 @@ String APIManager::_formatSensorData(const SensorData& sensorData) {
   doc["temperature"] = sensorData.temperature;
   doc["timestamp"] = sensorData.timestamp;
   
-  String jsonString;
-  serializeJson(doc, jsonString);
-  return jsonString;
+  return serializeJson(doc, out, size);
 }
 
-String APIManager::_formatMLPrediction(const MLPrediction& mlResult) {
-  DynamicJsonDocument doc(256);
+size_t APIManager::_formatMLPrediction(const MLPrediction& mlResult, char* out, size_t size) {
+  StaticJsonDocument<JSON_OBJECT_SIZE(3)> doc;
   doc["prediction"] = mlResult.prediction;
   doc["confidence"] = mlResult.confidence;
   doc["timestamp"] = mlResult.timestamp;
   
-  String jsonString;
-  serializeJson(doc, jsonString);
-  return jsonString;
+  return serializeJson(doc, out, size);
 }
 
-String APIManager::_formatSystemState(SystemState state) {
-  DynamicJsonDocument doc(128);
+size_t APIManager::_formatSystemState(SystemState state, char* out, size_t size) {
+  StaticJsonDocument<JSON_OBJECT_SIZE(2)> doc;
   doc["state"] = state;
   doc["timestamp"] = millis();
   
-  String jsonString;
-  serializeJson(doc, jsonString);
-  return jsonString;
+  return serializeJson(doc, out, size);
 }
 
 CommandType APIManager::_parseCommandType(const String& type) {
@@ -502,20 +1417,382 @@ void APIManager::_logError(const String& error) {
   Serial.println("API Error: " + error);
 }
 
-bool APIManager::_retryRequest(const String& endpoint, const String& method, const String& data, APIResponse& response) {
-  for (int attempt = 0; attempt < RETRY_ATTEMPTS; attempt++) {
-    response = makeRequest(endpoint, method, data);
+void APIManager::_formatAlert(JsonDocument& doc, const String& alertType, const String& details) {
+  doc["device_id"] = DEVICE_ID;
+  doc["alert_type"] = alertType;
+  doc["details"] = details;
+  doc["timestamp"] = millis();
+  doc["severity"] = "high";
+}
+
+// Request queue helpers
+
+bool APIManager::_enqueue(APIRequestClass cls, const char* endpoint, const char* method, const uint8_t* data,
+                          size_t length, const char* contentType, APIStreamHandler handler,
+                          APICallback callback, void* context, bool handOff) {
+  // The caller's buffer may change as soon as this returns
+  int index = _openSlot(cls, endpoint, length);
+  if (index < 0) {
+    return false;
+  }
+  
+  if (length > 0) {
+    memcpy(_slots[index].body, data, length);
+  }
+  _submitSlot(index, cls, endpoint, method, contentType, handler, callback, context, handOff);
+  return true;
+}
+
+bool APIManager::_enqueueJson(APIRequestClass cls, const char* endpoint, const JsonDocument& doc,
+                              APICallback callback, void* context, bool handOff) {
+  // Serialized once, straight into the slot's arena range; the network task
+  // writes that range to the socket as it is
+  int index = _openSlot(cls, endpoint, measureJson(doc));
+  if (index < 0) {
+    return false;
+  }
+  
+  APIBodyWriter writer(_slots[index].body, _slots[index].length);
+  serializeJson(doc, writer);
+  _submitSlot(index, cls, endpoint, "POST", "application/json", nullptr, callback, context, handOff);
+  return true;
+}
+
+int APIManager::_openSlot(APIRequestClass cls, const char* endpoint, size_t length) {
+  if (!begin()) {
+    return -1;
+  }
+  if (strlen(endpoint) >= API_URL_MAX_LEN) {
+    Serial.print("API endpoint too long - ");
+    Serial.println(endpoint);
+    return -1;
+  }
+  
+  portENTER_CRITICAL(&_queueMux);
+  int index = _reserveSlot(cls, length);
+  portEXIT_CRITICAL(&_queueMux);
+  if (index < 0) {
+    // Printed piecewise: the caller may be on a path that must not allocate
+    Serial.print("API queue full - ");
+    Serial.print(endpoint);
+    Serial.println(" request rejected");
+  }
+  return index;
+}
+
+void APIManager::_submitSlot(int index, APIRequestClass cls, const char* endpoint, const char* method,
+                             const char* contentType, APIStreamHandler handler, APICallback callback,
+                             void* context, bool handOff) {
+  // Reserved slots are only touched by this task, so they are filled outside the lock
+  APIQueueSlot& slot = _slots[index];
+  slot.cls = cls;
+  slot.attempts = 0;
+  slot.handOff = handOff;
+  memcpy(slot.endpoint, endpoint, strlen(endpoint) + 1);  // Length checked by _openSlot()
+  slot.method = method;
+  slot.contentType = contentType;
+  slot.handler = handler;
+  slot.callback = callback;
+  slot.context = context;
+  slot.enqueued = millis();
+  slot.notBefore = slot.enqueued;
+  slot.response = {false, 0, String(), String(), 0};
+  
+  portENTER_CRITICAL(&_queueMux);
+  slot.state = API_SLOT_QUEUED;
+  _queueStats.enqueued++;
+  _queueStats.depth++;
+  _queueStats.max_depth = max(_queueStats.max_depth, _queueStats.depth);
+  portEXIT_CRITICAL(&_queueMux);
+  
+  xTaskNotifyGive(_task);
+}
+
+int APIManager::_reserveSlot(APIRequestClass cls, size_t length) {
+  // Called with _queueMux held. Alerts keep API_QUEUE_ALERT_RESERVE slots for
+  // themselves; others make room by evicting waiting requests of the same or a
+  // lower class, telemetry first and oldest first. Alerts, downloads and
+  // in-flight requests are never evicted. The body gets its arena range here.
+  int limit = cls == API_CLASS_ALERT ? API_QUEUE_SLOTS : API_QUEUE_SLOTS - API_QUEUE_ALERT_RESERVE;
+  if (length > API_QUEUE_MAX_BYTES) {
+    _queueStats.rejected++;
+    return -1;
+  }
+  
+  bool counted = false;
+  for (;;) {
+    int used = 0;
+    int vacant = -1;
+    for (int i = 0; i < API_QUEUE_SLOTS; i++) {
+      if (_slots[i].state == API_SLOT_FREE) {
+        vacant = vacant < 0 ? i : vacant;
+      } else {
+        used++;
+      }
+    }
     
-    if (response.success) {
-      return true;
+    uint32_t largest = 0;
+    int offset = vacant >= 0 && used < limit ? _arenaFit(length, &largest) : -1;
+    if (offset >= 0) {
+      _slots[vacant].state = API_SLOT_RESERVED;
+      _slots[vacant].seq = _nextSeq++;
+      _slots[vacant].body = length > 0 ? _arena + offset : nullptr;
+      _slots[vacant].length = length;
+      _queueStats.queued_bytes += length;
+      return vacant;
+    }
+    if (vacant >= 0 && used < limit && !counted && API_QUEUE_MAX_BYTES - _queueStats.queued_bytes >= length) {
+      // Enough bytes free, but split between the bodies still queued
+      _queueStats.fragmented++;
+      counted = true;
     }
     
-    if (attempt < RETRY_ATTEMPTS - 1) {
-      delay(RETRY_DELAY_MS * (attempt + 1)); // Exponential backoff
+    int victim = -1;
+    for (int i = 0; i < API_QUEUE_SLOTS; i++) {
+      const APIQueueSlot& slot = _slots[i];
+      if (slot.state != API_SLOT_QUEUED || slot.cls == API_CLASS_ALERT || slot.handler || slot.cls < cls) {
+        continue;
+      }
+      if (victim < 0 || slot.cls > _slots[victim].cls ||
+          (slot.cls == _slots[victim].cls && (int32_t)(slot.seq - _slots[victim].seq) < 0)) {
+        victim = i;
+      }
     }
+    if (victim < 0 || _droppedCount == API_QUEUE_SLOTS) {
+      _queueStats.rejected++;
+      return -1;
+    }
+    
+    // The slot and its arena range are reused at once; poll() reports the drop
+    APIQueueSlot& slot = _slots[victim];
+    _dropped[_droppedCount++] = {slot.callback, slot.context};
+    slot.body = nullptr;
+    slot.state = API_SLOT_FREE;
+    _queueStats.queued_bytes -= slot.length;
+    _queueStats.depth--;
+    _queueStats.dropped++;
+  }
+}
+
+int APIManager::_arenaFit(size_t length, uint32_t* largest) {
+  // Called with _queueMux held. Best fit: the smallest free range that holds
+  // length bytes, so the long ranges stay free for telemetry batches.
+  // Returns the offset (-1: none) and the longest free range.
+  int order[API_QUEUE_SLOTS];
+  int count = 0;
+  for (int i = 0; i < API_QUEUE_SLOTS; i++) {
+    if (_slots[i].state == API_SLOT_FREE || !_slots[i].body) {
+      continue;
+    }
+    int j = count++;
+    for (; j > 0 && _slots[order[j - 1]].body > _slots[i].body; j--) {
+      order[j] = order[j - 1];
+    }
+    order[j] = i;
   }
   
-  return false;
+  int best = -1;
+  size_t bestSize = 0;
+  size_t start = 0;
+  *largest = 0;
+  for (int k = 0; k <= count; k++) {
+    size_t end = k < count ? _slots[order[k]].body - _arena : API_QUEUE_MAX_BYTES;
+    size_t gap = end - start;
+    *largest = max(*largest, (uint32_t)gap);
+    if (gap >= length && (best < 0 || gap < bestSize)) {
+      best = start;
+      bestSize = gap;
+    }
+    if (k < count) {
+      start = end + _slots[order[k]].length;
+    }
+  }
+  return best;
+}
+
+int APIManager::_nextRequest() {
+  // Highest class first, oldest first within a class; skips alerts waiting to retry
+  unsigned long now = millis();
+  int index = -1;
+  portENTER_CRITICAL(&_queueMux);
+  for (int i = 0; i < API_QUEUE_SLOTS; i++) {
+    const APIQueueSlot& slot = _slots[i];
+    if (slot.state != API_SLOT_QUEUED || (long)(now - slot.notBefore) < 0) {
+      continue;
+    }
+    if (index < 0 || slot.cls < _slots[index].cls ||
+        (slot.cls == _slots[index].cls && (int32_t)(slot.seq - _slots[index].seq) < 0)) {
+      index = i;
+    }
+  }
+  if (index >= 0) {
+    _slots[index].state = API_SLOT_IN_FLIGHT;
+    _slots[index].started = now;
+    _queueStats.depth--;
+    _waitTotalMs += now - _slots[index].notBefore;
+  }
+  portEXIT_CRITICAL(&_queueMux);
+  return index;
+}
+
+void APIManager::_execute(APIQueueSlot& slot) {
+  APIResponse& response = slot.response;
+  response = {false, 0, "", "", 0};
+  
+  // The first request (and any after a failed init) sets the manager up on this task
+  if (!_initialized && !init()) {
+    response.error = "API Manager not initialized: " + _lastError;
+    return;
+  }
+  
+  if (slot.handler) {
+    // Download: the handler reads the body here, on the network task
+    int length = 0;
+    Stream* body = beginDownload(slot.endpoint, &length);
+    if (!body) {
+      response.error = _lastError;
+      return;
+    }
+    response.statusCode = HTTP_OK;
+    response.success = slot.handler(*body, length, slot.context);
+    if (!response.success) {
+      response.error = "Download rejected: " + String(slot.endpoint);
+    }
+    endDownload();
+    return;
+  }
+  
+  // Each request takes a token of its class; alerts always get one
+  if (!_admit((APIRequestClass)slot.cls)) {
+    response.statusCode = HTTP_TOO_MANY_REQUESTS;
+    response.error = "Rate limit exceeded (deferred)";
+    return;
+  }
+  
+  size_t compressed = _compressBody(slot);
+  if (compressed == 0) {
+    response = makeRequest(slot.endpoint, slot.method, slot.body, slot.length, slot.contentType);
+    return;
+  }
+  
+  response = makeRequest(slot.endpoint, slot.method, _compressed, compressed, slot.contentType, "gzip");
+  int status = response.statusCode;
+  if (response.success) {
+    _compressionAccepted = true;
+    _compressionRejections = 0;
+    return;
+  }
+  
+  // 415 means no. An older dashboard fails to parse the body (400/500)
+  // instead, but so does one with a passing fault: this body goes again as
+  // is, and only a dashboard that then takes it counts as a rejection.
+  // Compression goes off after API_COMPRESS_REJECTIONS of those in a row
+  bool unsupported = status == HTTP_UNSUPPORTED_MEDIA_TYPE;
+  if (!unsupported && (_compressionAccepted || (status != HTTP_BAD_REQUEST && status != HTTP_INTERNAL_ERROR))) {
+    return;
+  }
+  response = makeRequest(slot.endpoint, slot.method, slot.body, slot.length, slot.contentType);
+  if (!unsupported && response.success) {
+    _compressionRejections++;
+  }
+  if (unsupported || _compressionRejections >= API_COMPRESS_REJECTIONS) {
+    _compression = false;
+    Serial.println("Dashboard does not accept gzip bodies - compression off");
+  }
+}
+
+size_t APIManager::_compressBody(const APIQueueSlot& slot) {
+  // Batches and backlog only (alerts and polls are small); 0: send as is
+  if (!_compression || slot.length < compressMinBytes(slot.contentType) ||
+      (slot.cls != API_CLASS_TELEMETRY && slot.cls != API_CLASS_BULK)) {
+    return 0;
+  }
+  
+  uint32_t start = ESP.getCycleCount();
+  DeflateWriter out(_compressed, sizeof(_compressed));
+  out.write(slot.body, slot.length);
+  out.finish();
+  _compressCycles += ESP.getCycleCount() - start;
+  _compressInput += slot.length;
+  
+  if (out.overflowed() || out.length() >= slot.length) {
+    _compressStats.skipped++;
+    return 0;
+  }
+  _compressStats.compressed++;
+  _compressStats.raw_bytes += slot.length;
+  _compressStats.sent_bytes += out.length();
+  return out.length();
+}
+
+bool APIManager::_retryable(int status) {
+  // Worth sending again later: no answer, a server error, or throttled
+  return status <= 0 || status >= HTTP_INTERNAL_ERROR || status == HTTP_TOO_MANY_REQUESTS;
+}
+
+void APIManager::_finish(APIQueueSlot& slot) {
+  unsigned long now = millis();
+  uint32_t flight = now - slot.started;
+  bool success = slot.response.success;
+  slot.attempts++;
+  
+  // The server's Retry-After holds the whole class (getRateWait() includes it)
+  unsigned long retryAfter = slot.response.retryAfterMs;
+  if (retryAfter > 0) {
+    _holdClass((APIRequestClass)slot.cls, retryAfter);
+  }
+  
+  // Alerts are retried on network errors, server errors and 429; another 4xx will not change
+  bool retry = !success && slot.cls == API_CLASS_ALERT && slot.attempts < RETRY_ATTEMPTS &&
+               _retryable(slot.response.statusCode);
+  
+  // Throttled (here or by the server): commands and bulk wait in the queue for
+  // a token; telemetry is handed back so the next batch carries its frames
+  bool deferred = slot.response.statusCode == HTTP_TOO_MANY_REQUESTS &&
+                  (slot.cls == API_CLASS_COMMAND || slot.cls == API_CLASS_BULK);
+  if (!success && !deferred) {
+    _logError(String(slot.endpoint) + (retry ? " failed (will retry): " : " failed: ") + slot.response.error);
+  }
+  unsigned long wait = deferred ? max(getRateWait((APIRequestClass)slot.cls), (unsigned long)RETRY_DELAY_MS) :
+                       retry ? max((unsigned long)RETRY_DELAY_MS * slot.attempts, retryAfter) : 0;
+  
+  portENTER_CRITICAL(&_queueMux);
+  _flightTotalMs += flight;
+  _queueStats.max_flight_ms = max(_queueStats.max_flight_ms, flight);
+  if (deferred) {
+    slot.attempts--;
+    slot.notBefore = now + wait;
+    slot.state = API_SLOT_QUEUED;
+    _queueStats.depth++;
+  } else if (retry) {
+    slot.notBefore = now + wait;
+    slot.state = API_SLOT_QUEUED;
+    _queueStats.retries++;
+    _queueStats.depth++;
+  } else {
+    slot.state = API_SLOT_DONE;
+    _queueStats.completed++;
+    if (!success) {
+      _queueStats.failed++;
+    }
+  }
+  portEXIT_CRITICAL(&_queueMux);
+}
+
+void APIManager::_taskLoop(void* param) {
+  (void)param;
+  
+  for (;;) {
+    int index = _nextRequest();
+    if (index < 0) {
+      // Woken by the next enqueue, or in time for a pending retry
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(API_TASK_IDLE_MS));
+      continue;
+    }
+    
+    _execute(_slots[index]);
+    _finish(_slots[index]);
+  }
 }
 
 #endif // API_MANAGER_H
@@ -150,7 +150,7 @@ public:
   static float getAttackSeverity(AttackType attack);
   
   // Comprehensive threat analysis
-  static float comprehensiveThreatAnalysis(const SensorData& data);
+  static float comprehensiveThreatAnalysis(const SensorData& data, AttackType* attackOut = nullptr);
   static bool isThreatDetected(const SensorData& data);
   static AttackType getPrimaryThreat(const SensorData& data);
   
@@ -537,7 +537,7 @@ float AdvancedThreatDetection::getAttackSeverity(AttackType attack) {
   }
 }
 
-float AdvancedThreatDetection::comprehensiveThreatAnalysis(const SensorData& data) {
+float AdvancedThreatDetection::comprehensiveThreatAnalysis(const SensorData& data, AttackType* attackOut) {
   if (!_initialized) {
     return 0.0;
   }
@@ -553,6 +553,9 @@ float AdvancedThreatDetection::comprehensiveThreatAnalysis(const SensorData& dat
   
   // Classify attack
   AttackType attack = classifyAttack(data, signature);
+  if (attackOut) {
+    *attackOut = attack; // Saves callers a second analysis (and history update)
+  }
   
   // Calculate comprehensive threat score
   float threatScore = 0.0;
@@ -0,0 +1,659 @@
+/*
+ * CommandChannel.h - Push Channel for Dashboard Commands
+ *
+ * This library keeps a request open to the dashboard so a queued command
+ * (STOP in particular) reaches the station at once instead of on the next poll.
+ *
+ * Features:
+ * - Server-Sent Events stream (GET /api/commands/stream) on its own task and connection
+ * - Server heartbeat every 15 s; a silent stream is dropped and reopened
+ * - Long-poll fallback (GET /api/commands?wait=25) when no stream is served
+ * - Reconnect with exponential backoff and jitter
+ * - Commands handed to loop() through a fixed inbox; neither side waits
+ * - The dashboard resends a command until loop() acknowledges it
+ *   (APIManager::sendCommandResultAsync); a reopened stream sends
+ *   Last-Event-ID so commands lost with the old one come at once
+ * - Request, heartbeat and timeout counters
+ *
+ * Usage:
+ * 1. Start the channel task with CommandChannel::begin()
+ * 2. In loop(): while (CommandChannel::receive(json)) handle the command
+ * 3. While the channel is down, commands still arrive with /api/data
+ *    responses (up to COMMAND_PIGGYBACK_MAX per upload)
+ * 4. Check the channel with CommandChannel::getStats() / printStats()
+ */
+
+#ifndef COMMAND_CHANNEL_H
+#define COMMAND_CHANNEL_H
+
+#include "EV_Secure_Config.h"
+#include "APIManager.h"
+
+// Channel endpoints
+#define COMMAND_STREAM_ENDPOINT "/api/commands/stream"
+#define COMMAND_LONG_POLL_SECONDS 25        // Held by the server (it allows up to 30)
+
+// Channel task
+#define COMMAND_CHANNEL_CORE 0              // Next to the API network task
+#define COMMAND_CHANNEL_PRIORITY 1          // Blocks on its socket almost all the time
+#define COMMAND_CHANNEL_STACK 8192          // mbedTLS handshake needs about 6 KB
+#define COMMAND_CHANNEL_READ_POLL_MS 10     // Socket check interval while waiting for data
+
+// Liveness and fallback
+#define COMMAND_HEARTBEAT_TIMEOUT_MS 40000  // Server heartbeat is 15 s; two missed plus slack
+#define COMMAND_STREAM_MIN_MS 10000         // Streams that end sooner count as failures
+#define COMMAND_STREAM_RETRY_MS 600000      // Try the stream again after falling back to long-poll
+
+// Inbox (commands waiting for loop())
+#define COMMAND_CHANNEL_SLOTS 4
+#define COMMAND_CHANNEL_MAX_BYTES 1024      // Longest command or long-poll response kept
+#define COMMAND_INBOX_WAIT_MS 5000          // Wait for loop() to free a slot before dropping
+#define COMMAND_PIGGYBACK_MAX 4             // Commands returned with one /api/data response
+#define COMMAND_RECENT_IDS 8                // Command ids run lately (resent ones are not rerun)
+#define COMMAND_EVENT_ID_BYTES 64           // Longest Last-Event-ID kept for a reconnect
+
+// Channel modes
+enum CommandChannelMode {
+  COMMAND_CHANNEL_STREAM,
+  COMMAND_CHANNEL_LONG_POLL
+};
+
+// Channel statistics
+struct CommandChannelStats {
+  uint32_t connects;          // Connections opened
+  uint32_t requests;          // Requests sent (stream opens and long-polls)
+  uint32_t requests_per_hour; // requests scaled to an hour since the last reset
+  uint32_t commands;          // Commands passed to loop()
+  uint32_t heartbeats;        // Stream heartbeats received
+  uint32_t timeouts;          // Streams dropped after missed heartbeats
+  uint32_t failures;          // Failed connects and error responses
+  uint32_t dropped;           // Commands lost to a full inbox (loop() stalled) or oversize
+  uint32_t connected_ms;      // Time the channel has been up (0 while down)
+};
+
+class CommandChannel {
+public:
+  static bool begin();
+  static bool receive(String& commandJson);
+  static bool isConnected();
+  static CommandChannelMode getMode();
+  
+  // Configuration (before begin())
+  static void setServerURL(const String& serverURL);
+  static void setAPIKey(const String& apiKey);
+  static void enableSSL(bool enable);
+  
+  // Status and monitoring
+  static CommandChannelStats getStats();
+  static void resetStats();
+  static void printStats();
+  
+private:
+  static TaskHandle_t _task;
+  static String _serverURL;
+  static String _apiKey;
+  static bool _sslEnabled;
+  static String _serverHost;
+  static uint16_t _serverPort;
+  static String _basePath;
+  static ResumableTLSClient _secureClient;
+  static WiFiClient _plainClient;
+  static volatile bool _connected;
+  static volatile uint8_t _mode;
+  static unsigned long _connectedSince;
+  static unsigned long _streamRetryMillis;
+  static unsigned long _backoffMs;
+  static unsigned long _nextConnectMillis;
+  
+  // Response being read
+  static bool _chunked;
+  static long _remaining;               // Bytes left in the body or chunk; -1 reads to close
+  static bool _closeAfter;
+  
+  // Inbox
+  static portMUX_TYPE _inboxMux;
+  static uint8_t _inboxState[COMMAND_CHANNEL_SLOTS];
+  static uint32_t _inboxSeq[COMMAND_CHANNEL_SLOTS];
+  static char _inbox[COMMAND_CHANNEL_SLOTS][COMMAND_CHANNEL_MAX_BYTES + 1];
+  static uint32_t _nextSeq;
+  
+  static char _lastEventId[COMMAND_EVENT_ID_BYTES];  // Last command put in the inbox
+  
+  static CommandChannelStats _stats;
+  static unsigned long _statsSince;
+  
+  // Helper methods
+  static bool _parseServerURL();
+  static WiFiClient& _client();
+  static bool _request(const String& path, const char* accept, unsigned long timeoutMs,
+                       int* status, String* contentType);
+  static int _readByte(unsigned long timeoutMs);
+  static int _readBodyByte(unsigned long timeoutMs);
+  static int _readLine(String& line, unsigned long timeoutMs, bool body);
+  static bool _readBody(String& body);
+  static bool _runStream();
+  static void _runLongPoll();
+  static bool _deliver(const String& json);
+  static void _setConnected(bool connected);
+  static void _scheduleReconnect();
+  static void _taskLoop(void* param);
+};
+
+// Read results (negative; bytes are 0-255)
+#define CHANNEL_READ_TIMEOUT -1
+#define CHANNEL_READ_CLOSED -2
+#define CHANNEL_READ_END -3          // End of a Content-Length or chunked body
+
+// Inbox slot states
+#define CHANNEL_SLOT_FREE 0
+#define CHANNEL_SLOT_FILLING 1       // Being written by the channel task
+#define CHANNEL_SLOT_READY 2
+#define CHANNEL_SLOT_READING 3       // Being copied out by receive()
+
+// Implementation
+TaskHandle_t CommandChannel::_task = nullptr;
+String CommandChannel::_serverURL = DASHBOARD_URL;
+String CommandChannel::_apiKey = API_KEY;
+bool CommandChannel::_sslEnabled = SSL_ENABLED;
+String CommandChannel::_serverHost = "";
+uint16_t CommandChannel::_serverPort = 443;
+String CommandChannel::_basePath = "";
+ResumableTLSClient CommandChannel::_secureClient;
+WiFiClient CommandChannel::_plainClient;
+volatile bool CommandChannel::_connected = false;
+volatile uint8_t CommandChannel::_mode = COMMAND_CHANNEL_STREAM;
+unsigned long CommandChannel::_connectedSince = 0;
+unsigned long CommandChannel::_streamRetryMillis = 0;
+unsigned long CommandChannel::_backoffMs = 0;
+unsigned long CommandChannel::_nextConnectMillis = 0;
+bool CommandChannel::_chunked = false;
+long CommandChannel::_remaining = -1;
+bool CommandChannel::_closeAfter = false;
+portMUX_TYPE CommandChannel::_inboxMux = portMUX_INITIALIZER_UNLOCKED;
+uint8_t CommandChannel::_inboxState[COMMAND_CHANNEL_SLOTS] = {};
+uint32_t CommandChannel::_inboxSeq[COMMAND_CHANNEL_SLOTS] = {};
+char CommandChannel::_inbox[COMMAND_CHANNEL_SLOTS][COMMAND_CHANNEL_MAX_BYTES + 1];
+uint32_t CommandChannel::_nextSeq = 0;
+char CommandChannel::_lastEventId[COMMAND_EVENT_ID_BYTES] = "";
+CommandChannelStats CommandChannel::_stats = {};
+unsigned long CommandChannel::_statsSince = 0;
+
+bool CommandChannel::begin() {
+  if (_task) {
+    return true;
+  }
+  
+  if (!_parseServerURL()) {
+    Serial.println("Invalid server URL: " + _serverURL);
+    return false;
+  }
+  
+  // Configure SSL if enabled
+  if (_sslEnabled) {
+    _secureClient.setInsecure(); // For development - use proper certificates in production
+  }
+  
+  _statsSince = millis();
+  BaseType_t created = xTaskCreatePinnedToCore(_taskLoop, "api_cmd", COMMAND_CHANNEL_STACK, nullptr,
+                                               COMMAND_CHANNEL_PRIORITY, &_task, COMMAND_CHANNEL_CORE);
+  if (created != pdPASS) {
+    _task = nullptr;
+    Serial.println("Failed to start command channel task");
+    return false;
+  }
+  
+  Serial.println("Command channel started on core " + String(COMMAND_CHANNEL_CORE));
+  return true;
+}
+
+bool CommandChannel::receive(String& commandJson) {
+  // Oldest command first
+  int index = -1;
+  portENTER_CRITICAL(&_inboxMux);
+  for (int i = 0; i < COMMAND_CHANNEL_SLOTS; i++) {
+    if (_inboxState[i] == CHANNEL_SLOT_READY &&
+        (index < 0 || (int32_t)(_inboxSeq[i] - _inboxSeq[index]) < 0)) {
+      index = i;
+    }
+  }
+  if (index >= 0) {
+    _inboxState[index] = CHANNEL_SLOT_READING;
+  }
+  portEXIT_CRITICAL(&_inboxMux);
+  if (index < 0) {
+    return false;
+  }
+  
+  commandJson = _inbox[index];
+  
+  portENTER_CRITICAL(&_inboxMux);
+  _inboxState[index] = CHANNEL_SLOT_FREE;
+  portEXIT_CRITICAL(&_inboxMux);
+  return true;
+}
+
+bool CommandChannel::isConnected() {
+  return _connected;
+}
+
+CommandChannelMode CommandChannel::getMode() {
+  return (CommandChannelMode)_mode;
+}
+
+void CommandChannel::setServerURL(const String& serverURL) {
+  _serverURL = serverURL;
+  _parseServerURL();
+}
+
+void CommandChannel::setAPIKey(const String& apiKey) {
+  _apiKey = apiKey;
+}
+
+void CommandChannel::enableSSL(bool enable) {
+  _sslEnabled = enable;
+  _parseServerURL();
+}
+
+// Status and monitoring methods
+
+CommandChannelStats CommandChannel::getStats() {
+  CommandChannelStats stats = _stats;
+  unsigned long elapsed = millis() - _statsSince;
+  stats.requests_per_hour = elapsed ? (uint32_t)((uint64_t)stats.requests * 3600000UL / elapsed) : 0;
+  stats.connected_ms = _connected ? millis() - _connectedSince : 0;
+  return stats;
+}
+
+void CommandChannel::resetStats() {
+  memset(&_stats, 0, sizeof(_stats));
+  _statsSince = millis();
+}
+
+void CommandChannel::printStats() {
+  CommandChannelStats stats = getStats();
+  String mode = _mode == COMMAND_CHANNEL_STREAM ? "stream" : "long-poll";
+  Serial.println("Command channel: " + mode + (_connected ?
+                 " (up " + String(stats.connected_ms / 1000) + " s)" : " (down)"));
+  Serial.println("  Requests: " + String(stats.requests) + " (" + String(stats.requests_per_hour) +
+                 "/hour), connects " + String(stats.connects) + ", failures " + String(stats.failures));
+  Serial.println("  Commands: " + String(stats.commands) + ", dropped " + String(stats.dropped) +
+                 ", heartbeats " + String(stats.heartbeats) + ", timeouts " + String(stats.timeouts));
+}
+
+// Private helper methods
+
+bool CommandChannel::_parseServerURL() {
+  // scheme://host[:port][/path]; the path prefixes every endpoint
+  int hostStart = _serverURL.indexOf("://");
+  hostStart = hostStart < 0 ? 0 : hostStart + 3;
+  int hostEnd = _serverURL.indexOf('/', hostStart);
+  String authority = hostEnd < 0 ? _serverURL.substring(hostStart) : _serverURL.substring(hostStart, hostEnd);
+  _basePath = hostEnd < 0 ? "" : _serverURL.substring(hostEnd);
+  if (_basePath.endsWith("/")) {
+    _basePath.remove(_basePath.length() - 1);
+  }
+  
+  int colon = authority.indexOf(':');
+  _serverHost = colon < 0 ? authority : authority.substring(0, colon);
+  _serverPort = colon < 0 ? (_sslEnabled ? 443 : 80) : authority.substring(colon + 1).toInt();
+  return _serverHost.length() > 0 && _serverPort > 0;
+}
+
+WiFiClient& CommandChannel::_client() {
+  if (_sslEnabled) {
+    return _secureClient;
+  }
+  return _plainClient;
+}
+
+bool CommandChannel::_request(const String& path, const char* accept, unsigned long timeoutMs,
+                              int* status, String* contentType) {
+  // GET on the channel's own connection, then reads the status line and headers
+  WiFiClient& client = _client();
+  if (!client.connected()) {
+    _stats.connects++;
+    if (!client.connect(_serverHost.c_str(), _serverPort, REQUEST_TIMEOUT_MS)) {
+      _stats.failures++;
+      return false;
+    }
+  }
+  
+  String head = "GET " + _basePath + path + " HTTP/1.1\r\n";
+  head += "Host: " + _serverHost + "\r\n";
+  head += "Authorization: Bearer " + _apiKey + "\r\n";
+  head += "User-Agent: EV-Secure-ESP32/" + String(DEVICE_VERSION) + "\r\n";
+  head += "Accept: " + String(accept) + "\r\n";
+  if (_lastEventId[0] && path == COMMAND_STREAM_ENDPOINT) {
+    head += "Last-Event-ID: " + String(_lastEventId) + "\r\n";
+  }
+  head += "Cache-Control: no-cache\r\n\r\n";
+  _stats.requests++;
+  if (client.write((const uint8_t*)head.c_str(), head.length()) != head.length()) {
+    client.stop();
+    _stats.failures++;
+    return false;
+  }
+  
+  String line;
+  if (_readLine(line, timeoutMs, false) < 0 || !line.startsWith("HTTP/1.")) {
+    client.stop();
+    _stats.failures++;
+    return false;
+  }
+  *status = line.substring(9, 12).toInt();
+  
+  _chunked = false;
+  _remaining = -1;
+  _closeAfter = false;
+  *contentType = "";
+  for (;;) {
+    if (_readLine(line, REQUEST_TIMEOUT_MS, false) < 0) {
+      client.stop();
+      _stats.failures++;
+      return false;
+    }
+    if (line.length() == 0) {
+      break;
+    }
+  
+    line.toLowerCase();
+    if (line.startsWith("content-length:")) {
+      _remaining = line.substring(15).toInt();
+    } else if (line.startsWith("transfer-encoding:") && line.indexOf("chunked") > 0) {
+      _chunked = true;
+      _remaining = 0;
+    } else if (line.startsWith("content-type:")) {
+      *contentType = line.substring(13);
+      contentType->trim();
+    } else if (line.startsWith("connection:") && line.indexOf("close") > 0) {
+      _closeAfter = true;
+    }
+  }
+  return true;
+}
+
+int CommandChannel::_readByte(unsigned long timeoutMs) {
+  WiFiClient& client = _client();
+  unsigned long start = millis();
+  for (;;) {
+    if (client.available()) {
+      uint8_t byte;
+      if (client.read(&byte, 1) == 1) {
+        return byte;
+      }
+    }
+    if (!client.connected()) {
+      return CHANNEL_READ_CLOSED;
+    }
+    if (millis() - start >= timeoutMs) {
+      return CHANNEL_READ_TIMEOUT;
+    }
+    delay(COMMAND_CHANNEL_READ_POLL_MS);
+  }
+}
+
+int CommandChannel::_readBodyByte(unsigned long timeoutMs) {
+  // Undoes chunked transfer encoding (used by the event stream)
+  if (_chunked && _remaining == 0) {
+    String size;
+    do {
+      int result = _readLine(size, timeoutMs, false);  // Skips the CRLF ending the previous chunk
+      if (result < 0) {
+        return result;
+      }
+    } while (size.length() == 0);
+  
+    _remaining = strtol(size.c_str(), nullptr, 16);
+    if (_remaining == 0) {
+      // Last chunk: skip trailers up to the blank line so the connection can be reused
+      do {
+        if (_readLine(size, REQUEST_TIMEOUT_MS, false) < 0) {
+          return CHANNEL_READ_CLOSED;
+        }
+      } while (size.length() > 0);
+      _chunked = false;
+      return CHANNEL_READ_END;
+    }
+  }
+  if (_remaining == 0) {
+    return CHANNEL_READ_END;
+  }
+  
+  int byte = _readByte(timeoutMs);
+  if (byte >= 0 && _remaining > 0) {
+    _remaining--;
+  }
+  return byte;
+}
+
+int CommandChannel::_readLine(String& line, unsigned long timeoutMs, bool body) {
+  // timeoutMs bounds the wait for each byte, so a heartbeat resets it
+  line = "";
+  for (;;) {
+    int byte = body ? _readBodyByte(timeoutMs) : _readByte(timeoutMs);
+    if (byte < 0) {
+      return byte;
+    }
+    if (byte == '\n') {
+      return 0;
+    }
+    if (byte != '\r' && line.length() <= COMMAND_CHANNEL_MAX_BYTES) {
+      line += (char)byte;
+    }
+  }
+}
+
+bool CommandChannel::_readBody(String& body) {
+  // Long-poll response; false if the connection failed before the body ended
+  body = "";
+  for (;;) {
+    int byte = _readBodyByte(REQUEST_TIMEOUT_MS);
+    if (byte == CHANNEL_READ_END) {
+      return true;
+    }
+    if (byte < 0) {
+      // A body without length or chunking ends when the server closes
+      return byte == CHANNEL_READ_CLOSED && !_chunked && _remaining < 0;
+    }
+    if (body.length() <= COMMAND_CHANNEL_MAX_BYTES) {
+      body += (char)byte;
+    }
+  }
+}
+
+bool CommandChannel::_runStream() {
+  // Returns when the stream ends; false if the dashboard serves no stream
+  int status = 0;
+  String contentType;
+  if (!_request(COMMAND_STREAM_ENDPOINT, "text/event-stream", REQUEST_TIMEOUT_MS, &status, &contentType)) {
+    _scheduleReconnect();
+    return true;
+  }
+  
+  if (status != HTTP_OK || !contentType.startsWith("text/event-stream")) {
+    _client().stop();
+    if (status == HTTP_OK || status == HTTP_NOT_FOUND || status == 405) {
+      return false;
+    }
+    Serial.println("Command stream refused: HTTP " + String(status));
+    _stats.failures++;
+    _scheduleReconnect();
+    return true;
+  }
+  
+  unsigned long opened = millis();
+  _setConnected(true);
+  
+  // Events are "field: value" lines ended by a blank line; ":" lines are heartbeats
+  String line;
+  String event;
+  String id;
+  String data;
+  for (;;) {
+    int result = _readLine(line, COMMAND_HEARTBEAT_TIMEOUT_MS, true);
+    if (result == CHANNEL_READ_TIMEOUT) {
+      Serial.println("Command stream silent - reconnecting");
+      _stats.timeouts++;
+      break;
+    }
+    if (result < 0) {
+      break;
+    }
+  
+    if (line.length() == 0) {
+      if (event == "command" && data.length() > 0 && _deliver(data) && id.length() < COMMAND_EVENT_ID_BYTES) {
+        strcpy(_lastEventId, id.c_str());
+      }
+      event = "";
+      id = "";
+      data = "";
+    } else if (line[0] == ':') {
+      _stats.heartbeats++;
+    } else if (line.startsWith("event:")) {
+      event = line.substring(6);
+      event.trim();
+    } else if (line.startsWith("id:")) {
+      id = line.substring(3);
+      id.trim();
+    } else if (line.startsWith("data:")) {
+      if (data.length() > 0) {
+        data += '\n';
+      }
+      data += line.substring(line.startsWith("data: ") ? 6 : 5);
+    }
+  }
+  
+  _client().stop();
+  _setConnected(false);
+  // The server ends each stream after a few minutes; reopen at once unless it ended early
+  if (millis() - opened < COMMAND_STREAM_MIN_MS) {
+    _scheduleReconnect();
+  } else {
+    _backoffMs = 0;
+  }
+  return true;
+}
+
+void CommandChannel::_runLongPoll() {
+  int status = 0;
+  String contentType;
+  String path = String(API_COMMANDS_ENDPOINT) + "?wait=" + String(COMMAND_LONG_POLL_SECONDS);
+  unsigned long start = millis();
+  if (!_request(path, "application/json", COMMAND_LONG_POLL_SECONDS * 1000UL + REQUEST_TIMEOUT_MS,
+                &status, &contentType)) {
+    _setConnected(false);
+    _scheduleReconnect();
+    return;
+  }
+  
+  String body;
+  bool complete = _readBody(body);
+  if (!complete || _closeAfter) {
+    _client().stop();
+  }
+  if (!complete || status != HTTP_OK) {
+    _stats.failures++;
+    _setConnected(false);
+    _scheduleReconnect();
+    return;
+  }
+  
+  _setConnected(true);
+  _backoffMs = 0;
+  if (body.indexOf("\"command\":null") < 0) {
+    _deliver(body);
+  } else if (millis() - start < COMMAND_LONG_POLL_SECONDS * 500UL) {
+    // The server answered an empty poll without holding it: poll at the normal rate
+    delay(COMMAND_CHECK_INTERVAL);
+  }
+}
+
+bool CommandChannel::_deliver(const String& json) {
+  // A dropped command is resent by the dashboard (it was never acknowledged)
+  if (json.length() > COMMAND_CHANNEL_MAX_BYTES) {
+    _stats.dropped++;
+    Serial.println("Command too long (" + String(json.length()) + " bytes) - dropped");
+    return false;
+  }
+  
+  // A burst (commands queued while disconnected) waits here for loop() to take
+  // the earlier ones; the rest stay in the socket meanwhile
+  int index = -1;
+  unsigned long start = millis();
+  for (;;) {
+    portENTER_CRITICAL(&_inboxMux);
+    for (int i = 0; i < COMMAND_CHANNEL_SLOTS; i++) {
+      if (_inboxState[i] == CHANNEL_SLOT_FREE) {
+        index = i;
+        _inboxState[i] = CHANNEL_SLOT_FILLING;
+        _inboxSeq[i] = _nextSeq++;
+        break;
+      }
+    }
+    portEXIT_CRITICAL(&_inboxMux);
+    if (index >= 0) {
+      break;
+    }
+    if (millis() - start >= COMMAND_INBOX_WAIT_MS) {
+      _stats.dropped++;
+      Serial.println("Command inbox full - command dropped");
+      return false;
+    }
+    delay(COMMAND_CHANNEL_READ_POLL_MS);
+  }
+  
+  // Filling slots are only touched by this task, so the copy is made outside the lock
+  memcpy(_inbox[index], json.c_str(), json.length() + 1);
+  
+  portENTER_CRITICAL(&_inboxMux);
+  _inboxState[index] = CHANNEL_SLOT_READY;
+  portEXIT_CRITICAL(&_inboxMux);
+  _stats.commands++;
+  return true;
+}
+
+void CommandChannel::_setConnected(bool connected) {
+  if (connected && !_connected) {
+    _connectedSince = millis();
+  }
+  _connected = connected;
+}
+
+void CommandChannel::_scheduleReconnect() {
+  // Same policy as the API connection: exponential backoff with jitter
+  _backoffMs = _backoffMs == 0 ? API_BACKOFF_MIN_MS : min(_backoffMs * 2, (unsigned long)API_BACKOFF_MAX_MS);
+  _nextConnectMillis = millis() + _backoffMs + random(_backoffMs / 4 + 1);
+}
+
+void CommandChannel::_taskLoop(void* param) {
+  (void)param;
+  
+  for (;;) {
+    if (WiFi.status() != WL_CONNECTED) {
+      _client().stop();
+      _setConnected(false);
+      delay(1000);
+      continue;
+    }
+    if (_backoffMs > 0 && (long)(millis() - _nextConnectMillis) < 0) {
+      delay(min(_nextConnectMillis - millis(), (unsigned long)1000));
+      continue;
+    }
+  
+    if (_mode == COMMAND_CHANNEL_STREAM) {
+      if (!_runStream()) {
+        Serial.println("Command stream not available - using long-poll");
+        _mode = COMMAND_CHANNEL_LONG_POLL;
+        _streamRetryMillis = millis() + COMMAND_STREAM_RETRY_MS;
+      }
+    } else {
+      _runLongPoll();
+      if ((long)(millis() - _streamRetryMillis) >= 0) {
+        _client().stop();
+        _mode = COMMAND_CHANNEL_STREAM;
+      }
+    }
+  }
+}
+
+#endif // COMMAND_CHANNEL_H
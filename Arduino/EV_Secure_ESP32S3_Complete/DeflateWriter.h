@@ -0,0 +1,597 @@
+/*
+ * DeflateWriter.h - Streaming gzip Encoder into a Fixed Buffer
+ *
+ * This library compresses a byte stream into a gzip member (RFC 1952 around
+ * an RFC 1951 deflate stream) in a caller-owned buffer, without heap
+ * allocation. Batched telemetry and logs repeat the same keys and change
+ * slowly from sample to sample, so they shrink several times over.
+ *
+ * Features:
+ * - Streaming: write() any number of chunks, then finish(); it is a Print,
+ *   so serializeJson() can write into it
+ * - LZ77 over a DEFLATE_WINDOW byte window with hash chains (at most
+ *   DEFLATE_MAX_CHAIN candidates per position)
+ * - Blocks of DEFLATE_BLOCK_SYMBOLS matches/literals, each with Huffman
+ *   codes built for it (or the fixed codes when they come out smaller)
+ * - Window and hash tables are static: one writer at a time (APIManager only
+ *   uses it on the network task)
+ * - Overflow is sticky: check overflowed() once after finish()
+ *
+ * Usage:
+ * 1. DeflateWriter out(buffer, sizeof(buffer))
+ * 2. out.write(data, length) as often as needed
+ * 3. out.finish(), then send out.data() / out.length() with
+ *    "Content-Encoding: gzip" unless out.overflowed()
+ */
+
+#ifndef DEFLATE_WRITER_H
+#define DEFLATE_WRITER_H
+
+#include <Arduino.h>
+#include "ModelStore.h"
+
+// Compression
+#define DEFLATE_WINDOW 2048          // Longest match distance; the buffer holds two windows
+#define DEFLATE_HASH_BITS 10
+#define DEFLATE_MAX_CHAIN 16         // Match candidates tried per position
+#define DEFLATE_BLOCK_SYMBOLS 2048   // Matches/literals per block (3 bytes each)
+#define DEFLATE_MIN_MATCH 3
+#define DEFLATE_MAX_MATCH 258
+#define DEFLATE_NIL -1
+
+// Huffman codes (RFC 1951 3.2.5 - 3.2.7)
+#define DEFLATE_LITERALS 288         // Literal/length alphabet; 286 and 287 never occur
+#define DEFLATE_DISTANCES 30
+#define DEFLATE_CODE_LENGTHS 19      // Alphabet of the code lengths in a block header
+#define DEFLATE_MAX_BITS 15
+#define DEFLATE_MAX_LENGTH_BITS 7    // Longest code of the code length alphabet
+
+class DeflateWriter : public Print {
+public:
+  DeflateWriter(uint8_t* buffer, size_t capacity);
+  
+  // Input
+  using Print::write;
+  size_t write(uint8_t byte) override;
+  size_t write(const uint8_t* data, size_t length) override;
+  void finish();
+  
+  // Result
+  const uint8_t* data() const;
+  size_t length() const;
+  size_t inputLength() const;
+  bool overflowed() const;
+  
+private:
+  uint8_t* _buffer;
+  size_t _capacity;
+  size_t _length;
+  bool _overflow;
+  bool _finished;
+  uint32_t _bits;
+  int _bitCount;
+  uint32_t _crc;
+  size_t _inputLength;
+  int _start;                  // Next window byte to encode
+  int _end;                    // Bytes in the window
+  int _symbols;                // Matches/literals of the current block
+  
+  static uint8_t _window[2 * DEFLATE_WINDOW];
+  static int16_t _head[1 << DEFLATE_HASH_BITS];
+  static int16_t _prev[DEFLATE_WINDOW];
+  
+  // Current block
+  static uint8_t _symbolLength[DEFLATE_BLOCK_SYMBOLS];    // Literal byte, or match length - 3
+  static uint16_t _symbolDistance[DEFLATE_BLOCK_SYMBOLS]; // 0 for a literal
+  static uint16_t _literalFreq[DEFLATE_LITERALS];
+  static uint16_t _distanceFreq[DEFLATE_DISTANCES];
+  static uint8_t _literalBits[DEFLATE_LITERALS];
+  static uint16_t _literalCode[DEFLATE_LITERALS];         // Bit-reversed, ready for _putBits()
+  static uint8_t _distanceBits[DEFLATE_DISTANCES];
+  static uint16_t _distanceCode[DEFLATE_DISTANCES];
+  
+  static const uint16_t _lengthBase[29];
+  static const uint8_t _lengthExtra[29];
+  static const uint16_t _distanceBase[30];
+  static const uint8_t _distanceExtra[30];
+  
+  void _compress(bool flush);
+  void _slide();
+  uint32_t _hash(int pos) const;
+  void _insert(int pos);
+  int _longestMatch(int pos, int avail, int* distance);
+  void _tally(int length, int distance);
+  void _flushBlock(bool last);
+  static int _lengthSymbol(int length);
+  static int _distanceSymbol(int distance);
+  static void _buildLengths(const uint16_t* freq, int count, int maxBits, uint8_t* bits);
+  static void _assignCodes(const uint8_t* bits, uint16_t* codes, int count);
+  void _putBits(uint32_t value, int bits);
+  void _put(uint8_t byte);
+};
+
+// Implementation
+uint8_t DeflateWriter::_window[2 * DEFLATE_WINDOW];
+int16_t DeflateWriter::_head[1 << DEFLATE_HASH_BITS];
+int16_t DeflateWriter::_prev[DEFLATE_WINDOW];
+uint8_t DeflateWriter::_symbolLength[DEFLATE_BLOCK_SYMBOLS];
+uint16_t DeflateWriter::_symbolDistance[DEFLATE_BLOCK_SYMBOLS];
+uint16_t DeflateWriter::_literalFreq[DEFLATE_LITERALS];
+uint16_t DeflateWriter::_distanceFreq[DEFLATE_DISTANCES];
+uint8_t DeflateWriter::_literalBits[DEFLATE_LITERALS];
+uint16_t DeflateWriter::_literalCode[DEFLATE_LITERALS];
+uint8_t DeflateWriter::_distanceBits[DEFLATE_DISTANCES];
+uint16_t DeflateWriter::_distanceCode[DEFLATE_DISTANCES];
+
+const uint16_t DeflateWriter::_lengthBase[29] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+const uint8_t DeflateWriter::_lengthExtra[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+const uint16_t DeflateWriter::_distanceBase[30] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+const uint8_t DeflateWriter::_distanceExtra[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+DeflateWriter::DeflateWriter(uint8_t* buffer, size_t capacity)
+  : _buffer(buffer), _capacity(capacity), _length(0), _overflow(false), _finished(false),
+    _bits(0), _bitCount(0), _crc(0), _inputLength(0), _start(0), _end(0), _symbols(0) {
+  memset(_head, 0xFF, sizeof(_head));   // DEFLATE_NIL
+  memset(_literalFreq, 0, sizeof(_literalFreq));
+  memset(_distanceFreq, 0, sizeof(_distanceFreq));
+  
+  // gzip header: deflate, no name or time, unknown OS
+  static const uint8_t header[10] = {0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF};
+  for (size_t i = 0; i < sizeof(header); i++) {
+    _put(header[i]);
+  }
+}
+
+size_t DeflateWriter::write(uint8_t byte) {
+  return write(&byte, 1);
+}
+
+size_t DeflateWriter::write(const uint8_t* data, size_t length) {
+  if (_finished || _overflow) {
+    return 0;
+  }
+  
+  _crc = ModelStore::crc32(data, length, _crc);
+  _inputLength += length;
+  size_t done = 0;
+  while (done < length) {
+    if (_end == 2 * DEFLATE_WINDOW) {
+      _slide();
+    }
+    size_t n = min(length - done, (size_t)(2 * DEFLATE_WINDOW - _end));
+    memcpy(_window + _end, data + done, n);
+    _end += n;
+    done += n;
+    _compress(false);
+  }
+  return length;
+}
+
+void DeflateWriter::finish() {
+  if (_finished) {
+    return;
+  }
+  
+  _compress(true);
+  _flushBlock(true);
+  if (_bitCount > 0) {
+    _putBits(0, 8 - _bitCount);
+  }
+  
+  // Trailer: CRC-32 and length of the input, little-endian
+  for (int i = 0; i < 4; i++) {
+    _put(_crc >> (8 * i));
+  }
+  for (int i = 0; i < 4; i++) {
+    _put(_inputLength >> (8 * i));
+  }
+  _finished = true;
+}
+
+const uint8_t* DeflateWriter::data() const {
+  return _buffer;
+}
+
+size_t DeflateWriter::length() const {
+  return _length;
+}
+
+size_t DeflateWriter::inputLength() const {
+  return _inputLength;
+}
+
+bool DeflateWriter::overflowed() const {
+  return _overflow;
+}
+
+void DeflateWriter::_compress(bool flush) {
+  // Encodes while a full match can still be seen ahead (all of it on flush)
+  while (_start < _end && (flush || _end - _start > DEFLATE_MAX_MATCH) && !_overflow) {
+    int avail = min(_end - _start, DEFLATE_MAX_MATCH);
+    int distance = 0;
+    int length = _longestMatch(_start, avail, &distance);
+    if (length >= DEFLATE_MIN_MATCH) {
+      _tally(length, distance);
+      for (int i = 1; i < length; i++) {
+        _insert(_start + i);
+      }
+      _start += length;
+    } else {
+      _tally(_window[_start], 0);
+      _start++;
+    }
+  }
+}
+
+void DeflateWriter::_slide() {
+  // Drops the older window; everything encoded stays reachable as a match
+  memmove(_window, _window + DEFLATE_WINDOW, _end - DEFLATE_WINDOW);
+  _start -= DEFLATE_WINDOW;
+  _end -= DEFLATE_WINDOW;
+  for (size_t i = 0; i < sizeof(_head) / sizeof(_head[0]); i++) {
+    _head[i] = _head[i] >= DEFLATE_WINDOW ? _head[i] - DEFLATE_WINDOW : DEFLATE_NIL;
+  }
+  for (int i = 0; i < DEFLATE_WINDOW; i++) {
+    _prev[i] = _prev[i] >= DEFLATE_WINDOW ? _prev[i] - DEFLATE_WINDOW : DEFLATE_NIL;
+  }
+}
+
+uint32_t DeflateWriter::_hash(int pos) const {
+  // Of the 3 bytes at pos
+  return ((_window[pos] << 10) ^ (_window[pos + 1] << 5) ^ _window[pos + 2]) & ((1 << DEFLATE_HASH_BITS) - 1);
+}
+
+void DeflateWriter::_insert(int pos) {
+  if (pos + DEFLATE_MIN_MATCH > _end) {
+    return;
+  }
+  
+  uint32_t hash = _hash(pos);
+  _prev[pos & (DEFLATE_WINDOW - 1)] = _head[hash];
+  _head[hash] = pos;
+}
+
+int DeflateWriter::_longestMatch(int pos, int avail, int* distance) {
+  // Walks the chain of earlier positions with the same 3-byte hash, newest
+  // first, then adds pos to it
+  int best = 0;
+  if (avail >= DEFLATE_MIN_MATCH) {
+    int candidate = _head[_hash(pos)];
+    for (int chain = 0; chain < DEFLATE_MAX_CHAIN && candidate != DEFLATE_NIL &&
+         pos - candidate <= DEFLATE_WINDOW; chain++) {
+      if (_window[candidate + best] == _window[pos + best]) {
+        int length = 0;
+        while (length < avail && _window[candidate + length] == _window[pos + length]) {
+          length++;
+        }
+        if (length > best) {
+          best = length;
+          *distance = pos - candidate;
+          if (length == avail) {
+            break;
+          }
+        }
+      }
+  
+      // Older chain entries may be stale once the window has wrapped
+      int next = _prev[candidate & (DEFLATE_WINDOW - 1)];
+      if (next >= candidate) {
+        break;
+      }
+      candidate = next;
+    }
+  }
+  
+  _insert(pos);
+  return best;
+}
+
+void DeflateWriter::_tally(int length, int distance) {
+  // A literal byte (distance 0) or a match, kept until the block is full
+  if (distance == 0) {
+    _symbolLength[_symbols] = length;
+    _literalFreq[length]++;
+  } else {
+    _symbolLength[_symbols] = length - DEFLATE_MIN_MATCH;
+    _literalFreq[257 + _lengthSymbol(length)]++;
+    _distanceFreq[_distanceSymbol(distance)]++;
+  }
+  _symbolDistance[_symbols] = distance;
+  if (++_symbols == DEFLATE_BLOCK_SYMBOLS) {
+    _flushBlock(false);
+  }
+}
+
+void DeflateWriter::_flushBlock(bool last) {
+  _literalFreq[256] = 1;                // End of block
+  _buildLengths(_literalFreq, DEFLATE_LITERALS, DEFLATE_MAX_BITS, _literalBits);
+  _buildLengths(_distanceFreq, DEFLATE_DISTANCES, DEFLATE_MAX_BITS, _distanceBits);
+  int literals = 286;
+  while (literals > 257 && _literalBits[literals - 1] == 0) {
+    literals--;
+  }
+  int distances = DEFLATE_DISTANCES;
+  while (distances > 1 && _distanceBits[distances - 1] == 0) {
+    distances--;
+  }
+  
+  // The header sends both code length lists as one sequence, runs as
+  // 16 (repeat the previous 3-6 times), 17 (3-10 zeros) and 18 (11-138 zeros)
+  uint8_t lengths[286 + DEFLATE_DISTANCES];
+  memcpy(lengths, _literalBits, literals);
+  memcpy(lengths + literals, _distanceBits, distances);
+  int total = literals + distances;
+  uint8_t runSymbol[286 + DEFLATE_DISTANCES];
+  uint8_t runExtra[286 + DEFLATE_DISTANCES];
+  uint16_t lengthFreq[DEFLATE_CODE_LENGTHS] = {0};
+  int runs = 0;
+  for (int i = 0; i < total; ) {
+    int value = lengths[i];
+    int run = 1;
+    while (i + run < total && lengths[i + run] == value) {
+      run++;
+    }
+    if (value == 0 && run >= 3) {
+      run = min(run, 138);
+      runSymbol[runs] = run <= 10 ? 17 : 18;
+      runExtra[runs] = run - (run <= 10 ? 3 : 11);
+    } else if (value != 0 && i > 0 && lengths[i - 1] == value && run >= 3) {
+      run = min(run, 6);
+      runSymbol[runs] = 16;
+      runExtra[runs] = run - 3;
+    } else {
+      run = 1;
+      runSymbol[runs] = value;
+      runExtra[runs] = 0;
+    }
+    lengthFreq[runSymbol[runs++]]++;
+    i += run;
+  }
+  
+  static const uint8_t order[DEFLATE_CODE_LENGTHS] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+  };
+  uint8_t lengthBits[DEFLATE_CODE_LENGTHS];
+  uint16_t lengthCode[DEFLATE_CODE_LENGTHS];
+  _buildLengths(lengthFreq, DEFLATE_CODE_LENGTHS, DEFLATE_MAX_LENGTH_BITS, lengthBits);
+  int lengthCodes = DEFLATE_CODE_LENGTHS;
+  while (lengthCodes > 4 && lengthBits[order[lengthCodes - 1]] == 0) {
+    lengthCodes--;
+  }
+  
+  // Dynamic codes unless the fixed ones (no header) come out as small;
+  // extra bits are the same either way
+  static const uint8_t runExtraBits[3] = {2, 3, 7};
+  uint32_t dynamicBits = 14 + 3 * lengthCodes;
+  uint32_t fixedBits = 0;
+  for (int i = 0; i < runs; i++) {
+    dynamicBits += lengthBits[runSymbol[i]] + (runSymbol[i] >= 16 ? runExtraBits[runSymbol[i] - 16] : 0);
+  }
+  for (int i = 0; i < 286; i++) {
+    dynamicBits += _literalFreq[i] * _literalBits[i];
+    fixedBits += _literalFreq[i] * (i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8);
+  }
+  for (int i = 0; i < DEFLATE_DISTANCES; i++) {
+    dynamicBits += _distanceFreq[i] * _distanceBits[i];
+    fixedBits += _distanceFreq[i] * 5;
+  }
+  
+  _putBits(last ? 1 : 0, 1);
+  if (dynamicBits < fixedBits) {
+    _putBits(2, 2);
+    _putBits(literals - 257, 5);
+    _putBits(distances - 1, 5);
+    _putBits(lengthCodes - 4, 4);
+    for (int i = 0; i < lengthCodes; i++) {
+      _putBits(lengthBits[order[i]], 3);
+    }
+    _assignCodes(lengthBits, lengthCode, DEFLATE_CODE_LENGTHS);
+    for (int i = 0; i < runs; i++) {
+      _putBits(lengthCode[runSymbol[i]], lengthBits[runSymbol[i]]);
+      if (runSymbol[i] >= 16) {
+        _putBits(runExtra[i], runExtraBits[runSymbol[i] - 16]);
+      }
+    }
+  } else {
+    _putBits(1, 2);
+    for (int i = 0; i < DEFLATE_LITERALS; i++) {
+      _literalBits[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+    }
+    memset(_distanceBits, 5, sizeof(_distanceBits));
+  }
+  _assignCodes(_literalBits, _literalCode, DEFLATE_LITERALS);
+  _assignCodes(_distanceBits, _distanceCode, DEFLATE_DISTANCES);
+  
+  for (int i = 0; i < _symbols && !_overflow; i++) {
+    int distance = _symbolDistance[i];
+    if (distance == 0) {
+      _putBits(_literalCode[_symbolLength[i]], _literalBits[_symbolLength[i]]);
+      continue;
+    }
+    int length = _symbolLength[i] + DEFLATE_MIN_MATCH;
+    int symbol = _lengthSymbol(length);
+    _putBits(_literalCode[257 + symbol], _literalBits[257 + symbol]);
+    _putBits(length - _lengthBase[symbol], _lengthExtra[symbol]);
+    symbol = _distanceSymbol(distance);
+    _putBits(_distanceCode[symbol], _distanceBits[symbol]);
+    _putBits(distance - _distanceBase[symbol], _distanceExtra[symbol]);
+  }
+  _putBits(_literalCode[256], _literalBits[256]);
+  
+  _symbols = 0;
+  memset(_literalFreq, 0, sizeof(_literalFreq));
+  memset(_distanceFreq, 0, sizeof(_distanceFreq));
+}
+
+int DeflateWriter::_lengthSymbol(int length) {
+  int symbol = 28;
+  while (_lengthBase[symbol] > length) {
+    symbol--;
+  }
+  return symbol;
+}
+
+int DeflateWriter::_distanceSymbol(int distance) {
+  int symbol = 29;
+  while (_distanceBase[symbol] > distance) {
+    symbol--;
+  }
+  return symbol;
+}
+
+void DeflateWriter::_buildLengths(const uint16_t* freq, int count, int maxBits, uint8_t* bits) {
+  // Symbols in use, least frequent first
+  uint16_t symbol[DEFLATE_LITERALS];
+  uint32_t key[DEFLATE_LITERALS];
+  int used = 0;
+  for (int s = 0; s < count; s++) {
+    bits[s] = 0;
+    if (freq[s] == 0) {
+      continue;
+    }
+    int i = used++;
+    while (i > 0 && key[i - 1] > freq[s]) {
+      key[i] = key[i - 1];
+      symbol[i] = symbol[i - 1];
+      i--;
+    }
+    key[i] = freq[s];
+    symbol[i] = s;
+  }
+  
+  // Inflaters want at least two codes, even if one is never sent
+  if (used < 2) {
+    int first = used ? symbol[0] : 0;
+    bits[first] = 1;
+    bits[first == 0 ? 1 : 0] = 1;
+    return;
+  }
+  
+  // Code lengths in place (Moffat and Katajainen): first the parent of
+  // each internal node, then the depths
+  key[0] += key[1];
+  int root = 0;
+  int leaf = 2;
+  for (int next = 1; next < used - 1; next++) {
+    if (leaf >= used || key[root] < key[leaf]) {
+      key[next] = key[root];
+      key[root++] = next;
+    } else {
+      key[next] = key[leaf++];
+    }
+    if (leaf >= used || (root < next && key[root] < key[leaf])) {
+      key[next] += key[root];
+      key[root++] = next;
+    } else {
+      key[next] += key[leaf++];
+    }
+  }
+  key[used - 2] = 0;
+  for (int next = used - 3; next >= 0; next--) {
+    key[next] = key[key[next]] + 1;
+  }
+  uint16_t lengthCount[33] = {0};
+  int available = 1;
+  int depth = 0;
+  root = used - 2;
+  while (available > 0) {
+    int internal = 0;
+    while (root >= 0 && (int)key[root] == depth) {
+      internal++;
+      root--;
+    }
+    if (available > internal) {
+      lengthCount[min(depth, 32)] += available - internal;
+    }
+    available = 2 * internal;
+    depth++;
+  }
+  
+  // Limit to maxBits: fold the longer codes in, then lengthen shorter ones
+  // until the code is complete again
+  for (int b = maxBits + 1; b <= 32; b++) {
+    lengthCount[maxBits] += lengthCount[b];
+  }
+  uint32_t kraft = 0;
+  for (int b = maxBits; b > 0; b--) {
+    kraft += (uint32_t)lengthCount[b] << (maxBits - b);
+  }
+  while (kraft != (1UL << maxBits)) {
+    lengthCount[maxBits]--;
+    for (int b = maxBits - 1; b > 0; b--) {
+      if (lengthCount[b]) {
+        lengthCount[b]--;
+        lengthCount[b + 1] += 2;
+        break;
+      }
+    }
+    kraft--;
+  }
+  
+  // Longest codes to the least frequent symbols
+  int next = 0;
+  for (int b = maxBits; b > 0; b--) {
+    for (int i = 0; i < lengthCount[b]; i++) {
+      bits[symbol[next++]] = b;
+    }
+  }
+}
+
+void DeflateWriter::_assignCodes(const uint8_t* bits, uint16_t* codes, int count) {
+  // Canonical codes (RFC 1951 3.2.2), reversed: Huffman codes go out
+  // most significant bit first
+  uint16_t lengthCount[DEFLATE_MAX_BITS + 1] = {0};
+  for (int i = 0; i < count; i++) {
+    lengthCount[bits[i]]++;
+  }
+  lengthCount[0] = 0;
+  uint16_t nextCode[DEFLATE_MAX_BITS + 1];
+  uint16_t code = 0;
+  for (int b = 1; b <= DEFLATE_MAX_BITS; b++) {
+    code = (code + lengthCount[b - 1]) << 1;
+    nextCode[b] = code;
+  }
+  for (int i = 0; i < count; i++) {
+    if (bits[i] == 0) {
+      continue;
+    }
+    uint16_t value = nextCode[bits[i]]++;
+    uint16_t reversed = 0;
+    for (int b = 0; b < bits[i]; b++) {
+      reversed = (reversed << 1) | ((value >> b) & 1);
+    }
+    codes[i] = reversed;
+  }
+}
+
+void DeflateWriter::_putBits(uint32_t value, int bits) {
+  _bits |= value << _bitCount;
+  _bitCount += bits;
+  while (_bitCount >= 8) {
+    _put(_bits);
+    _bits >>= 8;
+    _bitCount -= 8;
+  }
+}
+
+void DeflateWriter::_put(uint8_t byte) {
+  if (_length >= _capacity) {
+    _overflow = true;
+    return;
+  }
+  _buffer[_length++] = byte;
+}
+
+#endif // DEFLATE_WRITER_H
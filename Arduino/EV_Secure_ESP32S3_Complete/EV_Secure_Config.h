@@ -29,14 +29,15 @@
 // WIFI_SSID and WIFI_PASSWORD are now defined in credentials.h
 #define WIFI_TIMEOUT_MS 10000
 #define WIFI_MAX_RETRIES 6
+#define NTP_SERVER "pool.ntp.org"  // Wall clock for dating telemetry spooled across reboots
 
 // ============================================================================
 // DASHBOARD API CONFIGURATION
 // ============================================================================
 // DASHBOARD_URL and API_KEY are now defined in credentials.h
 #define API_TIMEOUT_MS 10000
-#define DATA_TRANSMISSION_INTERVAL 2000  // Send data every 2 seconds
-#define COMMAND_CHECK_INTERVAL 1000      // Check for commands every 1 second
+#define DATA_TRANSMISSION_INTERVAL 2000  // Sample telemetry every 2 seconds (uploaded in batches)
+#define COMMAND_CHECK_INTERVAL 10000     // Command poll rate when the dashboard does not hold long-polls
 
 // ============================================================================
 // HARDWARE PIN CONFIGURATION (ESP32-S3) - Updated for Your Hardware
@@ -96,11 +97,21 @@
 // ============================================================================
 #define INPUT_FEATURES 6          // Number of input features
 #define MODEL_INPUT_SIZE 6        // Same as INPUT_FEATURES
+#define SENSOR_FEATURES 5         // Continuous inputs: current, voltage, power, frequency, temperature
+#define STATE_FEATURES 6          // One-hot SystemState (STATE_IDLE..STATE_ERROR)
+#define SCALED_FEATURES (SENSOR_FEATURES + STATE_FEATURES) // Normalized input of the neural models
 #define MODEL_OUTPUT_SIZE 1       // Single output (threat probability)
 #define MODEL_ARENA_SIZE 32768    // Tensor arena size in bytes
 #define THREAT_THRESHOLD 0.7      // Threshold for threat detection
 #define CRITICAL_THRESHOLD 0.9    // Threshold for critical threat
 
+// Activation implementations (see FastActivations.h for error bounds)
+#define ACTIVATION_EXACT 0        // libm exp() reference
+#define ACTIVATION_LUT 1          // Flash lookup table with linear interpolation
+#define ACTIVATION_RATIONAL 2     // Rational polynomial approximation
+#define ML_MODEL_ACTIVATION ACTIVATION_RATIONAL    // Activation used by MLModel
+#define ENHANCED_ML_ACTIVATION ACTIVATION_LUT      // Activation used by EnhancedMLModel
+
 // ============================================================================
 // SYSTEM THRESHOLDS
 // ============================================================================
@@ -42,6 +42,9 @@
 #include "DisplayManager.h"
 #include "SDLogger.h"
 #include "APIManager.h"
+#include "CommandChannel.h"
+#include "TelemetryBatcher.h"
+#include "TelemetrySpool.h"
 #include "RelayController.h"
 #include "MLModel.h"
 #include "EnhancedMLModel.h"
@@ -60,6 +63,43 @@ unsigned long lastDisplayUpdate = 0;
 unsigned long sessionStartTime = 0;
 String sessionId = "";
 
+// Dashboard requests in flight (completed by APIManager::poll())
+struct TelemetryUpload {
+  size_t frames;
+  size_t bytes;
+  uint32_t cycles;              // Encode time
+  bool binary;
+};
+struct RecentCommand {
+  String id;
+  int8_t result;                // -1 still running, 0 failed, 1 executed
+  String details;               // Sent again when the dashboard resends the command
+};
+struct ModelDownload {
+  ModelType type;
+  String commandId;             // Acknowledged once the model is staged or rejected
+};
+struct ShadowDownload {
+  ModelType type;
+  void* weights;                // Read on the network task, installed in loop()
+  uint32_t crc;
+  String commandId;             // Acknowledged once the model is installed or rejected
+};
+TelemetryUpload telemetryUpload;
+ModelDownload modelDownload;
+ShadowDownload shadowDownload;
+SpoolBatch spoolBatch;                    // Backlog upload in flight (TelemetrySpool)
+uint8_t msgpackBuffer[TELEMETRY_BINARY_BUFFER];  // The queue copies each payload, so uploads share it
+StaticJsonDocument<2048 + TELEMETRY_JSON_FRAMES_BYTES> telemetryDoc;  // Same for JSON: serialized into the queue
+bool telemetryInFlight = false;
+bool modelDownloadInFlight = false;      // One UPDATE_MODEL at a time: both would stage the same slot
+bool shadowDownloadInFlight = false;
+RecentCommand recentCommands[COMMAND_RECENT_IDS];  // The dashboard resends until acknowledged
+int recentCommandNext = 0;
+bool binaryTelemetry = TELEMETRY_BINARY;  // MessagePack unless the dashboard turned it down
+bool binaryAccepted = false;
+int binaryRejections = 0;                 // 400/500 answers to MessagePack in a row, none accepted yet
+
 // System State (defined in EV_Secure_Config.h)
 SystemState currentState = STATE_IDLE;
 
@@ -72,8 +112,24 @@ void handleEmergencyStop();
 void processMLInference();
 void updateDisplay();
 void logToSD();
+void recordTelemetryFrame();
 void sendToDashboard();
-void checkDashboardCommands();
+void sendBinaryTelemetry();
+void queueTelemetry(bool queued);
+void onTelemetrySent(const APIResponse& response, void* context);
+void drainSpool();
+void onSpoolSent(const APIResponse& response, void* context);
+void processPiggybackedCommands(const String& responseJson);
+void processDashboardCommand(const String& commandJson);
+bool reportCommand(const String& commandId, bool executed, const String& details,
+                   APICallback callback = nullptr, void* context = nullptr);
+bool parseModelType(int value, ModelType* type);
+bool stageDownloadedModel(Stream& body, int length, void* context);
+void onModelDownloaded(const APIResponse& response, void* context);
+bool readShadowDownload(Stream& body, int length, void* context);
+void onShadowDownloaded(const APIResponse& response, void* context);
+void restartAfterAlert(const APIResponse& response, void* context);
+void handleSerialCommands();
 void handleThreatDetection();
 void controlRelay(bool enable);
 void reconnectWiFi();
@@ -144,13 +200,33 @@ void loop() {
     logToSD();
   }
   
-  // Send data to dashboard every 2 seconds
-  if (currentTime - lastDataTransmission >= 2000) {
-    sendToDashboard();
-    checkDashboardCommands();
+  // Sample telemetry every 2 seconds; upload when a batch is due
+  if (currentTime - lastDataTransmission >= DATA_TRANSMISSION_INTERVAL) {
+    recordTelemetryFrame();
+    if (!telemetryInFlight && TelemetryBatcher::shouldFlush()) {
+      sendToDashboard();
+    }
     lastDataTransmission = currentTime;
   }
   
+  // Telemetry and alerts spooled during an outage, paced behind live uploads
+  if (WiFi.status() == WL_CONNECTED && TelemetrySpool::shouldDrain()) {
+    drainSpool();
+  }
+  
+  // Dashboard commands pushed by the command channel (the rest arrive with
+  // telemetry responses, so there is no separate poll)
+  String commandJson;
+  while (CommandChannel::receive(commandJson)) {
+    processDashboardCommand(commandJson);
+  }
+  
+  // Completion callbacks of finished dashboard requests
+  APIManager::poll();
+  
+  // Operator commands on the USB serial console
+  handleSerialCommands();
+  
   // Check for emergency stop button
   handleEmergencyStop();
   
@@ -194,6 +270,9 @@ void setupSystem() {
   // Begin connection (non-blocking). We'll monitor and reconnect in loop()
   WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
   Serial.println("Started WiFi connection in background.");
+  
+  // Wall clock (UTC) once WiFi is up; dates telemetry spooled before a reboot
+  configTime(0, 0, NTP_SERVER);
 }
 
 void initializePeripherals() {
@@ -223,6 +302,15 @@ void initializePeripherals() {
     Serial.println("✗ SD Card initialization failed");
   }
   
+  // Undelivered telemetry and alerts go to the SD card and are sent later
+  if (TelemetrySpool::init()) {
+    TelemetryBatcher::setSpillHandler(TelemetrySpool::spillFrames);
+    APIManager::setUndeliveredAlertHandler(TelemetrySpool::spoolAlert);
+    Serial.println("✓ Telemetry spool ready");
+  } else {
+    Serial.println("✗ Telemetry spool unavailable (outages longer than the RAM buffer lose frames)");
+  }
+  
   // Initialize relay controller
   if (RelayController::init()) {
     Serial.println("✓ Relay Controller initialized");
@@ -251,6 +339,20 @@ void initializePeripherals() {
     Serial.println("✗ Advanced Threat Detection initialization failed");
   }
   
+  // Dashboard requests run on their own task; it connects once WiFi is up
+  if (APIManager::begin()) {
+    Serial.println("✓ API network task started");
+  } else {
+    Serial.println("✗ API network task failed to start");
+  }
+  
+  // Commands are pushed over a second connection; polling covers the gaps
+  if (CommandChannel::begin()) {
+    Serial.println("✓ Command channel started");
+  } else {
+    Serial.println("✗ Command channel failed to start (polling for commands)");
+  }
+  
   Serial.println("Peripheral initialization complete!");
 }
 
@@ -297,20 +399,16 @@ void processMLInference() {
     return;
   }
   
-  // Prepare input features for ML model
-  float inputFeatures[INPUT_FEATURES] = {
-    currentSensorData.current,
-    currentSensorData.voltage,
-    currentSensorData.power,
-    currentSensorData.frequency,
-    currentSensorData.temperature,
-    (float)currentState
-  };
+  // Prepare input features once for every model of this tick
+  const FeatureVector& features = EnhancedMLModel::prepareFeatures(currentSensorData);
   
   // Run standard ML inference
-  if (MLModel::runInference(inputFeatures, &mlResult)) {
+  if (MLModel::runInference(features.raw, &mlResult)) {
     // Run Enhanced ML inference for advanced threat detection
     enhancedMLResult = EnhancedMLModel::predictAdvanced(currentSensorData);
+#if DEBUG_LEVEL >= 3
+    DEBUG_PRINTLN("Enhanced inference: " + String(EnhancedMLModel::getLastInferenceCycles()) + " cycles");
+#endif
     
     // Use the higher threat score between standard and enhanced ML
     float finalThreatScore = max(mlResult.prediction, enhancedMLResult.prediction);
@@ -334,6 +432,12 @@ void processMLInference() {
                               ", Uncertainty: " + String(enhancedMLResult.uncertainty);
       SDLogger::logAlert("ENHANCED_THREAT", enhancedDetails);
     }
+    
+    // Feed the online learner; retraining runs on the other core
+    EnhancedMLModel::addTrainingSample(features, threatDetected);
+    if (EnhancedMLModel::needsRetraining()) {
+      EnhancedMLModel::retrainModel();
+    }
   } else {
     Serial.println("ML inference failed");
     mlResult.prediction = 0;
@@ -360,18 +464,44 @@ void logToSD() {
   SDLogger::logSystemState(currentState);
 }
 
+void recordTelemetryFrame() {
+  TelemetryFrame frame;
+  frame.timestamp = millis();
+  frame.current = currentSensorData.current;
+  frame.voltage = currentSensorData.voltage;
+  frame.power = currentSensorData.power;
+  frame.frequency = currentSensorData.frequency;
+  frame.temperature = currentSensorData.temperature;
+  frame.prediction = mlResult.prediction;
+  frame.confidence = mlResult.confidence;
+  frame.enhanced_prediction = enhancedMLResult.prediction;
+  frame.state = currentState;
+  frame.flags = (isCharging ? FRAME_FLAG_CHARGING : 0) |
+                (threatDetected ? FRAME_FLAG_THREAT : 0) |
+                (enhancedMLResult.is_anomaly ? FRAME_FLAG_ANOMALY : 0);
+  frame.attack_type = enhancedMLResult.attack_type;
+  TelemetryBatcher::addFrame(frame);
+}
+
 void sendToDashboard() {
+  // The WiFi check in loop() reconnects; frames wait in the batcher meanwhile
   if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("WiFi not connected - attempting reconnection...");
-    reconnectWiFi();
-    if (WiFi.status() != WL_CONNECTED) {
-      Serial.println("WiFi reconnection failed - cannot send data");
-      return;
-    }
+    Serial.println("WiFi not connected - telemetry kept for the next upload");
+    TelemetryBatcher::flushFailed();
+    return;
+  }
+  
+  // MessagePack unless the dashboard turned it down; then JSON until reboot
+  if (binaryTelemetry) {
+    sendBinaryTelemetry();
+    return;
   }
   
-  // Create JSON payload (match Next.js API schema exactly)
-  DynamicJsonDocument doc(1024);
+  // Create JSON payload (match Next.js API schema exactly): the latest
+  // snapshot plus the batched frames since the last upload
+  uint32_t encodeStart = ESP.getCycleCount();
+  JsonDocument& doc = telemetryDoc;
+  doc.clear();
   doc["device_id"] = DEVICE_ID;
   doc["session_id"] = sessionId;
   doc["timestamp"] = millis();
@@ -393,7 +523,83 @@ void sendToDashboard() {
   system["wifi_rssi"] = WiFi.RSSI();
   system["uptime"] = millis();
   system["free_heap"] = ESP.getFreeHeap();
+  system["max_alloc_heap"] = ESP.getMaxAllocHeap();
   system["cpu_freq"] = ESP.getCpuFreqMHz();
+  
+  // Dashboard connection reuse
+  ConnectionStats connStats = APIManager::getConnectionStats();
+  JsonObject net = system.createNestedObject("connection");
+  net["requests"] = connStats.requests;
+  net["reused"] = connStats.reused;
+  net["handshakes"] = connStats.handshakes;
+  net["resumed"] = connStats.resumed;
+  net["avg_rtt_ms"] = connStats.avg_rtt_ms;
+  net["min_free_heap"] = connStats.min_free_heap;
+  
+  // Request queue (network task)
+  APIQueueStats queueStats = APIManager::getQueueStats();
+  JsonObject queue = net.createNestedObject("queue");
+  queue["depth"] = queueStats.depth;
+  queue["max_depth"] = queueStats.max_depth;
+  queue["avg_wait_ms"] = queueStats.avg_wait_ms;
+  queue["avg_flight_ms"] = queueStats.avg_flight_ms;
+  queue["max_flight_ms"] = queueStats.max_flight_ms;
+  queue["failed"] = queueStats.failed;
+  queue["dropped"] = queueStats.dropped;
+  queue["rejected"] = queueStats.rejected;
+  queue["largest_free"] = queueStats.largest_free;
+  queue["fragmented"] = queueStats.fragmented;
+  
+  // Rate limiter per request class: [admitted, deferred]
+  static const char* const rateClasses[API_CLASS_COUNT] = {"alert", "command", "telemetry", "bulk"};
+  JsonObject rate = queue.createNestedObject("rate");
+  for (int cls = 0; cls < API_CLASS_COUNT; cls++) {
+    APIRateStats rateStats = APIManager::getRateStats((APIRequestClass)cls);
+    JsonArray entry = rate.createNestedArray(rateClasses[cls]);
+    entry.add(rateStats.admitted);
+    entry.add(rateStats.deferred);
+  }
+  
+  // gzip bodies (telemetry batches and bulk uploads)
+  APICompressionStats gzipStats = APIManager::getCompressionStats();
+  JsonObject gzip = net.createNestedObject("compression");
+  gzip["enabled"] = gzipStats.enabled;
+  gzip["bodies"] = gzipStats.compressed;
+  gzip["raw_bytes"] = gzipStats.raw_bytes;
+  gzip["sent_bytes"] = gzipStats.sent_bytes;
+  gzip["skipped"] = gzipStats.skipped;
+  gzip["cycles_per_kb"] = gzipStats.cycles_per_kb;
+  
+  // Command channel (push stream or long-poll)
+  CommandChannelStats channelStats = CommandChannel::getStats();
+  JsonObject channel = net.createNestedObject("commands");
+  channel["mode"] = CommandChannel::getMode() == COMMAND_CHANNEL_STREAM ? "stream" : "long_poll";
+  channel["connected"] = CommandChannel::isConnected();
+  channel["requests_per_hour"] = channelStats.requests_per_hour;
+  channel["timeouts"] = channelStats.timeouts;
+  channel["dropped"] = channelStats.dropped;
+  
+  // Offline spool (SD journal)
+  SpoolStats spoolStats = TelemetrySpool::getStats();
+  JsonObject spool = system.createNestedObject("spool");
+  spool["bytes"] = spoolStats.bytes;
+  spool["drain_per_min"] = spoolStats.drain_per_min;
+  spool["last_lag_ms"] = spoolStats.last_lag_ms;
+  spool["max_lag_ms"] = spoolStats.max_lag_ms;
+  spool["lost_segments"] = spoolStats.lost_segments;
+  spool["skipped"] = spoolStats.skipped;
+  
+  // Per-model inference profile: [p50_us, p99_us, max_us, bytes]
+  JsonObject inference = system.createNestedObject("inference");
+  for (int t = MODEL_LSTM; t < MODEL_TYPE_COUNT; t++) {
+    ModelType type = (ModelType)t;
+    InferenceStats stats = EnhancedMLModel::getInferenceStats(type);
+    JsonArray entry = inference.createNestedArray(EnhancedMLModel::getModelName(type));
+    entry.add(LatencyStats::cyclesToMicros(stats.p50_cycles));
+    entry.add(LatencyStats::cyclesToMicros(stats.p99_cycles));
+    entry.add(LatencyStats::cyclesToMicros(stats.max_cycles));
+    entry.add(EnhancedMLModel::getModelSize(type));
+  }
 
   // ML prediction data (enhanced)
   JsonObject ml = doc.createNestedObject("ml_prediction");
@@ -405,80 +611,442 @@ void sendToDashboard() {
   ml["attack_type"] = enhancedMLResult.attack_type;
   ml["attack_confidence"] = enhancedMLResult.attack_confidence;
   ml["is_anomaly"] = enhancedMLResult.is_anomaly;
+  ml["early_exit_rate"] = EnhancedMLModel::getEarlyExitRate();
   ml["threat_level"] = threatDetected ? "HIGH" : "NORMAL";
   ml["timestamp"] = mlResult.timestamp;
   
-  String jsonString;
-  serializeJson(doc, jsonString);
+  // Shadow candidate (only while one is loaded; never affects threat_detected)
+  ShadowStats shadowStats = EnhancedMLModel::getShadowStats();
+  if (shadowStats.loaded) {
+    JsonObject shadow = ml.createNestedObject("shadow");
+    shadow["model"] = EnhancedMLModel::getModelName(shadowStats.type);
+    shadow["crc"] = shadowStats.crc;
+    shadow["evaluated"] = shadowStats.evaluated;
+    shadow["skipped"] = shadowStats.skipped_budget + shadowStats.skipped_busy;
+    shadow["disagreement_rate"] = shadowStats.evaluated ?
+      (float)shadowStats.disagreements / shadowStats.evaluated : 0.0;
+    shadow["active_disagreement_rate"] = shadowStats.compared_active ?
+      (float)shadowStats.active_disagreements / shadowStats.compared_active : 0.0;
+    shadow["mean_abs_diff"] = shadowStats.compared_active ?
+      shadowStats.abs_diff_sum / shadowStats.compared_active : 0.0;
+    shadow["p50_us"] = LatencyStats::cyclesToMicros(shadowStats.latency.p50_cycles);
+    shadow["p99_us"] = LatencyStats::cyclesToMicros(shadowStats.latency.p99_cycles);
+  }
   
-  // Ensure API manager is initialized and server reachable
-  static bool apiInitDone = false;
-  if (!apiInitDone) {
-    apiInitDone = APIManager::init();
-    if (apiInitDone) {
-      Serial.println("API Manager initialized successfully");
-    } else {
-      Serial.println("API Manager initialization failed");
-      return;
+  size_t frameCount = TelemetryBatcher::appendFrames(doc);
+  
+  // Serialized straight into the request queue (no String in between)
+  bool queued = frameCount > 0 && APIManager::sendDataAsync(doc, onTelemetrySent, nullptr);
+  uint32_t cycles = ESP.getCycleCount() - encodeStart;
+  telemetryUpload = {frameCount, measureJson(doc), cycles, false};
+  queueTelemetry(queued);
+}
+
+void queueTelemetry(bool queued) {
+  // Frames stay in the batcher until onTelemetrySent() sees the server accept them
+  if (queued) {
+    telemetryInFlight = true;
+  } else {
+    TelemetryBatcher::flushFailed();
+    Serial.println("Failed to queue data for the dashboard");
+  }
+}
+
+void onTelemetrySent(const APIResponse& response, void* context) {
+  telemetryInFlight = false;
+  
+  if (response.success) {
+    if (telemetryUpload.binary) {
+      binaryAccepted = true;
+      binaryRejections = 0;
     }
+    TelemetryBatcher::commit(telemetryUpload.frames);
+    Serial.println("Data sent to dashboard successfully (" + String(telemetryUpload.frames) + " frames, " +
+                   String(telemetryUpload.bytes) + " bytes " + (telemetryUpload.binary ? "MessagePack" : "JSON") +
+                   ", " + String(telemetryUpload.cycles) + " cycles)");
+    processPiggybackedCommands(response.data);
+    return;
+  }
+  
+  // Throttled: the frames stay queued and go out with the next batch
+  int status = response.statusCode;
+  if (status == HTTP_TOO_MANY_REQUESTS) {
+    unsigned long wait = APIManager::getRateWait(API_CLASS_TELEMETRY);
+    TelemetryBatcher::defer(max(wait, (unsigned long)DATA_TRANSMISSION_INTERVAL));
+    Serial.println("Telemetry upload throttled - " + String(telemetryUpload.frames) + " frames kept for the next batch");
+    return;
+  }
+  
+  // 415 means no. An older dashboard fails to parse the body (400/500) instead,
+  // but so does one with a passing fault: give up on MessagePack only after
+  // TELEMETRY_BINARY_REJECTIONS of those in a row. The frames go out as JSON
+  // with the next sample
+  if (telemetryUpload.binary && !binaryAccepted &&
+      (status == HTTP_BAD_REQUEST || status == HTTP_INTERNAL_ERROR)) {
+    binaryRejections++;
   }
+  if (telemetryUpload.binary && (status == HTTP_UNSUPPORTED_MEDIA_TYPE ||
+      binaryRejections >= TELEMETRY_BINARY_REJECTIONS)) {
+    binaryTelemetry = false;
+    Serial.println("Dashboard does not accept " TELEMETRY_MSGPACK_TYPE " - sending JSON");
+    return;
+  }
+  
+  TelemetryBatcher::flushFailed();
+  Serial.println("Failed to send data to dashboard");
+  Serial.println("Last API Error: " + response.error);
+}
+
+void sendBinaryTelemetry() {
+  uint32_t encodeStart = ESP.getCycleCount();
+  MsgPackWriter out(msgpackBuffer, sizeof(msgpackBuffer));
+  out.writeMap(TELEMETRY_BINARY_KEYS);
+  out.writeUInt(TELEMETRY_KEY_DEVICE_ID);
+  out.writeString(DEVICE_ID);
+  out.writeUInt(TELEMETRY_KEY_SESSION_ID);
+  out.writeString(sessionId.c_str(), sessionId.length());
+  out.writeUInt(TELEMETRY_KEY_TIMESTAMP);
+  out.writeUInt(millis());
+  out.writeUInt(TELEMETRY_KEY_STATE);
+  out.writeUInt(currentState);
+  out.writeUInt(TELEMETRY_KEY_CHARGING);
+  out.writeBool(isCharging);
+  out.writeUInt(TELEMETRY_KEY_THREAT);
+  out.writeBool(threatDetected);
+  
+  out.writeUInt(TELEMETRY_KEY_SYSTEM);
+  out.writeArray(4);
+  out.writeInt(WiFi.RSSI());
+  out.writeUInt(millis());
+  out.writeUInt(ESP.getFreeHeap());
+  out.writeUInt(ESP.getCpuFreqMHz());
+  
+  out.writeUInt(TELEMETRY_KEY_ML);
+  out.writeArray(9);
+  out.writeFloat(mlResult.prediction);
+  out.writeFloat(mlResult.confidence);
+  out.writeFloat(enhancedMLResult.prediction);
+  out.writeFloat(enhancedMLResult.confidence);
+  out.writeFloat(enhancedMLResult.uncertainty);
+  out.writeUInt(enhancedMLResult.attack_type);
+  out.writeFloat(enhancedMLResult.attack_confidence);
+  out.writeBool(enhancedMLResult.is_anomaly);
+  out.writeFloat(EnhancedMLModel::getEarlyExitRate());
+  
+  size_t frameCount = TelemetryBatcher::appendFrames(out);
+  
+  telemetryUpload = {frameCount, out.length(), ESP.getCycleCount() - encodeStart, true};
+  queueTelemetry(frameCount > 0 &&
+                 APIManager::sendDataAsync(out.data(), out.length(), TELEMETRY_MSGPACK_TYPE, onTelemetrySent, nullptr));
+}
 
-  // Send to dashboard
-  if (APIManager::sendData(jsonString)) {
-    Serial.println("Data sent to dashboard successfully");
-    Serial.println("JSON Payload: " + jsonString);
+void drainSpool() {
+  if (!TelemetrySpool::nextBatch(spoolBatch)) {
+    return;
+  }
+  
+  bool queued;
+  if (spoolBatch.type == SPOOL_RECORD_ALERT) {
+    queued = APIManager::resendAlertAsync(spoolBatch.alert, spoolBatch.length, onSpoolSent, nullptr);
+  } else if (binaryTelemetry) {
+    // Frames only; the dashboard takes the snapshot from the newest frame
+    MsgPackWriter out(msgpackBuffer, sizeof(msgpackBuffer));
+    out.writeMap(6);
+    out.writeUInt(TELEMETRY_KEY_DEVICE_ID);
+    out.writeString(DEVICE_ID);
+    out.writeUInt(TELEMETRY_KEY_TIMESTAMP);
+    out.writeUInt(spoolBatch.sent_at);
+    out.writeUInt(TELEMETRY_KEY_SPOOLED);
+    out.writeUInt(spoolBatch.seq);
+    queued = TelemetryBatcher::appendFrames(out, spoolBatch.frames, spoolBatch.count) > 0 &&
+             APIManager::sendBulkAsync(out.data(), out.length(), TELEMETRY_MSGPACK_TYPE, onSpoolSent, nullptr);
   } else {
-    Serial.println("Failed to send data to dashboard");
-    Serial.println("Last API Error: " + APIManager::getLastError());
+    const TelemetryFrame& latest = spoolBatch.frames[spoolBatch.count - 1];
+    JsonDocument& doc = telemetryDoc;
+    doc.clear();
+    doc["device_id"] = DEVICE_ID;
+    doc["timestamp"] = spoolBatch.sent_at;
+    doc["spooled"] = spoolBatch.seq;
+    JsonObject sensors = doc.createNestedObject("sensor_data");
+    sensors["current"] = latest.current;
+    sensors["voltage"] = latest.voltage;
+    sensors["power"] = latest.power;
+    sensors["frequency"] = latest.frequency;
+    sensors["temperature"] = latest.temperature;
+    sensors["timestamp"] = latest.timestamp;
+    
+    queued = TelemetryBatcher::appendFrames(doc, spoolBatch.frames, spoolBatch.count) > 0 &&
+             APIManager::sendBulkAsync(doc, onSpoolSent, nullptr);
+  }
+  
+  if (!queued) {
+    TelemetrySpool::drainFailed();
+  }
+}
+
+void onSpoolSent(const APIResponse& response, void* context) {
+  if (response.success) {
+    TelemetrySpool::commitBatch(spoolBatch);
+    processPiggybackedCommands(response.data);
+    return;
+  }
+  
+  // A malformed alert is refused every time; drop it rather than block the journal
+  if (spoolBatch.type == SPOOL_RECORD_ALERT && response.statusCode == HTTP_BAD_REQUEST) {
+    Serial.println("Spooled alert " + String(spoolBatch.seq) + " refused by the dashboard - dropped");
+    TelemetrySpool::commitBatch(spoolBatch);
+    return;
   }
+  
+  TelemetrySpool::drainFailed();
+  Serial.println("Failed to send spooled telemetry: " + response.error);
 }
 
-void checkDashboardCommands() {
-  String commandJson = APIManager::getCommand();
+void processPiggybackedCommands(const String& responseJson) {
+  // {"success": true, ..., "commands": [{...}, ...]}; "commands" only when some were queued
+  if (responseJson.indexOf("\"commands\"") < 0) {
+    return;
+  }
   
-  if (commandJson.length() > 0) {
-    Serial.println("Received command JSON: " + commandJson);
-    SDLogger::logSystemEvent(String("Command received: " + commandJson));
-    
-    // Parse JSON command
-    DynamicJsonDocument doc(512);
-    DeserializationError error = deserializeJson(doc, commandJson);
-    
-    if (error) {
-      Serial.println("Failed to parse command JSON: " + String(error.c_str()));
+  // Fixed capacity, off the heap and the loop stack
+  static StaticJsonDocument<COMMAND_PIGGYBACK_MAX * COMMAND_CHANNEL_MAX_BYTES> doc;
+  DeserializationError error = deserializeJson(doc, responseJson);
+  if (error) {
+    Serial.println("Failed to parse commands in data response: " + String(error.c_str()));
+    return;
+  }
+  
+  for (JsonObject entry : doc["commands"].as<JsonArray>()) {
+    String commandJson;
+    serializeJson(entry, commandJson);
+    processDashboardCommand(commandJson);
+  }
+}
+
+void processDashboardCommand(const String& commandJson) {
+  // Parse JSON command (the pushed form carries id, timestamps and parameters)
+  static StaticJsonDocument<COMMAND_CHANNEL_MAX_BYTES> doc;
+  DeserializationError error = deserializeJson(doc, commandJson);
+  
+  if (error) {
+    Serial.println("Failed to parse command JSON: " + String(error.c_str()));
+    return;
+  }
+  
+  // Poll responses wrap the command: {"success": true, "command": {...} | null}
+  JsonVariant wrapped = doc["command"];
+  if (wrapped.isNull()) {
+    return;
+  }
+  JsonObject entry = wrapped.is<JsonObject>() ? wrapped.as<JsonObject>() : doc.as<JsonObject>();
+  
+  Serial.println("Received command JSON: " + commandJson);
+  SDLogger::logSystemEvent(String("Command received: " + commandJson));
+  
+  String command = entry["command"];
+  String commandId = entry["id"] | "";
+  
+  // A resent command whose result was lost: send the same result again, do not rerun
+  if (commandId.length() > 0) {
+    for (int i = 0; i < COMMAND_RECENT_IDS; i++) {
+      RecentCommand& recent = recentCommands[i];
+      if (recent.id != commandId) {
+        continue;
+      }
+      if (recent.result < 0) {
+        Serial.println("Command " + commandId + " still running - result follows");
+      } else {
+        Serial.println("Command " + commandId + " already run - result sent again");
+        APIManager::sendCommandResultAsync(commandId, recent.result == 1, recent.details);
+      }
       return;
     }
+    recentCommands[recentCommandNext] = {commandId, -1, ""};
+    recentCommandNext = (recentCommandNext + 1) % COMMAND_RECENT_IDS;
+  }
+  
+  Serial.println("Processing command: " + command + " (ID: " + commandId + ")");
+  
+  if (command == "STOP" || command == "EMERGENCY_STOP") {
+    emergencyStop = true;
+    updateSystemState(STATE_LOCKDOWN);
+    controlRelay(false); // Turn off relay
+    Serial.println("EMERGENCY STOP COMMAND RECEIVED!");
+    reportCommand(commandId, true, "Emergency stop command executed");
+  } else if (command == "START") {
+    emergencyStop = false;
+    updateSystemState(STATE_IDLE);
+    controlRelay(true); // Turn on relay
+    Serial.println("START COMMAND RECEIVED!");
+    reportCommand(commandId, true, "Start command executed");
+  } else if (command == "RESET") {
+    Serial.println("RESET COMMAND RECEIVED!");
+    // Restart once the alert is delivered (or has failed)
+    if (!reportCommand(commandId, true, "Reset command executed", restartAfterAlert, nullptr)) {
+      ESP.restart();
+    }
+  } else if (command == "CALIBRATE") {
+    Serial.println("CALIBRATE COMMAND RECEIVED!");
+    SensorManager::calibrateSensors();
+    reportCommand(commandId, true, "Calibration command executed");
+  } else if (command == "UPDATE_MODEL") {
+    // {"command": "UPDATE_MODEL", "model": <ModelType>, "url": "/models/model_1.evm"}
+    // Staging reads the download on the network task; the swap happens at a tick boundary
+    ModelType model;
+    String url = entry["url"] | "";
+    if (!parseModelType(entry["model"] | -1, &model)) {
+      reportCommand(commandId, false, "Invalid model");
+    } else if (modelDownloadInFlight) {
+      reportCommand(commandId, false, "Model download already in progress");
+    } else {
+      modelDownload = {model, commandId};
+      modelDownloadInFlight = url.length() > 0 &&
+                              APIManager::downloadAsync(url, stageDownloadedModel, onModelDownloaded, nullptr);
+      if (!modelDownloadInFlight) {
+        reportCommand(commandId, false, "Model " + String(model) + " update rejected");
+      }
+    }
+  } else if (command == "SHADOW_MODEL") {
+    // Same fields as UPDATE_MODEL; without "url" the shadow slot is cleared
+    ModelType model;
+    String url = entry["url"] | "";
+    if (url.length() == 0) {
+      EnhancedMLModel::unloadShadowModel();
+      reportCommand(commandId, true, "Shadow model cleared");
+    } else if (!parseModelType(entry["model"] | -1, &model)) {
+      reportCommand(commandId, false, "Invalid model");
+    } else if (shadowDownloadInFlight) {
+      reportCommand(commandId, false, "Shadow model download already in progress");
+    } else {
+      shadowDownload = {model, nullptr, 0, commandId};
+      shadowDownloadInFlight = APIManager::downloadAsync(url, readShadowDownload, onShadowDownloaded, nullptr);
+      if (!shadowDownloadInFlight) {
+        reportCommand(commandId, false, "Shadow model rejected");
+      }
+    }
+  } else {
+    Serial.println("Unknown command: " + command);
+    reportCommand(commandId, false, "Unknown command: " + command);
+  }
+}
+
+bool reportCommand(const String& commandId, bool executed, const String& details,
+                   APICallback callback, void* context) {
+  // Remember the outcome for a resend, then send COMMAND_EXECUTED / COMMAND_ERROR
+  for (int i = 0; i < COMMAND_RECENT_IDS && commandId.length() > 0; i++) {
+    if (recentCommands[i].id == commandId) {
+      recentCommands[i].result = executed ? 1 : 0;
+      recentCommands[i].details = details;
+      break;
+    }
+  }
+  return APIManager::sendCommandResultAsync(commandId, executed, details, callback, context);
+}
+
+bool parseModelType(int value, ModelType* type) {
+  // Only the models with weight files can be replaced (0 LSTM, 1 autoencoder, 2 ensemble)
+  if (value < MODEL_LSTM || value > MODEL_ENSEMBLE) {
+    return false;
+  }
+  *type = (ModelType)value;
+  return true;
+}
+
+bool stageDownloadedModel(Stream& body, int length, void* context) {
+  // Network task: stageModel() only writes the standby slot
+  return EnhancedMLModel::stageModel(modelDownload.type, body);
+}
+
+void onModelDownloaded(const APIResponse& response, void* context) {
+  modelDownloadInFlight = false;
+  reportCommand(modelDownload.commandId, response.success,
+                "Model " + String(modelDownload.type) + (response.success ? " staged for hot-swap" : " update rejected"));
+}
+
+bool readShadowDownload(Stream& body, int length, void* context) {
+  // Network task: only reads into a new buffer; onShadowDownloaded() installs it
+  shadowDownload.weights = EnhancedMLModel::readShadowModel(shadowDownload.type, body, &shadowDownload.crc);
+  return shadowDownload.weights != nullptr;
+}
+
+void onShadowDownloaded(const APIResponse& response, void* context) {
+  shadowDownloadInFlight = false;
+  bool loaded = false;
+  if (response.success) {
+    loaded = EnhancedMLModel::installShadowModel(shadowDownload.type, shadowDownload.weights, shadowDownload.crc);
+  } else {
+    free(shadowDownload.weights);
+  }
+  shadowDownload.weights = nullptr;
+  reportCommand(shadowDownload.commandId, loaded, "Shadow model " + String(loaded ? "loaded" : "rejected"));
+}
+
+void restartAfterAlert(const APIResponse& response, void* context) {
+  ESP.restart();
+}
+
+void handleSerialCommands() {
+  static String line = "";
+  
+  // Collect a line without blocking the loop
+  while (Serial.available() > 0) {
+    char c = Serial.read();
+    if (c != '\n' && c != '\r') {
+      if (line.length() < 64) {
+        line += c;
+      }
+      continue;
+    }
     
-    String command = doc["command"];
-    String commandId = doc["id"];
-    
-    Serial.println("Processing command: " + command + " (ID: " + commandId + ")");
+    line.trim();
+    if (line.length() == 0) {
+      continue;
+    }
     
-    if (command == "STOP" || command == "EMERGENCY_STOP") {
-      emergencyStop = true;
-      updateSystemState(STATE_LOCKDOWN);
-      controlRelay(false); // Turn off relay
-      Serial.println("EMERGENCY STOP COMMAND RECEIVED!");
-      APIManager::sendAlert("COMMAND_EXECUTED", "Emergency stop command executed");
-    } else if (command == "START") {
-      emergencyStop = false;
-      updateSystemState(STATE_IDLE);
-      controlRelay(true); // Turn on relay
-      Serial.println("START COMMAND RECEIVED!");
-      APIManager::sendAlert("COMMAND_EXECUTED", "Start command executed");
-    } else if (command == "RESET") {
-      Serial.println("RESET COMMAND RECEIVED!");
-      APIManager::sendAlert("COMMAND_EXECUTED", "Reset command executed");
-      delay(1000); // Give time for alert to be sent
-      ESP.restart();
-    } else if (command == "CALIBRATE") {
-      Serial.println("CALIBRATE COMMAND RECEIVED!");
-      SensorManager::calibrateSensors();
-      APIManager::sendAlert("COMMAND_EXECUTED", "Calibration command executed");
+    if (line == "stats") {
+      EnhancedMLModel::printModelStats();
+      APIManager::printConnectionStats();
+      CommandChannel::printStats();
+      TelemetrySpool::printStats();
+    } else if (line == "stats reset") {
+      EnhancedMLModel::resetInferenceStats();
+      EnhancedMLModel::resetShadowStats();
+      APIManager::resetConnectionStats();
+      APIManager::resetQueueStats();
+      CommandChannel::resetStats();
+      TelemetrySpool::resetStats();
+      Serial.println("Inference stats reset");
+    } else if (line == "parallel on" || line == "parallel off") {
+      EnhancedMLModel::setParallelEnsemble(line == "parallel on");
+      Serial.println("Parallel ensemble " + String(line == "parallel on" ? "enabled" : "disabled"));
+    } else if (line.startsWith("swap ")) {
+      // Hot-swap from /models/model_<n>.evm on the SD card
+      ModelType model;
+      if (parseModelType(line.substring(5).toInt(), &model)) {
+        EnhancedMLModel::stageModel(model);
+      } else {
+        Serial.println("Invalid model: " + line.substring(5));
+      }
+    } else if (line == "shadow off") {
+      EnhancedMLModel::unloadShadowModel();
+      Serial.println("Shadow model unloaded");
+    } else if (line.startsWith("shadow budget ")) {
+      EnhancedMLModel::setShadowBudget(line.substring(14).toInt());
+    } else if (line.startsWith("shadow ")) {
+      // Candidate from /models/shadow_<n>.evm on the SD card
+      ModelType model;
+      if (parseModelType(line.substring(7).toInt(), &model)) {
+        EnhancedMLModel::loadShadowModel(model);
+      } else {
+        Serial.println("Invalid model: " + line.substring(7));
+      }
+    } else if (line == "help") {
+      Serial.println("Commands: stats, stats reset, parallel on|off, swap <model>, "
+                     "shadow <model>|off|budget <cycles/s>, help");
     } else {
-      Serial.println("Unknown command: " + command);
-      APIManager::sendAlert("COMMAND_ERROR", "Unknown command: " + command);
+      Serial.println("Unknown command: " + line + " (try 'help')");
     }
+    line = "";
   }
 }
 
@@ -513,7 +1081,7 @@ void handleThreatDetection() {
       String alertDetails = "Standard ML: " + String(mlResult.prediction) + 
                            ", Enhanced ML: " + String(enhancedMLResult.prediction) +
                            ", Attack: " + AdvancedThreatDetection::getAttackDescription(enhancedMLResult.attack_type);
-      APIManager::sendAlert("ADVANCED_THREAT_DETECTED", alertDetails);
+      APIManager::sendAlertAsync("ADVANCED_THREAT_DETECTED", alertDetails);
       
       // Enhanced threat evaluation
       float combinedConfidence = (mlResult.confidence + enhancedMLResult.confidence) / 2.0;
@@ -529,9 +1097,9 @@ void handleThreatDetection() {
         Serial.println("Attack Type: " + AdvancedThreatDetection::getAttackDescription(enhancedMLResult.attack_type));
         
         // Send critical alert
-        APIManager::sendAlert("CRITICAL_THREAT_LOCKDOWN", 
-                             "Critical threat detected - System locked down. Attack: " + 
-                             AdvancedThreatDetection::getAttackDescription(enhancedMLResult.attack_type));
+        APIManager::sendAlertAsync("CRITICAL_THREAT_LOCKDOWN", 
+                                   "Critical threat detected - System locked down. Attack: " + 
+                                   AdvancedThreatDetection::getAttackDescription(enhancedMLResult.attack_type));
       }
     }
   }
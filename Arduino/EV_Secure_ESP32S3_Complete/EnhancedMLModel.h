@@ -12,6 +12,16 @@
  * - Autoencoder for anomaly detection
  * - Hybrid rule-based + ML approach
  * - Real-time inference optimization
+ * - Streaming input normalization (see FeatureScaler.h)
+ * - Early-exit cascade: LSTM/ensemble only for uncertain ticks
+ * - Per-model latency histograms and memory accounting
+ * - Dual-core ensemble: LSTM on a worker core, other members on the caller
+ * - Trained weights compiled into flash (ModelWeights.h, see tools/model_tool.py)
+ * - Compiled tree ensemble member (TreeEnsemble.h) when a forest is generated
+ * - Double-buffered weights: new models from SD or the dashboard are
+ *   validated in a standby slot and switched in between two ticks
+ * - Shadow slot: a candidate model sees every tick's inputs in idle time
+ *   under a cycle budget; it is compared with production, never acted on
  * 
  * Research-based enhancements:
  * - Power signature analysis
@@ -26,6 +36,11 @@
 
 #include "EV_Secure_Config.h"
 #include "AdvancedThreatDetection.h"
+#include "FastActivations.h"
+#include "FeatureScaler.h"
+#include "LatencyHistogram.h"
+#include "ModelStore.h"
+#include "TreeEnsemble.h"
 #include <Arduino.h>
 
 // Ensure visibility of global system state in this header's translation unit
@@ -34,28 +49,91 @@ extern SystemState currentState;
 // LSTM configuration
 #define LSTM_HIDDEN_SIZE 32
 #define LSTM_SEQUENCE_LENGTH 10
-#define LSTM_INPUT_FEATURES 6
+#define LSTM_INPUT_FEATURES SCALED_FEATURES
 #define LSTM_OUTPUT_SIZE 1
 
-// Ensemble configuration
-#define ENSEMBLE_MODELS 3
-#define ENSEMBLE_WEIGHTS {0.4, 0.35, 0.25}
+// Ensemble configuration (the tree member only takes part when ForestModel.h exists)
+#define ENSEMBLE_MODELS 4
+#define ENSEMBLE_WEIGHTS {0.4, 0.35, 0.25, 0.0}
+#define ENSEMBLE_WEIGHTS_WITH_TREES {0.25, 0.2, 0.2, 0.35}
 
 // Online learning configuration
 #define LEARNING_RATE 0.01
 #define BATCH_SIZE 32
 #define MAX_TRAINING_SAMPLES 1000
 #define RETRAIN_THRESHOLD 0.1
+#define RETRAIN_SAMPLE_INTERVAL 50       // Flag retraining every N new samples
 
-// Model types
+// Seed for untrained weights when no stored or compiled weights exist
+#define MODEL_INIT_SEED 0x45565345       // "EVSE"
+
+// Training buffer storage
+#define TRAINING_STORAGE_FLOAT 0         // 4 bytes per feature
+#define TRAINING_STORAGE_INT16 1         // 2 bytes per feature, fixed-point (see TRAINING_FEATURE_SCALES)
+#define TRAINING_SAMPLE_STORAGE TRAINING_STORAGE_INT16
+#define TRAINING_BUFFER_IN_PSRAM true    // Place the sample ring in PSRAM when available
+#define TRAINING_RESERVOIR_SAMPLING false // Keep a uniform sample of the whole history instead of the newest N
+
+// Fixed-point resolution per feature: A, V, W, Hz, C, state
+#define TRAINING_FEATURE_SCALES {0.01f, 0.02f, 0.5f, 0.01f, 0.01f, 1.0f}
+
+// Background autoencoder training (Adam over normal samples in the learner buffer)
+#define TRAINING_TASK_ENABLED true
+#define TRAINING_TASK_CORE 0             // Arduino loop() runs on core 1
+#define TRAINING_TASK_PRIORITY 1         // Just above idle
+#define TRAINING_TASK_STACK 4096
+#define TRAINING_SLICE_BUDGET_US 2000    // CPU time per slice before yielding
+#define TRAINING_SLICE_PERIOD_MS 10      // Sleep between slices (caps the task at ~20% of a core)
+#define TRAINING_EPOCHS_PER_RUN 1
+#define ADAM_BETA1 0.9f
+#define ADAM_BETA2 0.999f
+#define ADAM_EPSILON 1e-8f
+#define GRADIENT_CLIP 1.0f
+
+// Parallel ensemble: the LSTM runs on a pre-created worker task while the
+// caller evaluates the other members (fork/join, no per-inference allocation).
+// By default the LSTM is forked only once stage 0 escalates. Forking at tick
+// start overlaps it with stage 0 as well, but pays the hand-off and a
+// discarded LSTM run on every early exit, most ticks while charging
+#define PARALLEL_ENSEMBLE_ENABLED true
+#define PARALLEL_SPECULATIVE_LSTM false  // Fork the LSTM at tick start, before the cascade decides
+#define PARALLEL_WORKER_CORE 0           // Opposite the Arduino loop()
+#define PARALLEL_WORKER_PRIORITY 2       // Above the training task, below the WiFi stack
+#define PARALLEL_WORKER_STACK 4096
+
+// Shadow inference: a candidate model runs on copies of finished ticks in a
+// low-priority task; its decisions are counted, never used
+#define SHADOW_TASK_CORE 0               // Same core as the worker; yields to it
+#define SHADOW_TASK_PRIORITY 1           // Idle time only (same level as training)
+#define SHADOW_TASK_STACK 4096
+#define SHADOW_CYCLE_BUDGET 24000000     // Cycles per second (10% of one 240 MHz core)
+#define SHADOW_BURST_MS 100              // Unused budget kept for at most this long
+#define SHADOW_LOG_INTERVAL_MS 1000      // At most one disagreement line per interval
+#define SHADOW_SD_PREFIX "/shadow_"      // Candidate files: /models/shadow_<type>.evm
+
+// Autoencoder reconstruction error above which a sample is anomalous
+#define AUTOENCODER_ANOMALY_THRESHOLD 0.5
+
+// Inference cascade: stage 0 (rules + autoencoder) decides plainly normal or
+// plainly malicious ticks; the LSTM and full ensemble run only in between
+#define CASCADE_ENABLED true
+#define CASCADE_RULE_CLEAR (THREAT_THRESHOLD - 0.1) // Rule score at or below this is normal...
+#define CASCADE_RECONSTRUCTION_CLEAR (AUTOENCODER_ANOMALY_THRESHOLD * 0.8) // ...if the reconstruction error is too
+#define CASCADE_RULE_THREAT CRITICAL_THRESHOLD // Rule score at or above this is a threat on its own
+#define CASCADE_AUDIT_INTERVAL 32        // Run the full ensemble on every Nth early exit (0 = never)
+
+// Model types (the values are used in commands and model files: append only)
 enum ModelType {
   MODEL_LSTM = 0,
   MODEL_AUTOENCODER,
   MODEL_ENSEMBLE,
   MODEL_RULE_BASED,
-  MODEL_HYBRID
+  MODEL_HYBRID,
+  MODEL_TREE_ENSEMBLE
 };
 
+#define MODEL_TYPE_COUNT (MODEL_TREE_ENSEMBLE + 1)
+
 // LSTM cell structure
 struct LSTMCell {
   float forget_gate[LSTM_HIDDEN_SIZE];
@@ -94,7 +172,7 @@ struct LSTMModel {
 // Autoencoder structure
 struct AutoencoderModel {
   // Encoder weights
-  float W1[INPUT_FEATURES][8];
+  float W1[SCALED_FEATURES][8];
   float b1[8];
   float W2[8][4];
   float b2[4];
@@ -102,12 +180,35 @@ struct AutoencoderModel {
   // Decoder weights
   float W3[4][8];
   float b3[8];
-  float W4[8][INPUT_FEATURES];
-  float b4[INPUT_FEATURES];
+  float W4[8][SCALED_FEATURES];
+  float b4[SCALED_FEATURES];
+};
+
+// Number of trainable parameters in the autoencoder (struct is all floats)
+#define AUTOENCODER_PARAMS (sizeof(AutoencoderModel) / sizeof(float))
+
+// Trained weights as constexpr tables in flash (.rodata). Generate with
+// tools/model_tool.py codegen; the file defines MODEL_WEIGHTS_<TYPE> for each
+// model it contains.
+#if __has_include("ModelWeights.h")
+#include "ModelWeights.h"
+#endif
+
+// Autoencoder trainer state
+struct AutoencoderTrainer {
+  AutoencoderModel weights;      // Working copy being optimized
+  AutoencoderModel gradients;
+  float adam_m[AUTOENCODER_PARAMS];
+  float adam_v[AUTOENCODER_PARAMS];
+  unsigned long step;
+  unsigned long epochs;
+  float last_loss;
+  unsigned long last_epoch_ms;
 };
 
 // Ensemble model structure
 struct EnsembleModel {
+  int member_count;              // Active members (first N entries)
   ModelType models[ENSEMBLE_MODELS];
   float weights[ENSEMBLE_MODELS];
   float predictions[ENSEMBLE_MODELS];
@@ -115,15 +216,33 @@ struct EnsembleModel {
   float confidence;
 };
 
-// Online learning structure
+// Stored training sample
+#if TRAINING_SAMPLE_STORAGE == TRAINING_STORAGE_INT16
+typedef int16_t TrainingFeature;
+#else
+typedef float TrainingFeature;
+#endif
+
+struct TrainingSample {
+  TrainingFeature features[INPUT_FEATURES];
+};
+
+// Online learning structure (ring buffer of samples, 1 label bit per slot)
 struct OnlineLearner {
-  float training_data[MAX_TRAINING_SAMPLES][INPUT_FEATURES];
-  bool training_labels[MAX_TRAINING_SAMPLES];
-  int sample_count;
+  TrainingSample* samples;
+  uint8_t* labels;
+  int head;                      // Next slot to write
+  int sample_count;              // Valid slots
+  unsigned long samples_seen;    // Samples offered since init
+  bool in_psram;
   float learning_rate;
   bool needs_retraining;
-  float accuracy;
-  float false_positive_rate;
+  float agreement;               // Autoencoder decisions matching the stored labels
+  float false_alarm_rate;        // ...flagging samples labelled normal
+  
+  // Insert cost benchmark
+  unsigned long insert_cycles;
+  unsigned long insert_count;
 };
 
 // Enhanced ML prediction structure
@@ -139,6 +258,127 @@ struct EnhancedMLPrediction {
   unsigned long timestamp;
 };
 
+// Cascade thresholds (defaults from the CASCADE_* macros)
+struct CascadeConfig {
+  bool enabled;
+  float rule_clear;
+  float reconstruction_clear;
+  float rule_threat;
+  unsigned int audit_interval;
+};
+
+// Cascade counters
+struct CascadeStats {
+  unsigned long ticks;
+  unsigned long early_exits;        // Decided by stage 0 alone
+  unsigned long escalations;        // Stage 0 uncertain; full ensemble ran
+  unsigned long audits;             // Early exits re-checked by the full ensemble
+  unsigned long audit_misses;       // Audits where the ensemble found a threat stage 0 had cleared
+  unsigned long labelled_attacks;   // Ticks labelled as attacks (replay/evaluation)
+  unsigned long missed_attacks;     // Labelled attacks predicted below THREAT_THRESHOLD
+  unsigned long missed_early_exits; // Missed attacks that stage 0 cleared
+};
+
+// Model input of one inference tick, built once and shared by every model
+struct FeatureVector {
+  float raw[INPUT_FEATURES];       // Sensor units + state (MLModel, online learner)
+  float scaled[SCALED_FEATURES];   // Normalized input of the neural models
+};
+
+// Model outputs of the current tick; each model runs at most once per tick
+struct TickResults {
+  unsigned long tick;
+  bool lstm_valid;
+  bool autoencoder_valid;
+  bool rules_valid;
+  bool trees_valid;
+  bool ensemble_valid;
+  bool prediction_valid;
+  bool sequence_valid;
+  bool early_exit;
+  float lstm;
+  float reconstruction_error;
+  float rule_score;
+  float trees;
+  float ensemble;
+  AttackType attack_type;
+  float prediction;
+};
+
+// Latency summary of one model (CPU cycles)
+struct InferenceStats {
+  unsigned long count;
+  uint32_t p50_cycles;
+  uint32_t p99_cycles;
+  uint32_t max_cycles;
+  uint32_t mean_cycles;
+};
+
+// Fork/join counters of the parallel ensemble
+struct ParallelStats {
+  unsigned long forks;          // LSTM runs handed to the worker core
+  unsigned long joins;          // Forked results used by the same tick
+  unsigned long discards;       // Speculative results dropped (cascade exited early)
+  unsigned long inline_runs;    // LSTM runs on the caller core
+  uint64_t wall_cycles;         // Caller cycles from fork to join (used forks)
+  uint64_t member_cycles;       // Work done on both cores in that time (serial cost)
+};
+
+// Memory used by one model (bytes)
+struct ModelSizeInfo {
+  size_t weight_bytes;    // Parameters (flash when mapped, RAM otherwise)
+  size_t scratch_bytes;   // State and activations needed for inference
+  size_t training_bytes;  // Extra RAM held only for on-device training
+  size_t standby_bytes;   // Inactive hot-swap slot (RAM)
+  bool weights_in_flash;
+};
+
+// Copy of a finished tick handed to the shadow task
+struct ShadowInput {
+  unsigned long tick;
+  FeatureVector features;
+  float sequence[LSTM_SEQUENCE_LENGTH][LSTM_INPUT_FEATURES];
+  float members[ENSEMBLE_MODELS];  // Production member outputs (NAN where not run)
+  float active;                    // Active model of the candidate's type (NAN if not run)
+  float production;                // predictAdvanced() prediction of the tick
+};
+
+// Shadow candidate counters
+struct ShadowStats {
+  bool loaded;
+  ModelType type;
+  uint32_t crc;                       // Payload CRC of the candidate
+  uint32_t cycles_per_second;         // Budget cap
+  unsigned long offered;              // Finished ticks
+  unsigned long evaluated;            // Ticks the candidate ran on
+  unsigned long skipped_budget;       // Budget used up
+  unsigned long skipped_busy;         // Previous tick still running
+  unsigned long disagreements;        // Candidate decision != production decision
+  unsigned long compared_active;      // Ticks where the active model of the same type ran too
+  unsigned long active_disagreements; // ...with a different decision
+  float abs_diff_sum;                 // Sum of |candidate - active| over those ticks
+  InferenceStats latency;             // Candidate run time (includes preemption)
+};
+
+// Hot-swap slot state of one model
+enum SwapState {
+  SWAP_IDLE = 0,                // Standby slot free
+  SWAP_STAGING,                 // Standby slot being written and validated
+  SWAP_READY                    // Validated; becomes active at the next tick boundary
+};
+
+// Hot-swap counters of one model
+struct ModelSwapStats {
+  uint8_t state;                // SwapState
+  unsigned long swaps;          // Committed swaps since boot
+  unsigned long rejects;        // Candidates that failed the checksum or smoke test
+  uint32_t active_crc;          // Payload CRC of the active weights (0 = built-in or trained on device)
+  uint32_t staged_crc;          // Payload CRC of the candidate in the standby slot
+  unsigned long stage_micros;   // Last load + checksum + smoke test (caller's task)
+  uint32_t commit_cycles;       // Last slot switch at the tick boundary
+  float smoke_output;           // Candidate output on the normal probe
+};
+
 // Enhanced ML Model class
 class EnhancedMLModel {
 public:
@@ -153,6 +393,22 @@ public:
   static void switchModel(ModelType type);
   static ModelType getCurrentModel();
   
+  // Hot-swap: load into the inactive slot, validate, switch at a tick boundary
+  static bool stageModel(ModelType type, Stream& source);
+  static bool stageModel(ModelType type);
+  static ModelSwapStats getSwapStats(ModelType type);
+  
+  // Shadow inference (candidate compared with production, never acted on)
+  static bool loadShadowModel(ModelType type, Stream& source);
+  static bool loadShadowModel(ModelType type);
+  static void* readShadowModel(ModelType type, Stream& source, uint32_t* crc);
+  static bool installShadowModel(ModelType type, void* weights, uint32_t crc);
+  static void unloadShadowModel();
+  static void setShadowBudget(uint32_t cyclesPerSecond);
+  static bool startShadowTask();
+  static ShadowStats getShadowStats();
+  static void resetShadowStats();
+  
   // LSTM methods
   static bool initLSTM();
   static float predictLSTM(const float* sequence, int length);
@@ -175,10 +431,24 @@ public:
   // Online learning
   static bool initOnlineLearner();
   static void addTrainingSample(const SensorData& data, bool isThreat);
+  static void addTrainingSample(const FeatureVector& features, bool isThreat);
   static bool needsRetraining();
   static void retrainModel();
-  static float getAccuracy();
-  static float getFalsePositiveRate();
+  static float getAccuracy();              // Agreement with the detector's labels, not ground truth
+  static float getFalsePositiveRate();     // Same labels: normal per the detector
+  static int getTrainingSampleCount();
+  static bool getTrainingSample(int index, float* features, bool* label);
+  static size_t getTrainingBufferSize();
+  static float getAverageInsertCycles();
+  static bool startTrainingTask();
+  static float getTrainingLoss();
+  static unsigned long getTrainingEpochs();
+  
+  // Parallel ensemble
+  static bool startEnsembleWorker();
+  static void setParallelEnsemble(bool enabled);
+  static ParallelStats getParallelStats();
+  static float getParallelSpeedup();
   
   // Hybrid methods
   static float predictHybrid(const SensorData& data);
@@ -191,20 +461,95 @@ public:
   static float calculateThreatScore(const SensorData& data);
   static bool isAnomalyDetected(const SensorData& data);
   
+  // Per-tick inference
+  static const FeatureVector& prepareFeatures(const SensorData& data);
+  static const TickResults& getTickResults();
+  static uint32_t getLastInferenceCycles();
+  static float getAverageInferenceCycles();
+  
+  // Inference cascade
+  static void setCascadeConfig(const CascadeConfig& config);
+  static CascadeConfig getCascadeConfig();
+  static CascadeStats getCascadeStats();
+  static void resetCascadeStats();
+  static void recordCascadeLabel(bool isAttack);
+  static float getEarlyExitRate();
+  static float getMissedDetectionRate();
+  
   // Model evaluation
   static float evaluateModel(ModelType type, const SensorData* testData, const bool* testLabels, int count);
+  static float getTickScore(ModelType type);
+  static float getDecisionThreshold(ModelType type);
   static void printModelStats();
   static size_t getModelSize(ModelType type);
+  static ModelSizeInfo getModelSizeInfo(ModelType type);
   static float getInferenceTime(ModelType type);
+  static InferenceStats getInferenceStats(ModelType type);
+  static void resetInferenceStats();
+  static const char* getModelName(ModelType type);
+  static unsigned long getModelLoadTime(ModelType type);
   
 private:
   static bool _initialized;
   static ModelType _currentModel;
-  static LSTMModel _lstmModel;
+  static LSTMModel* _lstmModel;   // RAM copy, allocated only for SD or seeded weights
   static AutoencoderModel _autoencoderModel;
   static EnsembleModel _ensembleModel;
   static OnlineLearner _onlineLearner;
   
+  // Active weights: mapped or compiled flash, or the RAM structs above
+  static const LSTMModel* _lstm;
+  static const AutoencoderModel* _autoencoder;
+  static AutoencoderModel _autoencoderBackBuffer;
+  static AutoencoderTrainer _trainer;
+  static TaskHandle_t _trainingTask;
+  static volatile bool _trainerBusy;     // _trainer is owned by one training run at a time
+  static portMUX_TYPE _learnerMux;
+  static unsigned long _modelLoadMicros[MODEL_TYPE_COUNT];
+  
+  // Hot-swap standby slots (the autoencoder shares _autoencoderBackBuffer with the trainer)
+  static LSTMModel* _lstmStandby;
+  static float _ensembleStandby[ENSEMBLE_MODELS];
+  static ModelSwapStats _swap[MODEL_TYPE_COUNT];
+  static volatile uint32_t _weightReaders[MODEL_AUTOENCODER + 1][3];  // Pins per slot: RAM, RAM standby, flash
+  static LSTMCell _probeCell;
+  
+  // Shadow slot
+  static void* _shadowWeights;
+  static ShadowStats _shadow;
+  static ShadowInput _shadowInput;
+  static LSTMCell _shadowCell;
+  static LatencyHistogram _shadowLatency;
+  static TaskHandle_t _shadowTask;
+  static portMUX_TYPE _shadowMux;
+  static volatile bool _shadowBusy;
+  static volatile int32_t _shadowBudget;
+  static unsigned long _shadowRefillMicros;
+  static unsigned long _shadowLogMillis;
+  
+  // Per-tick state
+  static FeatureVector _features;
+  static TickResults _tick;
+  static unsigned long _tickCount;
+  static bool _tickOpen;
+  static uint32_t _lastInferenceCycles;
+  static uint64_t _inferenceCycles;
+  static unsigned long _inferenceCount;
+  static CascadeConfig _cascadeConfig;
+  static CascadeStats _cascadeStats;
+  static unsigned int _exitsSinceAudit;
+  static LatencyHistogram _latency[MODEL_TYPE_COUNT];
+  
+  // Parallel ensemble worker
+  static TaskHandle_t _ensembleWorker;
+  static SemaphoreHandle_t _workerDone;  // Given by the worker; the caller's notification slot stays free
+  static volatile bool _lstmComputed;    // Set by the worker when the forked LSTM finished
+  static volatile uint32_t _workerCycles;
+  static uint32_t _forkStart;
+  static bool _lstmForked;
+  static bool _parallelEnabled;
+  static ParallelStats _parallelStats;
+  
   // LSTM state
   static LSTMCell _lstmCell;
   static float _lstmSequence[LSTM_SEQUENCE_LENGTH][LSTM_INPUT_FEATURES];
@@ -213,24 +558,109 @@ private:
   // Helper methods
   static void _initializeLSTMWeights();
   static void _initializeAutoencoderWeights();
-  static void _updateLSTMSequence(const SensorData& data);
+  static float _initialWeight(uint32_t& seed);
+  static LSTMModel* _allocateLSTMWeights();
+  static void _releaseLSTMWeights();
+  static void _updateLSTMSequence(const float* scaled);
+  static float _runLSTM(const LSTMModel* w, const float* sequence, LSTMCell& cell);
+  static float _runAutoencoder(const AutoencoderModel* w, const float* input);
+  static bool _claimStandby(ModelType type);
+  static void* _standbySlot(ModelType type);
+  static const void* _activeWeights(ModelType type);
+  static int _weightSlot(ModelType type, const void* weights);
+  static const void* _pinWeights(ModelType type);
+  static void _unpinWeights(ModelType type, const void* weights);
+  static size_t _weightBytes(ModelType type);
+  static bool _smokeTest(ModelType type, const void* weights, float* output);
+  static void _commitSwaps();
+  static void _offerShadow();
+  static float _runShadow(const ShadowInput& in);
+  static void _shadowTaskLoop(void* param);
   static float _sigmoid(float x);
   static float _tanh(float x);
   static float _relu(float x);
   static void _softmax(float* values, int count);
   static float _calculateLoss(float prediction, float target);
   static void _updateWeights(float* weights, int count, float gradient, float learningRate);
-  static void _normalizeInput(float* input, int count);
+  static void _rawFeatures(const SensorData& data, float* raw);
+  static void _normalizeInput(const SensorData& data, float* scaled);
+  static void _addTrainingSample(const float* raw, bool isThreat);
+  static bool _beginTick(const SensorData& data);
+  static void _endTick(bool owner);
+  static void _tickSequence();
+  static float _tickLSTM();
+  static float _tickAutoencoder();
+  static float _tickRules(const SensorData& data);
+  static float _tickTrees();
+  static float _autoencoderScore(float reconstructionError);
+  static float _computeTickLSTM();
+  static void _evaluateMembers(const SensorData& data);
+  static bool _forkLSTM();
+  static void _joinLSTM(bool used);
+  static void _ensembleWorkerLoop(void* param);
+  static void _storeTrainingSample(int slot, const float* features, bool label);
+  static void _trainingTaskLoop(void* param);
+  static bool _claimTrainer();
+  static void _runTrainingEpoch(bool yieldSlices);
+  static float _trainAutoencoderBatch(const float (*batch)[SCALED_FEATURES], int count);
+  static void _adamStep();
+  static bool _publishAutoencoder(unsigned long generation);
+  static void _scoreAgreement();
   static void _denormalizeOutput(float* output, int count);
 };
 
 // Implementation
 bool EnhancedMLModel::_initialized = false;
 ModelType EnhancedMLModel::_currentModel = MODEL_HYBRID;
-LSTMModel EnhancedMLModel::_lstmModel;
+LSTMModel* EnhancedMLModel::_lstmModel = nullptr;
 AutoencoderModel EnhancedMLModel::_autoencoderModel;
 EnsembleModel EnhancedMLModel::_ensembleModel;
 OnlineLearner EnhancedMLModel::_onlineLearner;
+const LSTMModel* EnhancedMLModel::_lstm = nullptr;
+const AutoencoderModel* EnhancedMLModel::_autoencoder = &EnhancedMLModel::_autoencoderModel;
+unsigned long EnhancedMLModel::_modelLoadMicros[MODEL_TYPE_COUNT] = {0};
+LSTMModel* EnhancedMLModel::_lstmStandby = nullptr;
+float EnhancedMLModel::_ensembleStandby[ENSEMBLE_MODELS];
+ModelSwapStats EnhancedMLModel::_swap[MODEL_TYPE_COUNT];
+volatile uint32_t EnhancedMLModel::_weightReaders[MODEL_AUTOENCODER + 1][3] = {{0}};
+LSTMCell EnhancedMLModel::_probeCell;
+void* EnhancedMLModel::_shadowWeights = nullptr;
+ShadowStats EnhancedMLModel::_shadow = {false, MODEL_LSTM, 0, SHADOW_CYCLE_BUDGET};
+ShadowInput EnhancedMLModel::_shadowInput;
+LSTMCell EnhancedMLModel::_shadowCell;
+LatencyHistogram EnhancedMLModel::_shadowLatency;
+TaskHandle_t EnhancedMLModel::_shadowTask = nullptr;
+portMUX_TYPE EnhancedMLModel::_shadowMux = portMUX_INITIALIZER_UNLOCKED;
+volatile bool EnhancedMLModel::_shadowBusy = false;
+volatile int32_t EnhancedMLModel::_shadowBudget = 0;
+unsigned long EnhancedMLModel::_shadowRefillMicros = 0;
+unsigned long EnhancedMLModel::_shadowLogMillis = 0;
+AutoencoderModel EnhancedMLModel::_autoencoderBackBuffer;
+AutoencoderTrainer EnhancedMLModel::_trainer;
+TaskHandle_t EnhancedMLModel::_trainingTask = nullptr;
+volatile bool EnhancedMLModel::_trainerBusy = false;
+portMUX_TYPE EnhancedMLModel::_learnerMux = portMUX_INITIALIZER_UNLOCKED;
+FeatureVector EnhancedMLModel::_features;
+TickResults EnhancedMLModel::_tick;
+unsigned long EnhancedMLModel::_tickCount = 0;
+bool EnhancedMLModel::_tickOpen = false;
+uint32_t EnhancedMLModel::_lastInferenceCycles = 0;
+uint64_t EnhancedMLModel::_inferenceCycles = 0;
+unsigned long EnhancedMLModel::_inferenceCount = 0;
+CascadeConfig EnhancedMLModel::_cascadeConfig = {
+  CASCADE_ENABLED, CASCADE_RULE_CLEAR, CASCADE_RECONSTRUCTION_CLEAR, CASCADE_RULE_THREAT, CASCADE_AUDIT_INTERVAL
+};
+CascadeStats EnhancedMLModel::_cascadeStats = {0};
+unsigned int EnhancedMLModel::_exitsSinceAudit = 0;
+LatencyHistogram EnhancedMLModel::_latency[MODEL_TYPE_COUNT];
+TaskHandle_t EnhancedMLModel::_ensembleWorker = nullptr;
+SemaphoreHandle_t EnhancedMLModel::_workerDone = nullptr;
+volatile bool EnhancedMLModel::_lstmComputed = false;
+volatile uint32_t EnhancedMLModel::_workerCycles = 0;
+uint32_t EnhancedMLModel::_forkStart = 0;
+bool EnhancedMLModel::_lstmForked = false;
+bool EnhancedMLModel::_parallelEnabled = PARALLEL_ENSEMBLE_ENABLED;
+ParallelStats EnhancedMLModel::_parallelStats = {0};
 LSTMCell EnhancedMLModel::_lstmCell;
 float EnhancedMLModel::_lstmSequence[LSTM_SEQUENCE_LENGTH][LSTM_INPUT_FEATURES];
 int EnhancedMLModel::_sequenceIndex = 0;
@@ -242,6 +672,25 @@ bool EnhancedMLModel::init() {
   
   Serial.println("Initializing Enhanced ML Model...");
   
+  // Check fast activation error bounds before trusting any prediction
+  float tanhError = 0.0;
+  float sigmoidError = 0.0;
+  if (!FastActivations::verify(&tanhError, &sigmoidError)) {
+    Serial.println("Fast activation error out of bounds: tanh " + String(tanhError, 6) +
+                   ", sigmoid " + String(sigmoidError, 6));
+    return false;
+  }
+#if DEBUG_LEVEL >= 3
+  FastActivations::benchmark();
+#endif
+  
+  // Normalization statistics must be in place before any input is scaled
+#ifdef MODEL_WEIGHTS_SCALER
+  FeatureScaler::init(&MODEL_WEIGHTS_SCALER);
+#else
+  FeatureScaler::init();
+#endif
+  
   // Initialize all models
   if (!initLSTM()) {
     Serial.println("Failed to initialize LSTM model");
@@ -263,6 +712,8 @@ bool EnhancedMLModel::init() {
     return false;
   }
   
+  resetInferenceStats();
+  
   // Initialize sequence buffer
   for (int i = 0; i < LSTM_SEQUENCE_LENGTH; i++) {
     for (int j = 0; j < LSTM_INPUT_FEATURES; j++) {
@@ -271,6 +722,15 @@ bool EnhancedMLModel::init() {
   }
   
   _initialized = true;
+  
+  if (TRAINING_TASK_ENABLED && !startTrainingTask()) {
+    Serial.println("Background training unavailable");
+  }
+  
+  if (PARALLEL_ENSEMBLE_ENABLED && !startEnsembleWorker()) {
+    Serial.println("Parallel ensemble unavailable - members run on one core");
+  }
+  
   Serial.println("Enhanced ML Model initialized successfully");
   return true;
 }
@@ -289,8 +749,23 @@ bool EnhancedMLModel::isInitialized() {
 bool EnhancedMLModel::initLSTM() {
   Serial.println("Initializing LSTM model...");
   
-  // Initialize weights with small random values
-  _initializeLSTMWeights();
+  // Weight sources in order: flash partition, SD card, compiled-in tables, seeded initialization
+  if (!loadModel(MODEL_LSTM)) {
+    unsigned long start = micros();
+#ifdef MODEL_WEIGHTS_LSTM
+    _lstm = &MODEL_WEIGHTS_LSTM;
+    Serial.println("Using compiled-in LSTM weights");
+#else
+    if (!_allocateLSTMWeights()) {
+      Serial.println("Failed to allocate LSTM weights");
+      return false;
+    }
+    Serial.println("No stored LSTM weights - using seeded initialization");
+    _initializeLSTMWeights();
+    _lstm = _lstmModel;
+#endif
+    _modelLoadMicros[MODEL_LSTM] = micros() - start;
+  }
   
   // Initialize LSTM cell
   for (int i = 0; i < LSTM_HIDDEN_SIZE; i++) {
@@ -309,8 +784,19 @@ bool EnhancedMLModel::initLSTM() {
 bool EnhancedMLModel::initAutoencoder() {
   Serial.println("Initializing Autoencoder model...");
   
-  // Initialize weights
-  _initializeAutoencoderWeights();
+  // Weight sources in order: flash partition, SD card, compiled-in tables, seeded initialization
+  if (!loadModel(MODEL_AUTOENCODER)) {
+    unsigned long start = micros();
+#ifdef MODEL_WEIGHTS_AUTOENCODER
+    _autoencoder = &MODEL_WEIGHTS_AUTOENCODER;
+    Serial.println("Using compiled-in Autoencoder weights");
+#else
+    Serial.println("No stored Autoencoder weights - using seeded initialization");
+    _initializeAutoencoderWeights();
+    _autoencoder = &_autoencoderModel;
+#endif
+    _modelLoadMicros[MODEL_AUTOENCODER] = micros() - start;
+  }
   
   Serial.println("Autoencoder model initialized");
   return true;
@@ -323,11 +809,25 @@ bool EnhancedMLModel::initEnsemble() {
   _ensembleModel.models[0] = MODEL_LSTM;
   _ensembleModel.models[1] = MODEL_AUTOENCODER;
   _ensembleModel.models[2] = MODEL_RULE_BASED;
+  _ensembleModel.models[3] = MODEL_TREE_ENSEMBLE;
+  
+  // Initialize weights; without compiled trees the ensemble keeps three members
+  static const float defaultWeights[ENSEMBLE_MODELS] = ENSEMBLE_WEIGHTS;
+  static const float treeWeights[ENSEMBLE_MODELS] = ENSEMBLE_WEIGHTS_WITH_TREES;
+  bool trees = TreeEnsemble::isAvailable();
+  _ensembleModel.member_count = trees ? ENSEMBLE_MODELS : ENSEMBLE_MODELS - 1;
+  memcpy(_ensembleModel.weights, trees ? treeWeights : defaultWeights, sizeof(_ensembleModel.weights));
+  if (trees) {
+    Serial.println("Tree ensemble member: " + String(TreeEnsemble::getTreeCount()) + " trees, " +
+                   String(TreeEnsemble::getNodeCount()) + " nodes");
+  }
   
-  // Initialize weights
-  _ensembleModel.weights[0] = 0.4;
-  _ensembleModel.weights[1] = 0.35;
-  _ensembleModel.weights[2] = 0.25;
+  // Override defaults with stored or compiled-in member weights
+  if (!loadModel(MODEL_ENSEMBLE)) {
+#ifdef MODEL_WEIGHTS_ENSEMBLE
+    memcpy(_ensembleModel.weights, MODEL_WEIGHTS_ENSEMBLE, sizeof(_ensembleModel.weights));
+#endif
+  }
   
   Serial.println("Ensemble model initialized");
   return true;
@@ -336,13 +836,40 @@ bool EnhancedMLModel::initEnsemble() {
 bool EnhancedMLModel::initOnlineLearner() {
   Serial.println("Initializing Online Learner...");
   
+  // Allocate the sample ring once; keep it across re-init
+  if (!_onlineLearner.samples) {
+    size_t sampleBytes = sizeof(TrainingSample) * MAX_TRAINING_SAMPLES;
+    size_t labelBytes = (MAX_TRAINING_SAMPLES + 7) / 8;
+    
+    _onlineLearner.in_psram = false;
+    if (TRAINING_BUFFER_IN_PSRAM && psramFound()) {
+      _onlineLearner.samples = (TrainingSample*)ps_malloc(sampleBytes);
+      _onlineLearner.in_psram = (_onlineLearner.samples != nullptr);
+    }
+    if (!_onlineLearner.samples) {
+      _onlineLearner.samples = (TrainingSample*)malloc(sampleBytes);
+    }
+    _onlineLearner.labels = (uint8_t*)calloc(labelBytes, 1);
+    
+    if (!_onlineLearner.samples || !_onlineLearner.labels) {
+      Serial.println("Failed to allocate training buffer");
+      return false;
+    }
+  }
+  
+  _onlineLearner.head = 0;
   _onlineLearner.sample_count = 0;
+  _onlineLearner.samples_seen = 0;
   _onlineLearner.learning_rate = LEARNING_RATE;
   _onlineLearner.needs_retraining = false;
-  _onlineLearner.accuracy = 0.0;
-  _onlineLearner.false_positive_rate = 0.0;
-  
-  Serial.println("Online Learner initialized");
+  _onlineLearner.agreement = 0.0;
+  _onlineLearner.false_alarm_rate = 0.0;
+  _onlineLearner.insert_cycles = 0;
+  _onlineLearner.insert_count = 0;
+  
+  Serial.println("Online Learner initialized: " + String(MAX_TRAINING_SAMPLES) + " samples, " +
+                 String(getTrainingBufferSize()) + " bytes in " +
+                 String(_onlineLearner.in_psram ? "PSRAM" : "internal RAM"));
   return true;
 }
 
@@ -351,78 +878,83 @@ float EnhancedMLModel::predictLSTM(const float* sequence, int length) {
     return 0.0;
   }
   
+  // Weights are switched only at tick boundaries, after the worker joined
+  return _runLSTM(_lstm, sequence, _lstmCell);
+}
+
+float EnhancedMLModel::_runLSTM(const LSTMModel* w, const float* sequence, LSTMCell& cell) {
   // Reset LSTM cell state
   for (int i = 0; i < LSTM_HIDDEN_SIZE; i++) {
-    _lstmCell.cell_state[i] = 0.0;
-    _lstmCell.hidden_state[i] = 0.0;
+    cell.cell_state[i] = 0.0;
+    cell.hidden_state[i] = 0.0;
   }
   
   // Process sequence
   for (int t = 0; t < LSTM_SEQUENCE_LENGTH; t++) {
     // Calculate forget gate
     for (int i = 0; i < LSTM_HIDDEN_SIZE; i++) {
-      float sum = _lstmModel.bf[i];
+      float sum = w->bf[i];
       for (int j = 0; j < LSTM_INPUT_FEATURES; j++) {
-        sum += sequence[t * LSTM_INPUT_FEATURES + j] * _lstmModel.Wf[j][i];
+        sum += sequence[t * LSTM_INPUT_FEATURES + j] * w->Wf[j][i];
       }
       for (int j = 0; j < LSTM_HIDDEN_SIZE; j++) {
-        sum += _lstmCell.hidden_state[j] * _lstmModel.Uf[j][i];
+        sum += cell.hidden_state[j] * w->Uf[j][i];
       }
-      _lstmCell.forget_gate[i] = _sigmoid(sum);
+      cell.forget_gate[i] = _sigmoid(sum);
     }
     
     // Calculate input gate
     for (int i = 0; i < LSTM_HIDDEN_SIZE; i++) {
-      float sum = _lstmModel.bi[i];
+      float sum = w->bi[i];
       for (int j = 0; j < LSTM_INPUT_FEATURES; j++) {
-        sum += sequence[t * LSTM_INPUT_FEATURES + j] * _lstmModel.Wi[j][i];
+        sum += sequence[t * LSTM_INPUT_FEATURES + j] * w->Wi[j][i];
       }
       for (int j = 0; j < LSTM_HIDDEN_SIZE; j++) {
-        sum += _lstmCell.hidden_state[j] * _lstmModel.Ui[j][i];
+        sum += cell.hidden_state[j] * w->Ui[j][i];
       }
-      _lstmCell.input_gate[i] = _sigmoid(sum);
+      cell.input_gate[i] = _sigmoid(sum);
     }
     
     // Calculate candidate values
     for (int i = 0; i < LSTM_HIDDEN_SIZE; i++) {
-      float sum = _lstmModel.bc[i];
+      float sum = w->bc[i];
       for (int j = 0; j < LSTM_INPUT_FEATURES; j++) {
-        sum += sequence[t * LSTM_INPUT_FEATURES + j] * _lstmModel.Wc[j][i];
+        sum += sequence[t * LSTM_INPUT_FEATURES + j] * w->Wc[j][i];
       }
       for (int j = 0; j < LSTM_HIDDEN_SIZE; j++) {
-        sum += _lstmCell.hidden_state[j] * _lstmModel.Uc[j][i];
+        sum += cell.hidden_state[j] * w->Uc[j][i];
       }
-      _lstmCell.candidate[i] = _tanh(sum);
+      cell.candidate[i] = _tanh(sum);
     }
     
     // Update cell state
     for (int i = 0; i < LSTM_HIDDEN_SIZE; i++) {
-      _lstmCell.cell_state[i] = _lstmCell.forget_gate[i] * _lstmCell.cell_state[i] + 
-                                _lstmCell.input_gate[i] * _lstmCell.candidate[i];
+      cell.cell_state[i] = cell.forget_gate[i] * cell.cell_state[i] + 
+                                cell.input_gate[i] * cell.candidate[i];
     }
     
     // Calculate output gate
     for (int i = 0; i < LSTM_HIDDEN_SIZE; i++) {
-      float sum = _lstmModel.bo[i];
+      float sum = w->bo[i];
       for (int j = 0; j < LSTM_INPUT_FEATURES; j++) {
-        sum += sequence[t * LSTM_INPUT_FEATURES + j] * _lstmModel.Wo[j][i];
+        sum += sequence[t * LSTM_INPUT_FEATURES + j] * w->Wo[j][i];
       }
       for (int j = 0; j < LSTM_HIDDEN_SIZE; j++) {
-        sum += _lstmCell.hidden_state[j] * _lstmModel.Uo[j][i];
+        sum += cell.hidden_state[j] * w->Uo[j][i];
       }
-      _lstmCell.output_gate[i] = _sigmoid(sum);
+      cell.output_gate[i] = _sigmoid(sum);
     }
     
     // Update hidden state
     for (int i = 0; i < LSTM_HIDDEN_SIZE; i++) {
-      _lstmCell.hidden_state[i] = _lstmCell.output_gate[i] * _tanh(_lstmCell.cell_state[i]);
+      cell.hidden_state[i] = cell.output_gate[i] * _tanh(cell.cell_state[i]);
     }
   }
   
   // Calculate output
-  float output = _lstmModel.by[0];
+  float output = w->by[0];
   for (int i = 0; i < LSTM_HIDDEN_SIZE; i++) {
-    output += _lstmCell.hidden_state[i] * _lstmModel.Wy[i][0];
+    output += cell.hidden_state[i] * w->Wy[i][0];
   }
   
   return _sigmoid(output);
@@ -433,21 +965,29 @@ float EnhancedMLModel::predictAutoencoder(const float* input) {
     return 0.0;
   }
   
+  // The trainer may swap the weights mid-call; the pin keeps the old slot intact
+  const AutoencoderModel* weights = (const AutoencoderModel*)_pinWeights(MODEL_AUTOENCODER);
+  float error = _runAutoencoder(weights, input);
+  _unpinWeights(MODEL_AUTOENCODER, weights);
+  return error;
+}
+
+float EnhancedMLModel::_runAutoencoder(const AutoencoderModel* w, const float* input) {
   // Encoder
   float hidden1[8] = {0};
   for (int i = 0; i < 8; i++) {
-    float sum = _autoencoderModel.b1[i];
-    for (int j = 0; j < INPUT_FEATURES; j++) {
-      sum += input[j] * _autoencoderModel.W1[j][i];
+    float sum = w->b1[i];
+    for (int j = 0; j < SCALED_FEATURES; j++) {
+      sum += input[j] * w->W1[j][i];
     }
     hidden1[i] = _relu(sum);
   }
   
   float hidden2[4] = {0};
   for (int i = 0; i < 4; i++) {
-    float sum = _autoencoderModel.b2[i];
+    float sum = w->b2[i];
     for (int j = 0; j < 8; j++) {
-      sum += hidden1[j] * _autoencoderModel.W2[j][i];
+      sum += hidden1[j] * w->W2[j][i];
     }
     hidden2[i] = _relu(sum);
   }
@@ -455,18 +995,18 @@ float EnhancedMLModel::predictAutoencoder(const float* input) {
   // Decoder
   float hidden3[8] = {0};
   for (int i = 0; i < 8; i++) {
-    float sum = _autoencoderModel.b3[i];
+    float sum = w->b3[i];
     for (int j = 0; j < 4; j++) {
-      sum += hidden2[j] * _autoencoderModel.W3[j][i];
+      sum += hidden2[j] * w->W3[j][i];
     }
     hidden3[i] = _relu(sum);
   }
   
-  float reconstructed[INPUT_FEATURES] = {0};
-  for (int i = 0; i < INPUT_FEATURES; i++) {
-    float sum = _autoencoderModel.b4[i];
+  float reconstructed[SCALED_FEATURES] = {0};
+  for (int i = 0; i < SCALED_FEATURES; i++) {
+    float sum = w->b4[i];
     for (int j = 0; j < 8; j++) {
-      sum += hidden3[j] * _autoencoderModel.W4[j][i];
+      sum += hidden3[j] * w->W4[j][i];
     }
     reconstructed[i] = sum;
   }
@@ -477,11 +1017,11 @@ float EnhancedMLModel::predictAutoencoder(const float* input) {
 
 float EnhancedMLModel::calculateReconstructionError(const float* input, const float* reconstructed) {
   float error = 0.0;
-  for (int i = 0; i < INPUT_FEATURES; i++) {
+  for (int i = 0; i < SCALED_FEATURES; i++) {
     float diff = input[i] - reconstructed[i];
     error += diff * diff;
   }
-  return sqrt(error / INPUT_FEATURES);
+  return sqrt(error / SCALED_FEATURES);
 }
 
 float EnhancedMLModel::predictEnsemble(const SensorData& data) {
@@ -489,27 +1029,26 @@ float EnhancedMLModel::predictEnsemble(const SensorData& data) {
     return 0.0;
   }
   
-  float inputFeatures[INPUT_FEATURES] = {
-    data.current,
-    data.voltage,
-    data.power,
-    data.frequency,
-    data.temperature,
-    (float)currentState
-  };
+  uint32_t start = ESP.getCycleCount();
+  bool owner = _beginTick(data);
   
-  // Get predictions from each model
-  for (int i = 0; i < ENSEMBLE_MODELS; i++) {
+  _evaluateMembers(data);
+  
+  // Collect predictions in member order (all memoized now), so the result
+  // does not depend on which core finished first
+  for (int i = 0; i < _ensembleModel.member_count; i++) {
     switch (_ensembleModel.models[i]) {
       case MODEL_LSTM:
-        _updateLSTMSequence(data);
-        _ensembleModel.predictions[i] = predictLSTM((float*)_lstmSequence, LSTM_SEQUENCE_LENGTH);
+        _ensembleModel.predictions[i] = _tickLSTM();
         break;
       case MODEL_AUTOENCODER:
-        _ensembleModel.predictions[i] = predictAutoencoder(inputFeatures);
+        _ensembleModel.predictions[i] = _tickAutoencoder();
         break;
       case MODEL_RULE_BASED:
-        _ensembleModel.predictions[i] = AdvancedThreatDetection::comprehensiveThreatAnalysis(data);
+        _ensembleModel.predictions[i] = _tickRules(data);
+        break;
+      case MODEL_TREE_ENSEMBLE:
+        _ensembleModel.predictions[i] = _tickTrees();
         break;
       default:
         _ensembleModel.predictions[i] = 0.0;
@@ -518,18 +1057,22 @@ float EnhancedMLModel::predictEnsemble(const SensorData& data) {
   
   // Calculate weighted average
   _ensembleModel.final_prediction = 0.0;
-  for (int i = 0; i < ENSEMBLE_MODELS; i++) {
+  for (int i = 0; i < _ensembleModel.member_count; i++) {
     _ensembleModel.final_prediction += _ensembleModel.predictions[i] * _ensembleModel.weights[i];
   }
   
   // Calculate confidence based on agreement
   float variance = 0.0;
-  for (int i = 0; i < ENSEMBLE_MODELS; i++) {
+  for (int i = 0; i < _ensembleModel.member_count; i++) {
     float diff = _ensembleModel.predictions[i] - _ensembleModel.final_prediction;
     variance += diff * diff;
   }
   _ensembleModel.confidence = 1.0 / (1.0 + variance);
+  _tick.ensemble = _ensembleModel.final_prediction;
+  _tick.ensemble_valid = true;
   
+  _endTick(owner);
+  LatencyStats::record(_latency[MODEL_ENSEMBLE], ESP.getCycleCount() - start);
   return _ensembleModel.final_prediction;
 }
 
@@ -538,15 +1081,19 @@ float EnhancedMLModel::predictHybrid(const SensorData& data) {
     return 0.0;
   }
   
+  bool owner = _beginTick(data);
+  
   // Get ML prediction
   float mlPrediction = predictEnsemble(data);
   
-  // Get rule-based prediction
-  float rulePrediction = AdvancedThreatDetection::comprehensiveThreatAnalysis(data);
+  // Get rule-based prediction (already computed as an ensemble member)
+  float rulePrediction = _tickRules(data);
   
   // Calculate confidence
   float confidence = _ensembleModel.confidence;
   
+  _endTick(owner);
+  
   // Blend predictions
   return blendPredictions(mlPrediction, rulePrediction, confidence);
 }
@@ -566,24 +1113,84 @@ EnhancedMLPrediction EnhancedMLModel::predictAdvanced(const SensorData& data) {
     return prediction;
   }
   
-  // Get hybrid prediction
-  prediction.prediction = predictHybrid(data);
-  prediction.confidence = _ensembleModel.confidence;
-  prediction.primary_model = _currentModel;
-  prediction.timestamp = millis();
+  uint32_t start = ESP.getCycleCount();
+  
+  // Reuse the features from prepareFeatures() when the caller built them
+  _beginTick(data);
+  _cascadeStats.ticks++;
   
-  // Calculate uncertainty
-  prediction.uncertainty = calculateUncertainty(_ensembleModel.predictions, ENSEMBLE_MODELS);
+  // Start the LSTM on the other core; stage 0 runs here meanwhile
+  if (!_cascadeConfig.enabled || PARALLEL_SPECULATIVE_LSTM) {
+    _forkLSTM();
+  }
+  
+  // Stage 0: rule engine and autoencoder reconstruction error
+  float ruleScore = _tickRules(data);
+  float reconstructionError = _tickAutoencoder();
+  bool clear = ruleScore <= _cascadeConfig.rule_clear &&
+               reconstructionError <= _cascadeConfig.reconstruction_clear;
+  bool threat = ruleScore >= _cascadeConfig.rule_threat;
+  bool decided = _cascadeConfig.enabled && (clear || threat);
+  
+  // Periodically let the full ensemble check a decided tick
+  bool audit = false;
+  if (decided && _cascadeConfig.audit_interval > 0 && ++_exitsSinceAudit >= _cascadeConfig.audit_interval) {
+    _exitsSinceAudit = 0;
+    audit = true;
+  }
+  
+  if (decided && !audit) {
+    // Early exit: keep the LSTM window continuous without running the LSTM
+    // (a forked LSTM already advanced it and is simply not waited for)
+    if (!_lstmForked) {
+      _tickSequence();
+    }
+    float stage0[2] = {ruleScore, _autoencoderScore(reconstructionError)};
+    prediction.prediction = ruleScore;
+    prediction.uncertainty = calculateUncertainty(stage0, 2);
+    prediction.confidence = 1.0 / (1.0 + prediction.uncertainty * prediction.uncertainty);
+    prediction.primary_model = MODEL_RULE_BASED;
+    _tick.early_exit = true;
+    _cascadeStats.early_exits++;
+  } else {
+    // Get hybrid prediction
+    prediction.prediction = predictHybrid(data);
+    prediction.confidence = _ensembleModel.confidence;
+    prediction.primary_model = _currentModel;
+    
+    // Calculate uncertainty
+    prediction.uncertainty = calculateUncertainty(_ensembleModel.predictions, _ensembleModel.member_count);
+    
+    if (audit) {
+      _cascadeStats.audits++;
+      if (clear && prediction.prediction > THREAT_THRESHOLD) {
+        _cascadeStats.audit_misses++;
+      }
+    } else {
+      _cascadeStats.escalations++;
+    }
+  }
+  prediction.timestamp = millis();
+  _tick.prediction = prediction.prediction;
+  _tick.prediction_valid = true;
   
   // Detect anomaly
-  prediction.is_anomaly = isAnomalyDetected(data);
+  prediction.is_anomaly = reconstructionError > AUTOENCODER_ANOMALY_THRESHOLD;
   
-  // Classify attack
-  prediction.attack_type = classifyAttack(data);
+  // Classify attack (reported by the rule engine run)
+  prediction.attack_type = _tick.attack_type;
   
   // Calculate attack confidence
   prediction.attack_confidence = AdvancedThreatDetection::getAttackSeverity(prediction.attack_type);
   
+  // The tick is complete; the next call starts a new one
+  _tickOpen = false;
+  
+  _lastInferenceCycles = ESP.getCycleCount() - start;
+  _inferenceCycles += _lastInferenceCycles;
+  _inferenceCount++;
+  LatencyStats::record(_latency[MODEL_HYBRID], _lastInferenceCycles);
+  
   return prediction;
 }
 
@@ -595,43 +1202,218 @@ AttackType EnhancedMLModel::classifyAttack(const SensorData& data) {
 
 bool EnhancedMLModel::isAnomalyDetected(const SensorData& data) {
   // Use autoencoder reconstruction error for anomaly detection
-  float inputFeatures[INPUT_FEATURES] = {
-    data.current,
-    data.voltage,
-    data.power,
-    data.frequency,
-    data.temperature,
-    (float)currentState
-  };
+  bool owner = _beginTick(data);
+  float reconstructionError = _tickAutoencoder();
+  _endTick(owner);
+  
+  return reconstructionError > AUTOENCODER_ANOMALY_THRESHOLD;
+}
+
+const FeatureVector& EnhancedMLModel::prepareFeatures(const SensorData& data) {
+  // A speculative LSTM from the previous tick may still own the memo
+  _joinLSTM(false);
   
-  float reconstructionError = predictAutoencoder(inputFeatures);
-  return reconstructionError > 0.5; // Threshold for anomaly detection
+  // Nothing reads the weights between two ticks: switch in staged models
+  _commitSwaps();
+  
+  // The finished tick is settled; hand a copy to the shadow before it is overwritten
+  if (_shadow.loaded) {
+    _offerShadow();
+  }
+  
+  // Build the inputs once; every model of this tick reads them
+  _rawFeatures(data, _features.raw);
+  FeatureScaler::apply(_features.raw, _features.scaled);
+  
+  memset(&_tick, 0, sizeof(_tick));
+  _tick.tick = ++_tickCount;
+  _tickOpen = true;
+  
+  return _features;
+}
+
+const TickResults& EnhancedMLModel::getTickResults() {
+  // Settle a pending speculative LSTM so the fields are stable
+  _joinLSTM(false);
+  return _tick;
+}
+
+uint32_t EnhancedMLModel::getLastInferenceCycles() {
+  return _lastInferenceCycles;
+}
+
+float EnhancedMLModel::getAverageInferenceCycles() {
+  if (_inferenceCount == 0) {
+    return 0.0;
+  }
+  return (float)_inferenceCycles / _inferenceCount;
+}
+
+void EnhancedMLModel::setCascadeConfig(const CascadeConfig& config) {
+  _cascadeConfig = config;
+  _exitsSinceAudit = 0;
+}
+
+CascadeConfig EnhancedMLModel::getCascadeConfig() {
+  return _cascadeConfig;
+}
+
+CascadeStats EnhancedMLModel::getCascadeStats() {
+  return _cascadeStats;
+}
+
+void EnhancedMLModel::resetCascadeStats() {
+  memset(&_cascadeStats, 0, sizeof(_cascadeStats));
+  _exitsSinceAudit = 0;
+}
+
+void EnhancedMLModel::recordCascadeLabel(bool isAttack) {
+  // Ground truth for the last predictAdvanced() call (replayed data)
+  if (!isAttack) {
+    return;
+  }
+  _cascadeStats.labelled_attacks++;
+  if (_tick.prediction <= THREAT_THRESHOLD) {
+    _cascadeStats.missed_attacks++;
+    if (_tick.early_exit) {
+      _cascadeStats.missed_early_exits++;
+    }
+  }
+}
+
+float EnhancedMLModel::getEarlyExitRate() {
+  if (_cascadeStats.ticks == 0) {
+    return 0.0;
+  }
+  return (float)_cascadeStats.early_exits / _cascadeStats.ticks;
+}
+
+float EnhancedMLModel::getMissedDetectionRate() {
+  if (_cascadeStats.labelled_attacks == 0) {
+    return 0.0;
+  }
+  return (float)_cascadeStats.missed_attacks / _cascadeStats.labelled_attacks;
+}
+
+bool EnhancedMLModel::_beginTick(const SensorData& data) {
+  if (_tickOpen) {
+    return false; // Part of a tick someone else opened
+  }
+  prepareFeatures(data);
+  return true;
+}
+
+void EnhancedMLModel::_endTick(bool owner) {
+  if (owner) {
+    _tickOpen = false;
+  }
+}
+
+void EnhancedMLModel::_tickSequence() {
+  if (!_tick.sequence_valid) {
+    // The sequence must advance exactly once per tick
+    _updateLSTMSequence(_features.scaled);
+    _tick.sequence_valid = true;
+  }
+}
+
+float EnhancedMLModel::_tickLSTM() {
+  _joinLSTM(true);
+  return _computeTickLSTM();
+}
+
+float EnhancedMLModel::_computeTickLSTM() {
+  if (!_tick.lstm_valid) {
+    _tickSequence();
+    uint32_t start = ESP.getCycleCount();
+    _tick.lstm = predictLSTM((float*)_lstmSequence, LSTM_SEQUENCE_LENGTH);
+    LatencyStats::record(_latency[MODEL_LSTM], ESP.getCycleCount() - start);
+    _tick.lstm_valid = true;
+  }
+  return _tick.lstm;
+}
+
+float EnhancedMLModel::_tickAutoencoder() {
+  if (!_tick.autoencoder_valid) {
+    uint32_t start = ESP.getCycleCount();
+    _tick.reconstruction_error = predictAutoencoder(_features.scaled);
+    LatencyStats::record(_latency[MODEL_AUTOENCODER], ESP.getCycleCount() - start);
+    _tick.autoencoder_valid = true;
+  }
+  return _tick.reconstruction_error;
+}
+
+float EnhancedMLModel::_tickRules(const SensorData& data) {
+  if (!_tick.rules_valid) {
+    // The rule engine appends to its history, so it must run once per tick
+    uint32_t start = ESP.getCycleCount();
+    _tick.rule_score = AdvancedThreatDetection::comprehensiveThreatAnalysis(data, &_tick.attack_type);
+    LatencyStats::record(_latency[MODEL_RULE_BASED], ESP.getCycleCount() - start);
+    _tick.rules_valid = true;
+  }
+  return _tick.rule_score;
+}
+
+float EnhancedMLModel::_tickTrees() {
+  if (!_tick.trees_valid) {
+    uint32_t start = ESP.getCycleCount();
+    int32_t quantized[INPUT_FEATURES];
+    TreeEnsemble::quantize(_features.raw, quantized);
+    _tick.trees = TreeEnsemble::predict(quantized);
+    LatencyStats::record(_latency[MODEL_TREE_ENSEMBLE], ESP.getCycleCount() - start);
+    _tick.trees_valid = true;
+  }
+  return _tick.trees;
 }
 
 void EnhancedMLModel::addTrainingSample(const SensorData& data, bool isThreat) {
-  if (_onlineLearner.sample_count >= MAX_TRAINING_SAMPLES) {
-    // Remove oldest sample
-    for (int i = 0; i < MAX_TRAINING_SAMPLES - 1; i++) {
-      for (int j = 0; j < INPUT_FEATURES; j++) {
-        _onlineLearner.training_data[i][j] = _onlineLearner.training_data[i + 1][j];
-      }
-      _onlineLearner.training_labels[i] = _onlineLearner.training_labels[i + 1];
+  float features[INPUT_FEATURES];
+  _rawFeatures(data, features);
+  _addTrainingSample(features, isThreat);
+}
+
+void EnhancedMLModel::addTrainingSample(const FeatureVector& features, bool isThreat) {
+  _addTrainingSample(features.raw, isThreat);
+}
+
+void EnhancedMLModel::_addTrainingSample(const float* features, bool isThreat) {
+  // Normalization statistics follow normal charging only
+  if (!isThreat && currentState == STATE_CHARGING) {
+    FeatureScaler::update(features);
+  }
+  
+  if (!_onlineLearner.samples) {
+    return;
+  }
+  
+  uint32_t start = ESP.getCycleCount();
+  _onlineLearner.samples_seen++;
+  
+  // The training task reads the ring from the other core
+  portENTER_CRITICAL(&_learnerMux);
+  if (_onlineLearner.sample_count < MAX_TRAINING_SAMPLES) {
+    // Still filling: append
+    _storeTrainingSample(_onlineLearner.head, features, isThreat);
+    _onlineLearner.head = (_onlineLearner.head + 1) % MAX_TRAINING_SAMPLES;
+    _onlineLearner.sample_count++;
+  } else if (TRAINING_RESERVOIR_SAMPLING) {
+    // Algorithm R: keep each of the samples seen with equal probability
+    long slot = random(0, (long)_onlineLearner.samples_seen);
+    if (slot < MAX_TRAINING_SAMPLES) {
+      _storeTrainingSample((int)slot, features, isThreat);
     }
-    _onlineLearner.sample_count--;
+  } else {
+    // Overwrite the oldest sample in O(1)
+    _storeTrainingSample(_onlineLearner.head, features, isThreat);
+    _onlineLearner.head = (_onlineLearner.head + 1) % MAX_TRAINING_SAMPLES;
   }
+  portEXIT_CRITICAL(&_learnerMux);
   
-  // Add new sample
-  _onlineLearner.training_data[_onlineLearner.sample_count][0] = data.current;
-  _onlineLearner.training_data[_onlineLearner.sample_count][1] = data.voltage;
-  _onlineLearner.training_data[_onlineLearner.sample_count][2] = data.power;
-  _onlineLearner.training_data[_onlineLearner.sample_count][3] = data.frequency;
-  _onlineLearner.training_data[_onlineLearner.sample_count][4] = data.temperature;
-  _onlineLearner.training_data[_onlineLearner.sample_count][5] = (float)currentState;
-  _onlineLearner.training_labels[_onlineLearner.sample_count] = isThreat;
-  _onlineLearner.sample_count++;
+  _onlineLearner.insert_cycles += ESP.getCycleCount() - start;
+  _onlineLearner.insert_count++;
   
   // Check if retraining is needed
-  if (_onlineLearner.sample_count % 50 == 0) {
+  if (_onlineLearner.samples_seen % RETRAIN_SAMPLE_INTERVAL == 0) {
     _onlineLearner.needs_retraining = true;
   }
 }
@@ -641,42 +1423,100 @@ bool EnhancedMLModel::needsRetraining() {
 }
 
 void EnhancedMLModel::retrainModel() {
-  if (_onlineLearner.sample_count < 10) {
+  if (_onlineLearner.sample_count < BATCH_SIZE) {
     return; // Not enough data
   }
   
-  Serial.println("Retraining model with " + String(_onlineLearner.sample_count) + " samples...");
-  
-  // Simple retraining - in practice, use more sophisticated methods
-  float accuracy = 0.0;
-  int correct = 0;
+  _onlineLearner.needs_retraining = false;
   
-  for (int i = 0; i < _onlineLearner.sample_count; i++) {
-    float inputFeatures[INPUT_FEATURES];
-    for (int j = 0; j < INPUT_FEATURES; j++) {
-      inputFeatures[j] = _onlineLearner.training_data[i][j];
-    }
-    
-    float prediction = predictHybrid({0}); // Simplified
-    bool predicted = prediction > 0.5;
-    
-    if (predicted == _onlineLearner.training_labels[i]) {
-      correct++;
-    }
+  // Training runs on the other core; inference keeps using the active weights
+  if (_trainingTask) {
+    Serial.println("Retraining autoencoder with " + String(_onlineLearner.sample_count) + " samples in background");
+    xTaskNotifyGive(_trainingTask);
+    return;
   }
   
-  _onlineLearner.accuracy = (float)correct / _onlineLearner.sample_count;
-  _onlineLearner.needs_retraining = false;
-  
-  Serial.println("Model retrained. Accuracy: " + String(_onlineLearner.accuracy * 100) + "%");
+  if (!_claimTrainer()) {
+    Serial.println("Autoencoder training already running - retrain skipped");
+    return;
+  }
+  Serial.println("Retraining autoencoder with " + String(_onlineLearner.sample_count) + " samples...");
+  _runTrainingEpoch(false);
+  __atomic_store_n(&_trainerBusy, false, __ATOMIC_RELEASE);
 }
 
 float EnhancedMLModel::getAccuracy() {
-  return _onlineLearner.accuracy;
+  return _onlineLearner.agreement;
 }
 
 float EnhancedMLModel::getFalsePositiveRate() {
-  return _onlineLearner.false_positive_rate;
+  return _onlineLearner.false_alarm_rate;
+}
+
+int EnhancedMLModel::getTrainingSampleCount() {
+  return _onlineLearner.sample_count;
+}
+
+bool EnhancedMLModel::getTrainingSample(int index, float* features, bool* label) {
+  portENTER_CRITICAL(&_learnerMux);
+  if (index < 0 || index >= _onlineLearner.sample_count) {
+    portEXIT_CRITICAL(&_learnerMux);
+    return false;
+  }
+  
+  // Index 0 is the oldest sample in the ring
+  int slot = (_onlineLearner.sample_count < MAX_TRAINING_SAMPLES)
+    ? index
+    : (_onlineLearner.head + index) % MAX_TRAINING_SAMPLES;
+  
+  TrainingSample sample = _onlineLearner.samples[slot];
+  *label = (_onlineLearner.labels[slot >> 3] >> (slot & 7)) & 1;
+  portEXIT_CRITICAL(&_learnerMux);
+  
+#if TRAINING_SAMPLE_STORAGE == TRAINING_STORAGE_INT16
+  static const float scales[INPUT_FEATURES] = TRAINING_FEATURE_SCALES;
+  for (int j = 0; j < INPUT_FEATURES; j++) {
+    features[j] = sample.features[j] * scales[j];
+  }
+#else
+  for (int j = 0; j < INPUT_FEATURES; j++) {
+    features[j] = sample.features[j];
+  }
+#endif
+  
+  return true;
+}
+
+size_t EnhancedMLModel::getTrainingBufferSize() {
+  return sizeof(TrainingSample) * MAX_TRAINING_SAMPLES + (MAX_TRAINING_SAMPLES + 7) / 8;
+}
+
+float EnhancedMLModel::getAverageInsertCycles() {
+  if (_onlineLearner.insert_count == 0) {
+    return 0.0;
+  }
+  return (float)_onlineLearner.insert_cycles / _onlineLearner.insert_count;
+}
+
+void EnhancedMLModel::_storeTrainingSample(int slot, const float* features, bool label) {
+  TrainingSample& sample = _onlineLearner.samples[slot];
+#if TRAINING_SAMPLE_STORAGE == TRAINING_STORAGE_INT16
+  static const float scales[INPUT_FEATURES] = TRAINING_FEATURE_SCALES;
+  for (int j = 0; j < INPUT_FEATURES; j++) {
+    float q = roundf(features[j] / scales[j]);
+    sample.features[j] = (int16_t)constrain(q, -32768.0f, 32767.0f);
+  }
+#else
+  for (int j = 0; j < INPUT_FEATURES; j++) {
+    sample.features[j] = features[j];
+  }
+#endif
+  
+  if (label) {
+    _onlineLearner.labels[slot >> 3] |= (1 << (slot & 7));
+  } else {
+    _onlineLearner.labels[slot >> 3] &= ~(1 << (slot & 7));
+  }
 }
 
 float EnhancedMLModel::calculateUncertainty(const float* predictions, int count) {
@@ -700,7 +1540,7 @@ float EnhancedMLModel::calculateUncertainty(const float* predictions, int count)
   return sqrt(variance);
 }
 
-void EnhancedMLModel::_updateLSTMSequence(const SensorData& data) {
+void EnhancedMLModel::_updateLSTMSequence(const float* scaled) {
   // Shift sequence
   for (int i = 0; i < LSTM_SEQUENCE_LENGTH - 1; i++) {
     for (int j = 0; j < LSTM_INPUT_FEATURES; j++) {
@@ -709,80 +1549,75 @@ void EnhancedMLModel::_updateLSTMSequence(const SensorData& data) {
   }
   
   // Add new data
-  _lstmSequence[LSTM_SEQUENCE_LENGTH - 1][0] = data.current;
-  _lstmSequence[LSTM_SEQUENCE_LENGTH - 1][1] = data.voltage;
-  _lstmSequence[LSTM_SEQUENCE_LENGTH - 1][2] = data.power;
-  _lstmSequence[LSTM_SEQUENCE_LENGTH - 1][3] = data.frequency;
-  _lstmSequence[LSTM_SEQUENCE_LENGTH - 1][4] = data.temperature;
-  _lstmSequence[LSTM_SEQUENCE_LENGTH - 1][5] = (float)currentState;
+  memcpy(_lstmSequence[LSTM_SEQUENCE_LENGTH - 1], scaled, sizeof(_lstmSequence[0]));
 }
 
 void EnhancedMLModel::_initializeLSTMWeights() {
-  // Initialize with small random values
-  randomSeed(analogRead(0));
+  // Small pseudo-random values from a fixed seed, so every boot gets the same model
+  uint32_t seed = MODEL_INIT_SEED;
   
   // Input weights
   for (int i = 0; i < LSTM_INPUT_FEATURES; i++) {
     for (int j = 0; j < LSTM_HIDDEN_SIZE; j++) {
-      _lstmModel.Wf[i][j] = (random(-100, 100) / 1000.0);
-      _lstmModel.Wi[i][j] = (random(-100, 100) / 1000.0);
-      _lstmModel.Wo[i][j] = (random(-100, 100) / 1000.0);
-      _lstmModel.Wc[i][j] = (random(-100, 100) / 1000.0);
+      _lstmModel->Wf[i][j] = _initialWeight(seed);
+      _lstmModel->Wi[i][j] = _initialWeight(seed);
+      _lstmModel->Wo[i][j] = _initialWeight(seed);
+      _lstmModel->Wc[i][j] = _initialWeight(seed);
     }
   }
   
   // Hidden weights
   for (int i = 0; i < LSTM_HIDDEN_SIZE; i++) {
     for (int j = 0; j < LSTM_HIDDEN_SIZE; j++) {
-      _lstmModel.Uf[i][j] = (random(-100, 100) / 1000.0);
-      _lstmModel.Ui[i][j] = (random(-100, 100) / 1000.0);
-      _lstmModel.Uo[i][j] = (random(-100, 100) / 1000.0);
-      _lstmModel.Uc[i][j] = (random(-100, 100) / 1000.0);
+      _lstmModel->Uf[i][j] = _initialWeight(seed);
+      _lstmModel->Ui[i][j] = _initialWeight(seed);
+      _lstmModel->Uo[i][j] = _initialWeight(seed);
+      _lstmModel->Uc[i][j] = _initialWeight(seed);
     }
   }
   
   // Output weights
   for (int i = 0; i < LSTM_HIDDEN_SIZE; i++) {
-    _lstmModel.Wy[i][0] = (random(-100, 100) / 1000.0);
+    _lstmModel->Wy[i][0] = _initialWeight(seed);
   }
   
   // Initialize biases to zero
   for (int i = 0; i < LSTM_HIDDEN_SIZE; i++) {
-    _lstmModel.bf[i] = 0.0;
-    _lstmModel.bi[i] = 0.0;
-    _lstmModel.bo[i] = 0.0;
-    _lstmModel.bc[i] = 0.0;
+    _lstmModel->bf[i] = 0.0;
+    _lstmModel->bi[i] = 0.0;
+    _lstmModel->bo[i] = 0.0;
+    _lstmModel->bc[i] = 0.0;
   }
-  _lstmModel.by[0] = 0.0;
+  _lstmModel->by[0] = 0.0;
 }
 
 void EnhancedMLModel::_initializeAutoencoderWeights() {
-  // Initialize with small random values
-  randomSeed(analogRead(0));
+  // Small pseudo-random values from a fixed seed, so every boot gets the same model
+  uint32_t seed = MODEL_INIT_SEED + MODEL_AUTOENCODER;
   
   // Encoder weights
-  for (int i = 0; i < INPUT_FEATURES; i++) {
+  for (int i = 0; i < SCALED_FEATURES; i++) {
     for (int j = 0; j < 8; j++) {
-      _autoencoderModel.W1[i][j] = (random(-100, 100) / 1000.0);
+      _autoencoderModel.W1[i][j] = _initialWeight(seed);
     }
   }
   
   for (int i = 0; i < 8; i++) {
     for (int j = 0; j < 4; j++) {
-      _autoencoderModel.W2[i][j] = (random(-100, 100) / 1000.0);
+      _autoencoderModel.W2[i][j] = _initialWeight(seed);
     }
   }
   
   // Decoder weights
   for (int i = 0; i < 4; i++) {
     for (int j = 0; j < 8; j++) {
-      _autoencoderModel.W3[i][j] = (random(-100, 100) / 1000.0);
+      _autoencoderModel.W3[i][j] = _initialWeight(seed);
     }
   }
   
   for (int i = 0; i < 8; i++) {
-    for (int j = 0; j < INPUT_FEATURES; j++) {
-      _autoencoderModel.W4[i][j] = (random(-100, 100) / 1000.0);
+    for (int j = 0; j < SCALED_FEATURES; j++) {
+      _autoencoderModel.W4[i][j] = _initialWeight(seed);
     }
   }
   
@@ -794,23 +1629,52 @@ void EnhancedMLModel::_initializeAutoencoderWeights() {
   for (int i = 0; i < 4; i++) {
     _autoencoderModel.b2[i] = 0.0;
   }
-  for (int i = 0; i < INPUT_FEATURES; i++) {
+  for (int i = 0; i < SCALED_FEATURES; i++) {
     _autoencoderModel.b4[i] = 0.0;
   }
 }
 
+float EnhancedMLModel::_initialWeight(uint32_t& seed) {
+  // xorshift32: same sequence on every build, uniform in [-0.1, 0.1)
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return ((int)(seed % 200) - 100) / 1000.0f;
+}
+
+LSTMModel* EnhancedMLModel::_allocateLSTMWeights() {
+  // Only SD-loaded and seeded weights need RAM; flash weights are used in place
+  if (!_lstmModel) {
+    _lstmModel = (LSTMModel*)malloc(sizeof(LSTMModel));
+  }
+  return _lstmModel;
+}
+
+void EnhancedMLModel::_releaseLSTMWeights() {
+  if (_lstmModel && _lstm != _lstmModel) {
+    free(_lstmModel);
+    _lstmModel = nullptr;
+  }
+}
+
 float EnhancedMLModel::_sigmoid(float x) {
-  if (x > 10) return 1.0;
-  if (x < -10) return 0.0;
-  return 1.0 / (1.0 + exp(-x));
+#if ENHANCED_ML_ACTIVATION == ACTIVATION_LUT
+  return FastActivations::sigmoidLUT(x);
+#elif ENHANCED_ML_ACTIVATION == ACTIVATION_RATIONAL
+  return FastActivations::sigmoidRational(x);
+#else
+  return FastActivations::sigmoidExact(x);
+#endif
 }
 
 float EnhancedMLModel::_tanh(float x) {
-  if (x > 10) return 1.0;
-  if (x < -10) return -1.0;
-  float ex = exp(x);
-  float enx = exp(-x);
-  return (ex - enx) / (ex + enx);
+#if ENHANCED_ML_ACTIVATION == ACTIVATION_LUT
+  return FastActivations::tanhLUT(x);
+#elif ENHANCED_ML_ACTIVATION == ACTIVATION_RATIONAL
+  return FastActivations::tanhRational(x);
+#else
+  return FastActivations::tanhExact(x);
+#endif
 }
 
 float EnhancedMLModel::_relu(float x) {
@@ -847,11 +1711,19 @@ void EnhancedMLModel::_updateWeights(float* weights, int count, float gradient,
   }
 }
 
-void EnhancedMLModel::_normalizeInput(float* input, int count) {
-  // Simple normalization - in practice, use proper normalization
-  for (int i = 0; i < count; i++) {
-    input[i] = (input[i] - 0.5) * 2.0; // Scale to [-1, 1]
-  }
+void EnhancedMLModel::_rawFeatures(const SensorData& data, float* raw) {
+  raw[0] = data.current;
+  raw[1] = data.voltage;
+  raw[2] = data.power;
+  raw[3] = data.frequency;
+  raw[4] = data.temperature;
+  raw[5] = (float)currentState;
+}
+
+void EnhancedMLModel::_normalizeInput(const SensorData& data, float* scaled) {
+  float raw[INPUT_FEATURES];
+  _rawFeatures(data, raw);
+  FeatureScaler::apply(raw, scaled);
 }
 
 void EnhancedMLModel::_denormalizeOutput(float* output, int count) {
@@ -861,17 +1733,86 @@ void EnhancedMLModel::_denormalizeOutput(float* output, int count) {
   }
 }
 
-// Placeholder implementations for additional methods
 bool EnhancedMLModel::loadModel(ModelType type) {
-  // Implement model loading
+  ModelStore::init();
+  
+  unsigned long start = micros();
+  const char* source = nullptr;
+  
+  // Flash weights are used in place; SD weights are read into the RAM structs
+  switch (type) {
+    case MODEL_LSTM: {
+      const LSTMModel* mapped = (const LSTMModel*)ModelStore::mapModel(type, sizeof(LSTMModel));
+      if (mapped) {
+        _lstm = mapped;
+        source = "flash";
+      } else if (_allocateLSTMWeights() && ModelStore::loadFromSD(type, _lstmModel, sizeof(LSTMModel))) {
+        _lstm = _lstmModel;
+        source = "SD";
+      }
+      _releaseLSTMWeights();
+      break;
+    }
+    case MODEL_AUTOENCODER: {
+      const AutoencoderModel* mapped = (const AutoencoderModel*)ModelStore::mapModel(type, sizeof(AutoencoderModel));
+      if (mapped) {
+        _autoencoder = mapped;
+        source = "flash";
+      } else if (ModelStore::loadFromSD(type, &_autoencoderModel, sizeof(AutoencoderModel))) {
+        _autoencoder = &_autoencoderModel;
+        source = "SD";
+      }
+      break;
+    }
+    case MODEL_ENSEMBLE: {
+      // Member weights are tiny and get updated at runtime, so always copy
+      float weights[ENSEMBLE_MODELS];
+      const void* mapped = ModelStore::mapModel(type, sizeof(weights));
+      if (mapped) {
+        memcpy(weights, mapped, sizeof(weights));
+        source = "flash";
+      } else if (ModelStore::loadFromSD(type, weights, sizeof(weights))) {
+        source = "SD";
+      }
+      if (source) {
+        memcpy(_ensembleModel.weights, weights, sizeof(weights));
+      }
+      break;
+    }
+    default:
+      return false; // Rule-based and hybrid models have no stored weights
+  }
+  
+  _modelLoadMicros[type] = micros() - start;
+  
+  if (!source) {
+    return false;
+  }
+  
+  Serial.println("Model " + String(type) + " loaded from " + String(source) +
+                 " in " + String(_modelLoadMicros[type]) + " us");
   return true;
 }
 
 bool EnhancedMLModel::saveModel(ModelType type) {
-  // Implement model saving
-  return true;
+  switch (type) {
+    case MODEL_LSTM:
+      // The weights are only valid with the statistics they were trained under
+      return ModelStore::saveToSD(type, _lstm, sizeof(LSTMModel)) && FeatureScaler::save();
+    case MODEL_AUTOENCODER:
+      return ModelStore::saveToSD(type, _autoencoder, sizeof(AutoencoderModel)) && FeatureScaler::save();
+    case MODEL_ENSEMBLE:
+      return ModelStore::saveToSD(type, _ensembleModel.weights, sizeof(_ensembleModel.weights));
+    default:
+      return false;
+  }
+}
+
+unsigned long EnhancedMLModel::getModelLoadTime(ModelType type) {
+  return _modelLoadMicros[type];
 }
 
+// Placeholder implementations for additional methods
 void EnhancedMLModel::switchModel(ModelType type) {
   _currentModel = type;
 }
@@ -880,43 +1821,1109 @@ ModelType EnhancedMLModel::getCurrentModel() {
   return _currentModel;
 }
 
-void EnhancedMLModel::updateLSTM(const SensorData& data, bool isThreat) {
-  // Implement LSTM update
+bool EnhancedMLModel::stageModel(ModelType type, Stream& source) {
+  // Load a model container into the standby slot; inference keeps using the
+  // active slot until the next tick boundary commits the swap
+  if (!_initialized || (unsigned)type > MODEL_ENSEMBLE) {
+    Serial.println("Model " + String(type) + " cannot be hot-swapped");
+    return false;
+  }
+  if (!_claimStandby(type)) {
+    Serial.println("Model " + String(type) + " swap already in progress");
+    return false;
+  }
+  
+  ModelSwapStats& swap = _swap[type];
+  unsigned long start = micros();
+  void* slot = _standbySlot(type);
+  uint32_t crc = 0;
+  float output = NAN;
+  bool ok = slot && ModelStore::loadFromStream(type, source, slot, _weightBytes(type), &crc) &&
+            _smokeTest(type, slot, &output);
+  swap.stage_micros = micros() - start;
+  swap.smoke_output = output;
+  
+  if (!ok) {
+    swap.rejects++;
+    __atomic_store_n(&swap.state, (uint8_t)SWAP_IDLE, __ATOMIC_RELEASE);
+    Serial.println("Model " + String(type) + " rejected - keeping the active weights");
+    return false;
+  }
+  
+  swap.staged_crc = crc;
+  __atomic_store_n(&swap.state, (uint8_t)SWAP_READY, __ATOMIC_RELEASE);
+  Serial.println("Model " + String(type) + " staged in " + String(swap.stage_micros) +
+                 " us (CRC " + String(crc, HEX) + "), active from the next tick");
+  return true;
 }
 
-void EnhancedMLModel::trainLSTM(const SensorData* data, const bool* labels, int count) {
-  // Implement LSTM training
+bool EnhancedMLModel::stageModel(ModelType type) {
+  // Same container the boot loader reads from SD
+  File file = SD.open(ModelStore::getModelPath(type), FILE_READ);
+  if (!file) {
+    Serial.println("No model file: " + ModelStore::getModelPath(type));
+    return false;
+  }
+  bool ok = stageModel(type, file);
+  file.close();
+  return ok;
 }
 
-void EnhancedMLModel::trainAutoencoder(const SensorData* data, int count) {
-  // Implement autoencoder training
+ModelSwapStats EnhancedMLModel::getSwapStats(ModelType type) {
+  return _swap[type];
 }
 
-void EnhancedMLModel::addModel(ModelType type, float weight) {
-  // Implement adding model to ensemble
+bool EnhancedMLModel::_claimStandby(ModelType type) {
+  // One writer per standby slot: hot-swap staging or the autoencoder trainer
+  uint8_t idle = SWAP_IDLE;
+  if (!__atomic_compare_exchange_n(&_swap[type].state, &idle, (uint8_t)SWAP_STAGING,
+                                   false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+    return false;
+  }
+  
+  // The slot the last swap retired may still be read by a task that pinned it
+  // before the swap (shadow, trainer); wait for those readers to move on.
+  // Readers of the active slot do not hold this up.
+  if (type <= MODEL_AUTOENCODER) {
+    int retired = _weightSlot(type, _activeWeights(type)) == 0 ? 1 : 0;
+    while (__atomic_load_n(&_weightReaders[type][retired], __ATOMIC_SEQ_CST) > 0) {
+      vTaskDelay(1);
+    }
+  }
+  return true;
 }
 
-void EnhancedMLModel::updateWeights(const float* accuracies) {
-  // Implement weight update
+const void* EnhancedMLModel::_activeWeights(ModelType type) {
+  if (type == MODEL_LSTM) {
+    return __atomic_load_n(&_lstm, __ATOMIC_SEQ_CST);
+  }
+  return __atomic_load_n(&_autoencoder, __ATOMIC_SEQ_CST);
+}
+
+int EnhancedMLModel::_weightSlot(ModelType type, const void* weights) {
+  // 0 and 1 are the RAM slots hot-swap alternates between; flash is never written
+  if (type == MODEL_LSTM) {
+    return weights == _lstmModel ? 0 : weights == _lstmStandby ? 1 : 2;
+  }
+  return weights == &_autoencoderModel ? 0 : weights == &_autoencoderBackBuffer ? 1 : 2;
+}
+
+const void* EnhancedMLModel::_pinWeights(ModelType type) {
+  // Count the reader on the slot, then check the slot is still active: a writer
+  // that finds no readers on a retired slot knows later readers see the new one
+  for (;;) {
+    const void* weights = _activeWeights(type);
+    volatile uint32_t* readers = &_weightReaders[type][_weightSlot(type, weights)];
+    __atomic_add_fetch(readers, 1, __ATOMIC_SEQ_CST);
+    if (_activeWeights(type) == weights) {
+      return weights;
+    }
+    __atomic_sub_fetch(readers, 1, __ATOMIC_RELEASE);
+  }
+}
+
+void EnhancedMLModel::_unpinWeights(ModelType type, const void* weights) {
+  __atomic_sub_fetch(&_weightReaders[type][_weightSlot(type, weights)], 1, __ATOMIC_RELEASE);
+}
+
+void* EnhancedMLModel::_standbySlot(ModelType type) {
+  // The slot inference is not reading; only called while holding the claim
+  switch (type) {
+    case MODEL_LSTM: {
+      // RAM slots are allocated on first use; flash weights need no slot
+      LSTMModel** slot = (_lstm == _lstmModel) ? &_lstmStandby : &_lstmModel;
+      if (!*slot) {
+        *slot = (LSTMModel*)malloc(sizeof(LSTMModel));
+      }
+      return *slot;
+    }
+    case MODEL_AUTOENCODER: {
+      const AutoencoderModel* active = __atomic_load_n(&_autoencoder, __ATOMIC_ACQUIRE);
+      return (active == &_autoencoderModel) ? &_autoencoderBackBuffer : &_autoencoderModel;
+    }
+    case MODEL_ENSEMBLE:
+      return _ensembleStandby;
+    default:
+      return nullptr;
+  }
+}
+
+size_t EnhancedMLModel::_weightBytes(ModelType type) {
+  // Payload size of the model's container
+  switch (type) {
+    case MODEL_LSTM: return sizeof(LSTMModel);
+    case MODEL_AUTOENCODER: return sizeof(AutoencoderModel);
+    case MODEL_ENSEMBLE: return sizeof(_ensembleStandby);
+    default: return 0;
+  }
+}
+
+bool EnhancedMLModel::_smokeTest(ModelType type, const void* weights, float* output) {
+  // A matching CRC only proves the transfer; reject weights that cannot run
+  const float* params = (const float*)weights;
+  for (size_t i = 0; i < _weightBytes(type) / sizeof(float); i++) {
+    if (!isfinite(params[i])) {
+      Serial.println("Model " + String(type) + " has a non-finite weight at index " + String(i));
+      return false;
+    }
+  }
+  
+  // Probe: a typical charging sample (running mean) must not look like an attack
+  float raw[INPUT_FEATURES];
+  float probe[SCALED_FEATURES];
+  for (int i = 0; i < SENSOR_FEATURES; i++) {
+    raw[i] = FeatureScaler::getMean(i);
+  }
+  raw[SENSOR_FEATURES] = (float)STATE_CHARGING;
+  FeatureScaler::apply(raw, probe);
+  
+  bool ok = false;
+  switch (type) {
+    case MODEL_LSTM: {
+      static float sequence[LSTM_SEQUENCE_LENGTH][LSTM_INPUT_FEATURES];
+      for (int t = 0; t < LSTM_SEQUENCE_LENGTH; t++) {
+        memcpy(sequence[t], probe, sizeof(sequence[t]));
+      }
+      *output = _runLSTM((const LSTMModel*)weights, (const float*)sequence, _probeCell);
+      ok = isfinite(*output) && *output <= THREAT_THRESHOLD;
+      break;
+    }
+    case MODEL_AUTOENCODER:
+      *output = _runAutoencoder((const AutoencoderModel*)weights, probe);
+      ok = isfinite(*output) && *output <= AUTOENCODER_ANOMALY_THRESHOLD;
+      break;
+    case MODEL_ENSEMBLE: {
+      // Member weights: non-negative and not all zero
+      *output = 0.0;
+      ok = true;
+      for (int i = 0; i < _ensembleModel.member_count; i++) {
+        ok &= params[i] >= 0.0f;
+        *output += params[i];
+      }
+      ok &= *output > 0.0f;
+      break;
+    }
+    default:
+      break;
+  }
+  
+  if (!ok) {
+    Serial.println("Model " + String(type) + " failed the smoke test (probe output " + String(*output, 4) + ")");
+  }
+  return ok;
+}
+
+void EnhancedMLModel::_commitSwaps() {
+  // Runs between ticks on the inference task, after the LSTM worker joined
+  for (int t = MODEL_LSTM; t <= MODEL_ENSEMBLE; t++) {
+    ModelSwapStats& swap = _swap[t];
+    if (__atomic_load_n(&swap.state, __ATOMIC_ACQUIRE) != SWAP_READY) {
+      continue;
+    }
+    
+    uint32_t start = ESP.getCycleCount();
+    void* slot = _standbySlot((ModelType)t);
+    switch (t) {
+      case MODEL_LSTM:
+        __atomic_store_n(&_lstm, (const LSTMModel*)slot, __ATOMIC_RELEASE);
+        break;
+      case MODEL_AUTOENCODER:
+        __atomic_store_n(&_autoencoder, (const AutoencoderModel*)slot, __ATOMIC_RELEASE);
+        break;
+      case MODEL_ENSEMBLE:
+        // Member weights are read by this task only; a copy is as good as a pointer swap
+        memcpy(_ensembleModel.weights, slot, sizeof(_ensembleModel.weights));
+        break;
+    }
+    swap.commit_cycles = ESP.getCycleCount() - start;
+    swap.active_crc = swap.staged_crc;
+    __atomic_store_n(&swap.swaps, swap.swaps + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&swap.state, (uint8_t)SWAP_IDLE, __ATOMIC_RELEASE);
+    Serial.println("Model " + String(t) + " swapped in at tick " + String(_tickCount) + " (" +
+                   String(swap.commit_cycles) + " cycles)");
+  }
+}
+
+bool EnhancedMLModel::loadShadowModel(ModelType type, Stream& source) {
+  uint32_t crc = 0;
+  void* weights = readShadowModel(type, source, &crc);
+  return weights && installShadowModel(type, weights, crc);
+}
+
+void* EnhancedMLModel::readShadowModel(ModelType type, Stream& source, uint32_t* crc) {
+  // Reads into a new buffer only, so it may run on another task (network download)
+  if (!_initialized || (unsigned)type > MODEL_ENSEMBLE) {
+    Serial.println("Model " + String(type) + " cannot run in shadow");
+    return nullptr;
+  }
+  
+  void* weights = malloc(_weightBytes(type));
+  if (!weights || !ModelStore::loadFromStream(type, source, weights, _weightBytes(type), crc)) {
+    free(weights);
+    Serial.println("Shadow model " + String(type) + " rejected");
+    return nullptr;
+  }
+  return weights;
+}
+
+bool EnhancedMLModel::installShadowModel(ModelType type, void* weights, uint32_t crc) {
+  // Takes ownership of weights from readShadowModel(); call from the inference task.
+  // The candidate gets its own slot; production and hot-swap slots are untouched
+  if (!startShadowTask()) {
+    free(weights);
+    Serial.println("Failed to start shadow task");
+    return false;
+  }
+  unloadShadowModel();
+  
+  _shadowWeights = weights;
+  _shadow.type = type;
+  _shadow.crc = crc;
+  resetShadowStats();
+  __atomic_store_n(&_shadowBudget, 0, __ATOMIC_RELEASE);
+  _shadowRefillMicros = micros();
+  _shadow.loaded = true;
+  Serial.println("Shadow " + String(getModelName(type)) + " loaded (CRC " + String(crc, HEX) + "), budget " +
+                 String(_shadow.cycles_per_second) + " cycles/s");
+  return true;
+}
+
+bool EnhancedMLModel::loadShadowModel(ModelType type) {
+  String path = String(MODEL_SD_DIR) + SHADOW_SD_PREFIX + String(type) + ".evm";
+  File file = SD.open(path, FILE_READ);
+  if (!file) {
+    Serial.println("No shadow model file: " + path);
+    return false;
+  }
+  bool ok = loadShadowModel(type, file);
+  file.close();
+  return ok;
+}
+
+void EnhancedMLModel::unloadShadowModel() {
+  if (!_shadow.loaded) {
+    return;
+  }
+  
+  // No new ticks are offered; let a running one finish before freeing its weights
+  _shadow.loaded = false;
+  while (__atomic_load_n(&_shadowBusy, __ATOMIC_ACQUIRE)) {
+    vTaskDelay(1);
+  }
+  free(_shadowWeights);
+  _shadowWeights = nullptr;
+}
+
+void EnhancedMLModel::setShadowBudget(uint32_t cyclesPerSecond) {
+  _shadow.cycles_per_second = min(cyclesPerSecond, (uint32_t)INT32_MAX);
+  __atomic_store_n(&_shadowBudget, 0, __ATOMIC_RELEASE);
+  _shadowRefillMicros = micros();
+}
+
+bool EnhancedMLModel::startShadowTask() {
+  if (_shadowTask) {
+    return true;
+  }
+  
+  BaseType_t created = xTaskCreatePinnedToCore(_shadowTaskLoop, "ml_shadow", SHADOW_TASK_STACK,
+                                               nullptr, SHADOW_TASK_PRIORITY, &_shadowTask,
+                                               SHADOW_TASK_CORE);
+  if (created != pdPASS) {
+    _shadowTask = nullptr;
+    return false;
+  }
+  
+  Serial.println("Shadow task started on core " + String(SHADOW_TASK_CORE));
+  return true;
+}
+
+ShadowStats EnhancedMLModel::getShadowStats() {
+  portENTER_CRITICAL(&_shadowMux);
+  ShadowStats stats = _shadow;
+  stats.latency.count = _shadowLatency.count;
+  stats.latency.p50_cycles = LatencyStats::percentile(_shadowLatency, 0.5);
+  stats.latency.p99_cycles = LatencyStats::percentile(_shadowLatency, 0.99);
+  stats.latency.max_cycles = _shadowLatency.max;
+  stats.latency.mean_cycles = _shadowLatency.count ? (uint32_t)(_shadowLatency.total / _shadowLatency.count) : 0;
+  portEXIT_CRITICAL(&_shadowMux);
+  return stats;
+}
+
+void EnhancedMLModel::resetShadowStats() {
+  portENTER_CRITICAL(&_shadowMux);
+  _shadow.offered = 0;
+  _shadow.evaluated = 0;
+  _shadow.skipped_budget = 0;
+  _shadow.skipped_busy = 0;
+  _shadow.disagreements = 0;
+  _shadow.compared_active = 0;
+  _shadow.active_disagreements = 0;
+  _shadow.abs_diff_sum = 0.0;
+  LatencyStats::reset(_shadowLatency);
+  portEXIT_CRITICAL(&_shadowMux);
+}
+
+void EnhancedMLModel::_offerShadow() {
+  // Only ticks that produced a production decision can be compared
+  if (!_tick.prediction_valid) {
+    return;
+  }
+  _shadow.offered++;
+  
+  // Refill the cycle budget for the time since the last offer; an idle period
+  // banks at most SHADOW_BURST_MS so the shadow cannot burst over the cap
+  unsigned long now = micros();
+  int64_t refill = (int64_t)(now - _shadowRefillMicros) * _shadow.cycles_per_second / 1000000;
+  _shadowRefillMicros = now;
+  int64_t burst = (int64_t)_shadow.cycles_per_second * SHADOW_BURST_MS / 1000;
+  int32_t budget = __atomic_load_n(&_shadowBudget, __ATOMIC_ACQUIRE);
+  int32_t target = (int32_t)min((int64_t)budget + refill, burst);
+  budget = __atomic_add_fetch(&_shadowBudget, target - budget, __ATOMIC_ACQ_REL);
+  
+  if (budget <= 0) {
+    _shadow.skipped_budget++;
+    return;
+  }
+  if (__atomic_load_n(&_shadowBusy, __ATOMIC_ACQUIRE)) {
+    _shadow.skipped_busy++;
+    return;
+  }
+  
+  // The input copy is owned by the shadow task until it clears _shadowBusy
+  ShadowInput& in = _shadowInput;
+  in.tick = _tick.tick;
+  in.features = _features;
+  memcpy(in.sequence, _lstmSequence, sizeof(in.sequence));
+  for (int i = 0; i < _ensembleModel.member_count; i++) {
+    switch (_ensembleModel.models[i]) {
+      case MODEL_LSTM: in.members[i] = _tick.lstm_valid ? _tick.lstm : NAN; break;
+      case MODEL_AUTOENCODER: in.members[i] = _tick.autoencoder_valid ? _tick.reconstruction_error : NAN; break;
+      case MODEL_RULE_BASED: in.members[i] = _tick.rules_valid ? _tick.rule_score : NAN; break;
+      case MODEL_TREE_ENSEMBLE: in.members[i] = _tick.trees_valid ? _tick.trees : NAN; break;
+      default: in.members[i] = NAN;
+    }
+  }
+  in.active = getTickScore(_shadow.type);
+  in.production = _tick.prediction;
+  
+  __atomic_store_n(&_shadowBusy, true, __ATOMIC_RELEASE);
+  xTaskNotifyGive(_shadowTask);
+}
+
+float EnhancedMLModel::_runShadow(const ShadowInput& in) {
+  switch (_shadow.type) {
+    case MODEL_LSTM:
+      return _runLSTM((const LSTMModel*)_shadowWeights, (const float*)in.sequence, _shadowCell);
+    case MODEL_AUTOENCODER:
+      return _autoencoderScore(_runAutoencoder((const AutoencoderModel*)_shadowWeights, in.features.scaled));
+    case MODEL_ENSEMBLE: {
+      // Candidate member weights over production members; members the cascade
+      // skipped are computed here with the active weights (rules always ran)
+      const float* weights = (const float*)_shadowWeights;
+      float score = 0.0;
+      for (int i = 0; i < _ensembleModel.member_count; i++) {
+        float member = in.members[i];
+        if (isnan(member)) {
+          switch (_ensembleModel.models[i]) {
+            case MODEL_LSTM: {
+              // Pinned: a swap at the next tick boundary must not restage the slot under us
+              const void* lstm = _pinWeights(MODEL_LSTM);
+              member = _runLSTM((const LSTMModel*)lstm, (const float*)in.sequence, _shadowCell);
+              _unpinWeights(MODEL_LSTM, lstm);
+              break;
+            }
+            case MODEL_AUTOENCODER: {
+              const void* autoencoder = _pinWeights(MODEL_AUTOENCODER);
+              member = _runAutoencoder((const AutoencoderModel*)autoencoder, in.features.scaled);
+              _unpinWeights(MODEL_AUTOENCODER, autoencoder);
+              break;
+            }
+            case MODEL_TREE_ENSEMBLE: {
+              int32_t quantized[INPUT_FEATURES];
+              TreeEnsemble::quantize(in.features.raw, quantized);
+              member = TreeEnsemble::predict(quantized);
+              break;
+            }
+            default:
+              member = 0.0;
+          }
+        }
+        score += member * weights[i];
+      }
+      return score;
+    }
+    default:
+      return NAN;
+  }
+}
+
+void EnhancedMLModel::_shadowTaskLoop(void* param) {
+  (void)param;
+  
+  for (;;) {
+    // Sleep until a finished tick is offered
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    
+    const ShadowInput& in = _shadowInput;
+    uint32_t start = ESP.getCycleCount();
+    float score = _runShadow(in);
+    uint32_t cycles = ESP.getCycleCount() - start;
+    __atomic_sub_fetch(&_shadowBudget, (int32_t)min(cycles, (uint32_t)INT32_MAX), __ATOMIC_ACQ_REL);
+    
+    float threshold = getDecisionThreshold(_shadow.type);
+    bool candidate = score > threshold;
+    bool production = in.production > THREAT_THRESHOLD;
+    
+    portENTER_CRITICAL(&_shadowMux);
+    _shadow.evaluated++;
+    if (candidate != production) {
+      _shadow.disagreements++;
+    }
+    if (!isnan(in.active)) {
+      _shadow.compared_active++;
+      _shadow.abs_diff_sum += fabsf(score - in.active);
+      if (candidate != (in.active > threshold)) {
+        _shadow.active_disagreements++;
+      }
+    }
+    LatencyStats::record(_shadowLatency, cycles);
+    portEXIT_CRITICAL(&_shadowMux);
+    
+    if (candidate != production && millis() - _shadowLogMillis >= SHADOW_LOG_INTERVAL_MS) {
+      _shadowLogMillis = millis();
+      Serial.println("Shadow " + String(getModelName(_shadow.type)) + " disagrees at tick " + String(in.tick) +
+                     ": candidate " + String(score, 3) + ", production " + String(in.production, 3));
+    }
+    
+    __atomic_store_n(&_shadowBusy, false, __ATOMIC_RELEASE);
+  }
+}
+
+void EnhancedMLModel::updateLSTM(const SensorData& data, bool isThreat) {
+  // No on-device BPTT; collect the sample for the shared learner buffer
+  addTrainingSample(data, isThreat);
+}
+
+void EnhancedMLModel::trainLSTM(const SensorData* data, const bool* labels, int count) {
+  // Implement LSTM training
+}
+
+void EnhancedMLModel::trainAutoencoder(const SensorData* data, int count) {
+  if (!data || count <= 0) {
+    return;
+  }
+  
+  // The training task must not run Adam on the same state concurrently
+  if (!_claimTrainer()) {
+    Serial.println("Autoencoder training already running");
+    return;
+  }
+  
+  // Synchronous training over caller-supplied normal data (one pass)
+  unsigned long generation = __atomic_load_n(&_swap[MODEL_AUTOENCODER].swaps, __ATOMIC_ACQUIRE);
+  const void* active = _pinWeights(MODEL_AUTOENCODER);
+  memcpy(&_trainer.weights, active, sizeof(AutoencoderModel));
+  _unpinWeights(MODEL_AUTOENCODER, active);
+  
+  float batch[BATCH_SIZE][SCALED_FEATURES];
+  float lossSum = 0.0;
+  int batches = 0;
+  for (int start = 0; start < count; start += BATCH_SIZE) {
+    int n = min(BATCH_SIZE, count - start);
+    for (int i = 0; i < n; i++) {
+      _normalizeInput(data[start + i], batch[i]);
+    }
+    lossSum += _trainAutoencoderBatch(batch, n);
+    batches++;
+  }
+  
+  _trainer.last_loss = lossSum / batches;
+  _trainer.epochs++;
+  _publishAutoencoder(generation);
+  __atomic_store_n(&_trainerBusy, false, __ATOMIC_RELEASE);
+}
+
+void EnhancedMLModel::_evaluateMembers(const SensorData& data) {
+  bool needOther = false;
+  for (int i = 0; i < _ensembleModel.member_count; i++) {
+    switch (_ensembleModel.models[i]) {
+      case MODEL_AUTOENCODER: needOther |= !_tick.autoencoder_valid; break;
+      case MODEL_RULE_BASED: needOther |= !_tick.rules_valid; break;
+      case MODEL_TREE_ENSEMBLE: needOther |= !_tick.trees_valid; break;
+      default: break;
+    }
+  }
+  
+  // Splitting only pays when the caller has work of its own
+  if (needOther) {
+    _forkLSTM();
+  }
+  
+  // Run the caller's members now; collecting the LSTM joins the worker
+  for (int i = 0; i < _ensembleModel.member_count; i++) {
+    switch (_ensembleModel.models[i]) {
+      case MODEL_AUTOENCODER: _tickAutoencoder(); break;
+      case MODEL_RULE_BASED: _tickRules(data); break;
+      case MODEL_TREE_ENSEMBLE: _tickTrees(); break;
+      default: break;
+    }
+  }
+}
+
+bool EnhancedMLModel::_forkLSTM() {
+  if (!_parallelEnabled || !_ensembleWorker || _lstmForked || _tick.lstm_valid) {
+    return false;
+  }
+  
+  bool isMember = false;
+  for (int i = 0; i < _ensembleModel.member_count; i++) {
+    isMember |= _ensembleModel.models[i] == MODEL_LSTM;
+  }
+  if (!isMember) {
+    return false;
+  }
+  
+  // The LSTM only touches its window, cell, histogram and memo fields
+  __atomic_store_n(&_lstmComputed, false, __ATOMIC_RELEASE);
+  _forkStart = ESP.getCycleCount();
+  _lstmForked = true;
+  _parallelStats.forks++;
+  xTaskNotifyGive(_ensembleWorker);
+  return true;
+}
+
+void EnhancedMLModel::_joinLSTM(bool used) {
+  if (!_lstmForked) {
+    if (used && !_tick.lstm_valid) {
+      _parallelStats.inline_runs++;
+    }
+    return;
+  }
+  
+  // A wake-up only counts once the worker has published the result
+  uint32_t callerCycles = ESP.getCycleCount() - _forkStart;
+  while (!__atomic_load_n(&_lstmComputed, __ATOMIC_ACQUIRE)) {
+    xSemaphoreTake(_workerDone, portMAX_DELAY);
+  }
+  uint32_t wall = ESP.getCycleCount() - _forkStart;
+  _lstmForked = false;
+  
+  if (used) {
+    _parallelStats.joins++;
+    _parallelStats.wall_cycles += wall;
+    _parallelStats.member_cycles += callerCycles + _workerCycles;
+  } else {
+    _parallelStats.discards++;
+  }
+}
+
+void EnhancedMLModel::_ensembleWorkerLoop(void* param) {
+  (void)param;
+  
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    
+    uint32_t start = ESP.getCycleCount();
+    _computeTickLSTM();
+    _workerCycles = ESP.getCycleCount() - start;
+    
+    __atomic_store_n(&_lstmComputed, true, __ATOMIC_RELEASE);
+    xSemaphoreGive(_workerDone);
+  }
+}
+
+bool EnhancedMLModel::startEnsembleWorker() {
+  if (_ensembleWorker) {
+    return true;
+  }
+  if (!_workerDone) {
+    _workerDone = xSemaphoreCreateBinary();
+    if (!_workerDone) {
+      return false;
+    }
+  }
+  
+  BaseType_t created = xTaskCreatePinnedToCore(_ensembleWorkerLoop, "ens_worker", PARALLEL_WORKER_STACK,
+                                               nullptr, PARALLEL_WORKER_PRIORITY, &_ensembleWorker,
+                                               PARALLEL_WORKER_CORE);
+  if (created != pdPASS) {
+    _ensembleWorker = nullptr;
+    return false;
+  }
+  
+  Serial.println("Ensemble worker started on core " + String(PARALLEL_WORKER_CORE));
+  return true;
+}
+
+void EnhancedMLModel::setParallelEnsemble(bool enabled) {
+  _parallelEnabled = enabled;
+}
+
+ParallelStats EnhancedMLModel::getParallelStats() {
+  return _parallelStats;
+}
+
+float EnhancedMLModel::getParallelSpeedup() {
+  if (_parallelStats.wall_cycles == 0) {
+    return 1.0;
+  }
+  return (float)_parallelStats.member_cycles / _parallelStats.wall_cycles;
+}
+
+bool EnhancedMLModel::startTrainingTask() {
+  if (_trainingTask) {
+    return true;
+  }
+  
+  BaseType_t created = xTaskCreatePinnedToCore(_trainingTaskLoop, "ae_train", TRAINING_TASK_STACK,
+                                               nullptr, TRAINING_TASK_PRIORITY, &_trainingTask,
+                                               TRAINING_TASK_CORE);
+  if (created != pdPASS) {
+    _trainingTask = nullptr;
+    return false;
+  }
+  
+  Serial.println("Autoencoder training task started on core " + String(TRAINING_TASK_CORE));
+  return true;
+}
+
+float EnhancedMLModel::getTrainingLoss() {
+  return _trainer.last_loss;
+}
+
+unsigned long EnhancedMLModel::getTrainingEpochs() {
+  return _trainer.epochs;
+}
+
+void EnhancedMLModel::_trainingTaskLoop(void* param) {
+  (void)param;
+  
+  for (;;) {
+    // Sleep until retrainModel() asks for another run
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (!_claimTrainer()) {
+      Serial.println("Autoencoder training already running - retrain skipped");
+      continue;
+    }
+    
+    for (int epoch = 0; epoch < TRAINING_EPOCHS_PER_RUN; epoch++) {
+      _runTrainingEpoch(true);
+    }
+    __atomic_store_n(&_trainerBusy, false, __ATOMIC_RELEASE);
+  }
+}
+
+bool EnhancedMLModel::_claimTrainer() {
+  // Weights, gradients and Adam moments belong to one run: the training task or trainAutoencoder()
+  bool idle = false;
+  return __atomic_compare_exchange_n(&_trainerBusy, &idle, true, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+void EnhancedMLModel::_runTrainingEpoch(bool yieldSlices) {
+  // Continue from whatever weights inference is using right now (caller holds the trainer)
+  unsigned long generation = __atomic_load_n(&_swap[MODEL_AUTOENCODER].swaps, __ATOMIC_ACQUIRE);
+  const void* active = _pinWeights(MODEL_AUTOENCODER);
+  memcpy(&_trainer.weights, active, sizeof(AutoencoderModel));
+  _unpinWeights(MODEL_AUTOENCODER, active);
+  
+  int available = getTrainingSampleCount();
+  int batches = (available + BATCH_SIZE - 1) / BATCH_SIZE;
+  float batch[BATCH_SIZE][SCALED_FEATURES];
+  float raw[INPUT_FEATURES];
+  float lossSum = 0.0;
+  int trainedBatches = 0;
+  unsigned long sliceStart = micros();
+  
+  for (int b = 0; b < batches; b++) {
+    // Random mini-batch of normal samples; the autoencoder models normal charging
+    int n = 0;
+    for (int attempt = 0; attempt < BATCH_SIZE * 4 && n < BATCH_SIZE; attempt++) {
+      bool isThreat = false;
+      if (getTrainingSample(random(0, available), raw, &isThreat) && !isThreat) {
+        FeatureScaler::apply(raw, batch[n]);
+        n++;
+      }
+    }
+    if (n > 0) {
+      lossSum += _trainAutoencoderBatch(batch, n);
+      trainedBatches++;
+    }
+    
+    // Stay within the per-slice CPU budget
+    if (yieldSlices && micros() - sliceStart > TRAINING_SLICE_BUDGET_US) {
+      vTaskDelay(pdMS_TO_TICKS(TRAINING_SLICE_PERIOD_MS));
+      sliceStart = micros();
+    }
+  }
+  
+  if (trainedBatches == 0) {
+    return;
+  }
+  
+  _trainer.last_loss = lossSum / trainedBatches;
+  _trainer.epochs++;
+  _trainer.last_epoch_ms = millis();
+  if (!_publishAutoencoder(generation)) {
+    Serial.println("Autoencoder epoch discarded: weights were hot-swapped during training");
+    return;
+  }
+  _scoreAgreement();
+  
+  Serial.println("Autoencoder epoch " + String(_trainer.epochs) + " loss " + String(_trainer.last_loss, 5) +
+                 ", agreement with the detector " + String(_onlineLearner.agreement * 100) + "%");
+}
+
+float EnhancedMLModel::_trainAutoencoderBatch(const float (*batch)[SCALED_FEATURES], int count) {
+  AutoencoderModel& w = _trainer.weights;
+  AutoencoderModel& g = _trainer.gradients;
+  memset(&g, 0, sizeof(g));
+  float loss = 0.0;
+  
+  for (int s = 0; s < count; s++) {
+    const float* x = batch[s];
+    
+    // Forward pass, keeping activations for backprop
+    float h1[8], h2[4], h3[8], y[SCALED_FEATURES];
+    for (int i = 0; i < 8; i++) {
+      float sum = w.b1[i];
+      for (int j = 0; j < SCALED_FEATURES; j++) sum += x[j] * w.W1[j][i];
+      h1[i] = _relu(sum);
+    }
+    for (int i = 0; i < 4; i++) {
+      float sum = w.b2[i];
+      for (int j = 0; j < 8; j++) sum += h1[j] * w.W2[j][i];
+      h2[i] = _relu(sum);
+    }
+    for (int i = 0; i < 8; i++) {
+      float sum = w.b3[i];
+      for (int j = 0; j < 4; j++) sum += h2[j] * w.W3[j][i];
+      h3[i] = _relu(sum);
+    }
+    for (int i = 0; i < SCALED_FEATURES; i++) {
+      float sum = w.b4[i];
+      for (int j = 0; j < 8; j++) sum += h3[j] * w.W4[j][i];
+      y[i] = sum;
+    }
+    
+    // MSE loss, averaged over features and batch
+    float dy[SCALED_FEATURES];
+    for (int i = 0; i < SCALED_FEATURES; i++) {
+      float diff = y[i] - x[i];
+      loss += diff * diff / SCALED_FEATURES;
+      dy[i] = 2.0f * diff / (SCALED_FEATURES * count);
+    }
+    
+    // Backward pass (ReLU gradient is 1 where the activation is positive)
+    float d3[8] = {0}, d2[4] = {0}, d1[8] = {0};
+    for (int j = 0; j < 8; j++) {
+      for (int i = 0; i < SCALED_FEATURES; i++) {
+        g.W4[j][i] += h3[j] * dy[i];
+        d3[j] += w.W4[j][i] * dy[i];
+      }
+      if (h3[j] <= 0.0f) d3[j] = 0.0f;
+    }
+    for (int i = 0; i < SCALED_FEATURES; i++) g.b4[i] += dy[i];
+    
+    for (int j = 0; j < 4; j++) {
+      for (int i = 0; i < 8; i++) {
+        g.W3[j][i] += h2[j] * d3[i];
+        d2[j] += w.W3[j][i] * d3[i];
+      }
+      if (h2[j] <= 0.0f) d2[j] = 0.0f;
+    }
+    for (int i = 0; i < 8; i++) g.b3[i] += d3[i];
+    
+    for (int j = 0; j < 8; j++) {
+      for (int i = 0; i < 4; i++) {
+        g.W2[j][i] += h1[j] * d2[i];
+        d1[j] += w.W2[j][i] * d2[i];
+      }
+      if (h1[j] <= 0.0f) d1[j] = 0.0f;
+    }
+    for (int i = 0; i < 4; i++) g.b2[i] += d2[i];
+    
+    for (int j = 0; j < SCALED_FEATURES; j++) {
+      for (int i = 0; i < 8; i++) {
+        g.W1[j][i] += x[j] * d1[i];
+      }
+    }
+    for (int i = 0; i < 8; i++) g.b1[i] += d1[i];
+  }
+  
+  _adamStep();
+  return loss / count;
+}
+
+void EnhancedMLModel::_adamStep() {
+  float* params = (float*)&_trainer.weights;
+  float* grads = (float*)&_trainer.gradients;
+  
+  _trainer.step++;
+  float correction1 = 1.0f - powf(ADAM_BETA1, (float)_trainer.step);
+  float correction2 = 1.0f - powf(ADAM_BETA2, (float)_trainer.step);
+  float lr = _onlineLearner.learning_rate;
+  
+  for (size_t i = 0; i < AUTOENCODER_PARAMS; i++) {
+    float grad = constrain(grads[i], -GRADIENT_CLIP, GRADIENT_CLIP);
+    _trainer.adam_m[i] = ADAM_BETA1 * _trainer.adam_m[i] + (1.0f - ADAM_BETA1) * grad;
+    _trainer.adam_v[i] = ADAM_BETA2 * _trainer.adam_v[i] + (1.0f - ADAM_BETA2) * grad * grad;
+    float mHat = _trainer.adam_m[i] / correction1;
+    float vHat = _trainer.adam_v[i] / correction2;
+    params[i] -= lr * mHat / (sqrtf(vHat) + ADAM_EPSILON);
+  }
+}
+
+bool EnhancedMLModel::_publishAutoencoder(unsigned long generation) {
+  // The standby slot is shared with hot-swap; a staged or newly swapped-in
+  // model wins over weights trained from the one it replaced
+  if (!_claimStandby(MODEL_AUTOENCODER)) {
+    return false;
+  }
+  if (__atomic_load_n(&_swap[MODEL_AUTOENCODER].swaps, __ATOMIC_ACQUIRE) != generation) {
+    __atomic_store_n(&_swap[MODEL_AUTOENCODER].state, (uint8_t)SWAP_IDLE, __ATOMIC_RELEASE);
+    return false;
+  }
+  
+  // Write into the slot inference is not reading (the claim waited out readers
+  // still pinning it), then swap the pointer
+  AutoencoderModel* target = (AutoencoderModel*)_standbySlot(MODEL_AUTOENCODER);
+  memcpy(target, &_trainer.weights, sizeof(AutoencoderModel));
+  __atomic_store_n(&_autoencoder, (const AutoencoderModel*)target, __ATOMIC_RELEASE);
+  _swap[MODEL_AUTOENCODER].active_crc = 0;
+  __atomic_store_n(&_swap[MODEL_AUTOENCODER].state, (uint8_t)SWAP_IDLE, __ATOMIC_RELEASE);
+  return true;
+}
+
+void EnhancedMLModel::_scoreAgreement() {
+  // The stored labels are the detector's own decisions (addTrainingSample is fed
+  // threatDetected), so this measures agreement with it, not accuracy
+  int count = getTrainingSampleCount();
+  int correct = 0;
+  int normals = 0;
+  int falsePositives = 0;
+  
+  for (int i = 0; i < count; i++) {
+    float raw[INPUT_FEATURES];
+    float features[SCALED_FEATURES];
+    bool isThreat = false;
+    if (!getTrainingSample(i, raw, &isThreat)) {
+      continue;
+    }
+    
+    FeatureScaler::apply(raw, features);
+    bool predicted = predictAutoencoder(features) > AUTOENCODER_ANOMALY_THRESHOLD;
+    if (predicted == isThreat) correct++;
+    if (!isThreat) {
+      normals++;
+      if (predicted) falsePositives++;
+    }
+  }
+  
+  if (count > 0) {
+    _onlineLearner.agreement = (float)correct / count;
+  }
+  if (normals > 0) {
+    _onlineLearner.false_alarm_rate = (float)falsePositives / normals;
+  }
+}
+
+void EnhancedMLModel::addModel(ModelType type, float weight) {
+  // Implement adding model to ensemble
+}
+
+void EnhancedMLModel::updateWeights(const float* accuracies) {
+  // Implement weight update
 }
 
 float EnhancedMLModel::evaluateModel(ModelType type, const SensorData* testData, const bool* testLabels, int count) {
-  // Implement model evaluation
-  return 0.0;
+  // Accuracy at the model's decision threshold; samples are consumed in order
+  // like live ticks (rule history and LSTM window advance)
+  if (!_initialized || !testData || !testLabels || count <= 0) {
+    return 0.0;
+  }
+  
+  int correct = 0;
+  for (int i = 0; i < count; i++) {
+    prepareFeatures(testData[i]);
+    switch (type) {
+      case MODEL_LSTM: _tickLSTM(); break;
+      case MODEL_AUTOENCODER: _tickAutoencoder(); break;
+      case MODEL_ENSEMBLE: predictEnsemble(testData[i]); break;
+      case MODEL_RULE_BASED: _tickRules(testData[i]); break;
+      case MODEL_TREE_ENSEMBLE: _tickTrees(); break;
+      case MODEL_HYBRID: predictAdvanced(testData[i]); break;
+    }
+    _tickOpen = false;
+    
+    bool threat = getTickScore(type) > getDecisionThreshold(type);
+    if (threat == testLabels[i]) {
+      correct++;
+    }
+  }
+  
+  return (float)correct / count;
+}
+
+float EnhancedMLModel::getTickScore(ModelType type) {
+  // Threat score of the current tick, NAN when the model did not run
+  _joinLSTM(false);
+  switch (type) {
+    case MODEL_LSTM: return _tick.lstm_valid ? _tick.lstm : NAN;
+    case MODEL_AUTOENCODER: return _tick.autoencoder_valid ? _autoencoderScore(_tick.reconstruction_error) : NAN;
+    case MODEL_ENSEMBLE: return _tick.ensemble_valid ? _tick.ensemble : NAN;
+    case MODEL_RULE_BASED: return _tick.rules_valid ? _tick.rule_score : NAN;
+    case MODEL_TREE_ENSEMBLE: return _tick.trees_valid ? _tick.trees : NAN;
+    case MODEL_HYBRID: return _tick.prediction_valid ? _tick.prediction : NAN;
+    default: return NAN;
+  }
+}
+
+float EnhancedMLModel::getDecisionThreshold(ModelType type) {
+  // The autoencoder score puts the anomaly threshold at 0.5
+  return (type == MODEL_AUTOENCODER) ? 0.5 : THREAT_THRESHOLD;
+}
+
+float EnhancedMLModel::_autoencoderScore(float reconstructionError) {
+  // Reconstruction error mapped so the anomaly threshold scores 0.5
+  return min(1.0f, reconstructionError / (2.0f * (float)AUTOENCODER_ANOMALY_THRESHOLD));
 }
 
 void EnhancedMLModel::printModelStats() {
-  // Implement model statistics printing
+  Serial.println("=== Enhanced ML Model Stats ===");
+  Serial.println("Model        calls    p50 us    p99 us    max us   weights   scratch  training   standby");
+  
+  for (int t = MODEL_LSTM; t < MODEL_TYPE_COUNT; t++) {
+    ModelType type = (ModelType)t;
+    InferenceStats stats = getInferenceStats(type);
+    ModelSizeInfo size = getModelSizeInfo(type);
+    Serial.printf("%-11s %6lu %9.1f %9.1f %9.1f %8u%c %8u %9u %9u\n",
+                  getModelName(type), stats.count,
+                  LatencyStats::cyclesToMicros(stats.p50_cycles),
+                  LatencyStats::cyclesToMicros(stats.p99_cycles),
+                  LatencyStats::cyclesToMicros(stats.max_cycles),
+                  (unsigned)size.weight_bytes, size.weights_in_flash ? 'F' : ' ',
+                  (unsigned)size.scratch_bytes, (unsigned)size.training_bytes,
+                  (unsigned)size.standby_bytes);
+  }
+  
+  for (int t = MODEL_LSTM; t <= MODEL_ENSEMBLE; t++) {
+    const ModelSwapStats& swap = _swap[t];
+    if (swap.swaps == 0 && swap.rejects == 0) {
+      continue;
+    }
+    Serial.printf("Hot-swap %-11s %lu swapped, %lu rejected, CRC %08x, stage %lu us, switch %u cycles\n",
+                  getModelName((ModelType)t), swap.swaps, swap.rejects, (unsigned)swap.active_crc,
+                  swap.stage_micros, (unsigned)swap.commit_cycles);
+  }
+  
+  if (_shadow.loaded) {
+    ShadowStats shadow = getShadowStats();
+    Serial.printf("Shadow %s: %lu/%lu ticks (%lu over budget, %lu busy), %.2f%% disagree with production, "
+                  "%.2f%% with active, p99 %.1f us\n",
+                  getModelName(shadow.type), shadow.evaluated, shadow.offered, shadow.skipped_budget,
+                  shadow.skipped_busy, shadow.evaluated ? 100.0 * shadow.disagreements / shadow.evaluated : 0.0,
+                  shadow.compared_active ? 100.0 * shadow.active_disagreements / shadow.compared_active : 0.0,
+                  LatencyStats::cyclesToMicros(shadow.latency.p99_cycles));
+  }
+  
+  Serial.println("Early exits: " + String(getEarlyExitRate() * 100, 1) + "% of " +
+                 String(_cascadeStats.ticks) + " ticks (F = weights mapped from flash)");
+  Serial.println("Parallel LSTM: " + String(_parallelStats.forks) + " forks (" +
+                 String(_parallelStats.joins) + " used, " + String(_parallelStats.discards) + " speculative), " +
+                 String(_parallelStats.inline_runs) + " inline, speedup " + String(getParallelSpeedup(), 2) + "x");
 }
 
 size_t EnhancedMLModel::getModelSize(ModelType type) {
-  // Implement model size calculation
-  return 0;
+  // Bytes needed to run the model: parameters plus inference state
+  ModelSizeInfo size = getModelSizeInfo(type);
+  return size.weight_bytes + size.scratch_bytes;
+}
+
+ModelSizeInfo EnhancedMLModel::getModelSizeInfo(ModelType type) {
+  ModelSizeInfo size = {};
+  
+  switch (type) {
+    case MODEL_LSTM:
+      size.weight_bytes = sizeof(LSTMModel);
+      size.scratch_bytes = sizeof(LSTMCell) + sizeof(_lstmSequence);
+      size.standby_bytes = (_lstmModel && _lstm != _lstmModel) || (_lstmStandby && _lstm != _lstmStandby)
+        ? sizeof(LSTMModel) : 0;
+      size.weights_in_flash = _lstm != _lstmModel && _lstm != _lstmStandby;
+      break;
+    case MODEL_AUTOENCODER: {
+      const AutoencoderModel* active = __atomic_load_n(&_autoencoder, __ATOMIC_ACQUIRE);
+      size.weight_bytes = sizeof(AutoencoderModel);
+      size.scratch_bytes = (8 + 4 + 8 + SCALED_FEATURES) * sizeof(float); // Activations on the stack
+      size.training_bytes = sizeof(AutoencoderTrainer) +
+                            (_onlineLearner.samples ? getTrainingBufferSize() : 0);
+      size.standby_bytes = sizeof(AutoencoderModel); // Back buffer, shared with the trainer
+      size.weights_in_flash = active != &_autoencoderModel && active != &_autoencoderBackBuffer;
+      break;
+    }
+    case MODEL_RULE_BASED:
+      size.scratch_bytes = sizeof(SensorData) * POWER_SIGNATURE_WINDOW; // Rule engine history
+      break;
+    case MODEL_ENSEMBLE:
+      size.weight_bytes = sizeof(EnsembleModel);
+      size.standby_bytes = sizeof(_ensembleStandby);
+      break;
+    case MODEL_TREE_ENSEMBLE:
+      // The trees are code: compares, branches and their literal constants
+      size.weight_bytes = TreeEnsemble::getCodeBytes();
+      size.scratch_bytes = TreeEnsemble::isAvailable() ? INPUT_FEATURES * sizeof(int32_t) : 0;
+      size.weights_in_flash = true;
+      break;
+    case MODEL_HYBRID:
+      // Everything a predictAdvanced() tick touches
+      for (int t = MODEL_LSTM; t < MODEL_TYPE_COUNT; t++) {
+        if (t == MODEL_HYBRID) {
+          continue;
+        }
+        ModelSizeInfo member = getModelSizeInfo((ModelType)t);
+        size.weight_bytes += member.weight_bytes;
+        size.scratch_bytes += member.scratch_bytes;
+        size.training_bytes += member.training_bytes;
+        size.standby_bytes += member.standby_bytes;
+      }
+      size.scratch_bytes += sizeof(FeatureVector) + sizeof(TickResults);
+      break;
+  }
+  
+  return size;
 }
 
 float EnhancedMLModel::getInferenceTime(ModelType type) {
-  // Implement inference time calculation
-  return 0.0;
+  // Median latency in microseconds
+  return LatencyStats::cyclesToMicros(LatencyStats::percentile(_latency[type], 0.5));
+}
+
+InferenceStats EnhancedMLModel::getInferenceStats(ModelType type) {
+  const LatencyHistogram& histogram = _latency[type];
+  InferenceStats stats;
+  stats.count = histogram.count;
+  stats.p50_cycles = LatencyStats::percentile(histogram, 0.5);
+  stats.p99_cycles = LatencyStats::percentile(histogram, 0.99);
+  stats.max_cycles = histogram.max;
+  stats.mean_cycles = LatencyStats::mean(histogram);
+  return stats;
+}
+
+void EnhancedMLModel::resetInferenceStats() {
+  for (int t = MODEL_LSTM; t < MODEL_TYPE_COUNT; t++) {
+    LatencyStats::reset(_latency[t]);
+  }
+}
+
+const char* EnhancedMLModel::getModelName(ModelType type) {
+  switch (type) {
+    case MODEL_LSTM: return "lstm";
+    case MODEL_AUTOENCODER: return "autoencoder";
+    case MODEL_ENSEMBLE: return "ensemble";
+    case MODEL_RULE_BASED: return "rules";
+    case MODEL_TREE_ENSEMBLE: return "trees";
+    case MODEL_HYBRID: return "hybrid";
+    default: return "unknown";
+  }
 }
 
 #endif // ENHANCED_ML_MODEL_H
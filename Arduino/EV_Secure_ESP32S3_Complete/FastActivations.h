@@ -0,0 +1,212 @@
+/*
+ * FastActivations.h - Fast Activation Functions for ML Inference
+ * 
+ * This file provides exp()-free replacements for the sigmoid and tanh
+ * activations used by MLModel and EnhancedMLModel. The LSTM alone evaluates
+ * more than a thousand activations per inference, so replacing the libm
+ * transcendental calls is the cheapest win on the inference path.
+ * 
+ * Implementations:
+ * - ACTIVATION_EXACT: libm exp() reference (original behaviour)
+ * - ACTIVATION_LUT: 257-entry flash table of tanh over [0, 8] with linear interpolation
+ * - ACTIVATION_RATIONAL: Lambert continued-fraction rational polynomial, clamped at |x| > 4.97
+ * 
+ * Guaranteed max absolute error against libm over the whole real line:
+ * - ACTIVATION_LUT: tanh < 1.0e-4, sigmoid < 5.0e-5
+ * - ACTIVATION_RATIONAL: tanh < 1.0e-4, sigmoid < 5.0e-5
+ * Sigmoid is derived as 0.5 + 0.5 * tanh(x / 2), which halves the tanh error.
+ * 
+ * Usage:
+ * 1. Select the implementation per model in EV_Secure_Config.h
+ *    (ENHANCED_ML_ACTIVATION, ML_MODEL_ACTIVATION)
+ * 2. Check the error bounds with FastActivations::verify() (on the host,
+ *    host/activation_check.cpp sweeps the whole float range against std::tanh/std::exp)
+ * 3. Measure cycles per call with FastActivations::benchmark()
+ */
+
+#ifndef FAST_ACTIVATIONS_H
+#define FAST_ACTIVATIONS_H
+
+#include "EV_Secure_Config.h"
+#include <Arduino.h>
+
+// Lookup table configuration
+#define TANH_LUT_SIZE 256         // Intervals in the table (entries = size + 1)
+#define TANH_LUT_RANGE 8.0f       // tanh(8) = 1 - 2.3e-7, saturate beyond
+#define TANH_RATIONAL_CLAMP 4.97f // Rational form crosses 1.0 just above this
+
+// Error bounds verified by FastActivations::verify()
+#define TANH_MAX_ERROR 1.0e-4f
+#define SIGMOID_MAX_ERROR 5.0e-5f
+
+// Benchmark configuration
+#define ACTIVATION_BENCH_ITERATIONS 1000
+
+class FastActivations {
+public:
+  // Reference implementations (libm)
+  static float sigmoidExact(float x);
+  static float tanhExact(float x);
+  
+  // Piecewise linear lookup table
+  static float tanhLUT(float x);
+  static float sigmoidLUT(float x);
+  
+  // Rational polynomial
+  static float tanhRational(float x);
+  static float sigmoidRational(float x);
+  
+  // Validation and profiling
+  static bool verify(float* maxTanhError = nullptr, float* maxSigmoidError = nullptr);
+  static void benchmark();
+  
+private:
+  static const float _tanhTable[TANH_LUT_SIZE + 1];
+  static uint32_t _cycles();
+};
+
+// Implementation
+const float FastActivations::_tanhTable[TANH_LUT_SIZE + 1] = {
+  0.00000000f, 0.03123983f, 0.06241875f, 0.09347630f, 0.12435300f, 0.15499073f,
+  0.18533320f, 0.21532634f, 0.24491866f, 0.27406159f, 0.30270973f, 0.33082112f,
+  0.35835740f, 0.38528397f, 0.41157006f, 0.43718879f, 0.46211716f, 0.48633602f,
+  0.50982997f, 0.53258729f, 0.55459972f, 0.57586239f, 0.59637356f, 0.61613443f,
+  0.63514895f, 0.65342359f, 0.67096707f, 0.68779021f, 0.70390560f, 0.71932750f,
+  0.73407152f, 0.74815447f, 0.76159416f, 0.77440919f, 0.78661881f, 0.79824275f,
+  0.80930107f, 0.81981401f, 0.82980191f, 0.83928506f, 0.84828364f, 0.85681760f,
+  0.86490662f, 0.87257001f, 0.87982670f, 0.88669515f, 0.89319334f, 0.89933873f,
+  0.90514825f, 0.91063826f, 0.91582454f, 0.92072232f, 0.92534623f, 0.92971031f,
+  0.93382804f, 0.93771234f, 0.94137554f, 0.94482944f, 0.94808529f, 0.95115382f,
+  0.95404526f, 0.95676933f, 0.95933529f, 0.96175193f, 0.96402758f, 0.96617017f,
+  0.96818722f, 0.97008583f, 0.97187275f, 0.97355436f, 0.97513670f, 0.97662548f,
+  0.97802611f, 0.97934369f, 0.98058305f, 0.98174873f, 0.98284503f, 0.98387602f,
+  0.98484552f, 0.98575714f, 0.98661430f, 0.98742020f, 0.98817786f, 0.98889015f,
+  0.98955975f, 0.99018919f, 0.99078086f, 0.99133700f, 0.99185972f, 0.99235103f,
+  0.99281279f, 0.99324678f, 0.99365463f, 0.99403793f, 0.99439815f, 0.99473665f,
+  0.99505475f, 0.99535367f, 0.99563457f, 0.99589851f, 0.99614653f, 0.99637958f,
+  0.99659856f, 0.99680431f, 0.99699764f, 0.99717928f, 0.99734996f, 0.99751031f,
+  0.99766098f, 0.99780254f, 0.99793554f, 0.99806050f, 0.99817790f, 0.99828820f,
+  0.99839183f, 0.99848919f, 0.99858066f, 0.99866660f, 0.99874733f, 0.99882318f,
+  0.99889444f, 0.99896139f, 0.99902429f, 0.99908337f, 0.99913889f, 0.99919104f,
+  0.99924003f, 0.99928606f, 0.99932930f, 0.99936992f, 0.99940809f, 0.99944394f,
+  0.99947762f, 0.99950926f, 0.99953899f, 0.99956691f, 0.99959315f, 0.99961779f,
+  0.99964094f, 0.99966269f, 0.99968313f, 0.99970232f, 0.99972036f, 0.99973730f,
+  0.99975321f, 0.99976816f, 0.99978221f, 0.99979540f, 0.99980780f, 0.99981944f,
+  0.99983038f, 0.99984065f, 0.99985031f, 0.99985938f, 0.99986790f, 0.99987590f,
+  0.99988342f, 0.99989048f, 0.99989712f, 0.99990335f, 0.99990920f, 0.99991471f,
+  0.99991987f, 0.99992473f, 0.99992929f, 0.99993357f, 0.99993760f, 0.99994138f,
+  0.99994493f, 0.99994827f, 0.99995140f, 0.99995434f, 0.99995711f, 0.99995971f,
+  0.99996215f, 0.99996444f, 0.99996660f, 0.99996862f, 0.99997052f, 0.99997231f,
+  0.99997399f, 0.99997556f, 0.99997704f, 0.99997843f, 0.99997974f, 0.99998097f,
+  0.99998212f, 0.99998320f, 0.99998422f, 0.99998518f, 0.99998608f, 0.99998692f,
+  0.99998771f, 0.99998846f, 0.99998916f, 0.99998981f, 0.99999043f, 0.99999101f,
+  0.99999155f, 0.99999207f, 0.99999255f, 0.99999300f, 0.99999342f, 0.99999382f,
+  0.99999420f, 0.99999455f, 0.99999488f, 0.99999519f, 0.99999548f, 0.99999575f,
+  0.99999601f, 0.99999625f, 0.99999648f, 0.99999669f, 0.99999689f, 0.99999708f,
+  0.99999726f, 0.99999742f, 0.99999758f, 0.99999773f, 0.99999786f, 0.99999799f,
+  0.99999812f, 0.99999823f, 0.99999834f, 0.99999844f, 0.99999853f, 0.99999862f,
+  0.99999870f, 0.99999878f, 0.99999886f, 0.99999893f, 0.99999899f, 0.99999905f,
+  0.99999911f, 0.99999916f, 0.99999921f, 0.99999926f, 0.99999931f, 0.99999935f,
+  0.99999939f, 0.99999943f, 0.99999946f, 0.99999949f, 0.99999952f, 0.99999955f,
+  0.99999958f, 0.99999960f, 0.99999963f, 0.99999965f, 0.99999967f, 0.99999969f,
+  0.99999971f, 0.99999973f, 0.99999974f, 0.99999976f, 0.99999977f
+
+};
+
+float FastActivations::sigmoidExact(float x) {
+  if (x > 10) return 1.0;
+  if (x < -10) return 0.0;
+  return 1.0 / (1.0 + exp(-x));
+}
+
+float FastActivations::tanhExact(float x) {
+  if (x > 10) return 1.0;
+  if (x < -10) return -1.0;
+  float ex = exp(x);
+  float enx = exp(-x);
+  return (ex - enx) / (ex + enx);
+}
+
+float FastActivations::tanhLUT(float x) {
+  float a = fabsf(x);
+  if (!(a < TANH_LUT_RANGE)) {
+    // Saturated; NaN is passed through rather than used as a table index
+    return (x != x) ? x : ((x > 0.0f) ? 1.0f : -1.0f);
+  }
+  
+  // Linear interpolation between neighbouring table entries
+  float pos = a * (TANH_LUT_SIZE / TANH_LUT_RANGE);
+  int index = (int)pos;
+  float frac = pos - (float)index;
+  float y = _tanhTable[index] + (_tanhTable[index + 1] - _tanhTable[index]) * frac;
+  
+  return (x < 0.0f) ? -y : y;
+}
+
+float FastActivations::sigmoidLUT(float x) {
+  return 0.5f + 0.5f * tanhLUT(0.5f * x);
+}
+
+float FastActivations::tanhRational(float x) {
+  if (x > TANH_RATIONAL_CLAMP) return 1.0f;
+  if (x < -TANH_RATIONAL_CLAMP) return -1.0f;
+  
+  // 7/6 Lambert continued fraction, evaluated in Horner form
+  float x2 = x * x;
+  float num = x * (135135.0f + x2 * (17325.0f + x2 * (378.0f + x2)));
+  float den = 135135.0f + x2 * (62370.0f + x2 * (3150.0f + x2 * 28.0f));
+  return num / den;
+}
+
+float FastActivations::sigmoidRational(float x) {
+  return 0.5f + 0.5f * tanhRational(0.5f * x);
+}
+
+bool FastActivations::verify(float* maxTanhError, float* maxSigmoidError) {
+  float tanhErr = 0.0f;
+  float sigmoidErr = 0.0f;
+  
+  // Sweep past both saturation points with a step finer than the table spacing
+  for (float x = -20.0f; x <= 20.0f; x += 1.0f / 64.0f) {
+    float refTanh = tanh(x);
+    float refSigmoid = 1.0f / (1.0f + exp(-x));
+    
+    tanhErr = max(tanhErr, fabsf(tanhLUT(x) - refTanh));
+    tanhErr = max(tanhErr, fabsf(tanhRational(x) - refTanh));
+    sigmoidErr = max(sigmoidErr, fabsf(sigmoidLUT(x) - refSigmoid));
+    sigmoidErr = max(sigmoidErr, fabsf(sigmoidRational(x) - refSigmoid));
+  }
+  
+  if (maxTanhError) *maxTanhError = tanhErr;
+  if (maxSigmoidError) *maxSigmoidError = sigmoidErr;
+  
+  return tanhErr < TANH_MAX_ERROR && sigmoidErr < SIGMOID_MAX_ERROR;
+}
+
+void FastActivations::benchmark() {
+  float (*const functions[])(float) = {
+    sigmoidExact, sigmoidLUT, sigmoidRational,
+    tanhExact, tanhLUT, tanhRational
+  };
+  const char* names[] = {
+    "sigmoid exact", "sigmoid LUT", "sigmoid rational",
+    "tanh exact", "tanh LUT", "tanh rational"
+  };
+  
+  Serial.println("Activation benchmark (cycles/call):");
+  for (int f = 0; f < 6; f++) {
+    volatile float sink = 0.0f;
+    uint32_t start = _cycles();
+    for (int i = 0; i < ACTIVATION_BENCH_ITERATIONS; i++) {
+      sink = sink + functions[f]((float)(i - ACTIVATION_BENCH_ITERATIONS / 2) * 0.01f);
+    }
+    uint32_t elapsed = _cycles() - start;
+    Serial.println("  " + String(names[f]) + ": " + String((float)elapsed / ACTIVATION_BENCH_ITERATIONS, 1));
+  }
+}
+
+uint32_t FastActivations::_cycles() {
+  return ESP.getCycleCount();
+}
+
+#endif // FAST_ACTIVATIONS_H
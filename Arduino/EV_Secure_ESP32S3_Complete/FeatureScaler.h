@@ -0,0 +1,191 @@
+/*
+ * FeatureScaler.h - Streaming Feature Normalization
+ *
+ * This file standardizes sensor inputs before they reach the neural models.
+ * Raw inputs span five orders of magnitude (amps, ~230 V, kW, Hz, C), so
+ * without scaling the power term dominates every dot product and the
+ * activations saturate.
+ *
+ * Features:
+ * - Running mean/variance per sensor feature (Welford, O(1) per sample)
+ * - Learns only from normal charging samples
+ * - Bounded memory of the past: the sample count saturates at
+ *   FEATURE_SCALER_WINDOW, after which the statistics track slow drift
+ * - Fused scale-and-shift (x * scale + shift) applied before inference
+ * - SystemState expanded to a one-hot vector instead of an ordinal float
+ * - Persisted next to the model files through ModelStore
+ *
+ * Model input layout (SCALED_FEATURES):
+ * - [0..4] standardized current, voltage, power, frequency, temperature
+ * - [5..10] one-hot SystemState
+ *
+ * Usage:
+ * 1. Initialize with FeatureScaler::init() (loads stored statistics, else the
+ *    compiled-in defaults the model was trained under, else the priors)
+ * 2. Feed normal samples with FeatureScaler::update()
+ * 3. Transform raw features with FeatureScaler::apply()
+ * 4. Persist with FeatureScaler::save()
+ */
+
+#ifndef FEATURE_SCALER_H
+#define FEATURE_SCALER_H
+
+#include "EV_Secure_Config.h"
+#include "ModelStore.h"
+#include <Arduino.h>
+
+// Statistics configuration
+#define FEATURE_SCALER_WINDOW 10000        // Effective memory in samples
+#define FEATURE_SCALER_MIN_SAMPLES 100     // Use priors until this many samples
+#define FEATURE_SCALER_REFRESH 32          // Recompute scale/shift every N updates
+#define FEATURE_SCALER_MIN_STD 1e-3f       // Floor for constant features
+#define FEATURE_SCALER_MODEL_ID 16         // ModelStore id of the stored statistics
+
+// Priors for a nominal 16 A / 230 V / 50 Hz session: A, V, W, Hz, C
+#define FEATURE_PRIOR_MEAN {16.0f, 230.0f, 3680.0f, 50.0f, 30.0f}
+#define FEATURE_PRIOR_STD {10.0f, 10.0f, 2300.0f, 0.5f, 10.0f}
+
+// Persisted statistics (all floats so the host tool can pack them)
+struct FeatureScalerState {
+  float count;
+  float mean[SENSOR_FEATURES];
+  float m2[SENSOR_FEATURES];
+};
+
+class FeatureScaler {
+public:
+  static void init(const FeatureScalerState* defaults = nullptr);
+  static void update(const float* raw);
+  static void apply(const float* raw, float* scaled);
+  static bool isWarm();
+  static unsigned long getSampleCount();
+  static float getMean(int feature);
+  static float getStdDev(int feature);
+
+  // Persistence
+  static bool load();
+  static bool save();
+
+private:
+  static FeatureScalerState _state;
+  static float _scale[SENSOR_FEATURES];
+  static float _shift[SENSOR_FEATURES];
+  static int _updatesSinceRefresh;
+
+  static void _refreshAffine();
+};
+
+// Implementation
+FeatureScalerState FeatureScaler::_state;
+float FeatureScaler::_scale[SENSOR_FEATURES];
+float FeatureScaler::_shift[SENSOR_FEATURES];
+int FeatureScaler::_updatesSinceRefresh = 0;
+
+void FeatureScaler::init(const FeatureScalerState* defaults) {
+  if (!load()) {
+    if (defaults) {
+      memcpy(&_state, defaults, sizeof(FeatureScalerState));
+    } else {
+      // Start from priors; they are replaced as soon as real data arrives
+      static const float priorMean[SENSOR_FEATURES] = FEATURE_PRIOR_MEAN;
+      _state.count = 0;
+      for (int i = 0; i < SENSOR_FEATURES; i++) {
+        _state.mean[i] = priorMean[i];
+        _state.m2[i] = 0.0f;
+      }
+    }
+  }
+
+  _updatesSinceRefresh = 0;
+  _refreshAffine();
+
+  Serial.println("Feature scaler ready (" + String((unsigned long)_state.count) + " samples)");
+}
+
+void FeatureScaler::update(const float* raw) {
+  for (int i = 0; i < SENSOR_FEATURES; i++) {
+    if (isnan(raw[i])) {
+      return; // Never learn from broken readings
+    }
+  }
+
+  // Welford update; a saturated count turns it into an exponential moving average
+  if (_state.count < FEATURE_SCALER_WINDOW) {
+    _state.count += 1.0f;
+  }
+  for (int i = 0; i < SENSOR_FEATURES; i++) {
+    float delta = raw[i] - _state.mean[i];
+    _state.mean[i] += delta / _state.count;
+    float delta2 = raw[i] - _state.mean[i];
+    _state.m2[i] += delta * delta2;
+    if (_state.count >= FEATURE_SCALER_WINDOW) {
+      _state.m2[i] *= (FEATURE_SCALER_WINDOW - 1.0f) / FEATURE_SCALER_WINDOW;
+    }
+  }
+
+  if (++_updatesSinceRefresh >= FEATURE_SCALER_REFRESH) {
+    _refreshAffine();
+    _updatesSinceRefresh = 0;
+  }
+}
+
+void FeatureScaler::apply(const float* raw, float* scaled) {
+  for (int i = 0; i < SENSOR_FEATURES; i++) {
+    scaled[i] = raw[i] * _scale[i] + _shift[i];
+  }
+
+  // One-hot SystemState (raw[SENSOR_FEATURES] holds the enum value)
+  int state = (int)raw[SENSOR_FEATURES];
+  for (int i = 0; i < STATE_FEATURES; i++) {
+    scaled[SENSOR_FEATURES + i] = (i == state) ? 1.0f : 0.0f;
+  }
+}
+
+bool FeatureScaler::isWarm() {
+  return _state.count >= FEATURE_SCALER_MIN_SAMPLES;
+}
+
+unsigned long FeatureScaler::getSampleCount() {
+  return (unsigned long)_state.count;
+}
+
+float FeatureScaler::getMean(int feature) {
+  return _state.mean[feature];
+}
+
+float FeatureScaler::getStdDev(int feature) {
+  if (_state.count < 2) {
+    return 0.0f;
+  }
+  return sqrtf(_state.m2[feature] / (_state.count - 1.0f));
+}
+
+bool FeatureScaler::load() {
+  ModelStore::init();
+
+  const void* mapped = ModelStore::mapModel(FEATURE_SCALER_MODEL_ID, sizeof(FeatureScalerState));
+  if (mapped) {
+    memcpy(&_state, mapped, sizeof(FeatureScalerState));
+    return true;
+  }
+  return ModelStore::loadFromSD(FEATURE_SCALER_MODEL_ID, &_state, sizeof(FeatureScalerState));
+}
+
+bool FeatureScaler::save() {
+  return ModelStore::saveToSD(FEATURE_SCALER_MODEL_ID, &_state, sizeof(FeatureScalerState));
+}
+
+void FeatureScaler::_refreshAffine() {
+  static const float priorStd[SENSOR_FEATURES] = FEATURE_PRIOR_STD;
+
+  for (int i = 0; i < SENSOR_FEATURES; i++) {
+    float std = isWarm() ? getStdDev(i) : priorStd[i];
+    if (std < FEATURE_SCALER_MIN_STD) {
+      std = FEATURE_SCALER_MIN_STD;
+    }
+    _scale[i] = 1.0f / std;
+    _shift[i] = -_state.mean[i] * _scale[i];
+  }
+}
+
+#endif // FEATURE_SCALER_H
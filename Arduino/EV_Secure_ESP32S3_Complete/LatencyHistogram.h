@@ -0,0 +1,122 @@
+/*
+ * LatencyHistogram.h - Fixed-Size Latency Histograms
+ *
+ * This file records latencies measured with the CPU cycle counter into
+ * log-linear histograms, so percentiles can be reported without keeping
+ * individual samples.
+ *
+ * Features:
+ * - Constant memory per histogram (no allocation)
+ * - O(1) record (one count-leading-zeros and one increment)
+ * - 4 buckets per power of two: percentiles within 19% of the true value
+ * - Exact maximum and mean
+ *
+ * Usage:
+ * 1. Declare a LatencyHistogram and clear it with LatencyStats::reset()
+ * 2. Record with LatencyStats::record(histogram, ESP.getCycleCount() - start)
+ * 3. Query LatencyStats::percentile(histogram, 0.99)
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <Arduino.h>
+
+// Histogram layout
+#define LATENCY_SUB_BUCKET_BITS 2                                   // 4 buckets per power of two
+#define LATENCY_OCTAVES 25                                          // Up to 2^26 cycles (~280 ms at 240 MHz)
+#define LATENCY_BUCKETS (LATENCY_OCTAVES << LATENCY_SUB_BUCKET_BITS)
+
+// Latency histogram (cycles)
+struct LatencyHistogram {
+  uint32_t buckets[LATENCY_BUCKETS];
+  uint32_t count;
+  uint32_t max;
+  uint64_t total;
+};
+
+class LatencyStats {
+public:
+  static void reset(LatencyHistogram& histogram);
+  static void record(LatencyHistogram& histogram, uint32_t cycles);
+  static uint32_t percentile(const LatencyHistogram& histogram, float fraction);
+  static uint32_t mean(const LatencyHistogram& histogram);
+  static float cyclesToMicros(uint32_t cycles);
+
+private:
+  static int _bucketOf(uint32_t cycles);
+  static uint32_t _bucketUpperBound(int bucket);
+};
+
+// Implementation
+void LatencyStats::reset(LatencyHistogram& histogram) {
+  memset(&histogram, 0, sizeof(histogram));
+}
+
+void LatencyStats::record(LatencyHistogram& histogram, uint32_t cycles) {
+  histogram.buckets[_bucketOf(cycles)]++;
+  histogram.count++;
+  histogram.total += cycles;
+  if (cycles > histogram.max) {
+    histogram.max = cycles;
+  }
+}
+
+uint32_t LatencyStats::percentile(const LatencyHistogram& histogram, float fraction) {
+  if (histogram.count == 0) {
+    return 0;
+  }
+
+  // Smallest bucket that covers the requested share of samples
+  uint32_t target = (uint32_t)ceilf(fraction * histogram.count);
+  if (target == 0) {
+    target = 1;
+  }
+  uint32_t seen = 0;
+  for (int i = 0; i < LATENCY_BUCKETS; i++) {
+    seen += histogram.buckets[i];
+    if (seen >= target) {
+      uint32_t upper = _bucketUpperBound(i);
+      return (upper < histogram.max) ? upper : histogram.max;
+    }
+  }
+  return histogram.max;
+}
+
+uint32_t LatencyStats::mean(const LatencyHistogram& histogram) {
+  if (histogram.count == 0) {
+    return 0;
+  }
+  return (uint32_t)(histogram.total / histogram.count);
+}
+
+float LatencyStats::cyclesToMicros(uint32_t cycles) {
+  return (float)cycles / ESP.getCpuFreqMHz();
+}
+
+int LatencyStats::_bucketOf(uint32_t cycles) {
+  const uint32_t subBuckets = 1 << LATENCY_SUB_BUCKET_BITS;
+  if (cycles < subBuckets) {
+    return cycles; // First octave is linear
+  }
+
+  // Octave from the leading bit, sub-bucket from the next bits
+  int msb = 31 - __builtin_clz(cycles);
+  int octave = msb - LATENCY_SUB_BUCKET_BITS + 1;
+  int sub = (cycles >> (msb - LATENCY_SUB_BUCKET_BITS)) & (subBuckets - 1);
+  int bucket = (octave << LATENCY_SUB_BUCKET_BITS) + sub;
+  return (bucket < LATENCY_BUCKETS) ? bucket : LATENCY_BUCKETS - 1;
+}
+
+uint32_t LatencyStats::_bucketUpperBound(int bucket) {
+  const uint32_t subBuckets = 1 << LATENCY_SUB_BUCKET_BITS;
+  int octave = bucket >> LATENCY_SUB_BUCKET_BITS;
+  uint32_t sub = bucket & (subBuckets - 1);
+  if (octave == 0) {
+    return sub;
+  }
+  uint32_t width = 1UL << (octave - 1);
+  return (subBuckets + sub) * width + width - 1;
+}
+
+#endif // LATENCY_HISTOGRAM_H
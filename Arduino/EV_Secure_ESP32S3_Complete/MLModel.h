@@ -31,6 +31,7 @@
  #define ML_MODEL_H
  
  #include "EV_Secure_Config.h"
+ #include "FastActivations.h"
  #include <Arduino.h>
  
  // TensorFlow Lite Micro includes (you'll need to install the library)
@@ -43,15 +44,13 @@
  class MLModel {
  public:
    static bool init();
-   static bool runInference(float* inputFeatures, MLPrediction* result);
+   static bool runInference(const float* inputFeatures, MLPrediction* result);
    static void cleanup();
    static bool isInitialized();
    static size_t getModelSize();
    
  private:
    static bool _initialized;
-   static float _modelWeights[64]; // Placeholder weights
-   static void _initializeWeights();
    static float _sigmoid(float x);
    static float _relu(float x); // FIXED: Changed return type
    // Hybrid rule + lightweight NN scoring helpers
@@ -72,7 +71,6 @@
  
  // Implementation
  bool MLModel::_initialized = false;
- float MLModel::_modelWeights[64] = {0};
  
  bool MLModel::init() {
    if (_initialized) {
@@ -81,9 +79,6 @@
    
    Serial.println("Initializing ML Model...");
    
-   // Initialize model weights (placeholder)
-   _initializeWeights();
-   
    // In a real implementation, you would:
    // 1. Load the TensorFlow Lite model from model_data
    // 2. Initialize the interpreter
@@ -95,7 +90,7 @@
    return true;
  }
  
- bool MLModel::runInference(float* inputFeatures, MLPrediction* result) {
+ bool MLModel::runInference(const float* inputFeatures, MLPrediction* result) {
    if (!_initialized) {
      Serial.println("ML Model not initialized");
      return false;
@@ -159,22 +154,15 @@
    return model_data_size;
  }
  
- void MLModel::_initializeWeights() {
-   // Initialize with random weights (in practice, these would come from training)
-   randomSeed(analogRead(0));
-   
-   for (int i = 0; i < 64; i++) {
-     _modelWeights[i] = (random(-100, 100) / 100.0);
-   }
-   
-   Serial.println("Model weights initialized");
- }
- 
  float MLModel::_sigmoid(float x) {
    // Sigmoid activation function
-   if (x > 10) return 1.0;
-   if (x < -10) return 0.0;
-   return 1.0 / (1.0 + exp(-x));
+ #if ML_MODEL_ACTIVATION == ACTIVATION_LUT
+   return FastActivations::sigmoidLUT(x);
+ #elif ML_MODEL_ACTIVATION == ACTIVATION_RATIONAL
+   return FastActivations::sigmoidRational(x);
+ #else
+   return FastActivations::sigmoidExact(x);
+ #endif
  }
  
  float MLModel::_relu(float x) { // FIXED: Changed return type to float
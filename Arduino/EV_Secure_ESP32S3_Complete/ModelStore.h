@@ -0,0 +1,318 @@
+/*
+ * ModelStore.h - Versioned Model Weight Storage
+ *
+ * This library loads and saves model weights for the EV-Secure ML models.
+ * Each model is stored as a versioned, checksummed container so the same
+ * trained weights are used after every reset.
+ *
+ * Features:
+ * - Versioned binary container with CRC-32 over the payload
+ * - Shape check against the compiled model configuration
+ * - Zero-copy mapping from the "models" flash partition
+ * - Load/save from SD card (/models/<type>.evm); a save replaces the file by
+ *   rename and keeps the previous one (.old) until the new one is in place
+ * - Streamed load from any Stream (SD file, HTTP body) with a running CRC
+ * - Boot-time load measurement
+ *
+ * File Layout (little-endian, 32-byte header + payload):
+ * - 0  magic         "EVMF"
+ * - 4  version       MODEL_FILE_VERSION
+ * - 6  model_type    ModelType of the payload
+ * - 8  payload_size  Bytes following the header
+ * - 12 payload_crc   CRC-32 (zlib polynomial) of the payload
+ * - 16 created       Unix time the file was packed (0 if unknown)
+ * - 20 input_size    SCALED_FEATURES the weights were trained with
+ * - 22 flags         Reserved for optional sections (0 in version 2)
+ * - 24 reserved      Zero
+ * - 32 payload       Raw float32 weights in model struct order
+ *
+ * Flash Partition:
+ * The "models" data partition (see partitions.csv) holds model files back to
+ * back, each padded to MODEL_FILE_ALIGN bytes. It is mapped once into the data
+ * cache and payloads are used in place. Build the image with
+ * Arduino/tools/model_tool.py and flash it at the partition offset.
+ *
+ * Usage:
+ * 1. Initialize with ModelStore::init()
+ * 2. Get read-only weights with ModelStore::mapModel()
+ * 3. Fall back to ModelStore::loadFromSD() / persist with ModelStore::saveToSD()
+ */
+
+#ifndef MODEL_STORE_H
+#define MODEL_STORE_H
+
+#include "EV_Secure_Config.h"
+#include <SD.h>
+#include <esp_partition.h>
+
+// Container format
+#define MODEL_FILE_MAGIC 0x464D5645    // "EVMF" little-endian
+#define MODEL_FILE_VERSION 2           // 2: normalized inputs with one-hot state
+#define MODEL_FILE_ALIGN 16            // Payload alignment inside the flash image
+
+// Storage locations
+#define MODEL_PARTITION_LABEL "models"
+#define MODEL_PARTITION_SUBTYPE ((esp_partition_subtype_t)0x40)
+#define MODEL_SD_DIR "/models"
+#define MODEL_STREAM_CHUNK 512         // Bytes per read (and CRC update) when streaming
+
+// Model file header
+struct ModelFileHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t model_type;
+  uint32_t payload_size;
+  uint32_t payload_crc;
+  uint32_t created;
+  uint16_t input_size;
+  uint16_t flags;
+  uint8_t reserved[8];
+};
+
+class ModelStore {
+public:
+  static bool init();
+  static bool isPartitionMapped();
+  
+  // Flash (zero-copy)
+  static const void* mapModel(uint16_t modelType, size_t expectedSize);
+  
+  // SD card
+  static bool loadFromSD(uint16_t modelType, void* dest, size_t size);
+  static bool saveToSD(uint16_t modelType, const void* src, size_t size);
+  
+  // Any stream (hot-swap from SD or the dashboard)
+  static bool loadFromStream(uint16_t modelType, Stream& in, void* dest, size_t size, uint32_t* crcOut = nullptr);
+  
+  // Validation
+  static bool validateHeader(const ModelFileHeader& header, uint16_t modelType, size_t expectedSize);
+  static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0);
+  static String getModelPath(uint16_t modelType);
+  
+private:
+  static bool _initialized;
+  static const uint8_t* _partitionData;
+  static size_t _partitionSize;
+  static esp_partition_mmap_handle_t _mmapHandle;
+  
+  static void _fillHeader(ModelFileHeader& header, uint16_t modelType, const void* payload, size_t size);
+};
+
+// Implementation
+bool ModelStore::_initialized = false;
+const uint8_t* ModelStore::_partitionData = nullptr;
+size_t ModelStore::_partitionSize = 0;
+esp_partition_mmap_handle_t ModelStore::_mmapHandle;
+
+bool ModelStore::init() {
+  if (_initialized) {
+    return true;
+  }
+  
+  const esp_partition_t* partition = esp_partition_find_first(
+    ESP_PARTITION_TYPE_DATA, MODEL_PARTITION_SUBTYPE, MODEL_PARTITION_LABEL);
+  
+  if (partition) {
+    const void* mapped = nullptr;
+    if (esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA,
+                           &mapped, &_mmapHandle) == ESP_OK) {
+      _partitionData = (const uint8_t*)mapped;
+      _partitionSize = partition->size;
+      Serial.println("Model partition mapped: " + String(_partitionSize) + " bytes");
+    } else {
+      Serial.println("Failed to map model partition");
+    }
+  } else {
+    Serial.println("No '" MODEL_PARTITION_LABEL "' partition - models load from SD only");
+  }
+  
+  _initialized = true;
+  return true;
+}
+
+bool ModelStore::isPartitionMapped() {
+  return _partitionData != nullptr;
+}
+
+const void* ModelStore::mapModel(uint16_t modelType, size_t expectedSize) {
+  if (!_partitionData) {
+    return nullptr;
+  }
+  
+  // Walk the image; erased flash (0xFF) ends the list
+  size_t offset = 0;
+  while (offset + sizeof(ModelFileHeader) <= _partitionSize) {
+    ModelFileHeader header;
+    memcpy(&header, _partitionData + offset, sizeof(header));
+    if (header.magic != MODEL_FILE_MAGIC) {
+      break;
+    }
+  
+    const uint8_t* payload = _partitionData + offset + sizeof(ModelFileHeader);
+    // Subtract rather than add: a corrupt payload_size would wrap the sum
+    if (header.payload_size > _partitionSize - offset - sizeof(ModelFileHeader)) {
+      Serial.println("Truncated model entry in flash partition");
+      break;
+    }
+  
+    if (header.model_type == modelType) {
+      if (!validateHeader(header, modelType, expectedSize) ||
+          crc32(payload, header.payload_size) != header.payload_crc) {
+        Serial.println("Flash model " + String(modelType) + " failed validation");
+        return nullptr;
+      }
+      return payload;
+    }
+  
+    size_t entrySize = sizeof(ModelFileHeader) + header.payload_size;
+    offset += (entrySize + MODEL_FILE_ALIGN - 1) & ~(size_t)(MODEL_FILE_ALIGN - 1);
+  }
+  
+  return nullptr;
+}
+
+bool ModelStore::loadFromSD(uint16_t modelType, void* dest, size_t size) {
+  String path = getModelPath(modelType);
+  File file = SD.open(path, FILE_READ);
+  if (!file) {
+    // A power loss between saveToSD()'s two renames leaves only the previous file
+    path += ".old";
+    file = SD.open(path, FILE_READ);
+    if (!file) {
+      return false;
+    }
+  }
+  
+  bool ok = loadFromStream(modelType, file, dest, size);
+  file.close();
+  
+  if (!ok) {
+    Serial.println("Invalid model file: " + path);
+  }
+  return ok;
+}
+
+bool ModelStore::loadFromStream(uint16_t modelType, Stream& in, void* dest, size_t size, uint32_t* crcOut) {
+  ModelFileHeader header;
+  if (in.readBytes((uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+      !validateHeader(header, modelType, size)) {
+    return false;
+  }
+  
+  // Checksum each chunk as it arrives; no second pass over the payload
+  uint8_t* out = (uint8_t*)dest;
+  uint32_t crc = 0;
+  size_t received = 0;
+  while (received < size) {
+    size_t n = in.readBytes(out + received, min(size - received, (size_t)MODEL_STREAM_CHUNK));
+    if (n == 0) {
+      Serial.println("Model stream ended after " + String(received) + " of " + String(size) + " bytes");
+      return false;
+    }
+    crc = crc32(out + received, n, crc);
+    received += n;
+  }
+  
+  if (crc != header.payload_crc) {
+    Serial.println("Model " + String(modelType) + " checksum mismatch");
+    return false;
+  }
+  
+  if (crcOut) {
+    *crcOut = crc;
+  }
+  return true;
+}
+
+bool ModelStore::saveToSD(uint16_t modelType, const void* src, size_t size) {
+  if (!SD.exists(MODEL_SD_DIR)) {
+    SD.mkdir(MODEL_SD_DIR);
+  }
+  
+  ModelFileHeader header;
+  _fillHeader(header, modelType, src, size);
+  
+  // Write to a temporary file so a power loss never leaves a torn model
+  String path = getModelPath(modelType);
+  String tmpPath = path + ".tmp";
+  File file = SD.open(tmpPath, FILE_WRITE);
+  if (!file) {
+    Serial.println("Cannot create model file: " + tmpPath);
+    return false;
+  }
+  
+  bool ok = file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+            file.write((const uint8_t*)src, size) == size;
+  file.close();
+  
+  if (!ok) {
+    SD.remove(tmpPath);
+    return false;
+  }
+  
+  // FAT rename does not replace: move the old file aside, and only delete it
+  // once the new one is in place
+  String oldPath = path + ".old";
+  if (SD.exists(path)) {
+    SD.remove(oldPath);
+    if (!SD.rename(path, oldPath)) {
+      SD.remove(tmpPath);
+      return false;
+    }
+  }
+  if (!SD.rename(tmpPath, path)) {
+    SD.rename(oldPath, path);
+    SD.remove(tmpPath);
+    return false;
+  }
+  SD.remove(oldPath);
+  return true;
+}
+
+bool ModelStore::validateHeader(const ModelFileHeader& header, uint16_t modelType, size_t expectedSize) {
+  if (header.magic != MODEL_FILE_MAGIC) return false;
+  if (header.version != MODEL_FILE_VERSION) {
+    Serial.println("Unsupported model file version: " + String(header.version));
+    return false;
+  }
+  if (header.model_type != modelType) return false;
+  if (header.input_size != SCALED_FEATURES) {
+    Serial.println("Model trained for " + String(header.input_size) + " inputs, expected " + String(SCALED_FEATURES));
+    return false;
+  }
+  if (header.payload_size != expectedSize) {
+    Serial.println("Model size mismatch: " + String(header.payload_size) + " != " + String(expectedSize));
+    return false;
+  }
+  return true;
+}
+
+uint32_t ModelStore::crc32(const uint8_t* data, size_t length, uint32_t crc) {
+  // Standard reflected CRC-32 (same as zlib.crc32 in the host tool)
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+String ModelStore::getModelPath(uint16_t modelType) {
+  return String(MODEL_SD_DIR) + "/model_" + String(modelType) + ".evm";
+}
+
+void ModelStore::_fillHeader(ModelFileHeader& header, uint16_t modelType, const void* payload, size_t size) {
+  memset(&header, 0, sizeof(header));
+  header.magic = MODEL_FILE_MAGIC;
+  header.version = MODEL_FILE_VERSION;
+  header.model_type = modelType;
+  header.payload_size = size;
+  header.payload_crc = crc32((const uint8_t*)payload, size);
+  header.created = 0;
+  header.input_size = SCALED_FEATURES;
+  header.flags = 0;
+}
+
+#endif // MODEL_STORE_H
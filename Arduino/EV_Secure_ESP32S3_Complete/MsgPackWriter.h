@@ -0,0 +1,219 @@
+/*
+ * MsgPackWriter.h - MessagePack Encoder into a Fixed Buffer
+ *
+ * This library writes MessagePack (msgpack.org) values into a caller-owned
+ * buffer, so binary telemetry can be built without heap allocation.
+ *
+ * Features:
+ * - Smallest encoding for every integer, string and container header
+ * - bin payloads filled in place; endBin() picks the bin 8/16/32 header and
+ *   moves the payload down to it
+ * - Unsigned LEB128 varints and zig-zag signed varints inside bin payloads
+ * - Overflow is sticky: check overflowed() once after writing
+ *
+ * Usage:
+ * 1. MsgPackWriter out(buffer, sizeof(buffer))
+ * 2. out.writeMap(n), then alternate key and value writes
+ * 3. Send out.data() / out.length() unless out.overflowed()
+ */
+
+#ifndef MSGPACK_WRITER_H
+#define MSGPACK_WRITER_H
+
+#include <Arduino.h>
+
+class MsgPackWriter {
+public:
+  MsgPackWriter(uint8_t* buffer, size_t capacity);
+  
+  // Values
+  void writeNil();
+  void writeBool(bool value);
+  void writeUInt(uint32_t value);
+  void writeInt(int32_t value);
+  void writeFloat(float value);
+  void writeString(const char* value);
+  void writeString(const char* value, size_t length);
+  void writeMap(uint32_t entries);
+  void writeArray(uint32_t items);
+  
+  // bin payloads
+  size_t beginBin();
+  void endBin(size_t start);
+  void writeVarint(uint32_t value);
+  void writeZigZag(int32_t value);
+  
+  // Result
+  const uint8_t* data() const;
+  size_t length() const;
+  bool overflowed() const;
+  
+private:
+  uint8_t* _buffer;
+  size_t _capacity;
+  size_t _length;
+  bool _overflow;
+  
+  void _put(uint8_t byte);
+  void _putBE(uint32_t value, int bytes);
+  void _header(uint32_t size, uint8_t fix, uint8_t fixMax, uint8_t code16, uint8_t code32);
+};
+
+// Implementation
+MsgPackWriter::MsgPackWriter(uint8_t* buffer, size_t capacity)
+  : _buffer(buffer), _capacity(capacity), _length(0), _overflow(false) {
+}
+
+void MsgPackWriter::writeNil() {
+  _put(0xC0);
+}
+
+void MsgPackWriter::writeBool(bool value) {
+  _put(value ? 0xC3 : 0xC2);
+}
+
+void MsgPackWriter::writeUInt(uint32_t value) {
+  if (value < 0x80) {
+    _put(value);                    // positive fixint
+  } else if (value <= 0xFF) {
+    _put(0xCC);
+    _put(value);
+  } else if (value <= 0xFFFF) {
+    _put(0xCD);
+    _putBE(value, 2);
+  } else {
+    _put(0xCE);
+    _putBE(value, 4);
+  }
+}
+
+void MsgPackWriter::writeInt(int32_t value) {
+  if (value >= 0) {
+    writeUInt(value);
+  } else if (value >= -32) {
+    _put((uint8_t)value);           // negative fixint
+  } else if (value >= -128) {
+    _put(0xD0);
+    _put((uint8_t)value);
+  } else if (value >= -32768) {
+    _put(0xD1);
+    _putBE((uint16_t)value, 2);
+  } else {
+    _put(0xD2);
+    _putBE((uint32_t)value, 4);
+  }
+}
+
+void MsgPackWriter::writeFloat(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  _put(0xCA);
+  _putBE(bits, 4);
+}
+
+void MsgPackWriter::writeString(const char* value) {
+  writeString(value, strlen(value));
+}
+
+void MsgPackWriter::writeString(const char* value, size_t length) {
+  if (length < 32) {
+    _put(0xA0 | length);            // fixstr
+  } else if (length <= 0xFF) {
+    _put(0xD9);
+    _put(length);
+  } else {
+    _put(0xDA);
+    _putBE(length, 2);
+  }
+  for (size_t i = 0; i < length; i++) {
+    _put(value[i]);
+  }
+}
+
+void MsgPackWriter::writeMap(uint32_t entries) {
+  _header(entries, 0x80, 15, 0xDE, 0xDF);
+}
+
+void MsgPackWriter::writeArray(uint32_t items) {
+  _header(items, 0x90, 15, 0xDC, 0xDD);
+}
+
+size_t MsgPackWriter::beginBin() {
+  // Room for a bin 32 header; endBin() writes the real one
+  _put(0xC6);
+  size_t start = _length;
+  _putBE(0, 4);
+  return start;
+}
+
+void MsgPackWriter::endBin(size_t start) {
+  if (_overflow) {
+    return;
+  }
+  
+  // bin 8 or bin 16 when the length fits: move the payload down over the
+  // unused length bytes
+  uint32_t size = _length - start - 4;
+  int lengthBytes = size <= 0xFF ? 1 : size <= 0xFFFF ? 2 : 4;
+  _buffer[start - 1] = lengthBytes == 1 ? 0xC4 : lengthBytes == 2 ? 0xC5 : 0xC6;
+  if (lengthBytes < 4) {
+    memmove(_buffer + start + lengthBytes, _buffer + start + 4, size);
+    _length -= 4 - lengthBytes;
+  }
+  for (int i = 0; i < lengthBytes; i++) {
+    _buffer[start + i] = size >> (8 * (lengthBytes - 1 - i));
+  }
+}
+
+void MsgPackWriter::writeVarint(uint32_t value) {
+  while (value >= 0x80) {
+    _put((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  _put(value);
+}
+
+void MsgPackWriter::writeZigZag(int32_t value) {
+  // Small magnitudes of either sign become small varints: 0,-1,1,-2 -> 0,1,2,3
+  writeVarint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+const uint8_t* MsgPackWriter::data() const {
+  return _buffer;
+}
+
+size_t MsgPackWriter::length() const {
+  return _length;
+}
+
+bool MsgPackWriter::overflowed() const {
+  return _overflow;
+}
+
+void MsgPackWriter::_put(uint8_t byte) {
+  if (_length < _capacity) {
+    _buffer[_length++] = byte;
+  } else {
+    _overflow = true;
+  }
+}
+
+void MsgPackWriter::_putBE(uint32_t value, int bytes) {
+  for (int i = bytes - 1; i >= 0; i--) {
+    _put(value >> (8 * i));
+  }
+}
+
+void MsgPackWriter::_header(uint32_t size, uint8_t fix, uint8_t fixMax, uint8_t code16, uint8_t code32) {
+  if (size <= fixMax) {
+    _put(fix | size);
+  } else if (size <= 0xFFFF) {
+    _put(code16);
+    _putBE(size, 2);
+  } else {
+    _put(code32);
+    _putBE(size, 4);
+  }
+}
+
+#endif // MSGPACK_WRITER_H
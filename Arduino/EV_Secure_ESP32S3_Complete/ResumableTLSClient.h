@@ -0,0 +1,405 @@
+/*
+ * ResumableTLSClient.h - Keep-Alive TLS Client with Session Resumption
+ *
+ * This library is a WiFiClient for HTTPClient that keeps one TLS connection
+ * open between requests and, when the server drops it, reconnects with the
+ * saved TLS session so the certificate exchange and key agreement are skipped.
+ *
+ * Features:
+ * - mbedTLS over a plain WiFiClient socket
+ * - Session ID / session ticket resumption across reconnects
+ * - TLS configuration and random generator seeded once, not per connection
+ * - Handshake counters (full and resumed) and total handshake time
+ *
+ * Usage:
+ * 1. Declare a ResumableTLSClient and call setInsecure() or setCACert()
+ *    before the first connect
+ * 2. Pass it to HTTPClient::begin(client, url) with setReuse(true)
+ * 3. Read counters with getHandshakeCount() / getResumedCount()
+ */
+
+#ifndef RESUMABLE_TLS_CLIENT_H
+#define RESUMABLE_TLS_CLIENT_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+
+// Handshake
+#define TLS_HANDSHAKE_TIMEOUT_MS 10000   // Also bounds a blocked record write
+#define TLS_RESUMED_MAX_BYTES 1024       // A resumed handshake receives no certificate chain
+#define TLS_PERSONALIZATION "ev-secure-tls"
+
+class ResumableTLSClient : public WiFiClient {
+public:
+  ResumableTLSClient();
+  ~ResumableTLSClient();
+  
+  // Configuration (before the first connect)
+  void setInsecure();
+  void setCACert(const char* rootCA);
+  void setHandshakeTimeout(unsigned long timeoutMs);
+  void clearSession();
+  
+  // WiFiClient
+  int connect(IPAddress ip, uint16_t port);
+  int connect(IPAddress ip, uint16_t port, int32_t timeout);
+  int connect(const char* host, uint16_t port);
+  int connect(const char* host, uint16_t port, int32_t timeout);
+  size_t write(uint8_t data);
+  size_t write(const uint8_t* buf, size_t size);
+  int available();
+  int read();
+  int read(uint8_t* buf, size_t size);
+  int peek();
+  void flush();
+  void clear();
+  void stop();
+  uint8_t connected();
+  
+  // Counters
+  uint32_t getHandshakeCount() const;
+  uint32_t getResumedCount() const;
+  uint32_t getHandshakeMillis() const;
+  bool lastHandshakeResumed() const;
+  
+private:
+  WiFiClient _tcp;
+  mbedtls_ssl_context _ssl;
+  mbedtls_ssl_config _conf;
+  mbedtls_ctr_drbg_context _drbg;
+  mbedtls_entropy_context _entropy;
+  mbedtls_x509_crt _caCert;
+  mbedtls_ssl_session _session;
+  String _sessionHost;
+  const char* _rootCA;
+  bool _insecure;
+  bool _configured;
+  bool _open;
+  bool _sessionValid;
+  bool _lastResumed;
+  int _peeked;
+  unsigned long _timeoutMs;
+  uint32_t _bytesIn;
+  uint32_t _handshakes;
+  uint32_t _resumed;
+  uint32_t _handshakeMillis;
+  
+  bool _configure();
+  bool _handshake(const char* host);
+  void _close(bool notify);
+  void _logError(const char* what, int ret);
+  static int _send(void* ctx, const unsigned char* buf, size_t len);
+  static int _recv(void* ctx, unsigned char* buf, size_t len);
+};
+
+// Implementation
+ResumableTLSClient::ResumableTLSClient()
+  : _rootCA(nullptr), _insecure(false), _configured(false), _open(false), _sessionValid(false),
+    _lastResumed(false), _peeked(-1), _timeoutMs(TLS_HANDSHAKE_TIMEOUT_MS), _bytesIn(0),
+    _handshakes(0), _resumed(0), _handshakeMillis(0) {
+  mbedtls_ssl_init(&_ssl);
+  mbedtls_ssl_config_init(&_conf);
+  mbedtls_ctr_drbg_init(&_drbg);
+  mbedtls_entropy_init(&_entropy);
+  mbedtls_x509_crt_init(&_caCert);
+  mbedtls_ssl_session_init(&_session);
+}
+
+ResumableTLSClient::~ResumableTLSClient() {
+  _close(false);
+  mbedtls_ssl_free(&_ssl);
+  mbedtls_ssl_session_free(&_session);
+  mbedtls_x509_crt_free(&_caCert);
+  mbedtls_ssl_config_free(&_conf);
+  mbedtls_ctr_drbg_free(&_drbg);
+  mbedtls_entropy_free(&_entropy);
+}
+
+void ResumableTLSClient::setInsecure() {
+  _insecure = true;
+}
+
+void ResumableTLSClient::setCACert(const char* rootCA) {
+  _rootCA = rootCA;
+  _insecure = false;
+}
+
+void ResumableTLSClient::setHandshakeTimeout(unsigned long timeoutMs) {
+  _timeoutMs = timeoutMs;
+}
+
+void ResumableTLSClient::clearSession() {
+  mbedtls_ssl_session_free(&_session);
+  mbedtls_ssl_session_init(&_session);
+  _sessionValid = false;
+}
+
+int ResumableTLSClient::connect(IPAddress ip, uint16_t port) {
+  return connect(ip.toString().c_str(), port, (int32_t)_timeoutMs);
+}
+
+int ResumableTLSClient::connect(IPAddress ip, uint16_t port, int32_t timeout) {
+  return connect(ip.toString().c_str(), port, timeout);
+}
+
+int ResumableTLSClient::connect(const char* host, uint16_t port) {
+  return connect(host, port, (int32_t)_timeoutMs);
+}
+
+int ResumableTLSClient::connect(const char* host, uint16_t port, int32_t timeout) {
+  _close(_open);
+  
+  if (!_configure() || !_tcp.connect(host, port, timeout)) {
+    return 0;
+  }
+  
+  if (!_handshake(host)) {
+    _close(false);
+    return 0;
+  }
+  return 1;
+}
+
+size_t ResumableTLSClient::write(uint8_t data) {
+  return write(&data, 1);
+}
+
+size_t ResumableTLSClient::write(const uint8_t* buf, size_t size) {
+  if (!_open) {
+    return 0;
+  }
+  
+  size_t sent = 0;
+  unsigned long start = millis();
+  while (sent < size) {
+    int ret = mbedtls_ssl_write(&_ssl, buf + sent, size - sent);
+    if (ret > 0) {
+      sent += ret;
+      continue;
+    }
+    if ((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+        millis() - start > _timeoutMs) {
+      _logError("TLS write", ret);
+      _close(false);
+      break;
+    }
+    delay(1);
+  }
+  return sent;
+}
+
+int ResumableTLSClient::available() {
+  int pending = _peeked >= 0 ? 1 : 0;
+  if (!_open) {
+    return pending;
+  }
+  
+  // Decrypt the next record (if one has arrived) without consuming any data
+  int ret = mbedtls_ssl_read(&_ssl, nullptr, 0);
+  if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+    _close(false);
+    return pending;
+  }
+  return pending + (int)mbedtls_ssl_get_bytes_avail(&_ssl);
+}
+
+int ResumableTLSClient::read() {
+  uint8_t c;
+  return read(&c, 1) > 0 ? c : -1;
+}
+
+int ResumableTLSClient::read(uint8_t* buf, size_t size) {
+  int count = 0;
+  if (_peeked >= 0 && size > 0) {
+    buf[count++] = (uint8_t)_peeked;
+    _peeked = -1;
+  }
+  if (count == (int)size || !_open) {
+    return count > 0 ? count : -1;
+  }
+  
+  int ret = mbedtls_ssl_read(&_ssl, buf + count, size - count);
+  if (ret > 0) {
+    return count + ret;
+  }
+  if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+    // 0 or close_notify: the server closed the connection
+    _close(false);
+  }
+  return count > 0 ? count : -1;
+}
+
+int ResumableTLSClient::peek() {
+  if (_peeked < 0) {
+    uint8_t c;
+    if (read(&c, 1) > 0) {
+      _peeked = c;
+    }
+  }
+  return _peeked;
+}
+
+void ResumableTLSClient::flush() {
+  // Records are written as soon as write() is called; nothing is buffered
+}
+
+void ResumableTLSClient::clear() {
+  // Discard unread response data so the connection can carry the next request
+  uint8_t scratch[64];
+  while (available() > 0 && read(scratch, sizeof(scratch)) > 0) {
+  }
+}
+
+void ResumableTLSClient::stop() {
+  _close(true);
+}
+
+uint8_t ResumableTLSClient::connected() {
+  if (_peeked >= 0 || (_open && mbedtls_ssl_get_bytes_avail(&_ssl) > 0)) {
+    return 1;
+  }
+  if (_open && !_tcp.connected()) {
+    _close(false);
+  }
+  return _open ? 1 : 0;
+}
+
+uint32_t ResumableTLSClient::getHandshakeCount() const {
+  return _handshakes;
+}
+
+uint32_t ResumableTLSClient::getResumedCount() const {
+  return _resumed;
+}
+
+uint32_t ResumableTLSClient::getHandshakeMillis() const {
+  return _handshakeMillis;
+}
+
+bool ResumableTLSClient::lastHandshakeResumed() const {
+  return _lastResumed;
+}
+
+bool ResumableTLSClient::_configure() {
+  if (_configured) {
+    return true;
+  }
+  
+  int ret = mbedtls_ctr_drbg_seed(&_drbg, mbedtls_entropy_func, &_entropy,
+                                  (const unsigned char*)TLS_PERSONALIZATION, strlen(TLS_PERSONALIZATION));
+  if (ret == 0) {
+    ret = mbedtls_ssl_config_defaults(&_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                      MBEDTLS_SSL_PRESET_DEFAULT);
+  }
+  if (ret == 0 && !_insecure) {
+    if (!_rootCA) {
+      Serial.println("TLS: no CA certificate set (call setInsecure() for development)");
+      return false;
+    }
+    ret = mbedtls_x509_crt_parse(&_caCert, (const unsigned char*)_rootCA, strlen(_rootCA) + 1);
+  }
+  if (ret != 0) {
+    _logError("TLS setup", ret);
+    return false;
+  }
+  
+  if (_insecure) {
+    mbedtls_ssl_conf_authmode(&_conf, MBEDTLS_SSL_VERIFY_NONE);
+  } else {
+    mbedtls_ssl_conf_ca_chain(&_conf, &_caCert, nullptr);
+    mbedtls_ssl_conf_authmode(&_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+  }
+  mbedtls_ssl_conf_rng(&_conf, mbedtls_ctr_drbg_random, &_drbg);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+  mbedtls_ssl_conf_session_tickets(&_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+
+  _configured = true;
+  return true;
+}
+
+bool ResumableTLSClient::_handshake(const char* host) {
+  int ret = mbedtls_ssl_setup(&_ssl, &_conf);
+  if (ret == 0) {
+    ret = mbedtls_ssl_set_hostname(&_ssl, host);
+  }
+  if (ret != 0) {
+    _logError("TLS setup", ret);
+    return false;
+  }
+  mbedtls_ssl_set_bio(&_ssl, this, _send, _recv, nullptr);
+  
+  // Offer the saved session; an expired one just falls back to a full handshake
+  bool offered = _sessionValid && _sessionHost == host && mbedtls_ssl_set_session(&_ssl, &_session) == 0;
+  
+  unsigned long start = millis();
+  _bytesIn = 0;
+  while ((ret = mbedtls_ssl_handshake(&_ssl)) != 0) {
+    if ((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+        millis() - start > _timeoutMs) {
+      _logError("TLS handshake", ret);
+      clearSession();
+      return false;
+    }
+    delay(1);
+  }
+  
+  _handshakes++;
+  _handshakeMillis += millis() - start;
+  _lastResumed = offered && _bytesIn < TLS_RESUMED_MAX_BYTES;
+  if (_lastResumed) {
+    _resumed++;
+  }
+  
+  // Keep the (possibly renewed) session for the next reconnect
+  clearSession();
+  _sessionValid = mbedtls_ssl_get_session(&_ssl, &_session) == 0;
+  _sessionHost = host;
+  _open = true;
+  return true;
+}
+
+void ResumableTLSClient::_close(bool notify) {
+  if (_open && notify) {
+    mbedtls_ssl_close_notify(&_ssl);
+  }
+  mbedtls_ssl_free(&_ssl);
+  mbedtls_ssl_init(&_ssl);
+  _tcp.stop();
+  _open = false;
+  _peeked = -1;
+}
+
+void ResumableTLSClient::_logError(const char* what, int ret) {
+  Serial.println(String(what) + " failed: -0x" + String(-ret, HEX));
+}
+
+int ResumableTLSClient::_send(void* ctx, const unsigned char* buf, size_t len) {
+  ResumableTLSClient* self = (ResumableTLSClient*)ctx;
+  size_t n = self->_tcp.write(buf, len);
+  if (n == 0) {
+    return self->_tcp.connected() ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_NET_CONN_RESET;
+  }
+  return (int)n;
+}
+
+int ResumableTLSClient::_recv(void* ctx, unsigned char* buf, size_t len) {
+  ResumableTLSClient* self = (ResumableTLSClient*)ctx;
+  int avail = self->_tcp.available();
+  if (avail <= 0) {
+    return self->_tcp.connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_CONN_RESET;
+  }
+  
+  int n = self->_tcp.read(buf, min(len, (size_t)avail));
+  if (n <= 0) {
+    return MBEDTLS_ERR_SSL_WANT_READ;
+  }
+  self->_bytesIn += n;
+  return n;
+}
+
+#endif // RESUMABLE_TLS_CLIENT_H
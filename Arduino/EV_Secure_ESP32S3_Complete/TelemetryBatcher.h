@@ -0,0 +1,378 @@
+/*
+ * TelemetryBatcher.h - Batched Telemetry Upload
+ *
+ * This library collects one telemetry frame per sample interval in a
+ * preallocated ring and uploads many frames in one request, so full sample
+ * resolution reaches the dashboard within the API rate limit.
+ *
+ * Features:
+ * - Fixed ring of frames (no allocation per sample)
+ * - Flush by batch size, by age of the oldest frame, or at once on a threat
+ * - Frames are only removed after the server accepted them
+ * - Long outages: the oldest full batch is handed to a spill handler (the SD
+ *   spool) before the ring fills; frames are overwritten (and counted) only
+ *   if there is no handler or it fails
+ *
+ * Batch Format (added to the normal /api/data payload):
+ * - frame_fields  Names of the per-frame values, in order
+ * - frames        One array per frame: [timestamp, current, voltage, ...]
+ *                 timestamp is millis() on the device; the payload's own
+ *                 "timestamp" is millis() at upload, so the server can date
+ *                 each frame
+ *
+ * Binary Format (Content-Type TELEMETRY_MSGPACK_TYPE):
+ * A MessagePack map with small integer keys (TELEMETRY_KEY_*) instead of the
+ * JSON names. Frames are one bin value: for each field in frame_fields order,
+ * the field's fixed-point values (value * scale, rounded) for all frames as
+ * zig-zag varints, the first absolute and the rest as differences from the
+ * previous frame. Consecutive samples differ little, so most take one byte.
+ *
+ * Usage:
+ * 1. Add a frame every sample interval with TelemetryBatcher::addFrame()
+ * 2. When TelemetryBatcher::shouldFlush(), build the payload and call
+ *    TelemetryBatcher::appendFrames(doc) (JSON) or appendFrames(writer);
+ *    TELEMETRY_JSON_FRAMES_BYTES sizes a static document for any batch
+ * 3. After a successful upload call TelemetryBatcher::commit(count),
+ *    otherwise TelemetryBatcher::flushFailed(); a throttled upload calls
+ *    TelemetryBatcher::defer() and its frames go with the next batch
+ * 4. Optionally keep frames across long outages with setSpillHandler(), and
+ *    encode spooled frames later with appendFrames(doc, frames, count)
+ */
+
+#ifndef TELEMETRY_BATCHER_H
+#define TELEMETRY_BATCHER_H
+
+#include "EV_Secure_Config.h"
+#include <ArduinoJson.h>
+#include "MsgPackWriter.h"
+
+// Batching
+#define TELEMETRY_BATCH_FRAMES 30          // Frames per upload (60 s at one frame per 2 s)
+#define TELEMETRY_BATCH_MAX_AGE_MS 60000   // Upload earlier if the oldest frame is this old
+#define TELEMETRY_MAX_FRAMES_PER_UPLOAD 60 // Catch-up limit after failed uploads
+#define TELEMETRY_BUFFER_FRAMES 180        // Frames kept while uploads fail (6 min)
+#define TELEMETRY_RETRY_MS 10000           // Delay before retrying a failed upload
+#define TELEMETRY_FRAME_FIELDS 12
+// documentSize() of a full upload, for fixed-capacity documents
+#define TELEMETRY_JSON_FRAMES_BYTES (JSON_ARRAY_SIZE(TELEMETRY_FRAME_FIELDS) + \
+                                     JSON_ARRAY_SIZE(TELEMETRY_MAX_FRAMES_PER_UPLOAD) + \
+                                     TELEMETRY_MAX_FRAMES_PER_UPLOAD * JSON_ARRAY_SIZE(TELEMETRY_FRAME_FIELDS))
+
+// Binary encoding
+#define TELEMETRY_BINARY true              // Upload MessagePack (falls back to JSON if refused)
+#define TELEMETRY_MSGPACK_TYPE "application/msgpack"
+#define TELEMETRY_BINARY_BUFFER 4096       // 60 frames x 12 fields x 5-byte varints + header
+#define TELEMETRY_BINARY_REJECTIONS 3      // 400/500 answers in a row before falling back to JSON
+
+// Binary payload keys
+#define TELEMETRY_KEY_DEVICE_ID 0
+#define TELEMETRY_KEY_SESSION_ID 1
+#define TELEMETRY_KEY_TIMESTAMP 2          // millis() at upload
+#define TELEMETRY_KEY_STATE 3
+#define TELEMETRY_KEY_CHARGING 4
+#define TELEMETRY_KEY_THREAT 5
+#define TELEMETRY_KEY_SYSTEM 6             // [wifi_rssi, uptime, free_heap, cpu_freq]
+#define TELEMETRY_KEY_ML 7                 // [standard_prediction, standard_confidence, enhanced_prediction,
+                                           //  enhanced_confidence, enhanced_uncertainty, attack_type,
+                                           //  attack_confidence, is_anomaly, early_exit_rate]
+#define TELEMETRY_KEY_FRAME_COUNT 8
+#define TELEMETRY_KEY_FRAME_SCALES 9       // Fixed-point scale per field
+#define TELEMETRY_KEY_FRAMES 10            // Delta/zig-zag varint columns
+#define TELEMETRY_BINARY_KEYS 11          // Keys in a live upload
+#define TELEMETRY_KEY_SPOOLED 11           // Journal sequence number (spooled batches only)
+
+// Frame flags
+#define FRAME_FLAG_CHARGING 0x01
+#define FRAME_FLAG_THREAT 0x02
+#define FRAME_FLAG_ANOMALY 0x04
+
+// One telemetry sample
+struct TelemetryFrame {
+  unsigned long timestamp;
+  float current;
+  float voltage;
+  float power;
+  float frequency;
+  float temperature;
+  float prediction;             // Standard model threat probability
+  float confidence;
+  float enhanced_prediction;    // Enhanced model threat probability
+  uint8_t state;                // SystemState
+  uint8_t flags;                // FRAME_FLAG_*
+  uint8_t attack_type;          // AttackType
+};
+
+// Batcher statistics
+struct TelemetryBatchStats {
+  uint32_t frames;              // Frames added
+  uint32_t uploaded;            // Frames accepted by the server
+  uint32_t batches;             // Successful uploads
+  uint32_t failures;            // Failed uploads
+  uint32_t deferred;            // Uploads held back by the rate limiter (frames kept for the next)
+  uint32_t dropped;             // Frames overwritten before upload
+  uint32_t spilled;             // Frames handed to the spill handler
+  uint32_t pending;             // Frames waiting in the ring
+};
+
+// Takes the oldest frames out of the ring; false keeps them in memory
+typedef bool (*TelemetrySpillHandler)(const TelemetryFrame* frames, size_t count);
+
+class TelemetryBatcher {
+public:
+  static void addFrame(const TelemetryFrame& frame);
+  static bool shouldFlush();
+  static size_t appendFrames(JsonDocument& doc);
+  static size_t appendFrames(MsgPackWriter& out);
+  static void commit(size_t count);
+  static void flushFailed();
+  static void defer(unsigned long delayMs);
+  static void setSpillHandler(TelemetrySpillHandler handler);
+  
+  // Frames held elsewhere (the SD spool), same encodings
+  static size_t appendFrames(JsonDocument& doc, const TelemetryFrame* frames, size_t count);
+  static size_t appendFrames(MsgPackWriter& out, const TelemetryFrame* frames, size_t count);
+  
+  // Sizing and status
+  static size_t documentSize(size_t frames);
+  static size_t getPendingCount();
+  static TelemetryBatchStats getStats();
+  
+private:
+  static TelemetryFrame _frames[TELEMETRY_BUFFER_FRAMES];
+  static size_t _head;          // Oldest frame
+  static size_t _count;
+  static bool _urgent;
+  static uint8_t _lastFlags;
+  static unsigned long _retryAfter;
+  static TelemetryBatchStats _stats;
+  static TelemetrySpillHandler _spillHandler;
+  static const uint16_t _scales[TELEMETRY_FRAME_FIELDS];
+  
+  static size_t _writeFrames(JsonDocument& doc, const TelemetryFrame* frames, size_t count);
+  static size_t _writeFrames(MsgPackWriter& out, const TelemetryFrame* frames, size_t count);
+  static bool _spill();
+  static const TelemetryFrame& _at(size_t index);
+  static int32_t _fixedPoint(const TelemetryFrame& frame, int field);
+};
+
+// Implementation
+TelemetryFrame TelemetryBatcher::_frames[TELEMETRY_BUFFER_FRAMES];
+size_t TelemetryBatcher::_head = 0;
+size_t TelemetryBatcher::_count = 0;
+bool TelemetryBatcher::_urgent = false;
+uint8_t TelemetryBatcher::_lastFlags = 0;
+unsigned long TelemetryBatcher::_retryAfter = 0;
+TelemetryBatchStats TelemetryBatcher::_stats = {};
+TelemetrySpillHandler TelemetryBatcher::_spillHandler = nullptr;
+
+// Fixed-point scale per frame field (frame_fields order): 10 mA, 0.1 V, 1 W,
+// 0.01 Hz, 0.1 C, and 0.001 for model outputs
+const uint16_t TelemetryBatcher::_scales[TELEMETRY_FRAME_FIELDS] = {
+  1, 100, 10, 1, 100, 10, 1, 1, 1000, 1000, 1000, 1
+};
+
+void TelemetryBatcher::addFrame(const TelemetryFrame& frame) {
+  // A new threat goes out with the next flush instead of waiting for a full batch
+  if ((frame.flags & FRAME_FLAG_THREAT) && !(_lastFlags & FRAME_FLAG_THREAT)) {
+    _urgent = true;
+  }
+  _lastFlags = frame.flags;
+  
+  if (_count == TELEMETRY_BUFFER_FRAMES) {
+    // Ring full (uploads failing): overwrite the oldest frame
+    _head = (_head + 1) % TELEMETRY_BUFFER_FRAMES;
+    _count--;
+    _stats.dropped++;
+  }
+  _frames[(_head + _count) % TELEMETRY_BUFFER_FRAMES] = frame;
+  _count++;
+  _stats.frames++;
+}
+
+bool TelemetryBatcher::shouldFlush() {
+  if (_count == 0 || (long)(millis() - _retryAfter) < 0) {
+    return false;
+  }
+  return _urgent || _count >= TELEMETRY_BATCH_FRAMES ||
+         millis() - _at(0).timestamp >= TELEMETRY_BATCH_MAX_AGE_MS;
+}
+
+size_t TelemetryBatcher::appendFrames(JsonDocument& doc) {
+  // Oldest first; anything beyond the per-upload limit goes in the next request
+  return _writeFrames(doc, nullptr, min(_count, (size_t)TELEMETRY_MAX_FRAMES_PER_UPLOAD));
+}
+
+size_t TelemetryBatcher::appendFrames(JsonDocument& doc, const TelemetryFrame* frames, size_t count) {
+  return _writeFrames(doc, frames, min(count, (size_t)TELEMETRY_MAX_FRAMES_PER_UPLOAD));
+}
+
+size_t TelemetryBatcher::appendFrames(MsgPackWriter& out) {
+  return _writeFrames(out, nullptr, min(_count, (size_t)TELEMETRY_MAX_FRAMES_PER_UPLOAD));
+}
+
+size_t TelemetryBatcher::appendFrames(MsgPackWriter& out, const TelemetryFrame* frames, size_t count) {
+  return _writeFrames(out, frames, min(count, (size_t)TELEMETRY_MAX_FRAMES_PER_UPLOAD));
+}
+
+// frames == nullptr encodes the oldest frames of the ring
+size_t TelemetryBatcher::_writeFrames(JsonDocument& doc, const TelemetryFrame* frames, size_t count) {
+  static const char* const fields[TELEMETRY_FRAME_FIELDS] = {
+    "timestamp", "current", "voltage", "power", "frequency", "temperature",
+    "state", "flags", "prediction", "confidence", "enhanced_prediction", "attack_type"
+  };
+  
+  JsonArray names = doc.createNestedArray("frame_fields");
+  for (int i = 0; i < TELEMETRY_FRAME_FIELDS; i++) {
+    names.add(fields[i]);
+  }
+  
+  JsonArray rows = doc.createNestedArray("frames");
+  for (size_t i = 0; i < count; i++) {
+    const TelemetryFrame& frame = frames ? frames[i] : _at(i);
+    JsonArray values = rows.createNestedArray();
+    values.add(frame.timestamp);
+    values.add(frame.current);
+    values.add(frame.voltage);
+    values.add(frame.power);
+    values.add(frame.frequency);
+    values.add(frame.temperature);
+    values.add(frame.state);
+    values.add(frame.flags);
+    values.add(frame.prediction);
+    values.add(frame.confidence);
+    values.add(frame.enhanced_prediction);
+    values.add(frame.attack_type);
+  }
+  
+  if (doc.overflowed()) {
+    Serial.println("Telemetry batch does not fit the JSON document");
+    return 0;
+  }
+  return count;
+}
+
+size_t TelemetryBatcher::_writeFrames(MsgPackWriter& out, const TelemetryFrame* frames, size_t count) {
+  out.writeUInt(TELEMETRY_KEY_FRAME_COUNT);
+  out.writeUInt(count);
+  
+  out.writeUInt(TELEMETRY_KEY_FRAME_SCALES);
+  out.writeArray(TELEMETRY_FRAME_FIELDS);
+  for (int field = 0; field < TELEMETRY_FRAME_FIELDS; field++) {
+    out.writeUInt(_scales[field]);
+  }
+  
+  // Column by column, so each delta is taken against the same field
+  out.writeUInt(TELEMETRY_KEY_FRAMES);
+  size_t bin = out.beginBin();
+  for (int field = 0; field < TELEMETRY_FRAME_FIELDS; field++) {
+    int32_t previous = 0;
+    for (size_t i = 0; i < count; i++) {
+      int32_t value = _fixedPoint(frames ? frames[i] : _at(i), field);
+      out.writeZigZag((int32_t)((uint32_t)value - (uint32_t)previous));
+      previous = value;
+    }
+  }
+  out.endBin(bin);
+  
+  if (out.overflowed()) {
+    Serial.println("Telemetry batch does not fit the binary buffer");
+    return 0;
+  }
+  return count;
+}
+
+void TelemetryBatcher::commit(size_t count) {
+  count = min(count, _count);
+  _head = (_head + count) % TELEMETRY_BUFFER_FRAMES;
+  _count -= count;
+  _urgent = false;
+  _retryAfter = millis();
+  _stats.uploaded += count;
+  _stats.batches++;
+}
+
+void TelemetryBatcher::flushFailed() {
+  // Frames stay queued; wait before the next attempt instead of retrying every sample
+  _retryAfter = millis() + TELEMETRY_RETRY_MS;
+  _stats.failures++;
+  
+  // Keep one batch of headroom in the ring; older frames go to the spill handler
+  while (_spillHandler && _count > TELEMETRY_BUFFER_FRAMES - TELEMETRY_BATCH_FRAMES) {
+    if (!_spill()) {
+      break;
+    }
+  }
+}
+
+void TelemetryBatcher::defer(unsigned long delayMs) {
+  // Not a failure: the frames stay and the next flush sends them with the newer ones
+  _retryAfter = millis() + delayMs;
+  _stats.deferred++;
+}
+
+void TelemetryBatcher::setSpillHandler(TelemetrySpillHandler handler) {
+  _spillHandler = handler;
+}
+
+bool TelemetryBatcher::_spill() {
+  // Copy out the oldest batch; it may wrap around the end of the ring
+  static TelemetryFrame batch[TELEMETRY_BATCH_FRAMES];
+  size_t count = min(_count, (size_t)TELEMETRY_BATCH_FRAMES);
+  for (size_t i = 0; i < count; i++) {
+    batch[i] = _at(i);
+  }
+  
+  if (!_spillHandler(batch, count)) {
+    return false;
+  }
+  _head = (_head + count) % TELEMETRY_BUFFER_FRAMES;
+  _count -= count;
+  _stats.spilled += count;
+  return true;
+}
+
+size_t TelemetryBatcher::documentSize(size_t frames) {
+  frames = min(frames, (size_t)TELEMETRY_MAX_FRAMES_PER_UPLOAD);
+  return JSON_ARRAY_SIZE(TELEMETRY_FRAME_FIELDS) + JSON_ARRAY_SIZE(frames) +
+         frames * JSON_ARRAY_SIZE(TELEMETRY_FRAME_FIELDS);
+}
+
+size_t TelemetryBatcher::getPendingCount() {
+  return _count;
+}
+
+TelemetryBatchStats TelemetryBatcher::getStats() {
+  TelemetryBatchStats stats = _stats;
+  stats.pending = _count;
+  return stats;
+}
+
+const TelemetryFrame& TelemetryBatcher::_at(size_t index) {
+  return _frames[(_head + index) % TELEMETRY_BUFFER_FRAMES];
+}
+
+int32_t TelemetryBatcher::_fixedPoint(const TelemetryFrame& frame, int field) {
+  float value;
+  switch (field) {
+    case 0: return (int32_t)frame.timestamp;   // Wraps with millis(); differences stay exact
+    case 1: value = frame.current; break;
+    case 2: value = frame.voltage; break;
+    case 3: value = frame.power; break;
+    case 4: value = frame.frequency; break;
+    case 5: value = frame.temperature; break;
+    case 6: return frame.state;
+    case 7: return frame.flags;
+    case 8: value = frame.prediction; break;
+    case 9: value = frame.confidence; break;
+    case 10: value = frame.enhanced_prediction; break;
+    default: return frame.attack_type;
+  }
+  
+  if (!isfinite(value)) {
+    return 0;
+  }
+  value = constrain(value * _scales[field], -2.0e9f, 2.0e9f);
+  return (int32_t)lroundf(value);
+}
+
+#endif // TELEMETRY_BATCHER_H
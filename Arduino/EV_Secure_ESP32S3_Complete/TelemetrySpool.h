@@ -0,0 +1,656 @@
+/*
+ * TelemetrySpool.h - Store-and-Forward Telemetry Journal
+ *
+ * This library keeps telemetry frames and alerts that could not be delivered
+ * in a journal on the SD card and sends them to the dashboard once the
+ * connection is back, so an outage leaves no gap in the station's history.
+ *
+ * Features:
+ * - Append-only journal of checksummed records with sequence numbers
+ * - Segment files of SPOOL_SEGMENT_BYTES; the oldest segment is discarded
+ *   (and counted) when the journal holds SPOOL_MAX_SEGMENTS
+ * - Read cursor saved after every delivered batch, so it survives reboots
+ * - Drain paced by SPOOL_DRAIN_INTERVAL_MS and only while live telemetry is
+ *   caught up: fresh data first, backlog uploaded in the bulk rate class
+ *   (API_RATE_BULK) so it never takes live telemetry's requests
+ * - Frames of earlier boots dated with the NTP clock (records that cannot be
+ *   dated are skipped and counted)
+ * - Spool size, drain rate and delivery lag statistics
+ *
+ * Journal Layout (little-endian; records back to back in /spool/<n>.log):
+ * - 0  magic         SPOOL_RECORD_MAGIC
+ * - 2  type          SPOOL_RECORD_FRAMES or SPOOL_RECORD_ALERT
+ * - 3  count         Frames in the record (0 for an alert)
+ * - 4  length        Payload bytes
+ * - 6  reserved      Zero
+ * - 8  seq           Record sequence number, never reused
+ * - 12 boot          Boot counter when written
+ * - 16 written       millis() when written
+ * - 20 crc           CRC-32 of the header (crc = 0) and the payload
+ * - 24 boot_epoch    Unix time in ms at millis() == 0 (0 if the clock was not set)
+ * - 32 payload       TelemetryFrame structs, or the alert's JSON body
+ * Frames are raw structs; only this firmware reads them back. /spool/state
+ * holds the segment range, the read offset and the next sequence number.
+ *
+ * Usage:
+ * 1. Initialize with TelemetrySpool::init() after the SD card
+ * 2. Register spillFrames() with TelemetryBatcher::setSpillHandler() and
+ *    spoolAlert() with APIManager::setUndeliveredAlertHandler()
+ * 3. While WiFi is up and TelemetrySpool::shouldDrain(), upload the batch from
+ *    nextBatch(), then call commitBatch() or drainFailed()
+ * Call it from loop() only; the SD card is not shared with other tasks.
+ */
+
+#ifndef TELEMETRY_SPOOL_H
+#define TELEMETRY_SPOOL_H
+
+#include "EV_Secure_Config.h"
+#include <SD.h>
+#include <sys/time.h>
+#include "ModelStore.h"
+#include "TelemetryBatcher.h"
+
+// Journal files
+#define SPOOL_DIR "/spool"
+#define SPOOL_STATE_PATH "/spool/state"
+#define SPOOL_RECORD_MAGIC 0x4C53           // "SL"
+#define SPOOL_STATE_MAGIC 0x31505353        // "SSP1"
+#define SPOOL_SEGMENT_BYTES 262144          // ~210 one-minute batches (3.5 h) per file
+#define SPOOL_MAX_SEGMENTS 32               // 8 MB, about 4.5 days of frames
+
+// Drain
+#define SPOOL_DRAIN_FRAMES TELEMETRY_MAX_FRAMES_PER_UPLOAD
+#define SPOOL_DRAIN_INTERVAL_MS 10000       // 6 backlog + 1 live upload per minute
+#define SPOOL_DRAIN_RETRY_MS 30000          // Pause after a failed backlog upload
+#define SPOOL_ALERT_MAX_BYTES 512
+#define SPOOL_CLOCK_VALID 1700000000UL      // Unix seconds; earlier means NTP has not answered yet
+#define SPOOL_MAX_AGE_MS 0xF0000000UL       // Older frames cannot be dated by a 32-bit millis() upload
+
+// Record types
+#define SPOOL_RECORD_FRAMES 1
+#define SPOOL_RECORD_ALERT 2
+
+// Journal record header
+struct SpoolRecordHeader {
+  uint16_t magic;
+  uint8_t type;
+  uint8_t count;
+  uint16_t length;
+  uint16_t reserved;
+  uint32_t seq;
+  uint32_t boot;
+  uint32_t written;
+  uint32_t crc;
+  uint64_t boot_epoch;
+};
+
+// Persisted journal state
+struct SpoolState {
+  uint32_t magic;
+  uint32_t boot;
+  uint32_t first_segment;       // Oldest segment with undelivered records
+  uint32_t last_segment;        // Segment being appended to
+  uint32_t read_offset;         // Next undelivered record in first_segment
+  uint32_t next_seq;
+  uint64_t boot_epoch;          // This boot's clock offset once NTP set it (0 until then)
+  uint64_t prev_boot_epoch;     // The previous boot's, for its records written before NTP
+  uint32_t crc;
+  uint32_t reserved;
+};
+
+// One upload's worth of journal records
+struct SpoolBatch {
+  uint8_t type;                 // SPOOL_RECORD_*
+  size_t count;                 // Frames
+  size_t length;                // Alert body bytes
+  const TelemetryFrame* frames;
+  const uint8_t* alert;
+  uint32_t seq;                 // First record's sequence number
+  uint32_t sent_at;             // Upload "timestamp": frame times are millis() relative to it
+  uint32_t segment;             // Read cursor after the batch
+  uint32_t end_offset;
+  uint32_t age_ms;              // Oldest record's age when read
+  unsigned long read_at;
+};
+
+// Spool statistics
+struct SpoolStats {
+  uint32_t bytes;               // Journal bytes not yet delivered
+  uint32_t segments;
+  uint32_t spooled_frames;
+  uint32_t spooled_alerts;
+  uint32_t drained_frames;
+  uint32_t drained_alerts;
+  uint32_t drain_per_min;       // Frames per minute during the current (or last) drain
+  uint32_t last_lag_ms;         // Age of a batch's oldest record when the server accepted it
+  uint32_t max_lag_ms;
+  uint32_t lost_segments;       // Discarded unsent because the journal was full
+  uint32_t skipped;             // Damaged or undatable records
+  uint32_t write_errors;
+};
+
+class TelemetrySpool {
+public:
+  static bool init();
+  static bool isReady();
+  
+  // Spooling (handlers for TelemetryBatcher and APIManager)
+  static bool spillFrames(const TelemetryFrame* frames, size_t count);
+  static void spoolAlert(const uint8_t* body, size_t length);
+  
+  // Draining
+  static bool shouldDrain();
+  static bool nextBatch(SpoolBatch& batch);
+  static void commitBatch(const SpoolBatch& batch);
+  static void drainFailed();
+  
+  // Status and monitoring
+  static uint32_t getPendingBytes();
+  static SpoolStats getStats();
+  static void resetStats();
+  static void printStats();
+  
+private:
+  static bool _ready;
+  static bool _inFlight;
+  static SpoolState _state;
+  static uint32_t _pendingBytes;
+  static uint32_t _lastSize;            // Bytes in the segment being appended to
+  static unsigned long _nextDrain;
+  static unsigned long _drainStart;     // First accepted batch of the current drain
+  static uint32_t _drainFrames;         // Frames accepted since then
+  static SpoolStats _stats;
+  static TelemetryFrame _frames[SPOOL_DRAIN_FRAMES];
+  static uint8_t _alert[SPOOL_ALERT_MAX_BYTES];
+  
+  static bool _append(uint8_t type, uint8_t count, const uint8_t* payload, size_t length);
+  static bool _openCursor(File& file);
+  static void _advance(uint32_t segment, uint32_t offset);
+  static void _skipSegment();
+  static void _checkTail();
+  static void _discardOldest();
+  static bool _date(const SpoolRecordHeader& header, uint32_t timestamp, uint32_t& sentAt, uint32_t& age);
+  static void _updateBootEpoch();
+  static uint64_t _epochMs();
+  static bool _validHeader(const SpoolRecordHeader& header);
+  static uint32_t _checksum(const SpoolRecordHeader& header, const uint8_t* payload);
+  static bool _loadState(const String& path);
+  static bool _saveState();
+  static String _segmentPath(uint32_t segment);
+  static uint32_t _fileSize(const String& path);
+};
+
+// Implementation
+bool TelemetrySpool::_ready = false;
+bool TelemetrySpool::_inFlight = false;
+SpoolState TelemetrySpool::_state = {};
+uint32_t TelemetrySpool::_pendingBytes = 0;
+uint32_t TelemetrySpool::_lastSize = 0;
+unsigned long TelemetrySpool::_nextDrain = 0;
+unsigned long TelemetrySpool::_drainStart = 0;
+uint32_t TelemetrySpool::_drainFrames = 0;
+SpoolStats TelemetrySpool::_stats = {};
+TelemetryFrame TelemetrySpool::_frames[SPOOL_DRAIN_FRAMES];
+uint8_t TelemetrySpool::_alert[SPOOL_ALERT_MAX_BYTES];
+
+bool TelemetrySpool::init() {
+  if (_ready) {
+    return true;
+  }
+  
+  if (!SD.exists(SPOOL_DIR) && !SD.mkdir(SPOOL_DIR)) {
+    Serial.println("Cannot create spool directory " SPOOL_DIR);
+    return false;
+  }
+  
+  // A power loss between removing the state and renaming its replacement leaves only the .tmp
+  if (!_loadState(SPOOL_STATE_PATH) && !_loadState(String(SPOOL_STATE_PATH) + ".tmp")) {
+    memset(&_state, 0, sizeof(_state));
+    _state.magic = SPOOL_STATE_MAGIC;
+    _state.next_seq = 1;
+  }
+  _state.boot++;
+  _state.prev_boot_epoch = _state.boot_epoch;
+  _state.boot_epoch = 0;
+  
+  // Undelivered: the rest of the first segment and everything after it
+  _pendingBytes = 0;
+  for (uint32_t segment = _state.first_segment; segment <= _state.last_segment; segment++) {
+    uint32_t size = _fileSize(_segmentPath(segment));
+    if (segment == _state.first_segment) {
+      _pendingBytes += size > _state.read_offset ? size - _state.read_offset : 0;
+    } else {
+      _pendingBytes += size;
+    }
+    _lastSize = size;
+  }
+  _checkTail();
+  
+  _ready = _saveState();
+  if (_ready) {
+    Serial.println("Telemetry spool: boot " + String(_state.boot) + ", " + String(_pendingBytes) +
+                   " bytes waiting in " + String(_state.last_segment - _state.first_segment + 1) + " segment(s)");
+  }
+  return _ready;
+}
+
+bool TelemetrySpool::isReady() {
+  return _ready;
+}
+
+bool TelemetrySpool::spillFrames(const TelemetryFrame* frames, size_t count) {
+  if (count == 0 || count > SPOOL_DRAIN_FRAMES) {
+    return false;
+  }
+  if (!_append(SPOOL_RECORD_FRAMES, count, (const uint8_t*)frames, count * sizeof(TelemetryFrame))) {
+    return false;
+  }
+  _stats.spooled_frames += count;
+  return true;
+}
+
+void TelemetrySpool::spoolAlert(const uint8_t* body, size_t length) {
+  if (length == 0 || length > SPOOL_ALERT_MAX_BYTES) {
+    Serial.println("Alert of " + String(length) + " bytes not spooled");
+    return;
+  }
+  if (_append(SPOOL_RECORD_ALERT, 0, body, length)) {
+    _stats.spooled_alerts++;
+    Serial.println("Undelivered alert spooled (seq " + String(_state.next_seq - 1) + ")");
+  }
+}
+
+bool TelemetrySpool::shouldDrain() {
+  // Backlog waits while live frames are queued beyond one batch
+  return _ready && !_inFlight && _pendingBytes > 0 &&
+         (long)(millis() - _nextDrain) >= 0 &&
+         TelemetryBatcher::getPendingCount() <= TELEMETRY_BATCH_FRAMES;
+}
+
+bool TelemetrySpool::nextBatch(SpoolBatch& batch) {
+  File file;
+  if (!_ready || _inFlight || !_openCursor(file)) {
+    return false;
+  }
+  _updateBootEpoch();
+  
+  memset(&batch, 0, sizeof(batch));
+  batch.frames = _frames;
+  batch.alert = _alert;
+  batch.segment = _state.first_segment;
+  uint32_t offset = _state.read_offset;
+  uint32_t size = file.size();
+  uint32_t boot = 0;
+  
+  // One alert, or consecutive frame records of one boot up to SPOOL_DRAIN_FRAMES
+  while (offset < size) {
+    SpoolRecordHeader header = {};
+    bool valid = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) && _validHeader(header);
+    bool frames = header.type == SPOOL_RECORD_FRAMES;
+    if (valid && batch.type != 0 && (!frames || batch.type != SPOOL_RECORD_FRAMES || header.boot != boot ||
+                                     batch.count + header.count > SPOOL_DRAIN_FRAMES)) {
+      break;
+    }
+    if (valid && header.boot != _state.boot && _epochMs() == 0) {
+      break;                            // Earlier boot: wait until NTP sets the clock
+    }
+  
+    uint8_t* payload = frames ? (uint8_t*)(_frames + batch.count) : _alert;
+    valid = valid && file.read(payload, header.length) == header.length &&
+            _checksum(header, payload) == header.crc;
+    if (!valid) {
+      if (batch.type == 0) {
+        // Torn or damaged record: nothing after it in this segment can be trusted
+        Serial.println("Spool segment " + String(batch.segment) + " damaged at " + String(offset) +
+                       " - skipping the rest");
+        _stats.skipped++;
+        file.close();
+        _skipSegment();
+        return false;
+      }
+      break;                            // Deliver what was read; the damage is skipped next time
+    }
+    offset += sizeof(header) + header.length;
+  
+    uint32_t sentAt, age;
+    if (!_date(header, frames ? _frames[batch.count].timestamp : header.written, sentAt, age)) {
+      // An earlier boot whose clock offset was never known (always the batch's first record)
+      _stats.skipped++;
+      _advance(batch.segment, offset);
+      continue;
+    }
+  
+    if (batch.type == 0) {
+      batch.type = header.type;
+      batch.seq = header.seq;
+      batch.sent_at = sentAt;
+      batch.age_ms = age;
+      boot = header.boot;
+    }
+    if (!frames) {
+      batch.length = header.length;
+      break;
+    }
+    batch.count += header.count;
+  }
+  file.close();
+  
+  if (batch.type == 0) {
+    _nextDrain = millis() + SPOOL_DRAIN_INTERVAL_MS;
+    return false;
+  }
+  batch.end_offset = offset;
+  batch.read_at = millis();
+  _inFlight = true;
+  return true;
+}
+
+void TelemetrySpool::commitBatch(const SpoolBatch& batch) {
+  unsigned long now = millis();
+  _inFlight = false;
+  _nextDrain = now + SPOOL_DRAIN_INTERVAL_MS;
+  _advance(batch.segment, batch.end_offset);
+  
+  uint32_t lag = batch.age_ms + (now - batch.read_at);
+  _stats.last_lag_ms = lag;
+  _stats.max_lag_ms = max(_stats.max_lag_ms, lag);
+  if (batch.type == SPOOL_RECORD_FRAMES) {
+    _stats.drained_frames += batch.count;
+  } else {
+    _stats.drained_alerts++;
+  }
+  
+  // Rate over the batches accepted after the first, so it reflects the pacing
+  if (_drainStart == 0) {
+    _drainStart = now | 1;            // 0 means no drain running
+    _drainFrames = 0;
+  } else {
+    _drainFrames += batch.count;
+    _stats.drain_per_min = (uint32_t)((uint64_t)_drainFrames * 60000 / max(now - _drainStart, 1UL));
+  }
+  
+  if (_pendingBytes == 0) {
+    Serial.println("Telemetry spool drained (" + String(_stats.drained_frames) + " frames, " +
+                   String(_stats.drained_alerts) + " alerts since boot)");
+    _drainStart = 0;
+  }
+}
+
+void TelemetrySpool::drainFailed() {
+  // The records stay under the cursor and go out with the next attempt
+  _inFlight = false;
+  _nextDrain = millis() + SPOOL_DRAIN_RETRY_MS;
+}
+
+uint32_t TelemetrySpool::getPendingBytes() {
+  return _pendingBytes;
+}
+
+SpoolStats TelemetrySpool::getStats() {
+  SpoolStats stats = _stats;
+  stats.bytes = _pendingBytes;
+  stats.segments = _ready ? _state.last_segment - _state.first_segment + 1 : 0;
+  return stats;
+}
+
+void TelemetrySpool::resetStats() {
+  _stats = {};
+  _drainStart = 0;
+}
+
+void TelemetrySpool::printStats() {
+  SpoolStats stats = getStats();
+  Serial.println("Telemetry spool: " + String(stats.bytes) + " bytes in " + String(stats.segments) +
+                 " segment(s)" + (_ready ? "" : " (no SD card)"));
+  Serial.println("  Spooled: " + String(stats.spooled_frames) + " frames, " + String(stats.spooled_alerts) +
+                 " alerts; drained " + String(stats.drained_frames) + " frames, " +
+                 String(stats.drained_alerts) + " alerts (" + String(stats.drain_per_min) + " frames/min)");
+  Serial.println("  Delivery lag: last " + String(stats.last_lag_ms / 1000) + " s, max " +
+                 String(stats.max_lag_ms / 1000) + " s; lost segments " + String(stats.lost_segments) +
+                 ", skipped " + String(stats.skipped) + ", write errors " + String(stats.write_errors));
+}
+
+// Private helper methods
+
+bool TelemetrySpool::_append(uint8_t type, uint8_t count, const uint8_t* payload, size_t length) {
+  if (!_ready) {
+    return false;
+  }
+  _updateBootEpoch();
+  
+  SpoolRecordHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = SPOOL_RECORD_MAGIC;
+  header.type = type;
+  header.count = count;
+  header.length = length;
+  header.seq = _state.next_seq;
+  header.boot = _state.boot;
+  header.written = millis();
+  header.boot_epoch = _state.boot_epoch;
+  header.crc = _checksum(header, payload);
+  
+  size_t recordSize = sizeof(header) + length;
+  if (_lastSize > 0 && _lastSize + recordSize > SPOOL_SEGMENT_BYTES) {
+    _state.last_segment++;
+    _lastSize = 0;
+    if (_state.last_segment - _state.first_segment >= SPOOL_MAX_SEGMENTS) {
+      _discardOldest();
+    }
+  }
+  
+  File file = SD.open(_segmentPath(_state.last_segment), FILE_APPEND);
+  bool ok = file && file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+            file.write(payload, length) == length;
+  if (file) {
+    file.close();
+  }
+  if (!ok) {
+    // A partial record fails its checksum when read; start the next record in a fresh segment
+    _stats.write_errors++;
+    _lastSize = SPOOL_SEGMENT_BYTES;
+    Serial.println("Spool write failed (segment " + String(_state.last_segment) + ")");
+    return false;
+  }
+  
+  _lastSize += recordSize;
+  _pendingBytes += recordSize;
+  _state.next_seq++;
+  _saveState();
+  return true;
+}
+
+bool TelemetrySpool::_openCursor(File& file) {
+  // Opens the segment under the read cursor, deleting segments already delivered
+  for (;;) {
+    String path = _segmentPath(_state.first_segment);
+    file = SD.open(path, FILE_READ);
+    if (file && _state.read_offset < file.size() && file.seek(_state.read_offset)) {
+      return true;
+    }
+    if (file) {
+      file.close();
+    }
+  
+    if (_state.first_segment == _state.last_segment) {
+      _pendingBytes = 0;
+      return false;
+    }
+    SD.remove(path);
+    _state.first_segment++;
+    _state.read_offset = 0;
+    _saveState();
+  }
+}
+
+void TelemetrySpool::_advance(uint32_t segment, uint32_t offset) {
+  // A batch whose segment was discarded while in flight moves nothing
+  if (segment != _state.first_segment || offset <= _state.read_offset) {
+    return;
+  }
+  _pendingBytes -= min(offset - _state.read_offset, _pendingBytes);
+  _state.read_offset = offset;
+  _saveState();
+}
+
+void TelemetrySpool::_skipSegment() {
+  uint32_t size = _fileSize(_segmentPath(_state.first_segment));
+  if (_state.first_segment == _state.last_segment) {
+    // Appending after the damage would hide new records behind it
+    _state.last_segment++;
+    _lastSize = 0;
+  }
+  _advance(_state.first_segment, max(size, _state.read_offset + 1));
+}
+
+void TelemetrySpool::_checkTail() {
+  // Walk the record headers of the segment being appended to; a record cut
+  // short by a power loss would otherwise hide everything appended after it
+  uint32_t offset = _state.first_segment == _state.last_segment ? _state.read_offset : 0;
+  File file = SD.open(_segmentPath(_state.last_segment), FILE_READ);
+  if (!file) {
+    return;
+  }
+  SpoolRecordHeader header;
+  while (offset < _lastSize && file.seek(offset) &&
+         file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) && _validHeader(header) &&
+         offset + sizeof(header) + header.length <= _lastSize) {
+    offset += sizeof(header) + header.length;
+  }
+  file.close();
+  
+  if (offset < _lastSize) {
+    Serial.println("Spool segment " + String(_state.last_segment) + " ends in a torn record - starting a new one");
+    _state.last_segment++;
+    _lastSize = 0;
+  }
+}
+
+void TelemetrySpool::_discardOldest() {
+  String path = _segmentPath(_state.first_segment);
+  uint32_t size = _fileSize(path);
+  uint32_t lost = size > _state.read_offset ? size - _state.read_offset : 0;
+  SD.remove(path);
+  _state.first_segment++;
+  _state.read_offset = 0;
+  _pendingBytes -= min(lost, _pendingBytes);
+  _stats.lost_segments++;
+  Serial.println("Telemetry spool full - oldest segment discarded (" + String(lost) + " bytes unsent)");
+}
+
+bool TelemetrySpool::_date(const SpoolRecordHeader& header, uint32_t timestamp, uint32_t& sentAt, uint32_t& age) {
+  // The server dates a frame as (receive time) - (sentAt - timestamp), so sentAt
+  // is "now" on the record's millis() clock
+  if (header.boot == _state.boot) {
+    sentAt = millis();
+  } else {
+    uint64_t bootEpoch = header.boot_epoch;
+    if (bootEpoch == 0 && header.boot + 1 == _state.boot) {
+      bootEpoch = _state.prev_boot_epoch;
+    }
+    uint64_t now = _epochMs();
+    if (bootEpoch == 0 || now <= bootEpoch || now - bootEpoch > SPOOL_MAX_AGE_MS) {
+      return false;
+    }
+    sentAt = (uint32_t)(now - bootEpoch);
+  }
+  age = sentAt - timestamp;
+  return true;
+}
+
+void TelemetrySpool::_updateBootEpoch() {
+  if (_state.boot_epoch != 0) {
+    return;
+  }
+  uint64_t now = _epochMs();
+  if (now != 0) {
+    _state.boot_epoch = now - millis();
+    _saveState();
+  }
+}
+
+uint64_t TelemetrySpool::_epochMs() {
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  if (now.tv_sec < (time_t)SPOOL_CLOCK_VALID) {
+    return 0;
+  }
+  return (uint64_t)now.tv_sec * 1000 + now.tv_usec / 1000;
+}
+
+bool TelemetrySpool::_validHeader(const SpoolRecordHeader& header) {
+  if (header.magic != SPOOL_RECORD_MAGIC) return false;
+  if (header.type == SPOOL_RECORD_FRAMES) {
+    return header.count > 0 && header.count <= SPOOL_DRAIN_FRAMES &&
+           header.length == header.count * sizeof(TelemetryFrame);
+  }
+  return header.type == SPOOL_RECORD_ALERT && header.count == 0 &&
+         header.length > 0 && header.length <= SPOOL_ALERT_MAX_BYTES;
+}
+
+uint32_t TelemetrySpool::_checksum(const SpoolRecordHeader& header, const uint8_t* payload) {
+  SpoolRecordHeader copy = header;
+  copy.crc = 0;
+  uint32_t crc = ModelStore::crc32((const uint8_t*)&copy, sizeof(copy));
+  return ModelStore::crc32(payload, header.length, crc);
+}
+
+bool TelemetrySpool::_loadState(const String& path) {
+  File file = SD.open(path, FILE_READ);
+  if (!file) {
+    return false;
+  }
+  SpoolState state;
+  bool ok = file.read((uint8_t*)&state, sizeof(state)) == sizeof(state);
+  file.close();
+  
+  uint32_t crc = state.crc;
+  state.crc = 0;
+  if (!ok || state.magic != SPOOL_STATE_MAGIC || crc != ModelStore::crc32((const uint8_t*)&state, sizeof(state)) ||
+      state.last_segment < state.first_segment) {
+    Serial.println("Ignoring invalid spool state " + path);
+    return false;
+  }
+  _state = state;
+  return true;
+}
+
+bool TelemetrySpool::_saveState() {
+  _state.crc = 0;
+  _state.crc = ModelStore::crc32((const uint8_t*)&_state, sizeof(_state));
+  
+  // Same replace-by-rename as the model files
+  String tmpPath = String(SPOOL_STATE_PATH) + ".tmp";
+  File file = SD.open(tmpPath, FILE_WRITE);
+  if (!file) {
+    _stats.write_errors++;
+    Serial.println("Cannot write spool state");
+    return false;
+  }
+  bool ok = file.write((const uint8_t*)&_state, sizeof(_state)) == sizeof(_state);
+  file.close();
+  if (!ok) {
+    _stats.write_errors++;
+    SD.remove(tmpPath);
+    return false;
+  }
+  
+  SD.remove(SPOOL_STATE_PATH);
+  return SD.rename(tmpPath, SPOOL_STATE_PATH);
+}
+
+String TelemetrySpool::_segmentPath(uint32_t segment) {
+  return String(SPOOL_DIR) + "/" + String(segment) + ".log";
+}
+
+uint32_t TelemetrySpool::_fileSize(const String& path) {
+  File file = SD.open(path, FILE_READ);
+  if (!file) {
+    return 0;
+  }
+  uint32_t size = file.size();
+  file.close();
+  return size;
+}
+
+#endif // TELEMETRY_SPOOL_H
@@ -0,0 +1,124 @@
+/*
+ * TreeEnsemble.h - Compiled Decision-Tree Ensemble
+ *
+ * This file runs a trained random forest or gradient-boosted tree ensemble
+ * over the raw sensor features. The trees are compiled into nested integer
+ * compares by Arduino/tools/model_tool.py forest, which writes ForestModel.h
+ * next to this file; without it the model reports itself unavailable and is
+ * left out of the ensemble.
+ *
+ * Features:
+ * - Branch-only code: no node tables, no floats, no heap
+ * - Inputs quantized once per tick to fixed point (TREE_FEATURE_SCALES), floored
+ *   as model_tool.py floors the thresholds, so x <= threshold always branches left
+ * - Random forest (mean leaf probability) or boosting (sum of leaf margins)
+ * - Leaf values in Q12 fixed point; one conversion to float at the end
+ *
+ * Input layout (INPUT_FEATURES, same order as FeatureVector::raw):
+ * - [0] current (mA)   [1] voltage (10 mV)   [2] power (W)
+ * - [3] frequency (mHz)   [4] temperature (0.01 C)   [5] SystemState
+ *
+ * Usage:
+ * 1. Generate ForestModel.h from a trained model (see model_tool.py forest)
+ * 2. Quantize with TreeEnsemble::quantize(raw, q)
+ * 3. Score with TreeEnsemble::predict(q) (threat probability 0-1)
+ */
+
+#ifndef TREE_ENSEMBLE_H
+#define TREE_ENSEMBLE_H
+
+#include "EV_Secure_Config.h"
+#include "FastActivations.h"
+#include <Arduino.h>
+
+// Fixed-point input scales: mA, 10 mV, W, mHz, 0.01 C, state
+#define TREE_FEATURE_SCALES {1000, 100, 1, 1000, 100, 1}
+#define TREE_LEAF_SHIFT 12               // Leaf values are Q12
+
+// Ensemble kinds (FOREST_KIND in ForestModel.h)
+#define TREE_KIND_FOREST 0               // Leaves hold probabilities; averaged
+#define TREE_KIND_BOOSTED 1              // Leaves hold log-odds margins; summed
+
+// Compiled trees: defines FOREST_KIND, FOREST_TREES, FOREST_NODES, FOREST_CODE_BYTES and forestScore()
+#if __has_include("ForestModel.h")
+#include "ForestModel.h"
+#endif
+
+class TreeEnsemble {
+public:
+  static bool isAvailable();
+  static void quantize(const float* raw, int32_t* q);
+  static int32_t score(const int32_t* q);
+  static float predict(const int32_t* q);
+  static int getTreeCount();
+  static int getNodeCount();
+  static size_t getCodeBytes();
+};
+
+// Implementation
+bool TreeEnsemble::isAvailable() {
+#ifdef FOREST_TREES
+  return true;
+#else
+  return false;
+#endif
+}
+
+void TreeEnsemble::quantize(const float* raw, int32_t* q) {
+  static const int32_t scales[INPUT_FEATURES] = TREE_FEATURE_SCALES;
+  for (int i = 0; i < INPUT_FEATURES; i++) {
+    // Broken readings take the left branch at every split on this feature
+    q[i] = isnan(raw[i]) ? INT32_MIN : (int32_t)floorf(raw[i] * scales[i]);
+  }
+}
+
+int32_t TreeEnsemble::score(const int32_t* q) {
+  // Sum of the leaf values (plus the base margin when boosted), Q12
+#ifdef FOREST_TREES
+  return forestScore(q);
+#else
+  (void)q;
+  return 0;
+#endif
+}
+
+float TreeEnsemble::predict(const int32_t* q) {
+#ifdef FOREST_TREES
+  int32_t total = score(q);
+#if FOREST_KIND == TREE_KIND_BOOSTED
+  return FastActivations::sigmoidExact((float)total / (1 << TREE_LEAF_SHIFT));
+#else
+  return (float)total / ((int32_t)FOREST_TREES << TREE_LEAF_SHIFT);
+#endif
+#else
+  (void)q;
+  return 0.0f;
+#endif
+}
+
+int TreeEnsemble::getTreeCount() {
+#ifdef FOREST_TREES
+  return FOREST_TREES;
+#else
+  return 0;
+#endif
+}
+
+int TreeEnsemble::getNodeCount() {
+#ifdef FOREST_NODES
+  return FOREST_NODES;
+#else
+  return 0;
+#endif
+}
+
+size_t TreeEnsemble::getCodeBytes() {
+  // Measured by model_tool.py when it generated ForestModel.h (0: not measured)
+#ifdef FOREST_CODE_BYTES
+  return FOREST_CODE_BYTES;
+#else
+  return 0;
+#endif
+}
+
+#endif // TREE_ENSEMBLE_H
@@ -0,0 +1,139 @@
+/*
+ * activation_check.cpp - Fast Activation Error Bound Check
+ *
+ * This program compares the FastActivations approximations with std::tanh
+ * and std::exp (evaluated in double) and fails when one exceeds its
+ * documented bound, TANH_MAX_ERROR or SIGMOID_MAX_ERROR.
+ *
+ * Features:
+ * - Sweeps float bit patterns rather than a grid, so every binade from the
+ *   subnormals to FLT_MAX is covered, both signs
+ * - Inputs just either side of each table knot and of the rational clamp
+ * - Infinities saturate; NaN is passed through
+ * - The on-device self test, FastActivations::verify(), must pass as well
+ *
+ * Build (from Arduino/):
+ *   g++ -O1 -std=gnu++17 -Ihost/stubs -IEV_Secure_ESP32S3_Complete \
+ *       host/activation_check.cpp -o activation_check
+ *
+ * Usage:
+ *   activation_check [options]
+ *     --stride N        test every Nth float bit pattern (default 64)
+ */
+
+#include "FastActivations.h"
+#include <cfloat>
+
+HardwareSerial Serial;
+EspClass ESP;
+SDClass SD;
+SystemState currentState = STATE_IDLE;
+
+struct CheckOptions {
+  uint32_t stride = 64;
+};
+
+struct Approximation {
+  const char* name;
+  float (*function)(float);
+  bool sigmoid;
+  double maxError;
+  float worstInput;
+  bool special;   // Infinities and NaN handled
+};
+
+static Approximation approximations[] = {
+  {"tanh LUT", FastActivations::tanhLUT, false, 0, 0, true},
+  {"tanh rational", FastActivations::tanhRational, false, 0, 0, true},
+  {"sigmoid LUT", FastActivations::sigmoidLUT, true, 0, 0, true},
+  {"sigmoid rational", FastActivations::sigmoidRational, true, 0, 0, true},
+};
+
+static uint64_t inputs = 0;
+
+static double reference(bool sigmoid, float x) {
+  return sigmoid ? 1.0 / (1.0 + std::exp(-(double)x)) : std::tanh((double)x);
+}
+
+static void check(float x) {
+  inputs++;
+  for (Approximation& a : approximations) {
+    double error = fabs((double)a.function(x) - reference(a.sigmoid, x));
+    if (!(error <= a.maxError)) {
+      a.maxError = error;
+      a.worstInput = x;
+    }
+  }
+}
+
+static void checkSpecial() {
+  for (Approximation& a : approximations) {
+    float low = a.sigmoid ? 0.0f : -1.0f;
+    a.special = a.function(INFINITY) == 1.0f && a.function(-INFINITY) == low && isnan(a.function(NAN)) &&
+                a.function(FLT_MAX) == 1.0f && a.function(-FLT_MAX) == low;
+  }
+}
+
+static bool parseOptions(int argc, char** argv, CheckOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--stride" && hasValue) {
+      options.stride = max(1, atoi(argv[++i]));
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  CheckOptions options;
+  if (!parseOptions(argc, argv, options)) {
+    fprintf(stderr, "usage: %s [--stride N]\n", argv[0]);
+    return 2;
+  }
+
+  // Every stride-th float from 0 to FLT_MAX, both signs
+  for (uint64_t bits = 0; bits <= 0x7F7FFFFFull; bits += options.stride) {
+    float x;
+    uint32_t pattern = (uint32_t)bits;
+    memcpy(&x, &pattern, sizeof(x));
+    check(x);
+    check(-x);
+  }
+
+  // Either side of every table knot (sigmoid takes x / 2) and the rational clamp
+  for (int k = 0; k <= TANH_LUT_SIZE; k++) {
+    for (float scale : {1.0f, 2.0f}) {
+      float knot = k * (TANH_LUT_RANGE / TANH_LUT_SIZE) * scale;
+      for (float x : {nextafterf(knot, 0.0f), knot, nextafterf(knot, INFINITY)}) {
+        check(x);
+        check(-x);
+      }
+    }
+  }
+  for (float clamp : {TANH_RATIONAL_CLAMP, 2.0f * TANH_RATIONAL_CLAMP}) {
+    for (float x : {nextafterf(clamp, 0.0f), clamp, nextafterf(clamp, INFINITY)}) {
+      check(x);
+      check(-x);
+    }
+  }
+  checkSpecial();
+
+  float tanhError = 0.0f;
+  float sigmoidError = 0.0f;
+  bool selfTest = FastActivations::verify(&tanhError, &sigmoidError);
+
+  bool ok = selfTest;
+  printf("%llu inputs (stride %u)\n", (unsigned long long)inputs, options.stride);
+  for (const Approximation& a : approximations) {
+    double bound = a.sigmoid ? SIGMOID_MAX_ERROR : TANH_MAX_ERROR;
+    bool pass = a.maxError < bound && a.special;
+    ok = ok && pass;
+    printf("  %-17s max error %.3e at x = %-13.9g (bound %.1e), inf/NaN %s: %s\n", a.name, a.maxError,
+           a.worstInput, bound, a.special ? "ok" : "WRONG", pass ? "pass" : "FAIL");
+  }
+  printf("  verify(): tanh %.3e, sigmoid %.3e: %s\n", tanhError, sigmoidError, selfTest ? "pass" : "FAIL");
+  return ok ? 0 : 1;
+}
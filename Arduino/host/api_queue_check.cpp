@@ -0,0 +1,247 @@
+/*
+ * api_queue_check.cpp - Network Task and Request Queue Check
+ *
+ * This program drives APIManager's request queue the way loop() does and
+ * measures how long the caller is blocked, against fake_dashboard.py with a
+ * slow server.
+ *
+ * Features:
+ * - Synchronous sendAlert() versus async enqueue + poll() blocking time
+ * - Sketch pattern (one telemetry upload and one command poll in flight,
+ *   alerts at any time) and a telemetry flood that fills the queue
+ * - Alert retries after dropped connections, and the undelivered-alert
+ *   hand-off (5xx and 429 are handed off, other 4xx are not); a 429's
+ *   Retry-After spaces the alert's retries
+ * - A reply over API_RESPONSE_MAX_BYTES comes back as a success with an
+ *   error and no data, and the connection stays usable
+ *
+ * Build (from Arduino/):
+ *   g++ -O1 -std=gnu++17 -pthread -Ihost/stubs -IEV_Secure_ESP32S3_Complete \
+ *       host/api_queue_check.cpp -o api_queue_check \
+ *       -l:libmbedtls.so.14 -l:libmbedx509.so.1 -l:libmbedcrypto.so.7
+ *
+ * Usage:
+ *   python3 host/fake_dashboard.py --port 8080 &
+ *   api_queue_check [options]
+ *     --port N          server port (default 8080)
+ *     --latency MS      server latency (default 300)
+ */
+
+#include "APIManager.h"
+#include "fake_dashboard.h"
+#include <vector>
+
+HardwareSerial Serial;
+EspClass ESP;
+SDClass SD;
+WiFiClass WiFi;
+SystemState currentState = STATE_IDLE;
+
+struct CheckOptions {
+  int port = 8080;
+  int latencyMs = 300;
+};
+
+struct Outcome {
+  std::string name;
+  bool success;
+  int status;
+};
+
+static std::vector<Outcome> outcomes;
+static bool telemetryBusy = false;
+static bool commandBusy = false;
+static int handedOff = 0;
+
+static void record(const APIResponse& response, void* context) {
+  outcomes.push_back({context ? (const char*)context : "", response.success, response.statusCode});
+}
+
+static void onTelemetry(const APIResponse& response, void* context) {
+  telemetryBusy = false;
+  record(response, context);
+}
+
+static void onCommand(const APIResponse& response, void* context) {
+  commandBusy = false;
+  record(response, context);
+}
+
+static size_t replyLength = 0;
+static std::string replyError;
+
+static void onReply(const APIResponse& response, void* context) {
+  replyLength = response.data.length();
+  replyError = response.error.c_str();
+  record(response, context);
+}
+
+static void onUndelivered(const uint8_t*, size_t) {
+  handedOff++;
+}
+
+static int count(const char* prefix, bool success, int status = -1) {
+  int n = 0;
+  for (auto& outcome : outcomes) {
+    n += outcome.name.compare(0, strlen(prefix), prefix) == 0 && outcome.success == success &&
+         (status < 0 || outcome.status == status);
+  }
+  return n;
+}
+
+static void waitFor(size_t done) {
+  for (unsigned long start = millis(); outcomes.size() < done && millis() - start < 30000;) {
+    APIManager::poll();
+    delay(5);
+  }
+}
+
+// iterations x 10 ms of loop(); flood = telemetry every tick instead of gated
+static void runLoop(const char* title, bool flood, int iterations) {
+  static char names[2000][3][16];
+  static uint8_t payload[3000];
+  APIManager::resetQueueStats();
+  outcomes.clear();
+  telemetryBusy = commandBusy = false;
+
+  uint64_t enqueueWorst = 0;
+  uint64_t pollWorst = 0;
+  int alerts = 0;
+  int telemetry = 0;
+  for (int i = 0; i < iterations + 300; i++) {
+    uint64_t start = hostNanos();
+    if (i < iterations) {
+      if (i % (flood ? 40 : 200) == 5) {
+        snprintf(names[i][0], 16, "alert%d", i);
+        alerts += APIManager::sendAlertAsync("THREAT", "check", record, names[i][0]);
+      }
+      if (!flood && i % 100 == 0 && !commandBusy) {
+        snprintf(names[i][1], 16, "cmd%d", i);
+        commandBusy = APIManager::getCommandAsync(onCommand, names[i][1]);
+      }
+      if (flood || (i % 50 == 0 && !telemetryBusy)) {
+        snprintf(names[i][2], 16, "tel%d", i);
+        telemetryBusy = APIManager::sendDataAsync(payload, sizeof(payload), "application/msgpack",
+                                                  onTelemetry, names[i][2]);
+        telemetry++;
+      }
+    }
+    enqueueWorst = max(enqueueWorst, hostNanos() - start);
+    start = hostNanos();
+    APIManager::poll();
+    pollWorst = max(pollWorst, hostNanos() - start);
+    delay(10);
+  }
+
+  APIQueueStats stats = APIManager::getQueueStats();
+  printf("%s: enqueue worst %.2f ms, poll worst %.2f ms\n", title, enqueueWorst / 1e6, pollWorst / 1e6);
+  printf("  queued %u, done %u, failed %u, dropped %u, max depth %u, mean wait %u ms, in flight %u ms\n",
+         stats.enqueued, stats.completed, stats.failed, stats.dropped, stats.max_depth, stats.avg_wait_ms,
+         stats.avg_flight_ms);
+  printf("  alerts delivered %d/%d, telemetry delivered %d of %d (%d held back by the rate limiter)\n",
+         count("alert", true), alerts, count("tel", true), telemetry,
+         count("tel", false, HTTP_TOO_MANY_REQUESTS));
+  if (flood) {
+    std::string delivered;
+    for (auto& outcome : outcomes) {
+      if (outcome.success && outcome.name.compare(0, 3, "tel") == 0) {
+        delivered += " " + outcome.name;
+      }
+    }
+    printf("  telemetry that got through:%s\n", delivered.c_str());
+  }
+}
+
+static bool parseOptions(int argc, char** argv, CheckOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--port" && hasValue) {
+      options.port = atoi(argv[++i]);
+    } else if (arg == "--latency" && hasValue) {
+      options.latencyMs = atoi(argv[++i]);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  CheckOptions options;
+  if (!parseOptions(argc, argv, options)) {
+    fprintf(stderr, "usage: %s [--port N] [--latency MS]\n", argv[0]);
+    return 2;
+  }
+  setvbuf(stdout, nullptr, _IONBF, 0);
+  Serial.mute = true;
+  FakeDashboard::begin(options.port);
+  FakeDashboard::control("reset=1&status=200&latency_ms=0&fail=0&fail_every=0");
+  APIManager::enableSSL(false);
+  APIManager::setServerURL(FakeDashboard::url());
+  if (!APIManager::init()) {
+    fprintf(stderr, "fake dashboard not reachable on port %d\n", options.port);
+    return 1;
+  }
+  FakeDashboard::control("latency_ms=" + std::to_string(options.latencyMs));
+
+  // 1. Synchronous: the caller waits for the whole request
+  uint64_t worst = 0;
+  for (int i = 0; i < 5; i++) {
+    uint64_t start = hostNanos();
+    APIManager::sendAlert("THREAT", "check");
+    worst = max(worst, hostNanos() - start);
+  }
+  printf("sync sendAlert: caller blocked up to %.1f ms per call\n", worst / 1e6);
+
+  // 2. Async, as loop() uses it; the flood lifts the rate limits so the
+  //    queue itself has to make room
+  APIManager::setUndeliveredAlertHandler(onUndelivered);
+  APIManager::begin();
+  runLoop("sketch pattern", false, 1000);
+  APIManager::setRateLimit(API_CLASS_TELEMETRY, 6000, 100);
+  APIManager::setRateLimit(API_CLASS_ALERT, 6000, 100);
+  runLoop("telemetry flood", true, 200);
+
+  // 3. Alert retries after two dropped connections
+  outcomes.clear();
+  APIManager::resetQueueStats();
+  FakeDashboard::control("latency_ms=5&fail=2");
+  APIManager::sendAlertAsync("THREAT", "retry", record, (void*)"retry");
+  waitFor(1);
+  printf("retry: alert %s after %u retries\n", !outcomes.empty() && outcomes[0].success ? "delivered" : "lost",
+         APIManager::getQueueStats().retries);
+
+  // 4. Alerts that finally fail: a 5xx or 429 is handed off (spooled), a 400 is not
+  outcomes.clear();
+  FakeDashboard::control("status=503");
+  APIManager::sendAlertAsync("THREAT", "server error", record, (void*)"503");
+  waitFor(1);
+  FakeDashboard::control("status=400");
+  APIManager::sendAlertAsync("THREAT", "bad request", record, (void*)"400");
+  waitFor(2);
+  FakeDashboard::control("status=429&retry_after=1");
+  unsigned long throttledAt = millis();
+  APIManager::sendAlertAsync("THREAT", "throttled", record, (void*)"429");
+  waitFor(3);
+  printf("hand-off: %d of 3 failed alerts handed off (expect 2, the 503 and the 429); "
+         "429 retried over %lu ms (Retry-After 1 s)\n",
+         handedOff, millis() - throttledAt);
+
+  // 5. A reply too long for the response buffer is not handed on cut
+  outcomes.clear();
+  FakeDashboard::control("status=200&retry_after=0&reply_pad=" + std::to_string(API_RESPONSE_MAX_BYTES));
+  APIManager::getCommandAsync(onReply, (void*)"oversized");
+  waitFor(1);
+  bool dropped = count("oversized", true) == 1 && replyLength == 0 && !replyError.empty();
+  std::string error = replyError;
+  FakeDashboard::control("reply_pad=0");
+  APIManager::getCommandAsync(onReply, (void*)"normal");
+  waitFor(2);
+  bool normal = count("normal", true) == 1 && replyLength > 0 && replyError.empty();
+  printf("oversized reply: %s (\"%s\"), %u cut; next reply %s\n", dropped ? "dropped" : "PASSED ON",
+         error.c_str(), APIManager::getConnectionStats().cut_responses, normal ? "intact" : "BROKEN");
+
+  fflush(stdout);
+  _exit(0);
+}
@@ -0,0 +1,184 @@
+/*
+ * arena_soak.cpp - Request Body Arena Soak
+ *
+ * This program pushes days of the station's request mix through APIManager's
+ * queue and body arena to fake_dashboard.py, which checks every body it
+ * receives, and tracks arena fragmentation and process heap.
+ *
+ * Features:
+ * - Per simulated minute: one JSON telemetry document (4-9 KB), six bulk
+ *   uploads (1-4 KB x-test-pattern bodies), two command polls and an alert
+ *   every 5 minutes, spread over the minute: the next request is enqueued
+ *   while the previous one is still in flight, so the queue never runs empty
+ * - --load N enqueues N requests between those waits (overload)
+ * - 1 in 20 non-alert requests answered 503 by the server
+ * - Heap allocations made by the loop task inside the telemetry, bulk and
+ *   command enqueue calls are counted (documents are built before the count
+ *   starts; alerts are left out because the stub's JsonDocument allocates
+ *   its values, where ArduinoJson uses the document's own pool)
+ * - Process heap in use (mallinfo2) reported every 12 simulated hours
+ *
+ * Build (from Arduino/):
+ *   g++ -O1 -std=gnu++17 -pthread -Ihost/stubs -IEV_Secure_ESP32S3_Complete \
+ *       host/arena_soak.cpp -o arena_soak \
+ *       -l:libmbedtls.so.14 -l:libmbedx509.so.1 -l:libmbedcrypto.so.7
+ *
+ * Usage:
+ *   python3 host/fake_dashboard.py --port 8086 &
+ *   arena_soak [options]
+ *     --port N          server port (default 8086)
+ *     --hours N         simulated hours (default 72)
+ *     --load N          requests enqueued back to back (default 1)
+ */
+
+#include "APIManager.h"
+#include "fake_dashboard.h"
+#include <malloc.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+SDClass SD;
+WiFiClass WiFi;
+SystemState currentState = STATE_IDLE;
+
+struct CheckOptions {
+  int port = 8086;
+  double hours = 72;
+  int load = 1;
+};
+
+// Allocations by the loop task while it enqueues
+extern "C" void* __libc_malloc(size_t size);
+
+static thread_local bool counting = false;
+static uint64_t enqueueAllocs = 0;
+
+extern "C" void* malloc(size_t size) {
+  if (counting) {
+    enqueueAllocs++;
+  }
+  return __libc_malloc(size);
+}
+
+static uint32_t done = 0;
+static uint32_t failed = 0;
+
+static void record(const APIResponse& response, void*) {
+  done++;
+  failed += !response.success;
+}
+
+static bool parseOptions(int argc, char** argv, CheckOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--port" && hasValue) {
+      options.port = atoi(argv[++i]);
+    } else if (arg == "--hours" && hasValue) {
+      options.hours = atof(argv[++i]);
+    } else if (arg == "--load" && hasValue) {
+      options.load = max(1, atoi(argv[++i]));
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  CheckOptions options;
+  if (!parseOptions(argc, argv, options)) {
+    fprintf(stderr, "usage: %s [--port N] [--hours N] [--load N]\n", argv[0]);
+    return 2;
+  }
+  setvbuf(stdout, nullptr, _IONBF, 0);
+  Serial.mute = true;
+  FakeDashboard::begin(options.port);
+  FakeDashboard::control("reset=1&status=200&latency_ms=0&fail=0&fail_every=0");
+  APIManager::enableSSL(false);
+  APIManager::setServerURL(FakeDashboard::url());
+  if (!APIManager::init()) {
+    fprintf(stderr, "fake dashboard not reachable on port %d\n", options.port);
+    return 1;
+  }
+  APIManager::begin();
+  for (int cls = 0; cls < API_CLASS_COUNT; cls++) {
+    APIManager::setRateLimit((APIRequestClass)cls, 1000000, 1000);
+  }
+  FakeDashboard::control("fail_every=20");
+
+  static uint8_t raw[4096];
+  StaticJsonDocument<256> doc;
+  std::string pad;
+  size_t rawLength = 0;
+  uint64_t requests = 0;
+  uint32_t id = 1;
+  uint32_t minLargest = API_QUEUE_MAX_BYTES;
+  size_t minutes = (size_t)(options.hours * 60);
+  struct mallinfo2 heapStart = mallinfo2();
+  for (size_t minute = 0; minute < minutes; minute++) {
+    for (int step = 0; step < 10; step++) {
+      int kind = step;
+      if (kind == 0) {
+        doc.clear();
+        doc["seq"] = id;
+        pad = FakeDashboard::pad(id++);
+        doc["pad"] = pad.c_str();
+      } else if (kind <= 6) {
+        rawLength = 1000 + rand() % 3000;
+        FakeDashboard::fillPattern(raw, rawLength, id);
+      }
+
+      if (kind == 9 && minute % 5 != 0) {
+        continue;
+      }
+      counting = kind < 9;
+      if (kind == 0) {
+        APIManager::sendDataAsync(doc, record, nullptr);
+      } else if (kind <= 6) {
+        APIManager::sendBulkAsync(raw, rawLength, "application/x-test-pattern", record, nullptr);
+      } else if (kind <= 8) {
+        APIManager::getCommandAsync(record, nullptr);
+      } else {
+        APIManager::sendAlertAsync("THREAT", "soak", record, nullptr);
+      }
+      counting = false;
+      if (kind > 0 && kind <= 6) {
+        id++;
+      }
+      requests++;
+      minLargest = min(minLargest, APIManager::getQueueStats().largest_free);
+      delayMicroseconds(rand() % 400);
+      APIManager::poll();
+      if (requests % options.load == 0) {
+        for (unsigned long start = millis(); APIManager::getQueueStats().depth > 1 && millis() - start < 5000;) {
+          APIManager::poll();
+          delayMicroseconds(200);
+        }
+      }
+    }
+    if (minute % (12 * 60) == 0 || minute + 1 == minutes) {
+      APIQueueStats queue = APIManager::getQueueStats();
+      struct mallinfo2 heap = mallinfo2();
+      printf("t=%5.1fh requests %7llu done %7u failed %5u | arena queued %5u longest %5u fragmented %u "
+             "rejected %u dropped %u | enqueue allocs %llu | heap in use %+ld B\n",
+             minute / 60.0, (unsigned long long)requests, done, failed, queue.queued_bytes, queue.largest_free,
+             queue.fragmented, queue.rejected, queue.dropped, (unsigned long long)enqueueAllocs,
+             (long)heap.uordblks - (long)heapStart.uordblks);
+    }
+  }
+  for (unsigned long start = millis(); APIManager::getQueueStats().depth && millis() - start < 30000;) {
+    APIManager::poll();
+    delay(1);
+  }
+  delay(50);
+  APIManager::poll();
+
+  APIQueueStats queue = APIManager::getQueueStats();
+  printf("end: arena longest free %u B (min seen %u), fragmented %u; server checked %ld bodies, %ld corrupt, "
+         "%ld answered 503\n",
+         queue.largest_free, minLargest, queue.fragmented, FakeDashboard::stat("bodies"),
+         FakeDashboard::stat("corrupt"), FakeDashboard::stat("status 503"));
+  fflush(stdout);
+  _exit(0);
+}
@@ -0,0 +1,131 @@
+/*
+ * command_channel_check.cpp - Command Delivery Latency Check
+ *
+ * This program runs the real CommandChannel task against fake_dashboard.py
+ * queueing STOP commands, and reports the time from queueing to loop()
+ * receiving each command, plus the requests the station made.
+ *
+ * Features:
+ * - --poll reproduces the old loop(): GET /api/commands every
+ *   COMMAND_CHECK_INTERVAL
+ * - The server decides the channel mode: --stream on (SSE), off (404, so
+ *   the channel falls back to long-poll) or silent (half-open stream)
+ *
+ * Build (from Arduino/):
+ *   g++ -O1 -std=gnu++17 -pthread -Ihost/stubs -IEV_Secure_ESP32S3_Complete \
+ *       host/command_channel_check.cpp -o command_channel_check \
+ *       -l:libmbedtls.so.14 -l:libmbedx509.so.1 -l:libmbedcrypto.so.7
+ *
+ * Usage:
+ *   python3 host/fake_dashboard.py --port 8081 --commands 12 24 1 [--stream on|off|silent] &
+ *   command_channel_check [options]
+ *     --port N          server port (default 8081)
+ *     --seconds N       run time (default 240)
+ *     --poll            poll instead of running the channel
+ */
+
+#include "CommandChannel.h"
+#include "fake_dashboard.h"
+#include <chrono>
+#include <vector>
+
+HardwareSerial Serial;
+EspClass ESP;
+SDClass SD;
+WiFiClass WiFi;
+SystemState currentState = STATE_IDLE;
+
+struct CheckOptions {
+  int port = 8081;
+  long seconds = 240;
+  bool poll = false;
+};
+
+static long long wallMillis() {
+  using namespace std::chrono;
+  return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+// "queued_at" stamped by the server when the command was queued
+static long long queuedAt(const String& json) {
+  int at = json.indexOf("\"queued_at\":");
+  return at < 0 ? 0 : atoll(json.c_str() + at + 12);
+}
+
+static bool parseOptions(int argc, char** argv, CheckOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--port" && hasValue) {
+      options.port = atoi(argv[++i]);
+    } else if (arg == "--seconds" && hasValue) {
+      options.seconds = atol(argv[++i]);
+    } else if (arg == "--poll") {
+      options.poll = true;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  CheckOptions options;
+  if (!parseOptions(argc, argv, options)) {
+    fprintf(stderr, "usage: %s [--port N] [--seconds N] [--poll]\n", argv[0]);
+    return 2;
+  }
+  Serial.mute = true;
+  FakeDashboard::begin(options.port);
+  FakeDashboard::control("reset=1");
+  if (!options.poll) {
+    CommandChannel::enableSSL(false);
+    CommandChannel::setServerURL(FakeDashboard::url());
+    CommandChannel::begin();
+  }
+
+  std::vector<long long> latency;
+  unsigned long start = millis();
+  unsigned long lastPoll = 0;
+  bool polled = false;
+  while (millis() - start < (unsigned long)options.seconds * 1000) {
+    String json;
+    if (options.poll) {
+      if (!polled || millis() - lastPoll >= COMMAND_CHECK_INTERVAL) {
+        polled = true;
+        lastPoll = millis();
+        json = String(FakeDashboard::get(API_COMMANDS_ENDPOINT "?wait=0"));
+        if (json.indexOf("\"command\":null") < 0 && json.length() > 0) {
+          latency.push_back(wallMillis() - queuedAt(json));
+        }
+      }
+    } else {
+      while (CommandChannel::receive(json)) {
+        latency.push_back(wallMillis() - queuedAt(json));
+      }
+    }
+    delay(10);
+  }
+
+  std::sort(latency.begin(), latency.end());
+  long long total = 0;
+  for (long long value : latency) {
+    total += value;
+  }
+  double hours = options.seconds / 3600.0;
+  long streams = FakeDashboard::stat("GET /api/commands/stream");
+  long polls = FakeDashboard::stat("GET /api/commands");
+  printf("%s: %zu commands, latency mean %lld ms, p50 %lld ms, max %lld ms; "
+         "requests: %ld stream opens, %ld polls (%.0f/h)\n",
+         options.poll ? "poll" : (CommandChannel::getMode() == COMMAND_CHANNEL_STREAM ? "stream" : "long-poll"),
+         latency.size(), latency.empty() ? 0 : total / (long long)latency.size(),
+         latency.empty() ? 0 : latency[latency.size() / 2], latency.empty() ? 0 : latency.back(),
+         streams, polls, (streams + polls) / hours);
+  if (!options.poll) {
+    CommandChannelStats stats = CommandChannel::getStats();
+    printf("  channel: connects %u, requests %u, heartbeats %u, timeouts %u, failures %u, dropped %u\n",
+           stats.connects, stats.requests, stats.heartbeats, stats.timeouts, stats.failures, stats.dropped);
+  }
+  fflush(stdout);
+  _exit(0);
+}
@@ -0,0 +1,719 @@
+/*
+ * evaluate_models.cpp - Offline Model Evaluation Harness
+ *
+ * This program streams labelled session logs through every EnhancedMLModel
+ * ModelType (including the AdvancedThreatDetection rules) on a Linux host.
+ * The firmware headers are compiled unchanged against the stubbed Arduino
+ * layer in host/stubs.
+ *
+ * Features:
+ * - CSV logs (SDLogger sensor_data.csv columns plus state/label/session)
+ *   or a compact binary format (--convert writes it)
+ * - Confusion matrix at the firmware's decision threshold, ROC points and AUC
+ * - Time-to-detect per attack episode (consecutive attack records of a session)
+ * - Samples per second; reading, parsing and inference run as a three-stage
+ *   thread pipeline with bounded queues
+ * - --jobs N shards sessions across N worker processes, each with its own
+ *   model state (the models are static classes, so one process = one device)
+ *
+ * CSV format:
+ * - Header row naming the columns, in any order
+ * - Required: timestamp (ms), current, voltage, power, frequency, temperature
+ * - Optional: state (SystemState, default STATE_CHARGING), label (0 = normal,
+ *   otherwise the attack type) and session (default 0)
+ *
+ * Binary format (little-endian):
+ * - EvalLogHeader ("EVSL", version, record size) followed by EvalRecord structs
+ *
+ * Build (from Arduino/):
+ *   g++ -O2 -std=gnu++17 -pthread -Ihost/stubs -IEV_Secure_ESP32S3_Complete \
+ *       host/evaluate_models.cpp -o evaluate_models
+ *
+ * Usage:
+ *   evaluate_models [options] log.csv|log.bin ...
+ *     --jobs N          worker processes (sessions are split by id)
+ *     --cascade         evaluate as deployed: members only run when escalated
+ *     --parallel        keep the dual-core LSTM worker (off by default)
+ *     --sd DIR          directory standing in for the SD card (.evm files in models/)
+ *     --convert OUT     write the records to OUT in binary format and exit
+ *     --verbose         keep firmware Serial output (on stderr)
+ */
+
+#include "EnhancedMLModel.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+SystemState currentState = STATE_CHARGING;
+HardwareSerial Serial;
+EspClass ESP;
+SDClass SD;
+
+// Log format
+#define EVAL_LOG_MAGIC 0x4C535645        // "EVSL"
+#define EVAL_LOG_VERSION 1
+
+// Pipeline
+#define EVAL_CHUNK_BYTES (1 << 20)       // Bytes handed from reader to parser
+#define EVAL_QUEUE_DEPTH 8               // Chunks/batches in flight per queue
+
+// Metrics
+#define EVAL_MODELS MODEL_TYPE_COUNT
+#define EVAL_ROC_BINS 1000               // Score resolution of the ROC curve
+#define EVAL_ROC_POINTS 9                // Printed thresholds 0.1 .. 0.9
+
+struct EvalLogHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t record_size;
+};
+
+struct EvalRecord {
+  uint32_t timestamp;
+  float current;
+  float voltage;
+  float power;
+  float frequency;
+  float temperature;
+  uint8_t state;
+  uint8_t label;
+  uint16_t session;
+};
+static_assert(sizeof(EvalRecord) == 28, "EvalRecord is part of the file format");
+
+// Detection quality of one model
+struct ModelMetrics {
+  uint64_t tp;
+  uint64_t fp;
+  uint64_t tn;
+  uint64_t fn;
+  uint64_t skipped;                          // Ticks the model did not run (cascade)
+  uint64_t positives[EVAL_ROC_BINS + 1];     // Score histogram of attack records
+  uint64_t negatives[EVAL_ROC_BINS + 1];     // Score histogram of normal records
+  uint64_t episodes_detected;
+  LatencyHistogram time_to_detect;           // Milliseconds from episode start
+};
+
+// Everything one worker reports (plain data, sent over a pipe)
+struct EvalResult {
+  uint64_t records;
+  uint64_t attack_records;
+  uint64_t episodes;
+  uint64_t bad_lines;
+  uint64_t bytes;
+  double read_seconds;
+  double parse_seconds;
+  double infer_seconds;
+  ModelMetrics models[EVAL_MODELS];
+};
+
+struct EvalOptions {
+  std::vector<std::string> files;
+  int jobs = 1;
+  bool cascade = false;
+  bool parallel = false;
+  bool verbose = false;
+  std::string sdRoot = ".";
+  std::string convert;
+};
+
+// CSV column positions (-1 = absent)
+struct CsvColumns {
+  int timestamp = -1;
+  int current = -1;
+  int voltage = -1;
+  int power = -1;
+  int frequency = -1;
+  int temperature = -1;
+  int state = -1;
+  int label = -1;
+  int session = -1;
+  int count = 0;
+};
+
+struct Chunk {
+  std::string data;
+  std::shared_ptr<const CsvColumns> columns;   // nullptr for binary records
+};
+
+typedef std::vector<EvalRecord> Batch;
+
+// Blocking queue with a fixed depth; pop() fails once closed and drained
+template <class T>
+class BoundedQueue {
+public:
+  void push(T&& item) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notFull.wait(lock, [&] { return _items.size() < EVAL_QUEUE_DEPTH; });
+    _items.push_back(std::move(item));
+    _notEmpty.notify_one();
+  }
+
+  bool pop(T& item) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notEmpty.wait(lock, [&] { return !_items.empty() || _closed; });
+    if (_items.empty()) {
+      return false;
+    }
+    item = std::move(_items.front());
+    _items.pop_front();
+    _notFull.notify_one();
+    return true;
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _closed = true;
+    _notEmpty.notify_all();
+  }
+
+private:
+  std::mutex _mutex;
+  std::condition_variable _notEmpty;
+  std::condition_variable _notFull;
+  std::deque<T> _items;
+  bool _closed = false;
+};
+
+static double secondsSince(uint64_t startNanos) {
+  return (hostNanos() - startNanos) / 1e9;
+}
+
+// Stage 1: read files in large chunks, cut at record/line boundaries
+static void readerStage(const EvalOptions& options, BoundedQueue<Chunk>& out, EvalResult& result) {
+  for (const std::string& path : options.files) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+      fprintf(stderr, "%s: cannot open\n", path.c_str());
+      continue;
+    }
+
+    std::shared_ptr<CsvColumns> columns;
+    EvalLogHeader header;
+    bool binary = fread(&header, sizeof(header), 1, file) == 1 && header.magic == EVAL_LOG_MAGIC;
+    if (binary) {
+      if (header.version != EVAL_LOG_VERSION || header.record_size != sizeof(EvalRecord)) {
+        fprintf(stderr, "%s: unsupported binary log version %u\n", path.c_str(), header.version);
+        fclose(file);
+        continue;
+      }
+    } else {
+      // Map the header row; the data starts on the next line
+      rewind(file);
+      char line[512];
+      if (!fgets(line, sizeof(line), file)) {
+        fclose(file);
+        continue;
+      }
+      columns = std::make_shared<CsvColumns>();
+      int index = 0;
+      for (char* name = strtok(line, ",\r\n"); name; name = strtok(nullptr, ",\r\n"), index++) {
+        while (*name == ' ') name++;
+        if (!strcmp(name, "timestamp")) columns->timestamp = index;
+        else if (!strcmp(name, "current")) columns->current = index;
+        else if (!strcmp(name, "voltage")) columns->voltage = index;
+        else if (!strcmp(name, "power")) columns->power = index;
+        else if (!strcmp(name, "frequency")) columns->frequency = index;
+        else if (!strcmp(name, "temperature")) columns->temperature = index;
+        else if (!strcmp(name, "state")) columns->state = index;
+        else if (!strcmp(name, "label")) columns->label = index;
+        else if (!strcmp(name, "session")) columns->session = index;
+      }
+      columns->count = index;
+      if (columns->timestamp < 0 || columns->current < 0 || columns->voltage < 0 ||
+          columns->power < 0 || columns->frequency < 0 || columns->temperature < 0) {
+        fprintf(stderr, "%s: missing sensor columns in CSV header\n", path.c_str());
+        fclose(file);
+        continue;
+      }
+    }
+
+    std::string carry;
+    while (true) {
+      uint64_t start = hostNanos();
+      Chunk chunk;
+      chunk.columns = columns;
+      chunk.data.swap(carry);
+      size_t used = chunk.data.size();
+      chunk.data.resize(used + EVAL_CHUNK_BYTES);
+      size_t got = fread(&chunk.data[used], 1, EVAL_CHUNK_BYTES, file);
+      chunk.data.resize(used + got);
+      result.bytes += got;
+
+      // Keep a partial record/line for the next chunk
+      size_t cut = chunk.data.size();
+      if (got > 0) {
+        if (binary) {
+          cut -= cut % sizeof(EvalRecord);
+        } else {
+          size_t newline = chunk.data.rfind('\n');
+          cut = (newline == std::string::npos) ? 0 : newline + 1;
+        }
+      }
+      carry.assign(chunk.data, cut, std::string::npos);
+      chunk.data.resize(cut);
+      result.read_seconds += secondsSince(start);
+
+      if (!chunk.data.empty()) {
+        out.push(std::move(chunk));
+      }
+      if (got == 0) {
+        break;
+      }
+    }
+    fclose(file);
+  }
+  out.close();
+}
+
+static bool parseCsvLine(const char* line, const CsvColumns& columns, EvalRecord& record) {
+  float values[16] = {0};
+  int count = 0;
+  const char* p = line;
+  while (count < 16) {
+    char* end;
+    values[count++] = strtof(p, &end);
+    p = strchr(end, ',');
+    if (!p) {
+      break;
+    }
+    p++;
+  }
+  if (count < columns.count) {
+    return false;
+  }
+
+  record.timestamp = (uint32_t)values[columns.timestamp];
+  record.current = values[columns.current];
+  record.voltage = values[columns.voltage];
+  record.power = values[columns.power];
+  record.frequency = values[columns.frequency];
+  record.temperature = values[columns.temperature];
+  record.state = columns.state >= 0 ? (uint8_t)values[columns.state] : STATE_CHARGING;
+  record.label = columns.label >= 0 ? (uint8_t)values[columns.label] : 0;
+  record.session = columns.session >= 0 ? (uint16_t)values[columns.session] : 0;
+  return true;
+}
+
+// Stage 2: decode chunks into records of this worker's sessions
+static void parserStage(const EvalOptions& options, int job, BoundedQueue<Chunk>& in,
+                        BoundedQueue<Batch>& out, EvalResult& result) {
+  Chunk chunk;
+  while (in.pop(chunk)) {
+    uint64_t start = hostNanos();
+    Batch batch;
+    if (!chunk.columns) {
+      size_t count = chunk.data.size() / sizeof(EvalRecord);
+      batch.resize(count);
+      memcpy(batch.data(), chunk.data.data(), count * sizeof(EvalRecord));
+    } else {
+      batch.reserve(chunk.data.size() / 40);
+      char* line = &chunk.data[0];
+      char* end = line + chunk.data.size();
+      while (line < end) {
+        char* newline = (char*)memchr(line, '\n', end - line);
+        if (!newline) {
+          newline = end;
+        }
+        *newline = '\0';
+        EvalRecord record;
+        if (line != newline && *line != '\r') {
+          if (parseCsvLine(line, *chunk.columns, record)) {
+            batch.push_back(record);
+          } else {
+            result.bad_lines++;
+          }
+        }
+        line = newline + 1;
+      }
+    }
+
+    // Sessions stay on one worker so their model state is continuous
+    if (options.jobs > 1) {
+      size_t kept = 0;
+      for (const EvalRecord& record : batch) {
+        if (record.session % options.jobs == job) {
+          batch[kept++] = record;
+        }
+      }
+      batch.resize(kept);
+    }
+    result.parse_seconds += secondsSince(start);
+
+    if (!batch.empty()) {
+      out.push(std::move(batch));
+    }
+  }
+  out.close();
+}
+
+// Attack episode bookkeeping per session
+struct EpisodeState {
+  bool active = false;
+  uint32_t start = 0;
+  uint32_t detected = 0;   // Bit per ModelType
+};
+
+// Stage 3: run every model on each record and score it
+static void inferenceStage(const EvalOptions& options, BoundedQueue<Batch>& in, EvalResult& result) {
+  std::unordered_map<uint16_t, EpisodeState> episodes;
+  Batch batch;
+  while (in.pop(batch)) {
+    uint64_t start = hostNanos();
+    for (const EvalRecord& record : batch) {
+      currentState = (SystemState)record.state;
+      SensorData data = {record.current, record.voltage, record.power,
+                         record.frequency, record.temperature, record.timestamp};
+
+      EnhancedMLModel::prepareFeatures(data);
+      if (!options.cascade) {
+        EnhancedMLModel::predictEnsemble(data); // Every member runs, memoized for the hybrid
+      }
+      EnhancedMLModel::predictAdvanced(data);
+
+      bool attack = record.label != 0;
+      EpisodeState& episode = episodes[record.session];
+      if (attack && !episode.active) {
+        episode.active = true;
+        episode.start = record.timestamp;
+        episode.detected = 0;
+        result.episodes++;
+      } else if (!attack) {
+        episode.active = false;
+      }
+      result.records++;
+      result.attack_records += attack;
+
+      for (int t = 0; t < EVAL_MODELS; t++) {
+        ModelMetrics& metrics = result.models[t];
+        float score = EnhancedMLModel::getTickScore((ModelType)t);
+        if (isnan(score)) {
+          metrics.skipped++;
+          continue;
+        }
+
+        bool threat = score > EnhancedMLModel::getDecisionThreshold((ModelType)t);
+        int bin = constrain((int)(score * EVAL_ROC_BINS), 0, EVAL_ROC_BINS);
+        if (attack) {
+          metrics.positives[bin]++;
+          threat ? metrics.tp++ : metrics.fn++;
+          if (threat && !(episode.detected & (1u << t))) {
+            episode.detected |= 1u << t;
+            metrics.episodes_detected++;
+            LatencyStats::record(metrics.time_to_detect, record.timestamp - episode.start);
+          }
+        } else {
+          metrics.negatives[bin]++;
+          threat ? metrics.fp++ : metrics.tn++;
+        }
+      }
+    }
+    result.infer_seconds += secondsSince(start);
+  }
+}
+
+// Binary writer in place of inference (--convert)
+static void convertStage(const EvalOptions& options, BoundedQueue<Batch>& in, EvalResult& result) {
+  FILE* out = fopen(options.convert.c_str(), "wb");
+  if (!out) {
+    fprintf(stderr, "%s: cannot create\n", options.convert.c_str());
+  } else {
+    EvalLogHeader header = {EVAL_LOG_MAGIC, EVAL_LOG_VERSION, sizeof(EvalRecord)};
+    fwrite(&header, sizeof(header), 1, out);
+  }
+  Batch batch;
+  while (in.pop(batch)) {
+    if (out) {
+      fwrite(batch.data(), sizeof(EvalRecord), batch.size(), out);
+    }
+    result.records += batch.size();
+  }
+  if (out) {
+    fclose(out);
+  }
+}
+
+static bool initModels(const EvalOptions& options) {
+  Serial.mute = !options.verbose;
+  SD.root = options.sdRoot;
+  AdvancedThreatDetection::init();
+  if (!EnhancedMLModel::init()) {
+    return false;
+  }
+  EnhancedMLModel::setParallelEnsemble(options.parallel);
+  CascadeConfig cascade = EnhancedMLModel::getCascadeConfig();
+  cascade.enabled = options.cascade;
+  EnhancedMLModel::setCascadeConfig(cascade);
+  EnhancedMLModel::resetInferenceStats();
+  return true;
+}
+
+static void runPipeline(const EvalOptions& options, int job, EvalResult& result) {
+  memset(&result, 0, sizeof(result));
+  for (int t = 0; t < EVAL_MODELS; t++) {
+    LatencyStats::reset(result.models[t].time_to_detect);
+  }
+
+  BoundedQueue<Chunk> chunks;
+  BoundedQueue<Batch> batches;
+  std::thread reader(readerStage, std::cref(options), std::ref(chunks), std::ref(result));
+  std::thread parser(parserStage, std::cref(options), job, std::ref(chunks), std::ref(batches), std::ref(result));
+  if (options.convert.empty()) {
+    inferenceStage(options, batches, result);
+  } else {
+    convertStage(options, batches, result);
+  }
+  reader.join();
+  parser.join();
+}
+
+static void mergeResult(EvalResult& total, const EvalResult& part) {
+  total.records += part.records;
+  total.attack_records += part.attack_records;
+  total.episodes += part.episodes;
+  total.bad_lines += part.bad_lines;
+  total.bytes = max(total.bytes, part.bytes); // Every worker reads every file
+  total.read_seconds += part.read_seconds;
+  total.parse_seconds += part.parse_seconds;
+  total.infer_seconds += part.infer_seconds;
+  for (int t = 0; t < EVAL_MODELS; t++) {
+    ModelMetrics& a = total.models[t];
+    const ModelMetrics& b = part.models[t];
+    a.tp += b.tp;
+    a.fp += b.fp;
+    a.tn += b.tn;
+    a.fn += b.fn;
+    a.skipped += b.skipped;
+    a.episodes_detected += b.episodes_detected;
+    for (int i = 0; i <= EVAL_ROC_BINS; i++) {
+      a.positives[i] += b.positives[i];
+      a.negatives[i] += b.negatives[i];
+    }
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+      a.time_to_detect.buckets[i] += b.time_to_detect.buckets[i];
+    }
+    a.time_to_detect.count += b.time_to_detect.count;
+    a.time_to_detect.total += b.time_to_detect.total;
+    a.time_to_detect.max = max(a.time_to_detect.max, b.time_to_detect.max);
+  }
+}
+
+static bool runWorkers(const EvalOptions& options, EvalResult& total) {
+  memset(&total, 0, sizeof(total));
+  if (options.jobs == 1) {
+    if (options.convert.empty() && !initModels(options)) {
+      return false;
+    }
+    runPipeline(options, 0, total);
+    return true;
+  }
+
+  // Fork before any model thread exists; each child is one device
+  std::vector<std::pair<pid_t, int>> workers;
+  for (int job = 0; job < options.jobs; job++) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+      perror("pipe");
+      return false;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(fds[0]);
+      std::unique_ptr<EvalResult> result(new EvalResult());
+      if (!initModels(options)) {
+        _exit(1);
+      }
+      runPipeline(options, job, *result);
+      const char* p = (const char*)result.get();
+      for (size_t left = sizeof(EvalResult); left > 0;) {
+        ssize_t n = write(fds[1], p, left);
+        if (n <= 0) {
+          _exit(1);
+        }
+        p += n;
+        left -= n;
+      }
+      _exit(0);
+    }
+    close(fds[1]);
+    workers.push_back({pid, fds[0]});
+  }
+
+  bool ok = true;
+  std::unique_ptr<EvalResult> part(new EvalResult());
+  for (auto& worker : workers) {
+    char* p = (char*)part.get();
+    size_t left = sizeof(EvalResult);
+    while (left > 0) {
+      ssize_t n = read(worker.second, p, left);
+      if (n <= 0) {
+        break;
+      }
+      p += n;
+      left -= n;
+    }
+    close(worker.second);
+    int status = 0;
+    waitpid(worker.first, &status, 0);
+    if (left != 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      fprintf(stderr, "worker %d failed\n", (int)worker.first);
+      ok = false;
+      continue;
+    }
+    mergeResult(total, *part);
+  }
+  return ok;
+}
+
+// Area under the ROC curve from the score histograms (trapezoids)
+static double rocArea(const ModelMetrics& m) {
+  uint64_t positives = m.tp + m.fn;
+  uint64_t negatives = m.fp + m.tn;
+  if (positives == 0 || negatives == 0) {
+    return NAN;
+  }
+  double area = 0.0;
+  double tpr = 0.0;
+  double fpr = 0.0;
+  uint64_t tp = 0;
+  uint64_t fp = 0;
+  for (int i = EVAL_ROC_BINS; i >= 0; i--) {
+    tp += m.positives[i];
+    fp += m.negatives[i];
+    double nextTpr = (double)tp / positives;
+    double nextFpr = (double)fp / negatives;
+    area += (nextFpr - fpr) * (tpr + nextTpr) / 2.0;
+    tpr = nextTpr;
+    fpr = nextFpr;
+  }
+  return area;
+}
+
+// True/false positive rate for score >= threshold
+static void rocPoint(const ModelMetrics& m, float threshold, double* tpr, double* fpr) {
+  uint64_t tp = 0;
+  uint64_t fp = 0;
+  for (int i = (int)(threshold * EVAL_ROC_BINS); i <= EVAL_ROC_BINS; i++) {
+    tp += m.positives[i];
+    fp += m.negatives[i];
+  }
+  uint64_t positives = m.tp + m.fn;
+  uint64_t negatives = m.fp + m.tn;
+  *tpr = positives ? (double)tp / positives : NAN;
+  *fpr = negatives ? (double)fp / negatives : NAN;
+}
+
+static void printReport(const EvalOptions& options, const EvalResult& r, double wallSeconds) {
+  printf("Evaluated %llu records (%llu attack, %llu episodes) in %.2f s: %.0f samples/s, %d job%s%s\n",
+         (unsigned long long)r.records, (unsigned long long)r.attack_records,
+         (unsigned long long)r.episodes, wallSeconds, r.records / wallSeconds, options.jobs,
+         options.jobs == 1 ? "" : "s", options.cascade ? ", cascade on" : "");
+  if (r.bad_lines) {
+    printf("Skipped %llu malformed lines\n", (unsigned long long)r.bad_lines);
+  }
+  printf("Stage busy time: read %.2f s (%.0f MB/s), parse %.2f s, inference %.2f s "
+         "(%.0f samples/s per job)\n",
+         r.read_seconds, r.bytes / 1e6 / max(r.read_seconds, 1e-9), r.parse_seconds,
+         r.infer_seconds, r.records / max(r.infer_seconds, 1e-9));
+
+  printf("\nModel             TP         FP         TN         FN    TPR    FPR   Prec    AUC"
+         "  Episodes  TTD p50/p90/max ms\n");
+  for (int t = 0; t < EVAL_MODELS; t++) {
+    const ModelMetrics& m = r.models[t];
+    const char* name = EnhancedMLModel::getModelName((ModelType)t);
+    if (m.tp + m.fp + m.tn + m.fn == 0) {
+      printf("%-12s  not evaluated (%llu ticks skipped)\n", name, (unsigned long long)m.skipped);
+      continue;
+    }
+    double tpr = (m.tp + m.fn) ? (double)m.tp / (m.tp + m.fn) : NAN;
+    double fpr = (m.fp + m.tn) ? (double)m.fp / (m.fp + m.tn) : NAN;
+    double precision = (m.tp + m.fp) ? (double)m.tp / (m.tp + m.fp) : NAN;
+    printf("%-12s %10llu %10llu %10llu %10llu  %5.3f  %5.3f  %5.3f  %5.3f  %4llu/%-4llu  %u/%u/%u\n",
+           name, (unsigned long long)m.tp, (unsigned long long)m.fp, (unsigned long long)m.tn,
+           (unsigned long long)m.fn, tpr, fpr, precision, rocArea(m),
+           (unsigned long long)m.episodes_detected, (unsigned long long)r.episodes,
+           LatencyStats::percentile(m.time_to_detect, 0.5),
+           LatencyStats::percentile(m.time_to_detect, 0.9), m.time_to_detect.max);
+    if (m.skipped) {
+      printf("%-12s (%llu ticks not run)\n", "", (unsigned long long)m.skipped);
+    }
+  }
+
+  printf("\nROC points (TPR/FPR at score threshold)\nModel       ");
+  for (int i = 1; i <= EVAL_ROC_POINTS; i++) {
+    printf("      %.1f    ", i / 10.0);
+  }
+  printf("\n");
+  for (int t = 0; t < EVAL_MODELS; t++) {
+    const ModelMetrics& m = r.models[t];
+    if (m.tp + m.fp + m.tn + m.fn == 0) {
+      continue;
+    }
+    printf("%-12s", EnhancedMLModel::getModelName((ModelType)t));
+    for (int i = 1; i <= EVAL_ROC_POINTS; i++) {
+      double tpr, fpr;
+      rocPoint(m, i / 10.0f, &tpr, &fpr);
+      printf("  %5.3f/%5.3f", tpr, fpr);
+    }
+    printf("\n");
+  }
+}
+
+static bool parseOptions(int argc, char** argv, EvalOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--jobs" && hasValue) {
+      options.jobs = max(1, atoi(argv[++i]));
+    } else if (arg == "--cascade") {
+      options.cascade = true;
+    } else if (arg == "--parallel") {
+      options.parallel = true;
+    } else if (arg == "--verbose") {
+      options.verbose = true;
+    } else if (arg == "--sd" && hasValue) {
+      options.sdRoot = argv[++i];
+    } else if (arg == "--convert" && hasValue) {
+      options.convert = argv[++i];
+    } else if (arg.compare(0, 2, "--") == 0) {
+      return false;
+    } else {
+      options.files.push_back(arg);
+    }
+  }
+  if (!options.convert.empty()) {
+    options.jobs = 1;
+  }
+  return !options.files.empty();
+}
+
+int main(int argc, char** argv) {
+  EvalOptions options;
+  if (!parseOptions(argc, argv, options)) {
+    fprintf(stderr, "usage: %s [--jobs N] [--cascade] [--parallel] [--sd DIR] [--convert OUT] "
+                    "[--verbose] log.csv|log.bin ...\n", argv[0]);
+    return 2;
+  }
+
+  std::unique_ptr<EvalResult> result(new EvalResult());
+  uint64_t start = hostNanos();
+  bool ok = runWorkers(options, *result);
+  double wall = secondsSince(start);
+
+  if (!options.convert.empty()) {
+    printf("Wrote %llu records to %s in %.2f s\n", (unsigned long long)result->records,
+           options.convert.c_str(), wall);
+  } else if (ok) {
+    printReport(options, *result, wall);
+  }
+
+  // Model tasks are still parked on their notifications; do not join them
+  fflush(stdout);
+  _exit(ok ? 0 : 1);
+}
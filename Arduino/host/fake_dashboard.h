@@ -0,0 +1,83 @@
+/*
+ * fake_dashboard.h - Host Check Helpers for fake_dashboard.py
+ *
+ * This file lets a host check steer the fake dashboard (/control), read its
+ * counters (/stats, /log) and build the bodies it verifies.
+ *
+ * Usage:
+ * 1. Start fake_dashboard.py, then FakeDashboard::begin(port)
+ * 2. FakeDashboard::control("status=503&latency_ms=20")
+ * 3. FakeDashboard::stat("corrupt") after the run
+ */
+
+#ifndef FAKE_DASHBOARD_H
+#define FAKE_DASHBOARD_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <string>
+
+class FakeDashboard {
+public:
+  static void begin(uint16_t port) { _port() = port; }
+  static uint16_t port() { return _port(); }
+  static String url() { return "http://127.0.0.1:" + String((unsigned)_port()); }
+
+  // GET on a fresh connection; returns the body ("" when unreachable)
+  static std::string get(const std::string& path) {
+    WiFiClient client;
+    if (!client.connect("127.0.0.1", _port(), 2000)) {
+      return "";
+    }
+    std::string request = "GET " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+    client.write((const uint8_t*)request.data(), request.size());
+    std::string reply;
+    uint8_t buffer[512];
+    unsigned long start = millis();
+    while (millis() - start < 5000) {
+      int n = client.read(buffer, sizeof(buffer));
+      if (n > 0) {
+        reply.append((const char*)buffer, n);
+      } else if (!client.connected()) {
+        break;
+      } else {
+        delay(1);
+      }
+    }
+    size_t body = reply.find("\r\n\r\n");
+    return body == std::string::npos ? "" : reply.substr(body + 4);
+  }
+
+  static void control(const std::string& query) { get("/control?" + query); }
+
+  // Counter from /stats ({"key": n, ...}); 0 when absent
+  static long stat(const std::string& key) {
+    std::string stats = get("/stats");
+    size_t at = stats.find("\"" + key + "\": ");
+    return at == std::string::npos ? 0 : atol(stats.c_str() + at + key.size() + 4);
+  }
+
+  // application/x-test-pattern body: id, then (id * 31 + k) & 0xFF
+  static void fillPattern(uint8_t* out, size_t length, uint32_t id) {
+    for (size_t k = 0; k < length; k++) {
+      out[k] = k < 4 ? (uint8_t)(id >> (8 * k)) : (uint8_t)(id * 31 + k);
+    }
+  }
+
+  // The "pad" string (4-9 KB) fake_dashboard.py expects next to "seq" in a JSON body
+  static std::string pad(uint32_t seq) {
+    std::string text;
+    for (uint32_t i = 0; i < seq % 5000 + 4000; i++) {
+      text += (char)('a' + (seq * 7 + i) % 26);
+    }
+    return text;
+  }
+
+private:
+  static uint16_t& _port() {
+    static uint16_t port = 8080;
+    return port;
+  }
+};
+
+#endif // FAKE_DASHBOARD_H
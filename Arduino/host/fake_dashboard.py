@@ -0,0 +1,301 @@
+#!/usr/bin/env python3
+"""
+Scriptable stand-in for the dashboard API, used by the host checks in this
+directory (see each check's Usage section)
+
+Serves /api/data, /api/alerts, /api/status, /api/commands (long-poll) and
+/api/commands/stream (Server-Sent Events) over HTTP/1.1 keep-alive, or TLS 1.2
+with --tls. A check steers it at run time through /control and reads the
+counters from /stats.
+
+Control keys (GET /control?key=value&...):
+  status        status code for API requests (default 200)
+  gzip_status   status for gzip-encoded requests (default: status)
+  latency_ms    delay before every API response
+  fail          the next N API requests get no response (connection closed)
+  fail_every    1 in N telemetry/bulk requests gets a 503 (alerts never)
+  retry_after   seconds sent as Retry-After with 429 and 503 answers
+  reply_pad     bytes of filler ("pad") added to every API reply
+  reset         clear the counters and the request log
+
+Checked bodies:
+  application/x-test-pattern   bytes 0-3 are a little-endian id, byte k is
+                               (id * 31 + k) & 0xFF
+  JSON with "seq" and "pad"    pad must be test_pad(seq)
+"""
+
+import argparse
+import gzip
+import json
+import random
+import socket
+import socketserver
+import ssl
+import threading
+import time
+import http.server
+from urllib.parse import urlparse, parse_qs
+
+HEARTBEAT_S = 15
+
+state = {"status": 200, "gzip_status": None, "latency_ms": 0, "fail": 0, "fail_every": 0, "retry_after": 0,
+         "reply_pad": 0}
+stats = {}
+log = []
+lock = threading.Condition()
+commands = []
+
+
+def test_pad(seq):
+    """Deterministic 4-9 KB filler a check puts in a JSON body next to its seq"""
+    return "".join(chr(97 + (seq * 7 + i) % 26) for i in range(seq % 5000 + 4000))
+
+
+def count(key, n=1):
+    stats[key] = stats.get(key, 0) + n
+
+
+def check_body(content_type, body):
+    """True/False for bodies a check can verify, None for anything else"""
+    if not body:
+        return None
+    if content_type == "application/x-test-pattern":
+        if len(body) < 4:
+            return False
+        ident = int.from_bytes(body[:4], "little")
+        return all(body[k] == (ident * 31 + k) & 0xFF for k in range(4, len(body)))
+    if content_type.startswith("application/json"):
+        try:
+            doc = json.loads(body)
+        except ValueError:
+            return False
+        if isinstance(doc, dict) and "seq" in doc and "pad" in doc:
+            return doc["pad"] == test_pad(doc["seq"])
+    return None
+
+
+def producer(low, high, burst, seed):
+    """Queues `burst` STOP commands every low..high seconds"""
+    rng = random.Random(seed)
+    n = 0
+    while True:
+        time.sleep(rng.uniform(low, high))
+        with lock:
+            for _ in range(burst):
+                n += 1
+                commands.append({"id": f"cmd_{n}", "command": "STOP", "parameters": {},
+                                 "queued_at": int(time.time() * 1000)})
+            lock.notify_all()
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    server_version = "FakeDashboard/1.0"
+
+    def log_message(self, *args):
+        pass
+
+    def _send(self, code, body=b"", content_type="application/json", headers=None):
+        self.send_response(code)
+        self.send_header("Content-Type", content_type)
+        self.send_header("Content-Length", str(len(body)))
+        for name, value in (headers or {}).items():
+            self.send_header(name, value)
+        close_every = self.server.options.close_every
+        if close_every and stats.get("responses", 0) % close_every == close_every - 1:
+            self.send_header("Connection", "close")
+            self.close_connection = True
+        count("responses")
+        self.end_headers()
+        self.wfile.write(body)
+
+    def _read_body(self):
+        if self.headers.get("Transfer-Encoding", "").lower() == "chunked":
+            body = b""
+            while True:
+                size = int(self.rfile.readline().strip() or b"0", 16)
+                if size == 0:
+                    self.rfile.readline()
+                    return body
+                body += self.rfile.read(size)
+                self.rfile.readline()
+        return self.rfile.read(int(self.headers.get("Content-Length", 0) or 0))
+
+    def _chunk(self, text):
+        data = text.encode()
+        self.wfile.write(b"%x\r\n%s\r\n" % (len(data), data))
+        self.wfile.flush()
+
+    def _control(self, query):
+        with lock:
+            for key, values in query.items():
+                if key == "reset":
+                    stats.clear()
+                    log.clear()
+                elif key in state:
+                    state[key] = int(values[0])
+            body = json.dumps(state).encode()
+        self._send(200, body)
+
+    def _api(self, method, path):
+        body = self._read_body() if method in ("POST", "PUT") else b""
+        encoding = self.headers.get("Content-Encoding", "identity")
+        content_type = self.headers.get("Content-Type", "")
+        with lock:
+            count("requests")
+            count(f"{method} {path}")
+            latency = state["latency_ms"]
+            if state["fail"] > 0:
+                state["fail"] -= 1
+                count("dropped")
+                self.close_connection = True
+                return
+        if latency:
+            time.sleep(latency / 1000.0)
+
+        entry = {"method": method, "path": path, "encoding": encoding, "type": content_type, "sent": len(body)}
+        if encoding == "gzip":
+            try:
+                body = gzip.decompress(body)
+            except OSError:
+                entry["inflated"] = False
+        entry["size"] = len(body)
+        ok = check_body(content_type, body) if entry.get("inflated", True) else False
+        if ok is not None:
+            entry["body_ok"] = ok
+            count("bodies")
+            count("corrupt", 0 if ok else 1)
+
+        with lock:
+            code = state["status"]
+            if encoding == "gzip" and state["gzip_status"] is not None:
+                code = state["gzip_status"]
+            if (code < 300 and path != "/api/alerts" and state["fail_every"] and
+                    random.randrange(state["fail_every"]) == 0):
+                code = 503
+            entry["status"] = code
+            log.append(entry)
+            del log[:-1000]
+            retry_after = state["retry_after"]
+            pad = state["reply_pad"]
+        count(f"status {code}")
+        headers = {"Retry-After": str(retry_after)} if code in (429, 503) and retry_after else None
+        reply = {"success": code < 300}
+        if path == "/api/commands":
+            reply["command"] = None
+        if pad:
+            reply["pad"] = "x" * pad
+        self._send(code, json.dumps(reply, separators=(",", ":")).encode(), headers=headers)
+
+    def _long_poll(self, query):
+        wait = min(float(query.get("wait", ["0"])[0]), 30)
+        deadline = time.time() + wait
+        with lock:
+            count("GET /api/commands")
+            command = commands.pop(0) if commands else None
+            while command is None and time.time() < deadline:
+                lock.wait(deadline - time.time())
+                command = commands.pop(0) if commands else None
+        body = json.dumps({"success": True, "command": command}, separators=(",", ":")).encode()
+        self._send(200, body)
+
+    def _stream(self):
+        count("GET /api/commands/stream")
+        if self.headers.get("Last-Event-ID"):
+            count("stream resumed with Last-Event-ID")
+        mode = self.server.options.stream
+        if mode == "off":
+            self._send(404)
+            return
+        self.send_response(200)
+        self.send_header("Content-Type", "text/event-stream")
+        self.send_header("Transfer-Encoding", "chunked")
+        self.end_headers()
+        self._chunk(f"retry: 1000\nevent: ready\ndata: {{\"heartbeat\":{HEARTBEAT_S}}}\n\n")
+        opened = last = time.time()
+        try:
+            while True:
+                if mode == "silent" and time.time() - opened > 5:
+                    time.sleep(0.5)      # Half-open connection: nothing more arrives
+                    continue
+                with lock:
+                    lock.wait(0.5)
+                    pending = commands[:]
+                    commands.clear()
+                for command in pending:
+                    self._chunk(f"event: command\nid: {command['id']}\ndata: {json.dumps(command)}\n\n")
+                if time.time() - last >= HEARTBEAT_S:
+                    self._chunk(f": heartbeat {int(time.time() * 1000)}\n\n")
+                    last = time.time()
+        except OSError:
+            return
+
+    def do_GET(self):
+        url = urlparse(self.path)
+        query = parse_qs(url.query)
+        if url.path == "/control":
+            self._control(query)
+        elif url.path == "/stats":
+            with lock:
+                body = json.dumps(stats).encode()
+            self._send(200, body)
+        elif url.path == "/log":
+            with lock:
+                body = json.dumps(log).encode()
+                log.clear()
+            self._send(200, body)
+        elif url.path == "/api/commands/stream":
+            self._stream()
+        elif url.path == "/api/commands" and "wait" in query:
+            self._long_poll(query)
+        else:
+            self._api("GET", url.path)
+
+    def do_POST(self):
+        self._api("POST", urlparse(self.path).path)
+
+    def do_PUT(self):
+        self._api("PUT", urlparse(self.path).path)
+
+    def do_DELETE(self):
+        self._api("DELETE", urlparse(self.path).path)
+
+
+class Server(socketserver.ThreadingMixIn, http.server.HTTPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+
+    def get_request(self):
+        conn, address = self.socket.accept()
+        conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        if self.context:
+            conn = self.context.wrap_socket(conn, server_side=True)
+        return conn, address
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--tls", nargs=2, metavar=("CERT", "KEY"), help="serve TLS 1.2 with this certificate")
+    parser.add_argument("--close-every", type=int, default=0, help="answer every Nth response with Connection: close")
+    parser.add_argument("--stream", choices=["on", "off", "silent"], default="on",
+                        help="command stream: served, 404, or goes quiet after 5 s (half-open)")
+    parser.add_argument("--commands", nargs=3, type=float, metavar=("MIN_S", "MAX_S", "BURST"),
+                        help="queue BURST STOP commands every MIN_S..MAX_S seconds")
+    options = parser.parse_args()
+
+    server = Server(("127.0.0.1", options.port), Handler)
+    server.options = options
+    server.context = None
+    if options.tls:
+        server.context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        server.context.maximum_version = ssl.TLSVersion.TLSv1_2
+        server.context.load_cert_chain(*options.tls)
+    if options.commands:
+        low, high, burst = options.commands
+        threading.Thread(target=producer, args=(low, high, int(burst), options.port), daemon=True).start()
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
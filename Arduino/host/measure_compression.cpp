@@ -0,0 +1,557 @@
+/*
+ * measure_compression.cpp - Upload Compression Measurement
+ *
+ * This program replays session logs through the uploads the station makes
+ * and compresses every body with the firmware's DeflateWriter, the way
+ * APIManager does before sending it. It reports what compression gains on
+ * those sessions before the setting is changed on the fleet.
+ *
+ * Features:
+ * - The bodies the station sends, built with the firmware's encoders
+ *   (TelemetryBatcher::appendFrames, MsgPackWriter): live MessagePack
+ *   (sendBinaryTelemetry) and JSON (sendToDashboard) uploads of
+ *   TELEMETRY_BATCH_FRAMES frames, and spooled backlog of
+ *   TELEMETRY_MAX_FRAMES_PER_UPLOAD frames as drainSpool() sends it
+ * - Log uploads: SDLogger sensor_data.csv lines, cut into --log-chunk bytes
+ * - Same rules as the station: bodies below APIManager::compressMinBytes()
+ *   for their content type go as is, and so do bodies that do not fit
+ *   API_COMPRESS_BUFFER or do not shrink
+ * - Body size range per kind of upload, compression ratio, cycles per KB of
+ *   input (host clock, HOST_CPU_MHZ scale; the station reports its own in
+ *   connection.compression) and the airtime saved at --link-kbps
+ * - --verify inflates every body with zlib and compares it with the input;
+ *   the zlib -6 size is printed for reference
+ *
+ * CSV format (as for evaluate_models):
+ * - Header row naming the columns, in any order
+ * - Required: timestamp (ms), current, voltage, power, frequency, temperature
+ * - Optional: state, label (0 = normal, otherwise the attack type), session,
+ *   prediction, confidence, enhanced_prediction
+ *
+ * Build (from Arduino/):
+ *   g++ -O2 -std=gnu++17 -pthread -Ihost/stubs -IEV_Secure_ESP32S3_Complete \
+ *       host/measure_compression.cpp -o measure_compression \
+ *       -l:libmbedtls.so.14 -l:libmbedx509.so.1 -l:libmbedcrypto.so.7 -lz
+ *
+ * Usage:
+ *   measure_compression [options] log.csv ...
+ *     --synthetic S     also replay a generated S-second charging session
+ *     --min-bytes N     smallest JSON or text body to compress
+ *                       (default API_COMPRESS_MIN_BYTES)
+ *     --min-binary-bytes N  smallest MessagePack body to compress
+ *                       (default API_COMPRESS_MIN_BINARY_BYTES)
+ *     --batch-frames N  frames per live upload (default TELEMETRY_BATCH_FRAMES;
+ *                       threat flushes send fewer)
+ *     --log-chunk N     log upload size in bytes (default 4096)
+ *     --link-kbps N     uplink rate for the airtime estimate (default 1000)
+ *     --verify          check every body with zlib
+ */
+
+#include "APIManager.h"
+#include "TelemetryBatcher.h"
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+SDClass SD;
+WiFiClass WiFi;
+SystemState currentState = STATE_CHARGING;
+
+// Totals of one kind of upload
+struct MeasureTotals {
+  uint64_t bodies;
+  uint64_t compressed;
+  uint64_t skipped;
+  uint64_t raw_bytes;           // All bodies
+  uint64_t sent_bytes;          // All bodies, as sent
+  uint64_t zlib_bytes;          // All bodies at zlib -6, if smaller
+  uint64_t input_bytes;         // Bodies that went through the encoder
+  uint64_t cycles;
+  uint64_t mismatches;
+  size_t min_body;
+  size_t max_body;
+  size_t min_bytes;             // Threshold the bodies were measured against
+  double session_seconds;
+};
+
+struct MeasureOptions {
+  std::vector<std::string> files;
+  int synthetic = 0;
+  size_t minBytes = APIManager::compressMinBytes("application/json");
+  size_t minBinaryBytes = APIManager::compressMinBytes(TELEMETRY_MSGPACK_TYPE);
+  size_t batchFrames = TELEMETRY_BATCH_FRAMES;
+  size_t logChunk = 4096;
+  double linkKbps = 1000;
+  bool verify = false;
+};
+
+static uint8_t compressed[API_COMPRESS_BUFFER];
+static uint8_t msgpackBuffer[TELEMETRY_BINARY_BUFFER];
+static StaticJsonDocument<2048 + TELEMETRY_JSON_FRAMES_BYTES> telemetryDoc;
+
+static std::string serialized(const JsonDocument& doc) {
+  std::string out(measureJson(doc), '\0');
+  serializeJson(doc, &out[0], out.size() + 1);
+  return out;
+}
+
+// Live upload as sendToDashboard() builds it; station health has the same
+// shape every upload and slowly changing values
+static std::string liveJson(const TelemetryFrame* frames, size_t count) {
+  const TelemetryFrame& last = frames[count - 1];
+  JsonDocument& doc = telemetryDoc;
+  doc.clear();
+  doc["device_id"] = DEVICE_ID;
+  doc["session_id"] = "SES_1700000000";
+  doc["timestamp"] = last.timestamp + 40;
+  doc["state"] = last.state;
+  doc["is_charging"] = (last.flags & FRAME_FLAG_CHARGING) != 0;
+  doc["threat_detected"] = (last.flags & FRAME_FLAG_THREAT) != 0;
+
+  JsonObject sensors = doc.createNestedObject("sensor_data");
+  sensors["current"] = last.current;
+  sensors["voltage"] = last.voltage;
+  sensors["power"] = last.power;
+  sensors["frequency"] = last.frequency;
+  sensors["temperature"] = last.temperature;
+  sensors["timestamp"] = last.timestamp;
+
+  JsonObject system = doc.createNestedObject("system_data");
+  system["wifi_rssi"] = -61;
+  system["uptime"] = last.timestamp + 40;
+  system["free_heap"] = 181244;
+  system["max_alloc_heap"] = 110580;
+  system["cpu_freq"] = 240;
+  JsonObject net = system.createNestedObject("connection");
+  net["requests"] = 412;
+  net["reused"] = 409;
+  net["handshakes"] = 3;
+  net["resumed"] = 2;
+  net["avg_rtt_ms"] = 88;
+  net["min_free_heap"] = 172008;
+  JsonObject queue = net.createNestedObject("queue");
+  queue["depth"] = 0;
+  queue["max_depth"] = 3;
+  queue["avg_wait_ms"] = 4;
+  queue["avg_flight_ms"] = 91;
+  queue["max_flight_ms"] = 640;
+  queue["failed"] = 0;
+  queue["dropped"] = 0;
+  queue["rejected"] = 0;
+  queue["largest_free"] = API_QUEUE_MAX_BYTES;
+  queue["fragmented"] = 0;
+  static const char* const rateClasses[API_CLASS_COUNT] = {"alert", "command", "telemetry", "bulk"};
+  JsonObject rate = queue.createNestedObject("rate");
+  for (int cls = 0; cls < API_CLASS_COUNT; cls++) {
+    JsonArray entry = rate.createNestedArray(rateClasses[cls]);
+    entry.add(cls == API_CLASS_TELEMETRY ? 137 : 0);
+    entry.add(0);
+  }
+  JsonObject gzip = net.createNestedObject("compression");
+  gzip["enabled"] = true;
+  gzip["bodies"] = 137;
+  gzip["raw_bytes"] = 640000;
+  gzip["sent_bytes"] = 120000;
+  gzip["skipped"] = 0;
+  gzip["cycles_per_kb"] = 90000;
+  JsonObject channel = net.createNestedObject("commands");
+  channel["mode"] = "stream";
+  channel["connected"] = true;
+  channel["requests_per_hour"] = 1;
+  channel["timeouts"] = 0;
+  channel["dropped"] = 0;
+  JsonObject spool = system.createNestedObject("spool");
+  spool["bytes"] = 0;
+  spool["drain_per_min"] = 0;
+  spool["last_lag_ms"] = 0;
+  spool["max_lag_ms"] = 0;
+  spool["lost_segments"] = 0;
+  spool["skipped"] = 0;
+  static const char* const models[] = {"lstm", "autoencoder", "ensemble", "rules", "trees", "hybrid"};
+  JsonObject inference = system.createNestedObject("inference");
+  for (const char* model : models) {
+    JsonArray entry = inference.createNestedArray(model);
+    entry.add(412);
+    entry.add(1290);
+    entry.add(2231);
+    entry.add(18432);
+  }
+
+  JsonObject ml = doc.createNestedObject("ml_prediction");
+  ml["standard_prediction"] = last.prediction;
+  ml["standard_confidence"] = last.confidence;
+  ml["enhanced_prediction"] = last.enhanced_prediction;
+  ml["enhanced_confidence"] = last.confidence;
+  ml["enhanced_uncertainty"] = 0.05f;
+  ml["attack_type"] = last.attack_type;
+  ml["attack_confidence"] = last.attack_type ? last.confidence : 0.0f;
+  ml["is_anomaly"] = last.attack_type != 0;
+  ml["early_exit_rate"] = 0.8f;
+  ml["threat_level"] = (last.flags & FRAME_FLAG_THREAT) ? "HIGH" : "NORMAL";
+  ml["timestamp"] = last.timestamp;
+  TelemetryBatcher::appendFrames(doc, frames, count);
+  return serialized(doc);
+}
+
+// Live upload as sendBinaryTelemetry() builds it
+static std::string liveBinary(const TelemetryFrame* frames, size_t count) {
+  const TelemetryFrame& last = frames[count - 1];
+  MsgPackWriter out(msgpackBuffer, sizeof(msgpackBuffer));
+  out.writeMap(TELEMETRY_BINARY_KEYS);
+  out.writeUInt(TELEMETRY_KEY_DEVICE_ID);
+  out.writeString(DEVICE_ID);
+  out.writeUInt(TELEMETRY_KEY_SESSION_ID);
+  out.writeString("SES_1700000000");
+  out.writeUInt(TELEMETRY_KEY_TIMESTAMP);
+  out.writeUInt(last.timestamp + 40);
+  out.writeUInt(TELEMETRY_KEY_STATE);
+  out.writeUInt(last.state);
+  out.writeUInt(TELEMETRY_KEY_CHARGING);
+  out.writeBool((last.flags & FRAME_FLAG_CHARGING) != 0);
+  out.writeUInt(TELEMETRY_KEY_THREAT);
+  out.writeBool((last.flags & FRAME_FLAG_THREAT) != 0);
+  out.writeUInt(TELEMETRY_KEY_SYSTEM);
+  out.writeArray(4);
+  out.writeInt(-61);
+  out.writeUInt(last.timestamp + 40);
+  out.writeUInt(181244);
+  out.writeUInt(240);
+  out.writeUInt(TELEMETRY_KEY_ML);
+  out.writeArray(9);
+  out.writeFloat(last.prediction);
+  out.writeFloat(last.confidence);
+  out.writeFloat(last.enhanced_prediction);
+  out.writeFloat(last.confidence);
+  out.writeFloat(0.05f);
+  out.writeUInt(last.attack_type);
+  out.writeFloat(last.attack_type ? last.confidence : 0.0f);
+  out.writeBool(last.attack_type != 0);
+  out.writeFloat(0.8f);
+  TelemetryBatcher::appendFrames(out, frames, count);
+  return std::string((const char*)out.data(), out.length());
+}
+
+// Spooled backlog as drainSpool() builds it (frames only)
+static std::string backlogJson(const TelemetryFrame* frames, size_t count, uint32_t seq) {
+  const TelemetryFrame& latest = frames[count - 1];
+  JsonDocument& doc = telemetryDoc;
+  doc.clear();
+  doc["device_id"] = DEVICE_ID;
+  doc["timestamp"] = latest.timestamp + 3600000;
+  doc["spooled"] = seq;
+  JsonObject sensors = doc.createNestedObject("sensor_data");
+  sensors["current"] = latest.current;
+  sensors["voltage"] = latest.voltage;
+  sensors["power"] = latest.power;
+  sensors["frequency"] = latest.frequency;
+  sensors["temperature"] = latest.temperature;
+  sensors["timestamp"] = latest.timestamp;
+  TelemetryBatcher::appendFrames(doc, frames, count);
+  return serialized(doc);
+}
+
+static std::string backlogBinary(const TelemetryFrame* frames, size_t count, uint32_t seq) {
+  MsgPackWriter out(msgpackBuffer, sizeof(msgpackBuffer));
+  out.writeMap(6);
+  out.writeUInt(TELEMETRY_KEY_DEVICE_ID);
+  out.writeString(DEVICE_ID);
+  out.writeUInt(TELEMETRY_KEY_TIMESTAMP);
+  out.writeUInt(frames[count - 1].timestamp + 3600000);
+  out.writeUInt(TELEMETRY_KEY_SPOOLED);
+  out.writeUInt(seq);
+  TelemetryBatcher::appendFrames(out, frames, count);
+  return std::string((const char*)out.data(), out.length());
+}
+
+// sensor_data.csv as SDLogger writes it (_formatSensorData)
+static std::string logCsv(const std::vector<TelemetryFrame>& frames) {
+  std::string out = "Timestamp,Current,Voltage,Power,Frequency,Temperature\n";
+  char line[128];
+  for (const TelemetryFrame& frame : frames) {
+    snprintf(line, sizeof(line), "%lu,%.3f,%.1f,%.1f,%.1f,%.1f\n", (unsigned long)frame.timestamp,
+             frame.current, frame.voltage, frame.power, frame.frequency, frame.temperature);
+    out += line;
+  }
+  return out;
+}
+
+static void measureBody(const std::string& body, size_t minBytes, const MeasureOptions& options,
+                        MeasureTotals& totals) {
+  totals.bodies++;
+  totals.min_bytes = minBytes;
+  totals.min_body = totals.bodies == 1 ? body.size() : min(totals.min_body, body.size());
+  totals.max_body = max(totals.max_body, body.size());
+  totals.raw_bytes += body.size();
+
+  uLongf zlibLength = compressBound(body.size()) + 18;
+  std::vector<uint8_t> reference(zlibLength);
+  compress2(reference.data(), &zlibLength, (const Bytef*)body.data(), body.size(), 6);
+  totals.zlib_bytes += min((size_t)zlibLength + 18 - 6, body.size());    // zlib to gzip framing
+
+  if (body.size() < minBytes) {
+    totals.sent_bytes += body.size();
+    return;
+  }
+
+  uint32_t start = ESP.getCycleCount();
+  DeflateWriter out(compressed, sizeof(compressed));
+  out.write((const uint8_t*)body.data(), body.size());
+  out.finish();
+  totals.cycles += ESP.getCycleCount() - start;
+  totals.input_bytes += body.size();
+
+  if (out.overflowed() || out.length() >= body.size()) {
+    totals.skipped++;
+    totals.sent_bytes += body.size();
+    return;
+  }
+  totals.compressed++;
+  totals.sent_bytes += out.length();
+
+  if (options.verify) {
+    std::vector<uint8_t> inflated(body.size() + 1);
+    z_stream stream = {};
+    inflateInit2(&stream, 16 + MAX_WBITS);
+    stream.next_in = (Bytef*)out.data();
+    stream.avail_in = out.length();
+    stream.next_out = inflated.data();
+    stream.avail_out = inflated.size();
+    int status = inflate(&stream, Z_FINISH);
+    if (status != Z_STREAM_END || stream.total_out != body.size() ||
+        memcmp(inflated.data(), body.data(), body.size()) != 0) {
+      totals.mismatches++;
+    }
+    inflateEnd(&stream);
+  }
+}
+
+// Every upload a session makes: live batches of --batch-frames, the
+// same frames as spooled backlog (TELEMETRY_MAX_FRAMES_PER_UPLOAD per
+// upload) and the CSV log
+struct SessionTotals {
+  MeasureTotals liveBinary;
+  MeasureTotals liveJson;
+  MeasureTotals backlogBinary;
+  MeasureTotals backlogJson;
+  MeasureTotals logs;
+};
+
+static void measureSession(const std::vector<TelemetryFrame>& frames, const MeasureOptions& options,
+                           SessionTotals& totals) {
+  if (frames.empty()) {
+    return;
+  }
+  double seconds = (frames.back().timestamp - frames.front().timestamp + DATA_TRANSMISSION_INTERVAL) / 1000.0;
+  size_t jsonMin = options.minBytes;
+  size_t binaryMin = options.minBinaryBytes;
+
+  for (size_t first = 0; first < frames.size(); first += options.batchFrames) {
+    size_t count = min(options.batchFrames, frames.size() - first);
+    measureBody(liveBinary(&frames[first], count), binaryMin, options, totals.liveBinary);
+    measureBody(liveJson(&frames[first], count), jsonMin, options, totals.liveJson);
+  }
+  uint32_t seq = 1;
+  for (size_t first = 0; first < frames.size(); first += TELEMETRY_MAX_FRAMES_PER_UPLOAD, seq++) {
+    size_t count = min((size_t)TELEMETRY_MAX_FRAMES_PER_UPLOAD, frames.size() - first);
+    measureBody(backlogBinary(&frames[first], count, seq), binaryMin, options, totals.backlogBinary);
+    measureBody(backlogJson(&frames[first], count, seq), jsonMin, options, totals.backlogJson);
+  }
+
+  std::string log = logCsv(frames);
+  for (size_t offset = 0; offset < log.size(); offset += options.logChunk) {
+    measureBody(log.substr(offset, options.logChunk), APIManager::compressMinBytes("text/csv"), options,
+                totals.logs);
+  }
+  for (MeasureTotals* kind : {&totals.liveBinary, &totals.liveJson, &totals.backlogBinary, &totals.backlogJson,
+                              &totals.logs}) {
+    kind->session_seconds += seconds;
+  }
+}
+
+// A charging session: slow drift, sensor noise and one short attack episode
+static std::vector<TelemetryFrame> syntheticSession(int seconds) {
+  std::mt19937 random(12345);
+  std::normal_distribution<float> noise(0.0f, 1.0f);
+  std::vector<TelemetryFrame> frames;
+  float temperature = 31.0f;
+  for (int t = 0; t * DATA_TRANSMISSION_INTERVAL < seconds * 1000; t++) {
+    TelemetryFrame frame = {};
+    bool attack = t % 900 >= 600 && t % 900 < 615;
+    frame.timestamp = 120000 + t * DATA_TRANSMISSION_INTERVAL + (uint32_t)(random() % 7);
+    frame.current = 16.0f + 0.08f * noise(random) + (attack ? 9.0f : 0.0f);
+    frame.voltage = 230.0f + 0.6f * noise(random);
+    frame.power = frame.current * frame.voltage;
+    frame.frequency = 50.0f + 0.02f * noise(random);
+    temperature += 0.002f + 0.01f * noise(random);
+    frame.temperature = temperature;
+    frame.state = attack ? STATE_SUSPICIOUS : STATE_CHARGING;
+    frame.flags = 1 | (attack ? 2 : 0);
+    frame.prediction = attack ? 0.91f + 0.02f * noise(random) : 0.04f + 0.01f * noise(random);
+    frame.confidence = 0.8f + 0.05f * noise(random);
+    frame.enhanced_prediction = frame.prediction * 0.97f;
+    frame.attack_type = attack ? 1 : 0;
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+// Frames per session of one CSV log, in file order
+static bool readSessions(const std::string& path, std::map<int, std::vector<TelemetryFrame>>& sessions) {
+  FILE* file = fopen(path.c_str(), "r");
+  if (!file) {
+    fprintf(stderr, "%s: cannot open\n", path.c_str());
+    return false;
+  }
+
+  // Map the header row; the data starts on the next line
+  enum { TIMESTAMP, CURRENT, VOLTAGE, POWER, FREQUENCY, TEMPERATURE, STATE, LABEL, SESSION,
+         PREDICTION, CONFIDENCE, ENHANCED, COLUMNS };
+  static const char* const names[COLUMNS] = {
+    "timestamp", "current", "voltage", "power", "frequency", "temperature", "state", "label",
+    "session", "prediction", "confidence", "enhanced_prediction"
+  };
+  int column[COLUMNS];
+  for (int i = 0; i < COLUMNS; i++) {
+    column[i] = -1;
+  }
+  char line[512];
+  if (!fgets(line, sizeof(line), file)) {
+    fclose(file);
+    return false;
+  }
+  int index = 0;
+  for (char* name = strtok(line, ",\r\n"); name; name = strtok(nullptr, ",\r\n"), index++) {
+    while (*name == ' ') name++;
+    for (int i = 0; i < COLUMNS; i++) {
+      if (!strcmp(name, names[i])) column[i] = index;
+    }
+  }
+  for (int i = TIMESTAMP; i <= TEMPERATURE; i++) {
+    if (column[i] < 0) {
+      fprintf(stderr, "%s: missing sensor columns in CSV header\n", path.c_str());
+      fclose(file);
+      return false;
+    }
+  }
+
+  while (fgets(line, sizeof(line), file)) {
+    float values[16] = {0};
+    int count = 0;
+    const char* p = line;
+    while (count < 16) {
+      char* end;
+      values[count++] = strtof(p, &end);
+      p = strchr(end, ',');
+      if (!p) {
+        break;
+      }
+      p++;
+    }
+    if (count < index) {
+      continue;
+    }
+
+    auto value = [&](int i, float fallback) { return column[i] >= 0 ? values[column[i]] : fallback; };
+    TelemetryFrame frame = {};
+    int label = (int)value(LABEL, 0);
+    frame.timestamp = (uint32_t)value(TIMESTAMP, 0);
+    frame.current = value(CURRENT, 0);
+    frame.voltage = value(VOLTAGE, 0);
+    frame.power = value(POWER, 0);
+    frame.frequency = value(FREQUENCY, 0);
+    frame.temperature = value(TEMPERATURE, 0);
+    frame.state = (int)value(STATE, STATE_CHARGING);
+    frame.flags = (frame.current > 0.5f ? 1 : 0) | (label ? 2 : 0);
+    frame.prediction = value(PREDICTION, 0);
+    frame.confidence = value(CONFIDENCE, 0);
+    frame.enhanced_prediction = value(ENHANCED, 0);
+    frame.attack_type = label;
+    sessions[(int)value(SESSION, 0)].push_back(frame);
+  }
+  fclose(file);
+  return true;
+}
+
+static void printTotals(const char* name, const MeasureTotals& totals, const MeasureOptions& options) {
+  if (totals.bodies == 0) {
+    return;
+  }
+  double savedSeconds = (totals.raw_bytes - totals.sent_bytes) * 8.0 / (options.linkKbps * 1000);
+  double hours = totals.session_seconds / 3600;
+  printf("%s\n", name);
+  printf("  Bodies:         %llu of %zu-%zu bytes (%llu compressed, %llu skipped, %llu below %zu bytes)\n",
+         (unsigned long long)totals.bodies, totals.min_body, totals.max_body,
+         (unsigned long long)totals.compressed, (unsigned long long)totals.skipped,
+         (unsigned long long)(totals.bodies - totals.compressed - totals.skipped), totals.min_bytes);
+  printf("  Bytes:          %llu -> %llu (%.2fx; zlib -6 %.2fx)\n", (unsigned long long)totals.raw_bytes,
+         (unsigned long long)totals.sent_bytes, (double)totals.raw_bytes / totals.sent_bytes,
+         (double)totals.raw_bytes / totals.zlib_bytes);
+  printf("  Cycles per KB:  %.0f (host)\n", totals.input_bytes ? totals.cycles * 1024.0 / totals.input_bytes : 0.0);
+  printf("  Airtime saved:  %.2f s at %.0f kbit/s (%.2f s per session hour)\n", savedSeconds,
+         options.linkKbps, hours > 0 ? savedSeconds / hours : 0.0);
+  if (options.verify) {
+    printf("  Verified:       %llu mismatches\n", (unsigned long long)totals.mismatches);
+  }
+}
+
+static bool parseOptions(int argc, char** argv, MeasureOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--synthetic" && hasValue) {
+      options.synthetic = max(1, atoi(argv[++i]));
+    } else if (arg == "--min-bytes" && hasValue) {
+      options.minBytes = (size_t)atol(argv[++i]);
+    } else if (arg == "--min-binary-bytes" && hasValue) {
+      options.minBinaryBytes = (size_t)atol(argv[++i]);
+    } else if (arg == "--batch-frames" && hasValue) {
+      options.batchFrames = constrain(atol(argv[++i]), 1L, (long)TELEMETRY_MAX_FRAMES_PER_UPLOAD);
+    } else if (arg == "--log-chunk" && hasValue) {
+      options.logChunk = max(64L, atol(argv[++i]));
+    } else if (arg == "--link-kbps" && hasValue) {
+      options.linkKbps = max(1.0, atof(argv[++i]));
+    } else if (arg == "--verify") {
+      options.verify = true;
+    } else if (arg.compare(0, 2, "--") == 0) {
+      return false;
+    } else {
+      options.files.push_back(arg);
+    }
+  }
+  return !options.files.empty() || options.synthetic > 0;
+}
+
+int main(int argc, char** argv) {
+  MeasureOptions options;
+  if (!parseOptions(argc, argv, options)) {
+    fprintf(stderr, "usage: %s [--synthetic S] [--min-bytes N] [--min-binary-bytes N] [--log-chunk N] "
+                    "[--batch-frames N] [--link-kbps N] [--verify] log.csv ...\n", argv[0]);
+    return 2;
+  }
+
+  SessionTotals totals = {};
+  bool ok = true;
+  for (const std::string& path : options.files) {
+    std::map<int, std::vector<TelemetryFrame>> sessions;
+    ok = readSessions(path, sessions) && ok;
+    for (const auto& session : sessions) {
+      measureSession(session.second, options, totals);
+    }
+  }
+  if (options.synthetic > 0) {
+    measureSession(syntheticSession(options.synthetic), options, totals);
+  }
+
+  printTotals("Live telemetry, MessagePack (sendBinaryTelemetry)", totals.liveBinary, options);
+  printTotals("Live telemetry, JSON (sendToDashboard)", totals.liveJson, options);
+  printTotals("Spooled backlog, MessagePack (drainSpool)", totals.backlogBinary, options);
+  printTotals("Spooled backlog, JSON (drainSpool)", totals.backlogJson, options);
+  printTotals("Log uploads", totals.logs, options);
+  uint64_t mismatches = totals.liveBinary.mismatches + totals.liveJson.mismatches +
+                        totals.backlogBinary.mismatches + totals.backlogJson.mismatches + totals.logs.mismatches;
+  return ok && mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+/*
+ * rate_limit_check.cpp - Request Class Token Bucket Check
+ *
+ * This program sends bursts of each request class through APIManager's
+ * queue to fake_dashboard.py and reports what the token buckets admit,
+ * hold back and let alerts borrow.
+ *
+ * Features:
+ * - Telemetry burst past API_BURST_TELEMETRY: the excess completes with 429
+ * - Bulk uploads past their burst wait in the queue instead of failing
+ * - Alert storm past API_BURST_ALERT: every alert is sent, borrowing tokens
+ * - Threat frames flushing the batcher at a tight telemetry limit: deferred
+ *   batches coalesce and no frame is dropped
+ *
+ * Build (from Arduino/):
+ *   g++ -O1 -std=gnu++17 -pthread -Ihost/stubs -IEV_Secure_ESP32S3_Complete \
+ *       host/rate_limit_check.cpp -o rate_limit_check \
+ *       -l:libmbedtls.so.14 -l:libmbedx509.so.1 -l:libmbedcrypto.so.7
+ *
+ * Usage:
+ *   python3 host/fake_dashboard.py --port 8085 &
+ *   rate_limit_check [options]
+ *     --port N          server port (default 8085)
+ *     --latency MS      server latency (default 30)
+ */
+
+#include "APIManager.h"
+#include "TelemetryBatcher.h"
+#include "fake_dashboard.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+SDClass SD;
+WiFiClass WiFi;
+SystemState currentState = STATE_IDLE;
+
+struct CheckOptions {
+  int port = 8085;
+  int latencyMs = 30;
+};
+
+static int sent = 0;
+static int throttled = 0;
+static int failed = 0;
+static bool uploading = false;
+static size_t uploadFrames = 0;
+
+static void record(const APIResponse& response, void*) {
+  if (response.success) {
+    sent++;
+  } else if (response.statusCode == HTTP_TOO_MANY_REQUESTS) {
+    throttled++;
+  } else {
+    failed++;
+  }
+}
+
+// onTelemetrySent() as the sketch has it
+static void onTelemetry(const APIResponse& response, void*) {
+  uploading = false;
+  if (response.success) {
+    TelemetryBatcher::commit(uploadFrames);
+  } else if (response.statusCode == HTTP_TOO_MANY_REQUESTS) {
+    TelemetryBatcher::defer(max(APIManager::getRateWait(API_CLASS_TELEMETRY), 200UL));
+  } else {
+    TelemetryBatcher::flushFailed();
+  }
+}
+
+static void run(unsigned long ms) {
+  for (unsigned long start = millis(); millis() - start < ms;) {
+    APIManager::poll();
+    delay(5);
+  }
+}
+
+static void runUntil(int done) {
+  for (unsigned long start = millis(); sent + throttled + failed < done && millis() - start < 60000;) {
+    run(50);
+  }
+}
+
+static void reset() {
+  sent = throttled = failed = 0;
+}
+
+static void printRates(const char* title) {
+  static const char* names[] = {"alert", "command", "telemetry", "bulk"};
+  printf("%s\n", title);
+  for (int cls = 0; cls < API_CLASS_COUNT; cls++) {
+    APIRateStats stats = APIManager::getRateStats((APIRequestClass)cls);
+    printf("  %-9s admitted %3u, deferred %3u, bypassed %u\n", names[cls], stats.admitted, stats.deferred,
+           stats.bypassed);
+  }
+}
+
+static bool parseOptions(int argc, char** argv, CheckOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--port" && hasValue) {
+      options.port = atoi(argv[++i]);
+    } else if (arg == "--latency" && hasValue) {
+      options.latencyMs = atoi(argv[++i]);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  CheckOptions options;
+  if (!parseOptions(argc, argv, options)) {
+    fprintf(stderr, "usage: %s [--port N] [--latency MS]\n", argv[0]);
+    return 2;
+  }
+  setvbuf(stdout, nullptr, _IONBF, 0);
+  Serial.mute = true;
+  FakeDashboard::begin(options.port);
+  FakeDashboard::control("reset=1&status=200&fail=0&fail_every=0&latency_ms=" + std::to_string(options.latencyMs));
+  APIManager::enableSSL(false);
+  APIManager::setServerURL(FakeDashboard::url());
+  if (!APIManager::init()) {
+    fprintf(stderr, "fake dashboard not reachable on port %d\n", options.port);
+    return 1;
+  }
+  APIManager::begin();
+  uint8_t body[100] = {};
+
+  // 1. Telemetry burst: API_BURST_TELEMETRY tokens, the rest back as 429
+  for (int i = 0; i < 8; i++) {
+    APIManager::sendDataAsync(body, sizeof(body), "application/json", record, nullptr);
+  }
+  runUntil(8);
+  printf("telemetry burst of 8: %d sent, %d throttled (429), %d failed or evicted\n", sent, throttled, failed);
+
+  // 2. Bulk at 60/min with a burst of 2: the rest wait in the queue
+  reset();
+  APIManager::setRateLimit(API_CLASS_BULK, 60, 2);
+  unsigned long start = millis();
+  for (int i = 0; i < 6; i++) {
+    APIManager::sendBulkAsync(body, sizeof(body), "application/json", record, nullptr);
+  }
+  runUntil(6);
+  printf("bulk 6 at 60/min, burst 2: %d sent, %d failed, took %lu ms\n", sent, throttled + failed,
+         millis() - start);
+
+  // 3. Alert storm past the alert burst
+  reset();
+  for (int i = 0; i < 15; i++) {
+    while (!APIManager::sendAlertAsync("THREAT", "storm", record, nullptr)) {
+      run(10);
+    }
+  }
+  runUntil(15);
+  printf("alert storm of 15: %d sent, %d failed\n", sent, throttled + failed);
+  printRates("after the bursts:");
+
+  // 4. Every other frame is a threat, telemetry at 30/min with a burst of 1
+  APIManager::setRateLimit(API_CLASS_TELEMETRY, 30, 1);
+  uint32_t attempts = 0;
+  for (int i = 0; i < 100; i++) {
+    TelemetryFrame frame = {};
+    frame.timestamp = millis();
+    frame.flags = (i % 2) ? FRAME_FLAG_THREAT : 0;
+    TelemetryBatcher::addFrame(frame);
+    if (!uploading && TelemetryBatcher::shouldFlush()) {
+      uploadFrames = min(TelemetryBatcher::getPendingCount(), (size_t)TELEMETRY_MAX_FRAMES_PER_UPLOAD);
+      uploading = APIManager::sendDataAsync(body, sizeof(body), "application/json", onTelemetry, nullptr);
+      attempts++;
+    }
+    run(200);
+  }
+  run(3000);
+  TelemetryBatchStats batcher = TelemetryBatcher::getStats();
+  printf("threat flushes: 100 frames, %u attempts, %u accepted (%u frames), %u deferred, %u failures, "
+         "%u dropped, %u pending\n",
+         attempts, batcher.batches, batcher.uploaded, batcher.deferred, batcher.failures, batcher.dropped,
+         batcher.pending);
+  printf("server: %ld requests, %ld answered 200\n", FakeDashboard::stat("requests"),
+         FakeDashboard::stat("status 200"));
+
+  fflush(stdout);
+  _exit(0);
+}
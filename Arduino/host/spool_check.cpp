@@ -0,0 +1,221 @@
+/*
+ * spool_check.cpp - Store-and-Forward Journal Check
+ *
+ * This program runs TelemetryBatcher and TelemetrySpool against a host
+ * directory standing in for the SD card. Each phase is one "boot"; run the
+ * phases in the order below on the same directory to cover reboots.
+ *
+ * Features:
+ * - outage: 3000 frames with every upload failing, so the batcher spills to
+ *   the journal; an alert is spooled after them and two batches delivered
+ * - replay: next boot drains the rest in order, dated with the clock; the
+ *   fifth batch fails once and must be re-read unchanged
+ * - full: 8000 batches with no drain, so the journal caps at
+ *   SPOOL_MAX_SEGMENTS
+ * - torn: appends a record, then cuts the newest segment short as a power
+ *   loss would; the next boot appends again and drain reports what survives
+ *
+ * Build (from Arduino/):
+ *   g++ -O1 -std=gnu++17 -pthread -Ihost/stubs -IEV_Secure_ESP32S3_Complete \
+ *       host/spool_check.cpp -o spool_check
+ *
+ * Usage:
+ *   mkdir -p card && spool_check --sd card --phase outage && spool_check --sd card --phase replay
+ *   rm -rf card2; mkdir card2; spool_check --sd card2 --phase full
+ *   rm -rf card3; mkdir card3; spool_check --sd card3 --phase torn && \
+ *       spool_check --sd card3 --phase append && spool_check --sd card3 --phase drain
+ *     --sd DIR          directory standing in for the card
+ *     --phase NAME      outage, replay, full, torn, append or drain
+ */
+
+#include "TelemetrySpool.h"
+#include <dirent.h>
+#include <unistd.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+SDClass SD;
+SystemState currentState = STATE_IDLE;
+
+struct CheckOptions {
+  std::string sd;
+  std::string phase;
+};
+
+static TelemetryFrame makeFrame(uint32_t i) {
+  TelemetryFrame frame = {};
+  frame.timestamp = 1000 + i * 2000;
+  frame.current = i;
+  return frame;
+}
+
+// Newest segment file of the journal (highest <n>.log)
+static std::string newestSegment(const std::string& root) {
+  std::string dir = root + SPOOL_DIR;
+  DIR* handle = opendir(dir.c_str());
+  long newest = -1;
+  while (dirent* entry = handle ? readdir(handle) : nullptr) {
+    if (strstr(entry->d_name, ".log")) {
+      newest = max(newest, atol(entry->d_name));
+    }
+  }
+  if (handle) {
+    closedir(handle);
+  }
+  return newest < 0 ? "" : dir + "/" + std::to_string(newest) + ".log";
+}
+
+static void phaseOutage() {
+  TelemetryBatcher::setSpillHandler(TelemetrySpool::spillFrames);
+  for (uint32_t i = 0; i < 3000; i++) {
+    TelemetryBatcher::addFrame(makeFrame(i));
+    if (i % 30 == 29) {
+      TelemetryBatcher::flushFailed();
+    }
+  }
+  const char* alert = "{\"alert_type\":\"THREAT\"}";
+  TelemetrySpool::spoolAlert((const uint8_t*)alert, strlen(alert));
+  TelemetryBatchStats batcher = TelemetryBatcher::getStats();
+  SpoolStats spool = TelemetrySpool::getStats();
+  printf("outage: 3000 frames, %u spilled, %u left in RAM, %u dropped; journal %u B in %u segments\n",
+         batcher.spilled, batcher.pending, batcher.dropped, spool.bytes, spool.segments);
+
+  SpoolBatch batch;
+  for (int k = 0; k < 2 && TelemetrySpool::nextBatch(batch); k++) {
+    TelemetrySpool::commitBatch(batch);
+  }
+  printf("  2 batches delivered this boot, %u B left\n", TelemetrySpool::getPendingBytes());
+}
+
+static void phaseReplay() {
+  SpoolBatch batch;
+  uint32_t frames = 0;
+  uint32_t alerts = 0;
+  uint32_t batches = 0;
+  uint32_t expect = 2 * SPOOL_DRAIN_FRAMES;
+  bool ordered = true;
+  bool reread = false;
+  while (TelemetrySpool::nextBatch(batch)) {
+    if (batch.type == SPOOL_RECORD_FRAMES) {
+      for (size_t i = 0; i < batch.count; i++) {
+        ordered = ordered && alerts == 0 && (uint32_t)batch.frames[i].current == expect++;
+      }
+      frames += batch.count;
+    } else {
+      alerts++;
+    }
+    if (++batches == 5) {
+      SpoolBatch again;
+      TelemetrySpool::drainFailed();
+      reread = !TelemetrySpool::shouldDrain() && TelemetrySpool::nextBatch(again) && again.seq == batch.seq &&
+               again.end_offset == batch.end_offset;
+      batch = again;
+    }
+    TelemetrySpool::commitBatch(batch);
+  }
+  SpoolStats spool = TelemetrySpool::getStats();
+  printf("replay: %u frames and %u alert drained in %u batches, in order %s, failed batch re-read %s; "
+         "%u B left, %u skipped\n",
+         frames, alerts, batches, ordered ? "yes" : "NO", reread ? "yes" : "NO", spool.bytes, spool.skipped);
+}
+
+static void phaseFull() {
+  static TelemetryFrame frames[30];
+  for (uint32_t r = 0; r < 8000; r++) {
+    for (uint32_t i = 0; i < 30; i++) {
+      frames[i] = makeFrame(r * 30 + i);
+    }
+    TelemetrySpool::spillFrames(frames, 30);
+  }
+  SpoolStats spool = TelemetrySpool::getStats();
+  printf("full: 8000 batches written, journal %u B in %u segments, %u segments discarded\n", spool.bytes,
+         spool.segments, spool.lost_segments);
+}
+
+static void appendFrames() {
+  static TelemetryFrame frames[30];
+  for (uint32_t i = 0; i < 30; i++) {
+    frames[i] = makeFrame(i);
+  }
+  TelemetrySpool::spillFrames(frames, 30);
+}
+
+static void phaseTorn(const std::string& root) {
+  appendFrames();
+  std::string segment = newestSegment(root);
+  FILE* file = fopen(segment.c_str(), "rb");
+  long size = 0;
+  if (file) {
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fclose(file);
+  }
+  if (size < 40 || truncate(segment.c_str(), size - 40) != 0) {
+    printf("torn: could not cut %s\n", segment.c_str());
+    return;
+  }
+  printf("torn: 30 frames appended, %s cut from %ld to %ld B\n", segment.c_str(), size, size - 40);
+}
+
+static void phaseDrain() {
+  SpoolBatch batch;
+  uint32_t frames = 0;
+  int calls = 0;
+  for (; calls < 100 && TelemetrySpool::getPendingBytes() > 0; calls++) {
+    if (TelemetrySpool::nextBatch(batch)) {
+      frames += batch.count;
+      TelemetrySpool::commitBatch(batch);
+    }
+  }
+  SpoolStats spool = TelemetrySpool::getStats();
+  printf("drain: %u frames delivered in %d calls, %u records skipped, %u B left\n", frames, calls,
+         spool.skipped, spool.bytes);
+}
+
+static bool parseOptions(int argc, char** argv, CheckOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--sd" && hasValue) {
+      options.sd = argv[++i];
+    } else if (arg == "--phase" && hasValue) {
+      options.phase = argv[++i];
+    } else {
+      return false;
+    }
+  }
+  return !options.sd.empty() && !options.phase.empty();
+}
+
+int main(int argc, char** argv) {
+  CheckOptions options;
+  if (!parseOptions(argc, argv, options)) {
+    fprintf(stderr, "usage: %s --sd DIR --phase outage|replay|full|torn|append|drain\n", argv[0]);
+    return 2;
+  }
+  Serial.mute = true;
+  SD.root = options.sd;
+  if (!TelemetrySpool::init()) {
+    fprintf(stderr, "journal init failed in %s\n", options.sd.c_str());
+    return 1;
+  }
+
+  if (options.phase == "outage") {
+    phaseOutage();
+  } else if (options.phase == "replay") {
+    phaseReplay();
+  } else if (options.phase == "full") {
+    phaseFull();
+  } else if (options.phase == "torn") {
+    phaseTorn(options.sd);
+  } else if (options.phase == "append") {
+    appendFrames();
+    printf("append: 30 frames appended, journal %u B\n", TelemetrySpool::getPendingBytes());
+  } else if (options.phase == "drain") {
+    phaseDrain();
+  } else {
+    fprintf(stderr, "unknown phase %s\n", options.phase.c_str());
+    return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,12 @@
+/*
+ * Adafruit_GFX.h - Host Stub
+ *
+ * Empty: the headers built on the host only need the include to resolve.
+ */
+
+#ifndef HOST_ADAFRUIT_GFX_H
+#define HOST_ADAFRUIT_GFX_H
+
+#include <Arduino.h>
+
+#endif // HOST_ADAFRUIT_GFX_H
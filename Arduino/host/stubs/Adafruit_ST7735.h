@@ -0,0 +1,12 @@
+/*
+ * Adafruit_ST7735.h - Host Stub
+ *
+ * Empty: the headers built on the host only need the include to resolve.
+ */
+
+#ifndef HOST_ADAFRUIT_ST7735_H
+#define HOST_ADAFRUIT_ST7735_H
+
+#include <Arduino.h>
+
+#endif // HOST_ADAFRUIT_ST7735_H
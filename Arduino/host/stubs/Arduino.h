@@ -0,0 +1,356 @@
+/*
+ * Arduino.h - Host Stub of the Arduino-ESP32 Core
+ *
+ * This file provides the subset of the Arduino core, ESP class and FreeRTOS
+ * API that the model headers use, so they compile unchanged on a Linux host.
+ *
+ * Features:
+ * - String, Print/Stream and a Serial that can be muted (HardwareSerial::mute)
+ * - millis()/micros() from the steady clock; ESP.getCycleCount() counts
+ *   240 MHz cycles from the same clock
+ * - FreeRTOS tasks on std::thread, task notifications, critical sections
+ * - Heap and PSRAM calls mapped to malloc
+ *
+ * Usage:
+ * 1. Add host/stubs to the include path ahead of the sketch directory
+ * 2. Define the globals once: HardwareSerial Serial; EspClass ESP; SDClass SD;
+ *    and WiFiClass WiFi; in programs that include WiFi.h
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using std::isnan;
+using std::isfinite;
+using std::isinf;
+
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define DEC 10
+#define HEX 16
+
+#define PROGMEM
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+#define HOST_CPU_MHZ 240
+
+template <class A, class B> auto max(A a, B b) -> decltype(a + b) { return a > b ? a : b; }
+template <class A, class B> auto min(A a, B b) -> decltype(a + b) { return a < b ? a : b; }
+template <class T> T constrain(T x, T a, T b) { return x < a ? a : (x > b ? b : x); }
+
+// Time
+inline uint64_t hostNanos() {
+  using namespace std::chrono;
+  static const steady_clock::time_point start = steady_clock::now();
+  return (uint64_t)duration_cast<nanoseconds>(steady_clock::now() - start).count();
+}
+inline unsigned long millis() { return (unsigned long)(hostNanos() / 1000000); }
+inline unsigned long micros() { return (unsigned long)(hostNanos() / 1000); }
+inline void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+inline void delayMicroseconds(unsigned int us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+inline void yield() { std::this_thread::yield(); }
+
+// Random numbers and I/O pins
+inline long random(long low, long high) { return high > low ? low + rand() % (high - low) : low; }
+inline long random(long high) { return high > 0 ? rand() % high : 0; }
+inline void randomSeed(unsigned long seed) { srand(seed); }
+inline int analogRead(int) { return 0; }
+inline void pinMode(int, int) {}
+inline void digitalWrite(int, int) {}
+inline int digitalRead(int) { return HIGH; }
+
+// String
+class String {
+public:
+  std::string s;
+
+  String() {}
+  String(const char* c) : s(c ? c : "") {}
+  String(const std::string& x) : s(x) {}
+  String(char c) : s(1, c) {}
+  String(int v, unsigned char base = 10) : s(_format(base == HEX ? "%x" : "%d", v)) {}
+  String(unsigned int v, unsigned char base = 10) : s(_format(base == HEX ? "%x" : "%u", v)) {}
+  String(long v, unsigned char base = 10) : s(_format(base == HEX ? "%lx" : "%ld", v)) {}
+  String(unsigned long v, unsigned char base = 10) : s(_format(base == HEX ? "%lx" : "%lu", v)) {}
+  String(long long v) : s(std::to_string(v)) {}
+  String(unsigned long long v) : s(std::to_string(v)) {}
+  String(float v, unsigned char decimals = 2) : s(_format("%.*f", (int)decimals, (double)v)) {}
+  String(double v, unsigned char decimals = 2) : s(_format("%.*f", (int)decimals, v)) {}
+  String(bool v) : s(v ? "1" : "0") {}
+
+  unsigned length() const { return s.size(); }
+  const char* c_str() const { return s.c_str(); }
+  bool isEmpty() const { return s.empty(); }
+  bool reserve(unsigned n) { s.reserve(n); return true; }
+  char operator[](unsigned i) const { return s[i]; }
+  char charAt(unsigned i) const { return s[i]; }
+
+  bool startsWith(const String& x) const { return s.compare(0, x.s.size(), x.s) == 0; }
+  bool endsWith(const String& x) const {
+    return s.size() >= x.s.size() && s.compare(s.size() - x.s.size(), x.s.size(), x.s) == 0;
+  }
+  int indexOf(const String& x, unsigned from = 0) const { return _pos(s.find(x.s, from)); }
+  int indexOf(char x, unsigned from = 0) const { return _pos(s.find(x, from)); }
+  String substring(unsigned from) const { return from < s.size() ? String(s.substr(from)) : String(); }
+  String substring(unsigned from, unsigned to) const {
+    return from < s.size() ? String(s.substr(from, to - from)) : String();
+  }
+  long toInt() const { return atol(s.c_str()); }
+  float toFloat() const { return (float)atof(s.c_str()); }
+
+  void trim() {
+    size_t a = s.find_first_not_of(" \r\n\t");
+    size_t b = s.find_last_not_of(" \r\n\t");
+    s = (a == std::string::npos) ? "" : s.substr(a, b - a + 1);
+  }
+  void toUpperCase() { for (auto& c : s) c = toupper(c); }
+  void toLowerCase() { for (auto& c : s) c = tolower(c); }
+  void concat(const String& x) { s += x.s; }
+  void remove(unsigned i) { s.erase(i); }
+  void remove(unsigned i, unsigned n) { s.erase(i, n); }
+  void replace(const String& a, const String& b) {
+    for (size_t p = 0; (p = s.find(a.s, p)) != std::string::npos; p += b.s.size()) {
+      s.replace(p, a.s.size(), b.s);
+    }
+  }
+
+  String& operator+=(const String& x) { s += x.s; return *this; }
+  String& operator+=(const char* x) { s += x; return *this; }
+  String& operator+=(char x) { s += x; return *this; }
+  bool operator==(const String& x) const { return s == x.s; }
+  bool operator==(const char* x) const { return s == x; }
+  bool operator!=(const String& x) const { return s != x.s; }
+  bool operator!=(const char* x) const { return s != x; }
+  bool equals(const String& x) const { return s == x.s; }
+
+private:
+  template <class... T> static std::string _format(const char* format, T... args) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), format, args...);
+    return buffer;
+  }
+  static int _pos(size_t p) { return p == std::string::npos ? -1 : (int)p; }
+};
+
+inline String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+inline String operator+(const String& a, const char* b) { return String(a.s + b); }
+inline String operator+(const char* a, const String& b) { return String(a + b.s); }
+inline String operator+(const String& a, char b) { return String(a.s + b); }
+
+// Print / Stream
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) { return write(&c, 1); }
+  virtual size_t write(const uint8_t* buffer, size_t size) { return fwrite(buffer, 1, size, stdout); }
+  virtual void flush() {}
+  size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+
+  size_t print(const String& x) { return write((const uint8_t*)x.c_str(), x.length()); }
+  size_t print(const char* x) { return write((const uint8_t*)x, strlen(x)); }
+  template <class T> size_t print(T x) { return print(String(x)); }
+  template <class T> size_t print(T x, int format) { return print(String(x, format)); }
+  size_t println() { return print("\n"); }
+  template <class T> size_t println(T x) { return print(x) + println(); }
+  template <class T> size_t println(T x, int format) { return print(x, format) + println(); }
+
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    return write((const uint8_t*)buffer, n < (int)sizeof(buffer) ? n : sizeof(buffer) - 1);
+  }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() { return 0; }
+  virtual int read() { return -1; }
+  virtual int peek() { return -1; }
+  String readStringUntil(char) { return String(); }
+  String readString() { return String(); }
+  size_t readBytes(uint8_t* buffer, size_t length) {
+    size_t count = 0;
+    for (int c; count < length && (c = read()) >= 0;) {
+      buffer[count++] = (uint8_t)c;
+    }
+    return count;
+  }
+  size_t readBytes(char* buffer, size_t length) { return readBytes((uint8_t*)buffer, length); }
+  void setTimeout(unsigned long) {}
+};
+
+class HardwareSerial : public Stream {
+public:
+  bool mute = false;   // Drop firmware log output (evaluation runs)
+
+  void begin(unsigned long) {}
+  operator bool() const { return true; }
+  size_t write(const uint8_t* buffer, size_t size) override {
+    return mute ? size : fwrite(buffer, 1, size, stderr);
+  }
+};
+extern HardwareSerial Serial;
+
+// ESP class
+class EspClass {
+public:
+  uint32_t getFreeHeap() { return 200000; }
+  uint32_t getMinFreeHeap() { return 150000; }
+  uint32_t getMaxAllocHeap() { return 100000; }
+  uint32_t getPsramSize() { return 0; }
+  uint32_t getFreePsram() { return 0; }
+  uint32_t getCpuFreqMHz() { return HOST_CPU_MHZ; }
+  uint32_t getCycleCount() { return (uint32_t)(hostNanos() * HOST_CPU_MHZ / 1000); }
+  void restart() { exit(0); }
+};
+extern EspClass ESP;
+
+inline bool psramFound() { return false; }
+inline void* ps_malloc(size_t size) { return malloc(size); }
+inline void* ps_calloc(size_t count, size_t size) { return calloc(count, size); }
+
+// FreeRTOS subset on std::thread
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY 0xffffffffu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+struct HostTask {
+  std::mutex mutex;
+  std::condition_variable wake;
+  uint32_t notifications = 0;
+};
+typedef HostTask* TaskHandle_t;
+
+inline HostTask*& hostCurrentTask() {
+  static thread_local HostTask* task = nullptr;
+  return task;
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(void (*fn)(void*), const char*, uint32_t, void* arg,
+                                          UBaseType_t, TaskHandle_t* handle, BaseType_t) {
+  HostTask* task = new HostTask();
+  if (handle) {
+    *handle = task;
+  }
+  std::thread([=] {
+    hostCurrentTask() = task;
+    fn(arg);
+  }).detach();
+  return pdPASS;
+}
+
+inline BaseType_t xTaskCreate(void (*fn)(void*), const char* name, uint32_t stack, void* arg,
+                              UBaseType_t priority, TaskHandle_t* handle) {
+  return xTaskCreatePinnedToCore(fn, name, stack, arg, priority, handle, 0);
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+  if (!hostCurrentTask()) {
+    hostCurrentTask() = new HostTask();
+  }
+  return hostCurrentTask();
+}
+
+inline void xTaskNotifyGive(TaskHandle_t task) {
+  std::lock_guard<std::mutex> lock(task->mutex);
+  task->notifications++;
+  task->wake.notify_all();
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t wait) {
+  HostTask* task = xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> lock(task->mutex);
+  auto ready = [&] { return task->notifications > 0; };
+  if (wait == portMAX_DELAY) {
+    task->wake.wait(lock, ready);
+  } else {
+    task->wake.wait_for(lock, std::chrono::milliseconds(wait), ready);
+  }
+  uint32_t value = task->notifications;
+  if (clearOnExit) {
+    task->notifications = 0;
+  } else if (value) {
+    task->notifications--;
+  }
+  return value;
+}
+
+struct HostSemaphore {
+  std::mutex mutex;
+  std::condition_variable wake;
+  bool given = false;
+};
+typedef HostSemaphore* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary() {
+  return new HostSemaphore();
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  std::lock_guard<std::mutex> lock(semaphore->mutex);
+  if (semaphore->given) {
+    return pdFALSE;
+  }
+  semaphore->given = true;
+  semaphore->wake.notify_all();
+  return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t wait) {
+  std::unique_lock<std::mutex> lock(semaphore->mutex);
+  auto ready = [&] { return semaphore->given; };
+  if (wait == portMAX_DELAY) {
+    semaphore->wake.wait(lock, ready);
+  } else if (!semaphore->wake.wait_for(lock, std::chrono::milliseconds(wait), ready)) {
+    return pdFALSE;
+  }
+  semaphore->given = false;
+  return pdTRUE;
+}
+
+inline void vTaskDelay(TickType_t ticks) { delay(ticks); }
+inline void vTaskDelete(TaskHandle_t) {}
+inline TickType_t xTaskGetTickCount() { return millis(); }
+inline BaseType_t xPortGetCoreID() { return 1; }
+
+struct portMUX_TYPE {
+  std::recursive_mutex mutex;
+};
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(mux) (mux)->mutex.lock()
+#define portEXIT_CRITICAL(mux) (mux)->mutex.unlock()
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,837 @@
+/*
+ * ArduinoJson.h - Host Stub of ArduinoJson 6
+ *
+ * This file implements the subset of the ArduinoJson 6 API the sketch uses,
+ * producing and parsing real JSON, so request bodies built on the host can be
+ * checked byte for byte by a server.
+ *
+ * Features:
+ * - StaticJsonDocument / DynamicJsonDocument with a capacity: 16 bytes per
+ *   value plus copied strings, as on a 32-bit target; overflowed() is set
+ *   when a value does not fit and the value is dropped
+ * - JsonVariant, JsonObject, JsonArray with nested creation and iteration
+ * - serializeJson / measureJson into char buffers, Print, String
+ * - deserializeJson with the ArduinoJson error codes and nesting limit
+ * - Numbers are printed like ArduinoJson 6 with doubles: integers as is,
+ *   others with up to 9 decimal places, exponent outside 1e-5..1e7
+ */
+
+#ifndef HOST_ARDUINOJSON_H
+#define HOST_ARDUINOJSON_H
+
+#include <Arduino.h>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#define JSON_ARRAY_SIZE(n) ((n) * 16)
+#define JSON_OBJECT_SIZE(n) ((n) * 16)
+#define JSON_STRING_SIZE(n) ((n) + 1)
+#define ARDUINOJSON_DEFAULT_NESTING_LIMIT 10
+
+class JsonDocument;
+class JsonArray;
+class JsonObject;
+
+struct HostJsonNode {
+  enum Type { NUL, BOOL, INT, UINT, FLOAT, STRING, ARRAY, OBJECT };
+  Type type = NUL;
+  bool boolean = false;
+  int64_t integer = 0;
+  uint64_t unsignedInteger = 0;
+  double real = 0;
+  std::string text;
+  std::vector<std::string> keys;                      // OBJECT: one per item
+  std::vector<std::unique_ptr<HostJsonNode>> items;   // ARRAY or OBJECT
+
+  HostJsonNode* member(const char* key) const {
+    for (size_t i = 0; type == OBJECT && i < keys.size(); i++) {
+      if (keys[i] == key) {
+        return items[i].get();
+      }
+    }
+    return nullptr;
+  }
+};
+
+// Serialization
+inline void hostJsonWriteString(const std::string& text, std::string& out) {
+  out += '"';
+  for (unsigned char c : text) {
+    switch (c) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\b': out += "\\b"; break;
+      case '\f': out += "\\f"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if (c < 0x20) {
+          char escaped[8];
+          snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          out += escaped;
+        } else {
+          out += (char)c;
+        }
+    }
+  }
+  out += '"';
+}
+
+inline void hostJsonWriteReal(double value, std::string& out) {
+  if (std::isnan(value) || std::isinf(value)) {
+    out += "null";              // ArduinoJson's default for NaN and infinity
+    return;
+  }
+  char text[40];
+  double magnitude = fabs(value);
+  if (magnitude != 0 && (magnitude >= 1e7 || magnitude < 1e-5)) {
+    snprintf(text, sizeof(text), "%.9e", value);
+    // Trim the mantissa's trailing zeros: 1.500000000e+07 -> 1.5e7
+    std::string number(text);
+    size_t e = number.find('e');
+    std::string mantissa = number.substr(0, e);
+    int exponent = atoi(number.c_str() + e + 1);
+    mantissa.erase(mantissa.find_last_not_of('0') + 1);
+    if (mantissa.back() == '.') {
+      mantissa.pop_back();
+    }
+    out += mantissa + "e" + std::to_string(exponent);
+    return;
+  }
+  snprintf(text, sizeof(text), "%.9f", value);
+  std::string number(text);
+  number.erase(number.find_last_not_of('0') + 1);
+  if (number.back() == '.') {
+    number.pop_back();
+  }
+  out += number == "-0" ? "0" : number;
+}
+
+inline void hostJsonWrite(const HostJsonNode* node, std::string& out) {
+  if (!node) {
+    out += "null";
+    return;
+  }
+  switch (node->type) {
+    case HostJsonNode::NUL: out += "null"; break;
+    case HostJsonNode::BOOL: out += node->boolean ? "true" : "false"; break;
+    case HostJsonNode::INT: out += std::to_string(node->integer); break;
+    case HostJsonNode::UINT: out += std::to_string(node->unsignedInteger); break;
+    case HostJsonNode::FLOAT: hostJsonWriteReal(node->real, out); break;
+    case HostJsonNode::STRING: hostJsonWriteString(node->text, out); break;
+    case HostJsonNode::ARRAY:
+    case HostJsonNode::OBJECT: {
+      bool object = node->type == HostJsonNode::OBJECT;
+      out += object ? '{' : '[';
+      for (size_t i = 0; i < node->items.size(); i++) {
+        if (i) {
+          out += ',';
+        }
+        if (object) {
+          hostJsonWriteString(node->keys[i], out);
+          out += ':';
+        }
+        hostJsonWrite(node->items[i].get(), out);
+      }
+      out += object ? '}' : ']';
+      break;
+    }
+  }
+}
+
+// Document memory pool (accounting only; nodes live on the host heap)
+class HostJsonPool {
+public:
+  explicit HostJsonPool(size_t capacity) : _capacity(capacity) {}
+
+  bool take(size_t bytes) {
+    if (_used + bytes > _capacity) {
+      _overflowed = true;
+      return false;
+    }
+    _used += bytes;
+    return true;
+  }
+  void reset() {
+    _used = 0;
+    _overflowed = false;
+  }
+  size_t used() const { return _used; }
+  size_t capacity() const { return _capacity; }
+  bool overflowed() const { return _overflowed; }
+
+private:
+  size_t _capacity;
+  size_t _used = 0;
+  bool _overflowed = false;
+};
+
+// Value reference: an existing node, or a member/element created on first write
+class JsonVariant {
+public:
+  JsonVariant() {}
+  JsonVariant(const JsonVariant&) = default;
+  JsonVariant(HostJsonPool* pool, HostJsonNode* node) : _pool(pool), _node(node) {}
+  JsonVariant(HostJsonPool* pool, HostJsonNode* parent, const std::string& key, size_t keyCost)
+    : _pool(pool), _parent(parent), _key(key), _keyCost(keyCost) {}
+
+  // Writing
+  template <class T> JsonVariant& operator=(const T& value) {
+    set(value);
+    return *this;
+  }
+  JsonVariant& operator=(const JsonVariant& value) {
+    set(value);
+    return *this;
+  }
+
+  template <class T> bool set(const T& value) {
+    HostJsonNode* node = _resolve();
+    if (!node) {
+      return false;
+    }
+    return _assign(node, value);
+  }
+
+  bool set(const JsonVariant& value) {
+    HostJsonNode* node = _resolve();
+    if (!node) {
+      return false;
+    }
+    if (!value._node) {
+      *node = HostJsonNode();
+      return true;
+    }
+    return _copy(node, value._node);
+  }
+
+  // Reading
+  template <class T> T as() const { return _as((T*)nullptr); }
+  template <class T> operator T() const { return as<T>(); }
+  template <class T> bool is() const { return _is((T*)nullptr); }
+  bool isNull() const { return !_node || _node->type == HostJsonNode::NUL; }
+  size_t size() const {
+    return (_node && (_node->type == HostJsonNode::ARRAY || _node->type == HostJsonNode::OBJECT)) ?
+      _node->items.size() : 0;
+  }
+  bool containsKey(const char* key) const { return _node && _node->member(key); }
+  bool containsKey(const String& key) const { return containsKey(key.c_str()); }
+
+  template <class T> T operator|(const T& fallback) const { return is<T>() ? as<T>() : fallback; }
+  const char* operator|(const char* fallback) const { return is<const char*>() ? as<const char*>() : fallback; }
+  String operator|(const String& fallback) const { return is<const char*>() ? as<String>() : fallback; }
+
+  bool operator==(const char* text) const { return is<const char*>() && _node->text == text; }
+  bool operator==(const String& text) const { return *this == text.c_str(); }
+  bool operator!=(const char* text) const { return !(*this == text); }
+
+  // Nested values
+  JsonVariant operator[](const char* key) const;
+  JsonVariant operator[](const String& key) const { return (*this)[key.c_str()]; }
+  JsonVariant operator[](int index) const;
+  JsonArray createNestedArray(const char* key) const;
+  JsonObject createNestedObject(const char* key) const;
+  JsonArray createNestedArray() const;
+  JsonObject createNestedObject() const;
+  template <class T> bool add(const T& value) const;
+
+  const HostJsonNode* node() const { return _node; }
+
+protected:
+  HostJsonPool* _pool = nullptr;
+  HostJsonNode* _node = nullptr;
+  HostJsonNode* _parent = nullptr;      // Pending member of this object
+  std::string _key;
+  size_t _keyCost = 0;
+
+  HostJsonNode* _resolve() {
+    if (_node || !_parent || !_pool) {
+      return _node;
+    }
+    if (_parent->type == HostJsonNode::NUL) {
+      _parent->type = HostJsonNode::OBJECT;
+    }
+    if (_parent->type != HostJsonNode::OBJECT || !_pool->take(16 + _keyCost)) {
+      return nullptr;
+    }
+    _parent->keys.push_back(_key);
+    _parent->items.emplace_back(new HostJsonNode());
+    _node = _parent->items.back().get();
+    return _node;
+  }
+
+  bool _text(HostJsonNode* node, const std::string& text, bool copied) {
+    if (copied && !_pool->take(text.size() + 1)) {
+      return false;
+    }
+    *node = HostJsonNode();
+    node->type = HostJsonNode::STRING;
+    node->text = text;
+    return true;
+  }
+
+  bool _assign(HostJsonNode* node, const char* value) {
+    if (!value) {
+      *node = HostJsonNode();
+      return true;
+    }
+    return _text(node, value, false);    // Stored by pointer, no copy
+  }
+  bool _assign(HostJsonNode* node, char* value) { return _text(node, value, true); }
+  bool _assign(HostJsonNode* node, const String& value) { return _text(node, value.s, true); }
+  bool _assign(HostJsonNode* node, const std::string& value) { return _text(node, value, true); }
+  template <size_t N> bool _assign(HostJsonNode* node, const char (&value)[N]) { return _text(node, value, false); }
+  template <class T> bool _assign(HostJsonNode* node, const T& value) {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "unsupported JSON value type");
+    *node = HostJsonNode();
+    if (std::is_same<T, bool>::value) {
+      node->type = HostJsonNode::BOOL;
+      node->boolean = (bool)value;
+    } else if (std::is_floating_point<T>::value) {
+      node->type = HostJsonNode::FLOAT;
+      node->real = (double)value;
+    } else if (std::is_enum<T>::value || std::is_signed<T>::value) {
+      node->type = HostJsonNode::INT;
+      node->integer = (int64_t)value;
+    } else {
+      node->type = HostJsonNode::UINT;
+      node->unsignedInteger = (uint64_t)value;
+    }
+    return true;
+  }
+
+  bool _copy(HostJsonNode* node, const HostJsonNode* from) {
+    *node = HostJsonNode();
+    node->type = from->type;
+    node->boolean = from->boolean;
+    node->integer = from->integer;
+    node->unsignedInteger = from->unsignedInteger;
+    node->real = from->real;
+    if (from->type == HostJsonNode::STRING && !_text(node, from->text, true)) {
+      return false;
+    }
+    for (size_t i = 0; i < from->items.size(); i++) {
+      size_t keyCost = from->type == HostJsonNode::OBJECT ? from->keys[i].size() + 1 : 0;
+      if (!_pool->take(16 + keyCost)) {
+        return false;
+      }
+      if (from->type == HostJsonNode::OBJECT) {
+        node->keys.push_back(from->keys[i]);
+      }
+      node->items.emplace_back(new HostJsonNode());
+      if (!_copy(node->items.back().get(), from->items[i].get())) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Conversions
+  bool _numeric() const {
+    return _node && (_node->type == HostJsonNode::INT || _node->type == HostJsonNode::UINT ||
+                     _node->type == HostJsonNode::FLOAT || _node->type == HostJsonNode::BOOL);
+  }
+  double _real() const {
+    switch (_node ? _node->type : HostJsonNode::NUL) {
+      case HostJsonNode::BOOL: return _node->boolean;
+      case HostJsonNode::INT: return (double)_node->integer;
+      case HostJsonNode::UINT: return (double)_node->unsignedInteger;
+      case HostJsonNode::FLOAT: return _node->real;
+      default: return 0;
+    }
+  }
+  template <class T> T _as(T*) const {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "unsupported JSON value type");
+    if (!_node) {
+      return T();
+    }
+    if (std::is_same<T, bool>::value) {
+      return (T)(_node->type == HostJsonNode::BOOL ? _node->boolean : _real() != 0);
+    }
+    if (_node->type == HostJsonNode::INT) {
+      return (T)_node->integer;
+    }
+    if (_node->type == HostJsonNode::UINT) {
+      return (T)_node->unsignedInteger;
+    }
+    return (T)_real();
+  }
+  const char* _as(const char**) const {
+    return (_node && _node->type == HostJsonNode::STRING) ? _node->text.c_str() : nullptr;
+  }
+  String _as(String*) const {
+    if (_node && _node->type == HostJsonNode::STRING) {
+      return String(_node->text);
+    }
+    std::string out;
+    hostJsonWrite(_node, out);
+    return String(out);
+  }
+  JsonVariant _as(JsonVariant*) const { return *this; }
+  JsonArray _as(JsonArray*) const;
+  JsonObject _as(JsonObject*) const;
+
+  template <class T> bool _is(T*) const {
+    if (std::is_same<T, bool>::value) {
+      return _node && _node->type == HostJsonNode::BOOL;
+    }
+    if (std::is_floating_point<T>::value) {
+      return _numeric() && _node->type != HostJsonNode::BOOL;
+    }
+    return _node && (_node->type == HostJsonNode::INT || _node->type == HostJsonNode::UINT);
+  }
+  bool _is(const char**) const { return _node && _node->type == HostJsonNode::STRING; }
+  bool _is(String*) const { return _is((const char**)nullptr); }
+  bool _is(JsonArray*) const { return _node && _node->type == HostJsonNode::ARRAY; }
+  bool _is(JsonObject*) const { return _node && _node->type == HostJsonNode::OBJECT; }
+};
+
+typedef JsonVariant JsonVariantConst;
+
+class JsonArray : public JsonVariant {
+public:
+  JsonArray() {}
+  JsonArray(HostJsonPool* pool, HostJsonNode* node) : JsonVariant(pool, node) {}
+
+  class iterator {
+  public:
+    iterator(HostJsonPool* pool, HostJsonNode* node, size_t index) : _pool(pool), _node(node), _index(index) {}
+    JsonVariant operator*() const { return JsonVariant(_pool, _node->items[_index].get()); }
+    iterator& operator++() {
+      _index++;
+      return *this;
+    }
+    bool operator!=(const iterator& other) const { return _index != other._index; }
+
+  private:
+    HostJsonPool* _pool;
+    HostJsonNode* _node;
+    size_t _index;
+  };
+  iterator begin() const { return iterator(_pool, _node, 0); }
+  iterator end() const { return iterator(_pool, _node, size()); }
+};
+
+class JsonObject : public JsonVariant {
+public:
+  JsonObject() {}
+  JsonObject(HostJsonPool* pool, HostJsonNode* node) : JsonVariant(pool, node) {}
+};
+
+// Nested values: a pending member is created on first use
+inline JsonVariant JsonVariant::operator[](const char* key) const {
+  if (!_node || _node->type == HostJsonNode::NUL || _node->type == HostJsonNode::OBJECT) {
+    HostJsonNode* existing = _node ? _node->member(key) : nullptr;
+    if (existing) {
+      return JsonVariant(_pool, existing);
+    }
+    if (_node) {
+      return JsonVariant(_pool, _node, key, 0);
+    }
+  }
+  return JsonVariant();
+}
+
+inline JsonVariant JsonVariant::operator[](int index) const {
+  if (_node && _node->type == HostJsonNode::ARRAY && index >= 0 && (size_t)index < _node->items.size()) {
+    return JsonVariant(_pool, _node->items[index].get());
+  }
+  return JsonVariant();
+}
+
+inline JsonArray JsonVariant::createNestedArray() const {
+  JsonVariant slot;
+  if (_node && _node->type == HostJsonNode::NUL) {
+    _node->type = HostJsonNode::ARRAY;
+  }
+  if (_node && _node->type == HostJsonNode::ARRAY && _pool->take(16)) {
+    _node->items.emplace_back(new HostJsonNode());
+    HostJsonNode* node = _node->items.back().get();
+    node->type = HostJsonNode::ARRAY;
+    return JsonArray(_pool, node);
+  }
+  return JsonArray();
+}
+
+inline JsonObject JsonVariant::createNestedObject() const {
+  JsonArray holder = createNestedArray();
+  if (holder.node()) {
+    const_cast<HostJsonNode*>(holder.node())->type = HostJsonNode::OBJECT;
+  }
+  return JsonObject(_pool, const_cast<HostJsonNode*>(holder.node()));
+}
+
+inline JsonArray JsonVariant::createNestedArray(const char* key) const {
+  JsonVariant member = (*this)[key];
+  HostJsonNode* node = member._resolve();
+  if (!node) {
+    return JsonArray();
+  }
+  *node = HostJsonNode();
+  node->type = HostJsonNode::ARRAY;
+  return JsonArray(_pool, node);
+}
+
+inline JsonObject JsonVariant::createNestedObject(const char* key) const {
+  JsonVariant member = (*this)[key];
+  HostJsonNode* node = member._resolve();
+  if (!node) {
+    return JsonObject();
+  }
+  *node = HostJsonNode();
+  node->type = HostJsonNode::OBJECT;
+  return JsonObject(_pool, node);
+}
+
+template <class T> bool JsonVariant::add(const T& value) const {
+  if (_node && _node->type == HostJsonNode::NUL) {
+    _node->type = HostJsonNode::ARRAY;
+  }
+  if (!_node || _node->type != HostJsonNode::ARRAY || !_pool->take(16)) {
+    return false;
+  }
+  _node->items.emplace_back(new HostJsonNode());
+  JsonVariant element(_pool, _node->items.back().get());
+  if (!element.set(value)) {
+    _node->items.pop_back();
+    return false;
+  }
+  return true;
+}
+
+inline JsonArray JsonVariant::_as(JsonArray*) const {
+  return _is((JsonArray*)nullptr) ? JsonArray(_pool, _node) : JsonArray();
+}
+
+inline JsonObject JsonVariant::_as(JsonObject*) const {
+  return _is((JsonObject*)nullptr) ? JsonObject(_pool, _node) : JsonObject();
+}
+
+// Documents
+class JsonDocument {
+public:
+  explicit JsonDocument(size_t capacity) : _pool(capacity) {}
+  JsonDocument(const JsonDocument&) = delete;
+  JsonDocument& operator=(const JsonDocument&) = delete;
+
+  JsonVariant operator[](const char* key) { return _root()[key]; }
+  JsonVariant operator[](const String& key) { return _root()[key.c_str()]; }
+  JsonVariant operator[](int index) { return _root()[index]; }
+  JsonArray createNestedArray(const char* key) { return _root().createNestedArray(key); }
+  JsonObject createNestedObject(const char* key) { return _root().createNestedObject(key); }
+  JsonArray createNestedArray() { return _root().createNestedArray(); }
+  JsonObject createNestedObject() { return _root().createNestedObject(); }
+  template <class T> bool add(const T& value) { return _root().add(value); }
+
+  template <class T> T as() { return _root().as<T>(); }
+  template <class T> bool is() { return _root().is<T>(); }
+  template <class T> T to() {
+    clear();
+    _node.type = std::is_same<T, JsonArray>::value ? HostJsonNode::ARRAY : HostJsonNode::OBJECT;
+    return _root().as<T>();
+  }
+  bool containsKey(const char* key) const { return _node.member(key) != nullptr; }
+  bool isNull() const { return _node.type == HostJsonNode::NUL; }
+  size_t size() const { return _node.items.size(); }
+
+  void clear() {
+    _node = HostJsonNode();
+    _pool.reset();
+  }
+  bool overflowed() const { return _pool.overflowed(); }
+  size_t memoryUsage() const { return _pool.used(); }
+  size_t capacity() const { return _pool.capacity(); }
+
+  const HostJsonNode* node() const { return &_node; }
+  HostJsonPool& pool() { return _pool; }
+  HostJsonNode& root() { return _node; }
+
+private:
+  HostJsonPool _pool;
+  HostJsonNode _node;
+
+  JsonVariant _root() { return JsonVariant(&_pool, &_node); }
+};
+
+template <size_t N> class StaticJsonDocument : public JsonDocument {
+public:
+  StaticJsonDocument() : JsonDocument(N) {}
+};
+
+class DynamicJsonDocument : public JsonDocument {
+public:
+  explicit DynamicJsonDocument(size_t capacity) : JsonDocument(capacity) {}
+};
+
+// Serialization entry points; the text goes to a per-thread buffer that keeps
+// its capacity, so like ArduinoJson's serializer they stop allocating once warm
+inline const std::string& hostJsonText(const JsonDocument& doc) {
+  thread_local std::string out;
+  out.clear();
+  hostJsonWrite(doc.node(), out);
+  return out;
+}
+inline const std::string& hostJsonText(const JsonVariant& value) {
+  thread_local std::string out;
+  out.clear();
+  hostJsonWrite(value.node(), out);
+  return out;
+}
+
+template <class T> size_t measureJson(const T& value) {
+  return hostJsonText(value).size();
+}
+
+template <class T> size_t serializeJson(const T& value, char* buffer, size_t size) {
+  const std::string& text = hostJsonText(value);
+  if (size == 0) {
+    return 0;
+  }
+  size_t n = min(text.size(), size - 1);
+  memcpy(buffer, text.data(), n);
+  buffer[n] = 0;
+  return n;
+}
+
+template <class T> size_t serializeJson(const T& value, Print& out) {
+  const std::string& text = hostJsonText(value);
+  return out.write((const uint8_t*)text.data(), text.size());
+}
+
+template <class T> size_t serializeJson(const T& value, String& out) {
+  out = String(hostJsonText(value));
+  return out.length();
+}
+
+// Parsing
+class DeserializationError {
+public:
+  enum Code { Ok, EmptyInput, IncompleteInput, InvalidInput, NoMemory, TooDeep };
+
+  DeserializationError(Code code = Ok) : _code(code) {}
+  Code code() const { return _code; }
+  explicit operator bool() const { return _code != Ok; }
+  bool operator==(Code code) const { return _code == code; }
+  bool operator!=(Code code) const { return _code != code; }
+  const char* c_str() const {
+    static const char* const names[] = {"Ok", "EmptyInput", "IncompleteInput", "InvalidInput", "NoMemory", "TooDeep"};
+    return names[_code];
+  }
+
+private:
+  Code _code;
+};
+
+class HostJsonParser {
+public:
+  HostJsonParser(const char* text, size_t length, HostJsonPool& pool)
+    : _at(text), _end(text + length), _pool(pool) {}
+
+  DeserializationError::Code parse(HostJsonNode& root) {
+    _skipSpace();
+    if (_at == _end) {
+      return DeserializationError::EmptyInput;
+    }
+    return _value(root, 0);
+  }
+
+private:
+  const char* _at;
+  const char* _end;
+  HostJsonPool& _pool;
+
+  void _skipSpace() {
+    while (_at < _end && (*_at == ' ' || *_at == '\t' || *_at == '\r' || *_at == '\n')) {
+      _at++;
+    }
+  }
+
+  DeserializationError::Code _value(HostJsonNode& node, int depth) {
+    _skipSpace();
+    if (_at == _end) {
+      return DeserializationError::IncompleteInput;
+    }
+    char c = *_at;
+    if (c == '{' || c == '[') {
+      return _container(node, depth, c == '{');
+    }
+    if (c == '"' || c == '\'') {
+      node.type = HostJsonNode::STRING;
+      return _string(node.text);
+    }
+    if (c == '-' || (c >= '0' && c <= '9')) {
+      return _number(node);
+    }
+    return _literal(node);
+  }
+
+  DeserializationError::Code _container(HostJsonNode& node, int depth, bool object) {
+    if (depth >= ARDUINOJSON_DEFAULT_NESTING_LIMIT) {
+      return DeserializationError::TooDeep;
+    }
+    node.type = object ? HostJsonNode::OBJECT : HostJsonNode::ARRAY;
+    char close = object ? '}' : ']';
+    _at++;
+    _skipSpace();
+    if (_at < _end && *_at == close) {
+      _at++;
+      return DeserializationError::Ok;
+    }
+    for (;;) {
+      std::string key;
+      if (object) {
+        _skipSpace();
+        if (_at == _end) {
+          return DeserializationError::IncompleteInput;
+        }
+        if (*_at != '"' && *_at != '\'') {
+          return DeserializationError::InvalidInput;
+        }
+        DeserializationError::Code error = _string(key);
+        if (error != DeserializationError::Ok) {
+          return error;
+        }
+        _skipSpace();
+        if (_at == _end) {
+          return DeserializationError::IncompleteInput;
+        }
+        if (*_at++ != ':') {
+          return DeserializationError::InvalidInput;
+        }
+      }
+      if (!_pool.take(16)) {
+        return DeserializationError::NoMemory;
+      }
+      node.items.emplace_back(new HostJsonNode());
+      if (object) {
+        node.keys.push_back(key);
+      }
+      DeserializationError::Code error = _value(*node.items.back(), depth + 1);
+      if (error != DeserializationError::Ok) {
+        return error;
+      }
+      _skipSpace();
+      if (_at == _end) {
+        return DeserializationError::IncompleteInput;
+      }
+      char c = *_at++;
+      if (c == close) {
+        return DeserializationError::Ok;
+      }
+      if (c != ',') {
+        return DeserializationError::InvalidInput;
+      }
+    }
+  }
+
+  DeserializationError::Code _string(std::string& out) {
+    char quote = *_at++;
+    out.clear();
+    while (_at < _end && *_at != quote) {
+      char c = *_at++;
+      if (c != '\\') {
+        out += c;
+        continue;
+      }
+      if (_at == _end) {
+        return DeserializationError::IncompleteInput;
+      }
+      c = *_at++;
+      switch (c) {
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        case 'u': {
+          if (_end - _at < 4) {
+            return DeserializationError::IncompleteInput;
+          }
+          unsigned code = strtoul(std::string(_at, 4).c_str(), nullptr, 16);
+          _at += 4;
+          // UTF-8 (surrogate pairs are not combined)
+          if (code < 0x80) {
+            out += (char)code;
+          } else if (code < 0x800) {
+            out += (char)(0xC0 | (code >> 6));
+            out += (char)(0x80 | (code & 0x3F));
+          } else {
+            out += (char)(0xE0 | (code >> 12));
+            out += (char)(0x80 | ((code >> 6) & 0x3F));
+            out += (char)(0x80 | (code & 0x3F));
+          }
+          break;
+        }
+        default: out += c;
+      }
+    }
+    if (_at == _end) {
+      return DeserializationError::IncompleteInput;
+    }
+    _at++;
+    return _pool.take(out.size() + 1) ? DeserializationError::Ok : DeserializationError::NoMemory;
+  }
+
+  DeserializationError::Code _number(HostJsonNode& node) {
+    const char* start = _at;
+    bool real = false;
+    while (_at < _end && (isdigit((unsigned char)*_at) || *_at == '-' || *_at == '+' ||
+                          *_at == '.' || *_at == 'e' || *_at == 'E')) {
+      real |= *_at == '.' || *_at == 'e' || *_at == 'E';
+      _at++;
+    }
+    std::string text(start, _at);
+    char* parsed = nullptr;
+    if (!real && text[0] == '-') {
+      node.type = HostJsonNode::INT;
+      node.integer = strtoll(text.c_str(), &parsed, 10);
+    } else if (!real) {
+      node.type = HostJsonNode::UINT;
+      node.unsignedInteger = strtoull(text.c_str(), &parsed, 10);
+    } else {
+      node.type = HostJsonNode::FLOAT;
+      node.real = strtod(text.c_str(), &parsed);
+    }
+    return (parsed && *parsed == 0) ? DeserializationError::Ok : DeserializationError::InvalidInput;
+  }
+
+  DeserializationError::Code _literal(HostJsonNode& node) {
+    static const char* const words[] = {"true", "false", "null"};
+    for (int i = 0; i < 3; i++) {
+      size_t length = strlen(words[i]);
+      if ((size_t)(_end - _at) >= length && strncmp(_at, words[i], length) == 0) {
+        _at += length;
+        node.type = i == 2 ? HostJsonNode::NUL : HostJsonNode::BOOL;
+        node.boolean = i == 0;
+        return DeserializationError::Ok;
+      }
+      if ((size_t)(_end - _at) < length && strncmp(_at, words[i], _end - _at) == 0) {
+        return DeserializationError::IncompleteInput;
+      }
+    }
+    return DeserializationError::InvalidInput;
+  }
+};
+
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* text, size_t length) {
+  doc.clear();
+  HostJsonParser parser(text, length, doc.pool());
+  DeserializationError::Code code = parser.parse(doc.root());
+  if (code != DeserializationError::Ok) {
+    doc.clear();
+  }
+  return DeserializationError(code);
+}
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* text) {
+  return deserializeJson(doc, text, text ? strlen(text) : 0);
+}
+inline DeserializationError deserializeJson(JsonDocument& doc, const String& text) {
+  return deserializeJson(doc, text.c_str(), text.length());
+}
+inline DeserializationError deserializeJson(JsonDocument& doc, const uint8_t* data, size_t length) {
+  return deserializeJson(doc, (const char*)data, length);
+}
+
+#endif // HOST_ARDUINOJSON_H
@@ -0,0 +1,371 @@
+/*
+ * HTTPClient.h - Host Stub of the ESP32 HTTPClient
+ *
+ * This file speaks HTTP/1.1 over the WiFiClient passed to begin(), with the
+ * same calls, error codes and connection reuse rules as the arduino-esp32
+ * HTTPClient, so APIManager's request path runs unchanged against a local
+ * server (host/fake_dashboard.py).
+ *
+ * Features:
+ * - Keep-alive with setReuse(); the connection is dropped after a
+ *   "Connection: close" response or an unread body of unknown length
+ * - Content-Length and chunked response bodies (getString, writeToStream)
+ * - collectHeaders()/header() for response headers such as Retry-After
+ * - getStreamPtr() hands out the socket for bodies read in place
+ */
+
+#ifndef HOST_HTTPCLIENT_H
+#define HOST_HTTPCLIENT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <vector>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_NO_STREAM (-6)
+#define HTTPC_ERROR_NO_HTTP_SERVER (-7)
+#define HTTPC_ERROR_TOO_LESS_RAM (-8)
+#define HTTPC_ERROR_ENCODING (-9)
+#define HTTPC_ERROR_STREAM_WRITE (-10)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+#define HTTPCLIENT_DEFAULT_TCP_TIMEOUT 5000
+
+class HTTPClient {
+public:
+  HTTPClient() {}
+  ~HTTPClient() { end(); }
+
+  bool begin(WiFiClient& client, const String& url) {
+    // scheme://host[:port]/path
+    _client = &client;
+    _requestHeaders.clear();
+    _responseHeaders.clear();
+    _size = -1;
+    std::string text = url.s;
+    size_t scheme = text.find("://");
+    bool https = scheme != std::string::npos && text.compare(0, scheme, "https") == 0;
+    std::string rest = scheme == std::string::npos ? text : text.substr(scheme + 3);
+    size_t slash = rest.find('/');
+    std::string authority = rest.substr(0, slash);
+    _path = slash == std::string::npos ? "/" : rest.substr(slash);
+    size_t colon = authority.find(':');
+    _host = authority.substr(0, colon);
+    _port = colon == std::string::npos ? (https ? 443 : 80) : atoi(authority.c_str() + colon + 1);
+    return !_host.empty();
+  }
+
+  void setReuse(bool reuse) { _reuse = reuse; }
+  void setTimeout(uint16_t timeoutMs) { _timeoutMs = timeoutMs; }
+  void setConnectTimeout(int32_t timeoutMs) { _connectTimeoutMs = timeoutMs; }
+
+  // Kept across begin()/end(), as in arduino-esp32
+  void setUserAgent(const String& userAgent) { _userAgent = userAgent.s; }
+  void setAuthorizationType(const char* type) { _authorizationType = type; }
+  void setAuthorization(const char* token) {
+    if (token) {
+      _authorization = token;
+    }
+  }
+
+  void addHeader(const String& name, const String& value) {
+    for (auto& header : _requestHeaders) {
+      if (strcasecmp(header.first.c_str(), name.c_str()) == 0) {
+        header.second = value.s;
+        return;
+      }
+    }
+    _requestHeaders.push_back({name.s, value.s});
+  }
+
+  void collectHeaders(const char* keys[], size_t count) {
+    _collect.assign(keys, keys + count);
+  }
+  bool hasHeader(const char* name) { return _findHeader(name) != nullptr; }
+  String header(const char* name) {
+    const std::string* value = _findHeader(name);
+    return value ? String(*value) : String();
+  }
+
+  int GET() { return sendRequest("GET"); }
+  int POST(uint8_t* payload, size_t size) { return sendRequest("POST", payload, size); }
+  int POST(const String& payload) { return POST((uint8_t*)payload.c_str(), payload.length()); }
+  int PUT(uint8_t* payload, size_t size) { return sendRequest("PUT", payload, size); }
+  int PUT(const String& payload) { return PUT((uint8_t*)payload.c_str(), payload.length()); }
+
+  int sendRequest(const char* method, uint8_t* payload = nullptr, size_t size = 0) {
+    if (!_client) {
+      return HTTPC_ERROR_NOT_CONNECTED;
+    }
+    _responseHeaders.clear();
+    _size = -1;
+    _chunked = false;
+    _canReuse = _reuse;
+    _bodyRead = false;
+    if (!_client->connected() && !_client->connect(_host.c_str(), _port, _connectTimeoutMs)) {
+      return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+
+    std::string head = std::string(method) + " " + _path + " HTTP/1.1\r\nHost: " + _host;
+    if (_port != 80 && _port != 443) {
+      head += ":" + std::to_string(_port);
+    }
+    head += "\r\n";
+    if (!_findRequestHeader("User-Agent")) {
+      head += "User-Agent: " + _userAgent + "\r\n";
+    }
+    if (!_authorization.empty()) {
+      head += "Authorization: " + _authorizationType + " " + _authorization + "\r\n";
+    }
+    head += std::string("Connection: ") + (_reuse ? "keep-alive" : "close") + "\r\n";
+    if (payload && size > 0) {
+      head += "Content-Length: " + std::to_string(size) + "\r\n";
+    }
+    for (auto& header : _requestHeaders) {
+      head += header.first + ": " + header.second + "\r\n";
+    }
+    head += "\r\n";
+
+    if (_client->write((const uint8_t*)head.data(), head.size()) != head.size()) {
+      return HTTPC_ERROR_SEND_HEADER_FAILED;
+    }
+    if (payload && size > 0 && _client->write(payload, size) != size) {
+      return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+    }
+    return _readResponseHeader();
+  }
+
+  int getSize() { return _size; }
+  WiFiClient* getStreamPtr() { return _client && _client->connected() ? _client : nullptr; }
+  WiFiClient& getStream() { return *_client; }
+  bool connected() { return _client && _client->connected(); }
+
+  // Body into a stream (bytes written, or an HTTPC_ERROR code)
+  int writeToStream(Stream* stream) {
+    if (!stream) {
+      return HTTPC_ERROR_NO_STREAM;
+    }
+    if (!connected()) {
+      return HTTPC_ERROR_NOT_CONNECTED;
+    }
+    _bodyRead = true;
+    if (!_chunked) {
+      return _copyBody(stream, _size);
+    }
+
+    int total = 0;
+    for (;;) {
+      std::string line;
+      if (!_readLine(line)) {
+        return HTTPC_ERROR_READ_TIMEOUT;
+      }
+      long chunk = strtol(line.c_str(), nullptr, 16);
+      if (chunk <= 0) {
+        _readLine(line);    // Trailer terminator
+        return total;
+      }
+      int copied = _copyBody(stream, chunk);
+      if (copied < 0) {
+        return copied;
+      }
+      total += copied;
+      _readLine(line);
+    }
+  }
+
+  String getString() {
+    struct StringPrint : public Stream {
+      std::string text;
+      size_t write(const uint8_t* buffer, size_t size) override {
+        text.append((const char*)buffer, size);
+        return size;
+      }
+    } body;
+    if (_size != 0) {
+      writeToStream(&body);
+    }
+    return String(body.text);
+  }
+
+  void end() {
+    if (!_client) {
+      return;
+    }
+    // An unread body of known length is skipped so the connection can be
+    // reused; anything else ends it
+    if (!_bodyRead && _size > 0 && _canReuse) {
+      struct Discard : public Stream {
+        size_t write(const uint8_t*, size_t size) override { return size; }
+      } discard;
+      _bodyRead = _copyBody(&discard, _size) == _size;
+    }
+    bool bodyDone = _bodyRead || _size == 0;
+    if (!(_reuse && _canReuse && bodyDone && _client->connected())) {
+      _client->stop();
+    }
+    _size = -1;
+    _bodyRead = true;
+  }
+
+  static String errorToString(int error) {
+    switch (error) {
+      case HTTPC_ERROR_CONNECTION_REFUSED: return String("connection refused");
+      case HTTPC_ERROR_SEND_HEADER_FAILED: return String("send header failed");
+      case HTTPC_ERROR_SEND_PAYLOAD_FAILED: return String("send payload failed");
+      case HTTPC_ERROR_NOT_CONNECTED: return String("not connected");
+      case HTTPC_ERROR_CONNECTION_LOST: return String("connection lost");
+      case HTTPC_ERROR_NO_STREAM: return String("no stream");
+      case HTTPC_ERROR_NO_HTTP_SERVER: return String("no HTTP server");
+      case HTTPC_ERROR_TOO_LESS_RAM: return String("too less ram");
+      case HTTPC_ERROR_ENCODING: return String("Transfer-Encoding not supported");
+      case HTTPC_ERROR_STREAM_WRITE: return String("Stream write error");
+      case HTTPC_ERROR_READ_TIMEOUT: return String("read Timeout");
+      default: return String();
+    }
+  }
+
+private:
+  WiFiClient* _client = nullptr;
+  std::string _host;
+  std::string _path;
+  std::string _userAgent = "ESP32HTTPClient";
+  std::string _authorizationType = "Basic";
+  std::string _authorization;
+  uint16_t _port = 80;
+  bool _reuse = true;
+  bool _canReuse = false;
+  bool _chunked = false;
+  bool _bodyRead = true;
+  int _size = -1;
+  uint16_t _timeoutMs = HTTPCLIENT_DEFAULT_TCP_TIMEOUT;
+  int32_t _connectTimeoutMs = HTTPCLIENT_DEFAULT_TCP_TIMEOUT;
+  std::vector<std::pair<std::string, std::string>> _requestHeaders;
+  std::vector<std::pair<std::string, std::string>> _responseHeaders;
+  std::vector<std::string> _collect;
+
+  const std::string* _findHeader(const char* name) const {
+    for (auto& header : _responseHeaders) {
+      if (strcasecmp(header.first.c_str(), name) == 0) {
+        return &header.second;
+      }
+    }
+    return nullptr;
+  }
+
+  const std::string* _findRequestHeader(const char* name) const {
+    for (auto& header : _requestHeaders) {
+      if (strcasecmp(header.first.c_str(), name) == 0) {
+        return &header.second;
+      }
+    }
+    return nullptr;
+  }
+
+  bool _readLine(std::string& line) {
+    line.clear();
+    unsigned long start = millis();
+    while (millis() - start < _timeoutMs) {
+      int c = _client->read();
+      if (c < 0) {
+        if (!_client->connected()) {
+          return false;
+        }
+        delayMicroseconds(50);
+        continue;
+      }
+      if (c == '\n') {
+        if (!line.empty() && line.back() == '\r') {
+          line.pop_back();
+        }
+        return true;
+      }
+      line += (char)c;
+    }
+    return false;
+  }
+
+  int _readResponseHeader() {
+    std::string line;
+    int code = 0;
+    unsigned long start = millis();
+    for (;;) {
+      if (!_readLine(line)) {
+        _client->stop();
+        return millis() - start >= _timeoutMs ? HTTPC_ERROR_READ_TIMEOUT : HTTPC_ERROR_CONNECTION_LOST;
+      }
+      if (code == 0) {
+        if (line.compare(0, 5, "HTTP/") != 0) {
+          _client->stop();
+          return HTTPC_ERROR_NO_HTTP_SERVER;
+        }
+        code = atoi(line.c_str() + line.find(' ') + 1);
+        continue;
+      }
+      if (line.empty()) {
+        if (code == 100) {
+          code = 0;           // Interim response, the real one follows
+          continue;
+        }
+        break;
+      }
+
+      size_t colon = line.find(':');
+      if (colon == std::string::npos) {
+        continue;
+      }
+      std::string name = line.substr(0, colon);
+      std::string value = line.substr(line.find_first_not_of(' ', colon + 1) == std::string::npos ?
+                                      line.size() : line.find_first_not_of(' ', colon + 1));
+      if (strcasecmp(name.c_str(), "Content-Length") == 0) {
+        _size = atoi(value.c_str());
+      } else if (strcasecmp(name.c_str(), "Transfer-Encoding") == 0) {
+        _chunked = strcasecmp(value.c_str(), "chunked") == 0;
+      } else if (strcasecmp(name.c_str(), "Connection") == 0 && strcasecmp(value.c_str(), "close") == 0) {
+        _canReuse = false;
+      }
+      for (auto& key : _collect) {
+        if (strcasecmp(key.c_str(), name.c_str()) == 0) {
+          _responseHeaders.push_back({name, value});
+        }
+      }
+    }
+
+    // A body of unknown length ends with the connection
+    if (_size < 0 && !_chunked) {
+      _canReuse = false;
+    }
+    _bodyRead = _size == 0;
+    return code;
+  }
+
+  // length < 0: until the server closes
+  int _copyBody(Print* out, int length) {
+    uint8_t buffer[512];
+    int copied = 0;
+    unsigned long last = millis();
+    while (length < 0 || copied < length) {
+      size_t want = length < 0 ? sizeof(buffer) : min(sizeof(buffer), (size_t)(length - copied));
+      int n = _client->read(buffer, want);
+      if (n > 0) {
+        if (out->write(buffer, n) != (size_t)n) {
+          return HTTPC_ERROR_STREAM_WRITE;
+        }
+        copied += n;
+        last = millis();
+      } else if (!_client->connected()) {
+        break;
+      } else if (millis() - last >= _timeoutMs) {
+        return HTTPC_ERROR_READ_TIMEOUT;
+      } else {
+        delayMicroseconds(50);
+      }
+    }
+    return (length < 0 || copied == length) ? copied : HTTPC_ERROR_CONNECTION_LOST;
+  }
+};
+
+#endif // HOST_HTTPCLIENT_H
@@ -0,0 +1,77 @@
+/*
+ * SD.h - Host Stub of the SD Library
+ *
+ * This file maps the SD card onto a host directory (SDClass::root), so model
+ * files and logs can be staged on disk. Directory listing is not supported.
+ */
+
+#ifndef HOST_SD_H
+#define HOST_SD_H
+
+#include <Arduino.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define FILE_READ "rb"
+#define FILE_WRITE "wb"
+#define FILE_APPEND "ab"
+
+class File : public Stream {
+public:
+  File() {}
+  File(FILE* file, const std::string& path) : _file(file), _path(path) {}
+
+  operator bool() const { return _file != nullptr; }
+  size_t write(const uint8_t* buffer, size_t size) override { return _file ? fwrite(buffer, 1, size, _file) : 0; }
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  int read() override { return _file ? fgetc(_file) : -1; }
+  size_t read(uint8_t* buffer, size_t size) { return _file ? fread(buffer, 1, size, _file) : 0; }
+  int available() override { return _file ? (int)(size() - position()) : 0; }
+  bool seek(uint32_t position) { return _file && fseek(_file, position, SEEK_SET) == 0; }
+  size_t position() { return _file ? ftell(_file) : 0; }
+  size_t size() {
+    struct stat st;
+    return (_file && fstat(fileno(_file), &st) == 0) ? st.st_size : 0;
+  }
+  void flush() override {
+    if (_file) {
+      fflush(_file);
+    }
+  }
+  void close() {
+    if (_file) {
+      fclose(_file);
+    }
+    _file = nullptr;
+  }
+  bool isDirectory() { return false; }
+  const char* name() { return _path.c_str(); }
+  File openNextFile() { return File(); }
+
+private:
+  FILE* _file = nullptr;
+  std::string _path;
+};
+
+class SDClass {
+public:
+  std::string root = ".";   // Host directory standing in for the card
+
+  bool begin(int = 0) { return true; }
+  File open(const String& path, const char* mode = FILE_READ) { return File(fopen(_host(path).c_str(), mode), path.s); }
+  bool exists(const String& path) {
+    struct stat st;
+    return stat(_host(path).c_str(), &st) == 0;
+  }
+  bool mkdir(const String& path) { return ::mkdir(_host(path).c_str(), 0755) == 0; }
+  bool remove(const String& path) { return ::remove(_host(path).c_str()) == 0; }
+  bool rename(const String& from, const String& to) { return ::rename(_host(from).c_str(), _host(to).c_str()) == 0; }
+  uint64_t totalBytes() { return 1ull << 30; }
+  uint64_t usedBytes() { return 0; }
+
+private:
+  std::string _host(const String& path) { return root + path.s; }
+};
+extern SDClass SD;
+
+#endif // HOST_SD_H
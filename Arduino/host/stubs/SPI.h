@@ -0,0 +1,12 @@
+/*
+ * SPI.h - Host Stub
+ *
+ * Empty: the headers built on the host only need the include to resolve.
+ */
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <Arduino.h>
+
+#endif // HOST_SPI_H
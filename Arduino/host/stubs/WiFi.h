@@ -0,0 +1,46 @@
+/*
+ * WiFi.h - Host Stub of the WiFi Library
+ *
+ * The host is always associated; a test drops the link by setting
+ * WiFi.linkUp = false, which makes status() report WL_DISCONNECTED.
+ *
+ * Usage:
+ * 1. Define the global once next to Serial and ESP: WiFiClass WiFi;
+ */
+
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+#define WIFI_STA 1
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+class WiFiClass {
+public:
+  std::atomic<bool> linkUp{true};
+  int rssi = -60;
+
+  void mode(int) {}
+  void begin(const char*, const char*) {}
+  bool disconnect(bool = false) { return true; }
+  bool reconnect() { return true; }
+  void setAutoReconnect(bool) {}
+  wl_status_t status() { return linkUp ? WL_CONNECTED : WL_DISCONNECTED; }
+  int RSSI() { return linkUp ? rssi : 0; }
+  IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+  String SSID() { return String("host"); }
+  String macAddress() { return String("00:00:00:00:00:00"); }
+};
+extern WiFiClass WiFi;
+
+#endif // HOST_WIFI_H
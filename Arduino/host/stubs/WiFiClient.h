@@ -0,0 +1,196 @@
+/*
+ * WiFiClient.h - Host Stub of the WiFi TCP Client
+ *
+ * This file implements WiFiClient on POSIX sockets, so the network headers
+ * (ResumableTLSClient, HTTPClient, CommandChannel) talk to real servers on
+ * the host, e.g. host/fake_dashboard.py on 127.0.0.1.
+ *
+ * Features:
+ * - Blocking connect with a timeout, TCP_NODELAY like lwIP's default
+ * - Non-blocking read()/available(); connected() stays true while unread
+ *   bytes remain after the peer closed, as on the device
+ * - Byte counters (sent/received) for traffic checks
+ */
+
+#ifndef HOST_WIFICLIENT_H
+#define HOST_WIFICLIENT_H
+
+#include <Arduino.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+class IPAddress {
+public:
+  IPAddress() : _bytes{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _bytes{a, b, c, d} {}
+
+  uint8_t operator[](int i) const { return _bytes[i]; }
+  String toString() const {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2], _bytes[3]);
+    return String(text);
+  }
+
+private:
+  uint8_t _bytes[4];
+};
+
+class WiFiClient : public Stream {
+public:
+  uint64_t sent = 0;       // Bytes written to the socket
+  uint64_t received = 0;   // Bytes read from it
+
+  WiFiClient() {}
+  WiFiClient(const WiFiClient&) = delete;
+  WiFiClient& operator=(const WiFiClient&) = delete;
+  virtual ~WiFiClient() { _close(); }
+
+  virtual int connect(IPAddress ip, uint16_t port) { return connect(ip, port, 3000); }
+  virtual int connect(IPAddress ip, uint16_t port, int32_t timeout) {
+    return connect(ip.toString().c_str(), port, timeout);
+  }
+  virtual int connect(const char* host, uint16_t port) { return connect(host, port, 3000); }
+  virtual int connect(const char* host, uint16_t port, int32_t timeout) {
+    _close();
+    addrinfo hints = {};
+    addrinfo* found = nullptr;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+    if (getaddrinfo(host, service, &hints, &found) != 0) {
+      return 0;
+    }
+
+    // Non-blocking connect bounded by the timeout, then back to blocking
+    int fd = socket(found->ai_family, SOCK_STREAM, 0);
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    int ret = ::connect(fd, found->ai_addr, found->ai_addrlen);
+    freeaddrinfo(found);
+    if (ret != 0 && errno == EINPROGRESS) {
+      pollfd waiting = {fd, POLLOUT, 0};
+      int error = 0;
+      socklen_t length = sizeof(error);
+      ret = (poll(&waiting, 1, timeout > 0 ? timeout : 3000) == 1 &&
+             getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0) ? 0 : -1;
+    }
+    if (ret != 0) {
+      ::close(fd);
+      return 0;
+    }
+    fcntl(fd, F_SETFL, 0);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    _fd = fd;
+    _peek = -1;
+    return 1;
+  }
+
+  using Print::write;
+  size_t write(uint8_t data) override { return write(&data, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override {
+    size_t done = 0;
+    while (_fd >= 0 && done < size) {
+      ssize_t n = ::send(_fd, buffer + done, size - done, MSG_NOSIGNAL);
+      if (n <= 0) {
+        _close();
+        break;
+      }
+      done += n;
+    }
+    sent += done;
+    return done;
+  }
+
+  int available() override {
+    if (_fd < 0) {
+      return 0;
+    }
+    int pending = 0;
+    ioctl(_fd, FIONREAD, &pending);
+    return pending + (_peek >= 0 ? 1 : 0);
+  }
+
+  int read() override {
+    uint8_t data;
+    return read(&data, 1) == 1 ? data : -1;
+  }
+
+  virtual int read(uint8_t* buffer, size_t size) {
+    if (_fd < 0 || size == 0) {
+      return -1;
+    }
+    size_t done = 0;
+    if (_peek >= 0) {
+      buffer[done++] = (uint8_t)_peek;
+      _peek = -1;
+    }
+    ssize_t n = done < size ? recv(_fd, buffer + done, size - done, MSG_DONTWAIT) : 0;
+    if (n > 0) {
+      done += n;
+      received += n;
+    } else if (n == 0 && done < size) {
+      _peerClosed = true;
+    }
+    return done > 0 ? (int)done : -1;
+  }
+
+  int peek() override {
+    if (_peek < 0) {
+      uint8_t data;
+      if (_fd >= 0 && recv(_fd, &data, 1, MSG_DONTWAIT) == 1) {
+        _peek = data;
+        received++;
+      }
+    }
+    return _peek;
+  }
+
+  void flush() override {}
+  virtual void clear() {
+    uint8_t discard[256];
+    while (available() > 0 && read(discard, sizeof(discard)) > 0) {
+    }
+  }
+  virtual void stop() { _close(); }
+
+  virtual uint8_t connected() {
+    if (_fd < 0) {
+      return 0;
+    }
+    if (available() > 0) {
+      return 1;
+    }
+    char probe;
+    ssize_t n = recv(_fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (_peerClosed || n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+      _close();
+      return 0;
+    }
+    return 1;
+  }
+  operator bool() { return connected(); }
+
+private:
+  int _fd = -1;
+  int _peek = -1;
+  bool _peerClosed = false;
+
+  void _close() {
+    if (_fd >= 0) {
+      ::close(_fd);
+    }
+    _fd = -1;
+    _peek = -1;
+    _peerClosed = false;
+  }
+};
+
+#endif // HOST_WIFICLIENT_H
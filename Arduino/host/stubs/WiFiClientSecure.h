@@ -0,0 +1,12 @@
+/*
+ * WiFiClientSecure.h - Host Stub
+ *
+ * Empty: the headers built on the host only need the include to resolve.
+ */
+
+#ifndef HOST_WIFICLIENTSECURE_H
+#define HOST_WIFICLIENTSECURE_H
+
+#include <Arduino.h>
+
+#endif // HOST_WIFICLIENTSECURE_H
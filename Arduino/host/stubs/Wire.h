@@ -0,0 +1,12 @@
+/*
+ * Wire.h - Host Stub
+ *
+ * Empty: the headers built on the host only need the include to resolve.
+ */
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+
+#endif // HOST_WIRE_H
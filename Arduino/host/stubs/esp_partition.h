@@ -0,0 +1,39 @@
+/*
+ * esp_partition.h - Host Stub of the ESP-IDF Partition API
+ *
+ * There is no flash on the host: no partition is ever found, so ModelStore
+ * falls back to the SD stub and compiled-in weights.
+ */
+
+#ifndef HOST_ESP_PARTITION_H
+#define HOST_ESP_PARTITION_H
+
+#include <cstddef>
+#include <cstdint>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef int esp_partition_type_t;
+typedef int esp_partition_subtype_t;
+typedef uint32_t esp_partition_mmap_handle_t;
+#define ESP_PARTITION_TYPE_DATA 1
+#define ESP_PARTITION_MMAP_DATA 0
+
+struct esp_partition_t {
+  uint32_t address;
+  uint32_t size;
+  char label[17];
+};
+
+inline const esp_partition_t* esp_partition_find_first(int, esp_partition_subtype_t, const char*) {
+  return nullptr;
+}
+
+inline esp_err_t esp_partition_mmap(const esp_partition_t*, size_t, size_t, int, const void**,
+                                    esp_partition_mmap_handle_t*) {
+  return ESP_FAIL;
+}
+
+#endif // HOST_ESP_PARTITION_H
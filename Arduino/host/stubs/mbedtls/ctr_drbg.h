@@ -0,0 +1,12 @@
+/*
+ * mbedtls/ctr_drbg.h - Host Declarations for the System mbedTLS 2.28
+ *
+ * Declared together with the SSL calls in mbedtls/ssl.h.
+ */
+
+#ifndef HOST_MBEDTLS_CTR_DRBG_H
+#define HOST_MBEDTLS_CTR_DRBG_H
+
+#include "ssl.h"
+
+#endif // HOST_MBEDTLS_CTR_DRBG_H
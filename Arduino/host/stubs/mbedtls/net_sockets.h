@@ -0,0 +1,12 @@
+/*
+ * mbedtls/net_sockets.h - Host Declarations for the System mbedTLS 2.28
+ *
+ * Declared together with the SSL calls in mbedtls/ssl.h.
+ */
+
+#ifndef HOST_MBEDTLS_NET_SOCKETS_H
+#define HOST_MBEDTLS_NET_SOCKETS_H
+
+#include "ssl.h"
+
+#endif // HOST_MBEDTLS_NET_SOCKETS_H
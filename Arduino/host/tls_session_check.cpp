@@ -0,0 +1,170 @@
+/*
+ * tls_session_check.cpp - TLS Session Resumption Check
+ *
+ * This program sends keep-alive POSTs through ResumableTLSClient to
+ * fake_dashboard.py serving TLS 1.2, and reports handshakes (full and
+ * resumed), time per request and the peak heap held by mbedTLS.
+ *
+ * Features:
+ * - --fresh reproduces the old pattern: a new connection and a full
+ *   handshake per request
+ * - Server-side closes (fake_dashboard.py --close-every N) show resumption
+ * - mbedTLS allocations are counted by interposing calloc/free
+ *
+ * Build (from Arduino/):
+ *   g++ -O1 -std=gnu++17 -pthread -Ihost/stubs -IEV_Secure_ESP32S3_Complete \
+ *       host/tls_session_check.cpp -o tls_session_check \
+ *       -l:libmbedtls.so.14 -l:libmbedx509.so.1 -l:libmbedcrypto.so.7
+ *
+ * Usage:
+ *   openssl req -x509 -newkey rsa:2048 -nodes -days 1 -subj /CN=localhost \
+ *       -keyout key.pem -out cert.pem
+ *   python3 host/fake_dashboard.py --port 8443 --tls cert.pem key.pem [--close-every N] &
+ *   tls_session_check [options]
+ *     --port N          server port (default 8443)
+ *     --requests N      POSTs to send (default 200)
+ *     --body N          body bytes per POST (default 1200)
+ *     --fresh           close and forget the session before every request
+ */
+
+#include "ResumableTLSClient.h"
+#include <malloc.h>
+#include <unordered_set>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+struct CheckOptions {
+  int port = 8443;
+  int requests = 200;
+  int body = 1200;
+  bool fresh = false;
+};
+
+// Heap held by mbedTLS (it allocates with calloc)
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void __libc_free(void* p);
+
+static bool tracking = false;
+static long heapNow = 0;
+static long heapPeak = 0;
+static std::unordered_set<void*>* live = nullptr;
+
+extern "C" void* calloc(size_t count, size_t size) {
+  void* p = __libc_calloc(count, size);
+  if (p && tracking) {
+    tracking = false;
+    live->insert(p);
+    tracking = true;
+    heapNow += malloc_usable_size(p);
+    heapPeak = max(heapPeak, heapNow);
+  }
+  return p;
+}
+
+extern "C" void free(void* p) {
+  if (p && tracking) {
+    tracking = false;
+    if (live->erase(p)) {
+      heapNow -= malloc_usable_size(p);
+    }
+    tracking = true;
+  }
+  __libc_free(p);
+}
+
+// One POST on the open (or reopened) connection; false on any failure
+static bool post(ResumableTLSClient& client, const CheckOptions& options, const std::string& body) {
+  if (!client.connected() && !client.connect("localhost", options.port, 5000)) {
+    return false;
+  }
+  std::string request = "POST /api/data HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\n"
+                        "Connection: keep-alive\r\nContent-Length: " + std::to_string(body.size()) +
+                        "\r\n\r\n" + body;
+  if (client.write((const uint8_t*)request.data(), request.size()) != request.size()) {
+    return false;
+  }
+
+  std::string head;
+  long length = -1;
+  unsigned long start = millis();
+  while (millis() - start < 5000 && length < 0) {
+    int c = client.read();
+    if (c < 0) {
+      if (!client.connected()) {
+        break;
+      }
+      continue;
+    }
+    head += (char)c;
+    if (head.size() >= 4 && head.compare(head.size() - 4, 4, "\r\n\r\n") == 0) {
+      size_t at = head.find("Content-Length: ");
+      length = at == std::string::npos ? 0 : atol(head.c_str() + at + 16);
+    }
+  }
+  for (long got = 0; got < length && millis() - start < 5000;) {
+    uint8_t buffer[64];
+    int n = client.read(buffer, sizeof(buffer));
+    if (n > 0) {
+      got += n;
+    }
+  }
+  if (head.find("Connection: close") != std::string::npos) {
+    client.stop();
+  }
+  return head.compare(0, 12, "HTTP/1.1 200") == 0;
+}
+
+static bool parseOptions(int argc, char** argv, CheckOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--port" && hasValue) {
+      options.port = atoi(argv[++i]);
+    } else if (arg == "--requests" && hasValue) {
+      options.requests = max(1, atoi(argv[++i]));
+    } else if (arg == "--body" && hasValue) {
+      options.body = max(0, atoi(argv[++i]));
+    } else if (arg == "--fresh") {
+      options.fresh = true;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  CheckOptions options;
+  if (!parseOptions(argc, argv, options)) {
+    fprintf(stderr, "usage: %s [--port N] [--requests N] [--body N] [--fresh]\n", argv[0]);
+    return 2;
+  }
+  Serial.mute = true;
+
+  ResumableTLSClient client;
+  client.setInsecure();
+  std::string body(options.body, 'x');
+  live = new std::unordered_set<void*>();
+  tracking = true;
+
+  uint64_t start = hostNanos();
+  int ok = 0;
+  for (int i = 0; i < options.requests; i++) {
+    if (options.fresh) {
+      client.stop();
+      client.clearSession();
+    }
+    ok += post(client, options, body);
+  }
+  double ms = (hostNanos() - start) / 1e6;
+
+  printf("%s: %d/%d ok, handshakes %u (resumed %u), %.2f ms per handshake, %.2f ms per request, "
+         "peak TLS heap %ld B, held %ld B\n",
+         options.fresh ? "fresh" : "keep-alive", ok, options.requests, client.getHandshakeCount(),
+         client.getResumedCount(),
+         client.getHandshakeCount() ? (double)client.getHandshakeMillis() / client.getHandshakeCount() : 0.0,
+         ms / options.requests, heapPeak, heapNow);
+  fflush(stdout);
+  _exit(ok == options.requests ? 0 : 1);
+}
@@ -0,0 +1,241 @@
+/*
+ * tree_parity_check.cpp - Compiled Tree Ensemble Parity Check
+ *
+ * This program walks the trees of a model JSON (the input of model_tool.py
+ * forest) in floating point, as scikit-learn does, and compares every score
+ * with TreeEnsemble::quantize() + the generated ForestModel.h.
+ *
+ * Features:
+ * - Inputs at every split threshold (the float below, at and above it, and
+ *   half a fixed-point step either side) plus random inputs over the range
+ *   the thresholds span
+ * - Codegen: the generated compares must equal a fixed-point walk of the JSON
+ *   with model_tool.py's floored thresholds (tree_limit()), on every input
+ * - Quantization: a score may differ from the float walk only where an input
+ *   lies above a threshold but inside its last fixed-point step (the step
+ *   floors onto the threshold's value and goes left); any other difference,
+ *   e.g. an input below a threshold sent right, is a failure
+ *
+ * Build (from Arduino/):
+ *   python3 tools/model_tool.py forest --model forest.json --out /tmp/forest/ForestModel.h
+ *   g++ -O1 -std=gnu++17 -I/tmp/forest -Ihost/stubs -IEV_Secure_ESP32S3_Complete \
+ *       host/tree_parity_check.cpp -o tree_parity_check
+ *
+ * Usage:
+ *   tree_parity_check --model forest.json [options]
+ *     --model FILE      model JSON the header was generated from
+ *     --samples N       random inputs (default 100000)
+ *     --seed N          random seed (default 1)
+ */
+
+#include "TreeEnsemble.h"
+#include <ArduinoJson.h>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+HardwareSerial Serial;
+EspClass ESP;
+SDClass SD;
+SystemState currentState = STATE_IDLE;
+
+struct CheckOptions {
+  std::string model;
+  long samples = 100000;
+  unsigned seed = 1;
+};
+
+struct Tree {
+  std::vector<int> left;
+  std::vector<int> right;
+  std::vector<int> feature;
+  std::vector<double> threshold;
+  std::vector<int32_t> leaf;      // Q12, rounded as model_tool.py rounds
+};
+
+static const int32_t scales[INPUT_FEATURES] = TREE_FEATURE_SCALES;
+
+static std::vector<Tree> trees;
+static int32_t baseMargin = 0;
+
+// model_tool.py tree_limit(): the threshold rounded down to a float, floored as quantize() floors
+static int32_t limitOf(const Tree& tree, int node) {
+  double threshold = tree.threshold[node];
+  float t = (float)threshold;
+  if (t > threshold) {
+    t = nextafterf(t, -INFINITY);
+  }
+  return (int32_t)floorf(t * scales[tree.feature[node]]);
+}
+
+// Float walk (scikit-learn) and fixed-point walk with the floored thresholds;
+// a split they disagree on is within resolution when the input sits in the
+// threshold's last fixed-point step
+static int32_t walk(const Tree& tree, const float* x, const int32_t* q, bool fixed, bool& unexplained) {
+  int node = 0;
+  while (tree.left[node] != -1) {
+    int f = tree.feature[node];
+    bool floatLeft = (double)x[f] <= tree.threshold[node];
+    bool fixedLeft = q[f] <= limitOf(tree, node);
+    if (floatLeft != fixedLeft && !(fixedLeft && q[f] == limitOf(tree, node))) {
+      unexplained = true;
+    }
+    node = (fixed ? fixedLeft : floatLeft) ? tree.left[node] : tree.right[node];
+  }
+  return tree.leaf[node];
+}
+
+static bool loadModel(const std::string& path) {
+  std::ifstream file(path);
+  std::stringstream text;
+  text << file.rdbuf();
+  std::string json = text.str();
+  DynamicJsonDocument doc(json.size() * 16 + 1024);
+  if (json.empty() || deserializeJson(doc, json.c_str(), json.size())) {
+    return false;
+  }
+
+  bool boosted = strcmp(doc["kind"] | "", "boosted") == 0;
+  baseMargin = boosted ? (int32_t)nearbyint((doc["base_margin"] | 0.0) * (1 << TREE_LEAF_SHIFT)) : 0;
+  for (JsonVariant entry : doc["trees"].as<JsonArray>()) {
+    Tree tree;
+    size_t nodes = entry["children_left"].size();
+    for (size_t i = 0; i < nodes; i++) {
+      tree.left.push_back(entry["children_left"][(int)i].as<int>());
+      tree.right.push_back(entry["children_right"][(int)i].as<int>());
+      tree.feature.push_back(entry["feature"][(int)i].as<int>());
+      tree.threshold.push_back(entry["threshold"][(int)i].as<double>());
+      tree.leaf.push_back((int32_t)nearbyint(entry["value"][(int)i].as<double>() * (1 << TREE_LEAF_SHIFT)));
+    }
+    trees.push_back(tree);
+  }
+  return !trees.empty();
+}
+
+static bool parseOptions(int argc, char** argv, CheckOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--model" && hasValue) {
+      options.model = argv[++i];
+    } else if (arg == "--samples" && hasValue) {
+      options.samples = atol(argv[++i]);
+    } else if (arg == "--seed" && hasValue) {
+      options.seed = (unsigned)atol(argv[++i]);
+    } else {
+      return false;
+    }
+  }
+  return !options.model.empty();
+}
+
+int main(int argc, char** argv) {
+  CheckOptions options;
+  if (!parseOptions(argc, argv, options)) {
+    fprintf(stderr, "usage: %s --model FILE [--samples N] [--seed N]\n", argv[0]);
+    return 2;
+  }
+  if (!TreeEnsemble::isAvailable()) {
+    fprintf(stderr, "no ForestModel.h on the include path\n");
+    return 1;
+  }
+  if (!loadModel(options.model)) {
+    fprintf(stderr, "could not read %s\n", options.model.c_str());
+    return 1;
+  }
+  size_t nodes = 0;
+  for (const Tree& tree : trees) {
+    nodes += tree.left.size();
+  }
+  if ((int)trees.size() != TreeEnsemble::getTreeCount() || (int)nodes != TreeEnsemble::getNodeCount()) {
+    fprintf(stderr, "%s has %zu trees, %zu nodes; ForestModel.h has %d, %d\n", options.model.c_str(),
+            trees.size(), nodes, TreeEnsemble::getTreeCount(), TreeEnsemble::getNodeCount());
+    return 1;
+  }
+
+  // Inputs range over the thresholds seen per feature, with a margin
+  double low[INPUT_FEATURES];
+  double high[INPUT_FEATURES];
+  std::vector<std::pair<int, double>> splits;
+  for (int f = 0; f < INPUT_FEATURES; f++) {
+    low[f] = 0;
+    high[f] = 1;
+  }
+  for (const Tree& tree : trees) {
+    for (size_t i = 0; i < tree.left.size(); i++) {
+      if (tree.left[i] != -1) {
+        splits.push_back({tree.feature[i], tree.threshold[i]});
+      }
+    }
+  }
+  for (int f = 0; f < INPUT_FEATURES; f++) {
+    bool seen = false;
+    for (const auto& split : splits) {
+      if (split.first == f) {
+        low[f] = seen ? std::min(low[f], split.second) : split.second;
+        high[f] = seen ? std::max(high[f], split.second) : split.second;
+        seen = true;
+      }
+    }
+    double margin = std::max((high[f] - low[f]) * 0.1, 1.0 / scales[f]);
+    low[f] -= margin;
+    high[f] += margin;
+  }
+
+  std::mt19937 rng(options.seed);
+  long inputs = 0;
+  long codegenMismatches = 0;
+  long withinStep = 0;
+  long unexplained = 0;
+  auto check = [&](const float* x) {
+    int32_t q[INPUT_FEATURES];
+    TreeEnsemble::quantize(x, q);
+    int32_t compiled = TreeEnsemble::score(q);
+    int32_t fixed = baseMargin;
+    int32_t reference = baseMargin;
+    bool wrong = false;
+    for (const Tree& tree : trees) {
+      fixed += walk(tree, x, q, true, wrong);
+      reference += walk(tree, x, q, false, wrong);
+    }
+    inputs++;
+    codegenMismatches += compiled != fixed;
+    if (compiled != reference) {
+      withinStep += !wrong;
+    }
+    unexplained += wrong;
+  };
+
+  float x[INPUT_FEATURES];
+  auto randomize = [&]() {
+    for (int f = 0; f < INPUT_FEATURES; f++) {
+      x[f] = (float)std::uniform_real_distribution<double>(low[f], high[f])(rng);
+    }
+    x[INPUT_FEATURES - 1] = roundf(x[INPUT_FEATURES - 1]);  // SystemState is a whole number
+  };
+  for (const auto& split : splits) {
+    int f = split.first;
+    float at = (float)split.second;
+    double half = 0.5 / scales[f];
+    float probes[] = {nextafterf(at, -INFINITY), at, nextafterf(at, INFINITY),
+                      (float)(split.second - half), (float)(split.second + half)};
+    for (float probe : probes) {
+      randomize();
+      x[f] = probe;
+      check(x);
+    }
+  }
+  for (long i = 0; i < options.samples; i++) {
+    randomize();
+    check(x);
+  }
+
+  printf("%s: %zu trees, %zu nodes, %zu B of code; %ld inputs (%zu at thresholds)\n", options.model.c_str(),
+         trees.size(), nodes, TreeEnsemble::getCodeBytes(), inputs, splits.size() * 5);
+  printf("  codegen: %ld scores differ from the fixed-point walk of the JSON\n", codegenMismatches);
+  printf("  quantization: %ld scores differ from the float walk inside a threshold's last step, "
+         "%ld elsewhere\n",
+         withinStep, unexplained);
+  return codegenMismatches == 0 && unexplained == 0 ? 0 : 1;
+}
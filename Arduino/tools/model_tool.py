@@ -0,0 +1,508 @@
+#!/usr/bin/env python3
+"""
+Model file tool for EV-Secure ESP32-S3 firmware
+
+Packs trained weights into the versioned .evm container read by ModelStore.h,
+inspects existing containers, and builds the image for the "models" flash
+partition.
+
+Usage:
+  model_tool.py pack --type lstm --weights lstm.json --out model_0.evm
+  model_tool.py inspect model_0.evm
+  model_tool.py image model_0.evm model_1.evm --out models.bin
+  esptool.py --chip esp32s3 write_flash 0x310000 models.bin
+  model_tool.py codegen model_0.evm model_1.evm model_16.evm --out ../EV_Secure_ESP32S3_Complete/ModelWeights.h
+  model_tool.py forest --model forest.json --out ../EV_Secure_ESP32S3_Complete/ForestModel.h
+
+The weights JSON maps each tensor name (see LAYOUTS) to a nested list with the
+tensor's shape. Missing tensors are an error; extra keys are ignored.
+
+The networks take SCALED_FEATURES normalized inputs (see FeatureScaler.h). Pack
+the statistics the weights were trained under as well, e.g.
+  {"count": [5000], "mean": [...5], "m2": [...5]}  ->  --type scaler
+
+codegen turns containers into constexpr tables that the compiler places in
+flash (.rodata). EnhancedMLModel.h picks the header up when it exists and uses
+the tables in place whenever the models partition and SD card hold nothing.
+
+forest compiles a tree ensemble into nested integer compares (TreeEnsemble.h).
+The JSON holds the arrays of a fitted scikit-learn tree per entry of "trees"
+(tree_.children_left/children_right/feature/threshold, -1 = leaf) plus one
+leaf value per node, trained on the raw INPUT_FEATURES in FeatureVector order:
+  {"kind": "forest" | "boosted", "base_margin": 0.0,
+   "trees": [{"children_left": [...], "children_right": [...],
+              "feature": [...], "threshold": [...], "value": [...]}]}
+For "forest" a leaf value is the threat probability and the trees are
+averaged; for "boosted" it is the log-odds contribution (learning rate
+applied) and the trees are summed onto base_margin.
+The trees are also compiled once (--cc, default the ESP32-S3 toolchain when
+it is on PATH, else the host c++) to record their code size as
+FOREST_CODE_BYTES; host/tree_parity_check.cpp checks the generated header
+against the JSON.
+"""
+
+import argparse
+import json
+import math
+import os
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+import zlib
+
+MAGIC = 0x464D5645  # "EVMF"
+VERSION = 2
+ALIGN = 16
+HEADER = struct.Struct("<IHHIIIHH8x")
+
+# Must match EV_Secure_Config.h / EnhancedMLModel.h / FeatureScaler.h
+SENSOR_FEATURES = 5
+SCALED_FEATURES = 11
+LSTM_HIDDEN_SIZE = 32
+ENSEMBLE_MODELS = 4
+INPUT_FEATURES = 6
+
+MODEL_TYPES = {"lstm": 0, "autoencoder": 1, "ensemble": 2, "scaler": 16}
+
+# Tensor order and shapes of the firmware structs
+LAYOUTS = {
+    "lstm": [
+        ("Wf", (SCALED_FEATURES, LSTM_HIDDEN_SIZE)),
+        ("Wi", (SCALED_FEATURES, LSTM_HIDDEN_SIZE)),
+        ("Wo", (SCALED_FEATURES, LSTM_HIDDEN_SIZE)),
+        ("Wc", (SCALED_FEATURES, LSTM_HIDDEN_SIZE)),
+        ("Uf", (LSTM_HIDDEN_SIZE, LSTM_HIDDEN_SIZE)),
+        ("Ui", (LSTM_HIDDEN_SIZE, LSTM_HIDDEN_SIZE)),
+        ("Uo", (LSTM_HIDDEN_SIZE, LSTM_HIDDEN_SIZE)),
+        ("Uc", (LSTM_HIDDEN_SIZE, LSTM_HIDDEN_SIZE)),
+        ("bf", (LSTM_HIDDEN_SIZE,)),
+        ("bi", (LSTM_HIDDEN_SIZE,)),
+        ("bo", (LSTM_HIDDEN_SIZE,)),
+        ("bc", (LSTM_HIDDEN_SIZE,)),
+        ("Wy", (LSTM_HIDDEN_SIZE, 1)),
+        ("by", (1,)),
+    ],
+    "autoencoder": [
+        ("W1", (SCALED_FEATURES, 8)),
+        ("b1", (8,)),
+        ("W2", (8, 4)),
+        ("b2", (4,)),
+        ("W3", (4, 8)),
+        ("b3", (8,)),
+        ("W4", (8, SCALED_FEATURES)),
+        ("b4", (SCALED_FEATURES,)),
+    ],
+    "ensemble": [
+        ("weights", (ENSEMBLE_MODELS,)),
+    ],
+    # Running statistics of the raw sensor features (m2 = sum of squared deviations)
+    "scaler": [
+        ("count", (1,)),
+        ("mean", (SENSOR_FEATURES,)),
+        ("m2", (SENSOR_FEATURES,)),
+    ],
+}
+
+# codegen: C++ type, symbol and feature macro per model (None = plain float array)
+CODEGEN = {
+    "lstm": ("LSTMModel", "compiledLSTMWeights", "MODEL_WEIGHTS_LSTM"),
+    "autoencoder": ("AutoencoderModel", "compiledAutoencoderWeights", "MODEL_WEIGHTS_AUTOENCODER"),
+    "ensemble": (None, "compiledEnsembleWeights", "MODEL_WEIGHTS_ENSEMBLE"),
+    "scaler": ("FeatureScalerState", "compiledScalerState", "MODEL_WEIGHTS_SCALER"),
+}
+SCALAR_FIELDS = {("scaler", "count")}
+
+# Must match TreeEnsemble.h
+TREE_FEATURE_SCALES = [1000, 100, 1, 1000, 100, 1]
+TREE_FEATURE_NAMES = ["current", "voltage", "power", "frequency", "temperature", "state"]
+TREE_LEAF_SHIFT = 12
+TREE_KINDS = {"forest": "TREE_KIND_FOREST", "boosted": "TREE_KIND_BOOSTED"}
+TREE_COMPILERS = ["xtensa-esp32s3-elf-g++", "c++"]
+TREE_CODE_SECTIONS = (".text", ".literal", ".rodata")
+
+
+def flatten(values, shape, name):
+    flat = []
+
+    def walk(v, depth):
+        if depth == len(shape):
+            flat.append(float(v))
+            return
+        if len(v) != shape[depth]:
+            raise ValueError(f"{name}: expected dim {depth} = {shape[depth]}, got {len(v)}")
+        for item in v:
+            walk(item, depth + 1)
+
+    walk(values, 0)
+    return flat
+
+
+def pack(args):
+    with open(args.weights) as f:
+        tensors = json.load(f)
+
+    floats = []
+    for name, shape in LAYOUTS[args.type]:
+        if name not in tensors:
+            sys.exit(f"missing tensor '{name}' for {args.type}")
+        floats += flatten(tensors[name], shape, name)
+
+    payload = struct.pack(f"<{len(floats)}f", *floats)
+    header = HEADER.pack(MAGIC, VERSION, MODEL_TYPES[args.type], len(payload),
+                         zlib.crc32(payload), int(time.time()), SCALED_FEATURES, 0)
+
+    with open(args.out, "wb") as f:
+        f.write(header + payload)
+    print(f"{args.out}: {args.type}, {len(floats)} weights, {len(header) + len(payload)} bytes")
+
+
+def read_container(data, where):
+    if len(data) < HEADER.size:
+        raise ValueError(f"{where}: truncated header")
+    fields = HEADER.unpack_from(data)
+    magic, version, model_type, size, crc, created, inputs, flags = fields
+    if magic != MAGIC:
+        raise ValueError(f"{where}: bad magic 0x{magic:08x}")
+    payload = data[HEADER.size:HEADER.size + size]
+    if len(payload) != size:
+        raise ValueError(f"{where}: truncated payload")
+    return fields, payload
+
+
+def inspect(args):
+    status = 0
+    for path in args.files:
+        with open(path, "rb") as f:
+            data = f.read()
+        try:
+            (magic, version, model_type, size, crc, created, inputs, flags), payload = read_container(data, path)
+        except ValueError as e:
+            print(e)
+            status = 1
+            continue
+
+        names = {v: k for k, v in MODEL_TYPES.items()}
+        crc_ok = zlib.crc32(payload) == crc
+        print(f"{path}")
+        print(f"  version:    {version}")
+        print(f"  model_type: {model_type} ({names.get(model_type, 'unknown')})")
+        print(f"  payload:    {size} bytes, crc32 0x{crc:08x} {'OK' if crc_ok else 'MISMATCH'}")
+        print(f"  created:    {time.strftime('%Y-%m-%d %H:%M:%S', time.gmtime(created)) if created else 'unknown'}")
+        print(f"  inputs:     {inputs}, flags 0x{flags:04x}")
+        if not crc_ok:
+            status = 1
+            continue
+
+        layout = LAYOUTS.get(names.get(model_type))
+        if layout:
+            values = struct.unpack(f"<{size // 4}f", payload)
+            offset = 0
+            for name, shape in layout:
+                count = 1
+                for d in shape:
+                    count *= d
+                t = values[offset:offset + count]
+                offset += count
+                print(f"    {name:8s} {str(shape):10s} min {min(t):+.4f} max {max(t):+.4f} "
+                      f"mean {sum(t) / count:+.4f}")
+    return status
+
+
+def image(args):
+    out = bytearray()
+    for path in args.files:
+        with open(path, "rb") as f:
+            data = f.read()
+        fields, payload = read_container(data, path)
+        if zlib.crc32(payload) != fields[4]:
+            sys.exit(f"{path}: crc mismatch")
+        entry = data[:HEADER.size + len(payload)]
+        out += entry + b"\xff" * (-len(entry) % ALIGN)
+
+    if len(out) > args.size:
+        sys.exit(f"image is {len(out)} bytes, partition holds {args.size}")
+
+    with open(args.out, "wb") as f:
+        f.write(out)
+    print(f"{args.out}: {len(args.files)} models, {len(out)} bytes")
+
+
+def float_literal(value):
+    """Shortest C++ float literal that round-trips the float32 value."""
+    if value != value or value in (float("inf"), float("-inf")):
+        raise ValueError(f"non-finite weight {value}")
+    bits = struct.pack("<f", value)
+    for digits in range(6, 10):
+        text = f"{value:.{digits}g}"
+        if struct.pack("<f", float(text)) == bits:
+            break
+    if "." not in text and "e" not in text:
+        text += ".0"
+    return text + "f"
+
+
+def c_initializer(values, shape, indent):
+    if len(shape) == 1:
+        return "{" + ", ".join(float_literal(v) for v in values) + "}"
+    step = len(values) // shape[0]
+    rows = [c_initializer(values[i * step:(i + 1) * step], shape[1:], indent + "  ")
+            for i in range(shape[0])]
+    inner = ",\n".join(indent + "  " + r for r in rows)
+    return "{\n" + inner + "\n" + indent + "}"
+
+
+def codegen(args):
+    sections = []
+    sources = []
+    seen = set()
+    for path in args.files:
+        with open(path, "rb") as f:
+            data = f.read()
+        (magic, version, model_type, size, crc, created, inputs, flags), payload = read_container(data, path)
+        names = {v: k for k, v in MODEL_TYPES.items()}
+        name = names.get(model_type)
+        if zlib.crc32(payload) != crc:
+            sys.exit(f"{path}: crc mismatch")
+        if version != VERSION or inputs != SCALED_FEATURES:
+            sys.exit(f"{path}: version {version} / {inputs} inputs, expected {VERSION} / {SCALED_FEATURES}")
+        if name not in CODEGEN or name in seen:
+            sys.exit(f"{path}: unsupported or duplicate model type {model_type}")
+        seen.add(name)
+
+        values = struct.unpack(f"<{size // 4}f", payload)
+        ctype, symbol, macro = CODEGEN[name]
+        fields = []
+        offset = 0
+        for field, shape in LAYOUTS[name]:
+            count = 1
+            for d in shape:
+                count *= d
+            if offset + count > len(values):
+                sys.exit(f"{path}: payload too short for {field}")
+            t = values[offset:offset + count]
+            offset += count
+            text = float_literal(t[0]) if (name, field) in SCALAR_FIELDS else c_initializer(t, shape, "  ")
+            fields.append((field, text))
+        if offset != len(values):
+            sys.exit(f"{path}: {len(values)} weights, layout expects {offset}")
+
+        if ctype:
+            body = ",\n".join(f"  // {field}\n  {text}" for field, text in fields)
+            decl = f"static constexpr {ctype} {symbol} = {{\n{body}\n}};"
+        else:
+            decl = f"static constexpr float {symbol}[ENSEMBLE_MODELS] = {fields[0][1]};"
+        sections.append(f"// {name}: {len(values)} weights\n{decl}\n#define {macro} {symbol}\n")
+        stamp = time.strftime("%Y-%m-%d", time.gmtime(created)) if created else "unknown date"
+        sources.append(f" * - {path} ({name}, crc32 0x{crc:08x}, {stamp})")
+
+    header = "\n".join([
+        "/*",
+        " * ModelWeights.h - Compiled-In Model Weights",
+        " *",
+        " * Generated by tools/model_tool.py codegen from:",
+        *sources,
+        " *",
+        " * Do not edit; regenerate after retraining. Included by EnhancedMLModel.h.",
+        " */",
+        "",
+        "#ifndef MODEL_WEIGHTS_H",
+        "#define MODEL_WEIGHTS_H",
+        "",
+    ])
+    with open(args.out, "w") as f:
+        f.write(header + "\n" + "\n".join(sections) + "\n#endif // MODEL_WEIGHTS_H\n")
+    print(f"{args.out}: {len(sections)} models")
+
+
+def float32(value):
+    return struct.unpack("<f", struct.pack("<f", value))[0]
+
+
+def tree_limit(threshold, scale):
+    """Fixed-point limit of a split. TreeEnsemble::quantize() floors x * scale in
+    float32, so the threshold is rounded down to a float32 and floored the same
+    way: x <= threshold then always gives quantize(x) <= limit"""
+    t = float32(threshold)
+    if t > threshold:
+        bits, = struct.unpack("<I", struct.pack("<f", t))
+        bits = bits - 1 if t > 0 else (bits + 1 if t < 0 else 0x80000001)
+        t, = struct.unpack("<f", struct.pack("<I", bits))
+    return math.floor(float32(t * scale))
+
+
+def tree_code(tree, index):
+    left, right = tree["children_left"], tree["children_right"]
+    feature, threshold, value = tree["feature"], tree["threshold"], tree["value"]
+    nodes = len(left)
+    if not (len(right) == len(feature) == len(threshold) == len(value) == nodes) or nodes == 0:
+        raise ValueError(f"tree {index}: node arrays differ in length")
+
+    lines = []
+    visited = set()
+
+    def emit(node, depth):
+        if node in visited or not 0 <= node < nodes:
+            raise ValueError(f"tree {index}: bad child index {node}")
+        visited.add(node)
+        indent = "  " * depth
+        if left[node] == -1:
+            lines.append(f"{indent}return {round(value[node] * (1 << TREE_LEAF_SHIFT))};")
+            return
+        f = feature[node]
+        if not 0 <= f < INPUT_FEATURES:
+            raise ValueError(f"tree {index}: feature {f} out of range")
+        # Left branch is x <= threshold, compared in the feature's fixed-point units
+        limit = tree_limit(threshold[node], TREE_FEATURE_SCALES[f])
+        lines.append(f"{indent}if (x[{f}] <= {limit}) {{  // {TREE_FEATURE_NAMES[f]} <= {threshold[node]:.6g}")
+        emit(left[node], depth + 1)
+        lines.append(f"{indent}}}")
+        emit(right[node], depth)
+
+    emit(0, 1)
+    body = "\n".join(lines)
+    return (f"static inline int32_t forestTree{index}(const int32_t* x) {{\n{body}\n}}\n",
+            len(visited))
+
+
+def elf_section_bytes(path, prefixes):
+    """Total size of the sections whose names start with one of prefixes"""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"\x7fELF" or data[5] != 1:
+        raise ValueError("not a little-endian ELF object")
+    if data[4] == 2:
+        shoff, = struct.unpack_from("<Q", data, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x3A)
+        section = lambda i: struct.unpack_from("<IIQQQQ", data, shoff + i * shentsize)
+    else:
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+        section = lambda i: struct.unpack_from("<IIIIII", data, shoff + i * shentsize)
+    names = section(shstrndx)[4]
+    total = 0
+    for i in range(shnum):
+        name_at, _, _, _, _, size = section(i)
+        name = data[names + name_at:data.index(b"\0", names + name_at)].decode()
+        if name.startswith(prefixes):
+            total += size
+    return total
+
+
+def tree_code_bytes(cc, source):
+    """Code and constant bytes of forestScore() and the trees, built with cc -Os"""
+    with tempfile.TemporaryDirectory() as tmp:
+        src = os.path.join(tmp, "forest.cpp")
+        obj = os.path.join(tmp, "forest.o")
+        with open(src, "w") as f:
+            f.write("#include <stdint.h>\n" + source +
+                    "int32_t forestScoreEntry(const int32_t* x) { return forestScore(x); }\n")
+        subprocess.run([cc, "-Os", "-c", src, "-o", obj], check=True, capture_output=True)
+        return elf_section_bytes(obj, TREE_CODE_SECTIONS)
+
+
+def forest(args):
+    with open(args.model) as f:
+        model = json.load(f)
+
+    kind = model.get("kind")
+    if kind not in TREE_KINDS:
+        sys.exit(f"kind must be one of {sorted(TREE_KINDS)}")
+    trees = model.get("trees") or []
+    if not trees:
+        sys.exit("no trees")
+
+    functions = []
+    nodes = 0
+    for i, tree in enumerate(trees):
+        try:
+            code, count = tree_code(tree, i)
+        except (KeyError, ValueError) as e:
+            sys.exit(f"{args.model}: {e}")
+        functions.append(code)
+        nodes += count
+
+    base = round(model.get("base_margin", 0.0) * (1 << TREE_LEAF_SHIFT)) if kind == "boosted" else 0
+    terms = " +\n         ".join(f"forestTree{i}(x)" for i in range(len(trees)))
+    score = (f"static inline int32_t forestScore(const int32_t* x) {{\n"
+             f"  return FOREST_BASE_MARGIN +\n         {terms};\n}}\n")
+
+    # The trees are code, not tables: their footprint is what the compiler emits
+    cc = args.cc or next((c for c in TREE_COMPILERS if shutil.which(c)), None)
+    code_bytes = None
+    if cc:
+        try:
+            code_bytes = tree_code_bytes(cc, f"#define FOREST_BASE_MARGIN {base}\n" + "\n".join(functions) + score)
+        except (OSError, subprocess.CalledProcessError, ValueError) as e:
+            print(f"warning: could not build the trees with {cc} ({e}); code size unknown", file=sys.stderr)
+    else:
+        print("warning: no compiler found (--cc); code size unknown", file=sys.stderr)
+
+    header = "\n".join([
+        "/*",
+        " * ForestModel.h - Compiled Tree Ensemble",
+        " *",
+        f" * Generated by tools/model_tool.py forest from {args.model}",
+        f" * ({kind}, {len(trees)} trees, {nodes} nodes). Leaf values are Q{TREE_LEAF_SHIFT}.",
+        " *",
+        " * Do not edit; regenerate after retraining. Included by TreeEnsemble.h.",
+        " */",
+        "",
+        "#ifndef FOREST_MODEL_H",
+        "#define FOREST_MODEL_H",
+        "",
+        f"#define FOREST_KIND {TREE_KINDS[kind]}",
+        f"#define FOREST_TREES {len(trees)}",
+        f"#define FOREST_NODES {nodes}",
+        f"#define FOREST_BASE_MARGIN {base}",
+    ] + ([f"#define FOREST_CODE_BYTES {code_bytes}  // {cc} -Os: {', '.join(TREE_CODE_SECTIONS)}"]
+         if code_bytes is not None else []) + [""])
+    with open(args.out, "w") as f:
+        f.write(header + "\n" + "\n".join(functions) + "\n" + score + "\n#endif // FOREST_MODEL_H\n")
+    size = f", {code_bytes} B of code ({cc})" if code_bytes is not None else ""
+    print(f"{args.out}: {kind}, {len(trees)} trees, {nodes} nodes{size}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="EV-Secure model file tool")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("pack", help="pack JSON weights into a .evm container")
+    p.add_argument("--type", choices=sorted(MODEL_TYPES), required=True)
+    p.add_argument("--weights", required=True)
+    p.add_argument("--out", required=True)
+
+    p = sub.add_parser("inspect", help="print header and tensor statistics")
+    p.add_argument("files", nargs="+")
+
+    p = sub.add_parser("image", help="concatenate containers into a flash partition image")
+    p.add_argument("files", nargs="+")
+    p.add_argument("--out", required=True)
+    p.add_argument("--size", type=lambda x: int(x, 0), default=0x100000)
+
+    p = sub.add_parser("codegen", help="emit containers as constexpr C++ tables (ModelWeights.h)")
+    p.add_argument("files", nargs="+")
+    p.add_argument("--out", required=True)
+
+    p = sub.add_parser("forest", help="compile a tree ensemble into integer compares (ForestModel.h)")
+    p.add_argument("--model", required=True)
+    p.add_argument("--out", required=True)
+    p.add_argument("--cc", help="compiler for the code size (default: " + ", ".join(TREE_COMPILERS) + ")")
+
+    args = parser.parse_args()
+    if args.command == "pack":
+        pack(args)
+    elif args.command == "inspect":
+        sys.exit(inspect(args))
+    elif args.command == "codegen":
+        codegen(args)
+    elif args.command == "forest":
+        forest(args)
+    else:
+        image(args)
+
+
+if __name__ == "__main__":
+    main()
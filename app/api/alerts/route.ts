@@ -1,4 +1,5 @@
 import { NextRequest, NextResponse } from 'next/server'
+import { ackCommand } from '@/lib/command-queue'
 
 // In-memory storage for alerts
 const apiKeys = new Map<string, { stationId: string; lastUsed: Date; status: 'active' | 'inactive' }>()
@@ -45,11 +46,18 @@ export async function POST(request: NextRequest) {
       alerts.set(stationId, [])
     }
 
+    // A command result is the station's acknowledgement of that command
+    const commandId = typeof body.command_id === 'string' ? body.command_id : undefined
+    const acknowledged = commandId !== undefined &&
+      (body.alert_type === 'COMMAND_EXECUTED' || body.alert_type === 'COMMAND_ERROR') &&
+      ackCommand(stationId, commandId)
+
     const alert = {
       id: `alert_${Date.now()}_${Math.random().toString(36).substr(2, 9)}`,
       device_id: body.device_id,
       alert_type: body.alert_type,
       details: body.details || '',
+      ...(commandId !== undefined && { command_id: commandId }),
       severity: body.severity || 'medium',
       timestamp: new Date().toISOString(),
       stationId,
@@ -68,7 +76,8 @@ export async function POST(request: NextRequest) {
     console.log(`Alert received from ${stationId}:`, {
       alert_type: alert.alert_type,
       severity: alert.severity,
-      timestamp: alert.timestamp
+      timestamp: alert.timestamp,
+      ...(acknowledged && { acknowledged_command: commandId })
     })
 
     return NextResponse.json({
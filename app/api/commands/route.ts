@@ -1,8 +1,13 @@
 import { NextRequest, NextResponse } from 'next/server'
+import { hasListeners, queueCommand, waitForCommand } from '@/lib/command-queue'
 
-// In-memory storage for commands
+// In-memory storage for API keys
 const apiKeys = new Map<string, { stationId: string; lastUsed: Date; status: 'active' | 'inactive' }>()
-const commandQueue = new Map<string, any[]>()
+
+// Long-poll: GET /api/commands?wait=<seconds> holds the request until a command arrives
+const MAX_WAIT_SECONDS = 30
+
+export const maxDuration = 60
 
 // Initialize with default API keys
 apiKeys.set('vsr_st001_abc123def456', { stationId: 'ST001', lastUsed: new Date(), status: 'active' })
@@ -32,16 +37,12 @@ export async function GET(request: NextRequest) {
     }
 
     const stationId = keyData.stationId
-    const commands = commandQueue.get(stationId) || []
+    const wait = Math.min(Math.max(Number(request.nextUrl.searchParams.get('wait')) || 0, 0), MAX_WAIT_SECONDS)
 
-    // Return the oldest unprocessed command
-    const pendingCommand = commands.find(cmd => !cmd.processed)
+    // Return the oldest unacknowledged command (waiting for one on a long-poll)
+    const pendingCommand = await waitForCommand(stationId, wait * 1000, request.signal)
     
     if (pendingCommand) {
-      // Mark command as processed
-      pendingCommand.processed = true
-      pendingCommand.processedAt = new Date().toISOString()
-      
       console.log(`Command sent to ${stationId}:`, pendingCommand)
       
       return NextResponse.json({
@@ -96,27 +97,17 @@ export async function POST(request: NextRequest) {
     }
 
     const stationId = body.stationId
-    if (!commandQueue.has(stationId)) {
-      commandQueue.set(stationId, [])
-    }
-
-    const command = {
-      id: `cmd_${Date.now()}_${Math.random().toString(36).substr(2, 9)}`,
-      command: body.command,
-      parameters: body.parameters || {},
-      timestamp: new Date().toISOString(),
-      processed: false,
-      createdBy: 'dashboard'
-    }
-
-    commandQueue.get(stationId)!.push(command)
+    // A station with an open stream or held long-poll gets the command at once
+    const delivery = hasListeners(stationId) ? 'push' : 'poll'
+    const command = queueCommand(stationId, body.command, body.parameters || {})
     
-    console.log(`Command queued for ${stationId}:`, command)
+    console.log(`Command queued for ${stationId} (${delivery}):`, command)
 
     return NextResponse.json({
       success: true,
       message: 'Command queued successfully',
-      commandId: command.id
+      commandId: command.id,
+      delivery
     })
 
   } catch (error) {
@@ -0,0 +1,100 @@
+import { NextRequest, NextResponse } from 'next/server'
+import { apiKeys } from '@/lib/shared-storage'
+import { onCommandQueued, resendAfter, takeCommand, type StationCommand } from '@/lib/command-queue'
+
+// Push channel for station commands (Server-Sent Events)
+//   event: ready    - stream open, data holds the heartbeat interval
+//   event: command  - one command, same object GET /api/commands returns
+//   : heartbeat     - comment line every HEARTBEAT_SECONDS so the station can
+//                     tell a quiet stream from a dead connection
+// The stream ends after STREAM_SECONDS (inside the function time limit) and
+// the station reconnects with Last-Event-ID; commands queued meanwhile, and
+// unacknowledged ones sent after that id, are sent on reconnect.
+const HEARTBEAT_SECONDS = 15
+const STREAM_SECONDS = 280
+const RECONNECT_MS = 1000
+
+export const dynamic = 'force-dynamic'
+export const maxDuration = 300
+
+export async function GET(request: NextRequest) {
+  const authHeader = request.headers.get('authorization')
+
+  if (!authHeader || !authHeader.startsWith('Bearer ')) {
+    return NextResponse.json(
+      { error: 'Missing or invalid authorization header' },
+      { status: 401 }
+    )
+  }
+
+  const apiKey = authHeader.substring(7)
+  const keyData = apiKeys.get(apiKey)
+
+  if (!keyData || keyData.status !== 'active') {
+    return NextResponse.json(
+      { error: 'Invalid or inactive API key' },
+      { status: 401 }
+    )
+  }
+
+  const stationId = keyData.stationId
+  const encoder = new TextEncoder()
+  resendAfter(stationId, request.headers.get('last-event-id'))
+  let close = () => {}
+
+  const stream = new ReadableStream<Uint8Array>({
+    start(controller) {
+      let open = true
+      const send = (text: string) => {
+        if (open) {
+          controller.enqueue(encoder.encode(text))
+        }
+      }
+      const sendCommand = (command: StationCommand) => {
+        console.log(`Command pushed to ${stationId}:`, command)
+        send(`event: command\nid: ${command.id}\ndata: ${JSON.stringify(command)}\n\n`)
+      }
+      const push = () => {
+        for (let command = takeCommand(stationId); open && command; command = takeCommand(stationId)) {
+          sendCommand(command)
+        }
+      }
+
+      const unsubscribe = onCommandQueued(stationId, push)
+      const heartbeat = setInterval(() => send(`: heartbeat ${Date.now()}\n\n`), HEARTBEAT_SECONDS * 1000)
+      const expiry = setTimeout(() => close(), STREAM_SECONDS * 1000)
+
+      close = () => {
+        if (!open) return
+        open = false
+        clearInterval(heartbeat)
+        clearTimeout(expiry)
+        unsubscribe()
+        try {
+          controller.close()
+        } catch {
+          // Already cancelled by the client
+        }
+      }
+      request.signal.addEventListener('abort', () => close())
+
+      send(`retry: ${RECONNECT_MS}\nevent: ready\ndata: ${JSON.stringify({ heartbeat: HEARTBEAT_SECONDS })}\n\n`)
+      // Commands queued while the station was not connected
+      push()
+    },
+    cancel() {
+      close()
+    }
+  })
+
+  console.log(`Command stream opened for ${stationId}`)
+
+  return new Response(stream, {
+    headers: {
+      'Content-Type': 'text/event-stream',
+      'Cache-Control': 'no-cache, no-transform',
+      'Connection': 'keep-alive',
+      'X-Accel-Buffering': 'no'
+    }
+  })
+}
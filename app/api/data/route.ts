@@ -1,5 +1,83 @@
 import { NextRequest, NextResponse } from 'next/server'
-import { apiKeys, sensorData, type SensorDataEntry } from '@/lib/shared-storage'
+import { gunzipSync } from 'zlib'
+import { apiKeys, sensorData, spooledData, type SensorDataEntry } from '@/lib/shared-storage'
+import { decodeTelemetry, MSGPACK_CONTENT_TYPE } from '@/lib/telemetry-codec'
+import { takeCommands } from '@/lib/command-queue'
+
+// Batched uploads: `frames` holds one array per sample, values in `frame_fields` order
+const FRAME_FLAG_CHARGING = 0x01
+const FRAME_FLAG_THREAT = 0x02
+
+// Queued commands returned with each upload (COMMAND_PIGGYBACK_MAX on the
+// station), within the response body the station keeps (API_RESPONSE_MAX_BYTES,
+// 2048, less the rest of this response); a cut response would lose them all
+const MAX_PIGGYBACK_COMMANDS = 4
+const MAX_PIGGYBACK_BYTES = 1536
+
+// Request bodies: plain or gzip; inflated bodies are capped well above the
+// station's largest batch
+const ACCEPTED_ENCODINGS = ['identity', 'gzip']
+const MAX_INFLATED_BYTES = 1024 * 1024
+
+// Live data keeps the latest entries; replayed backlog is kept by age, long
+// enough for a full station spool (SPOOL_MAX_SEGMENTS, about 4.5 days)
+const MAX_LIVE_ENTRIES = 100
+const SPOOLED_HISTORY_MS = 5 * 24 * 60 * 60 * 1000
+const MAX_SPOOLED_ENTRIES = 250000
+
+function storeSpooled(stationId: string, entries: SensorDataEntry[], received: number) {
+  if (!spooledData.has(stationId)) {
+    spooledData.set(stationId, [])
+  }
+  const history = spooledData.get(stationId)!
+
+  // The station drains its spool oldest first; sort only when a batch is out of order
+  const last = history[history.length - 1]
+  history.push(...entries)
+  if (last && entries.length > 0 && entries[0].timestamp < last.timestamp) {
+    history.sort((a, b) => a.timestamp.localeCompare(b.timestamp))
+  }
+
+  const cutoff = new Date(received - SPOOLED_HISTORY_MS).toISOString()
+  let expired = 0
+  while (expired < history.length && history[expired].timestamp < cutoff) {
+    expired++
+  }
+  expired = Math.max(expired, history.length - MAX_SPOOLED_ENTRIES)
+  if (expired > 0) {
+    history.splice(0, expired)
+  }
+}
+
+function expandFrames(body: any, received: number): { sensor_data: SensorDataEntry['sensor_data']; timestamp: string }[] {
+  const fields: string[] = Array.isArray(body.frame_fields) ? body.frame_fields : []
+  const sentAt = Number(body.timestamp)
+
+  return body.frames
+    .filter((frame: unknown) => Array.isArray(frame) && frame.length === fields.length)
+    .map((frame: number[]) => {
+      const values: Record<string, number> = {}
+      fields.forEach((name, i) => { values[name] = frame[i] })
+
+      // Frame times are device millis(); date them relative to the upload
+      const age = Number.isFinite(sentAt) && Number.isFinite(values.timestamp)
+        ? Math.max(0, sentAt - values.timestamp)
+        : 0
+
+      return {
+        sensor_data: {
+          current: values.current,
+          voltage: values.voltage,
+          power: values.power,
+          frequency: values.frequency,
+          temperature: values.temperature,
+          car_connected: Boolean(values.flags & FRAME_FLAG_CHARGING),
+          ml_threat_level: values.flags & FRAME_FLAG_THREAT ? 'HIGH' : 'NORMAL'
+        },
+        timestamp: new Date(received - age).toISOString()
+      }
+    })
+}
 
 export async function POST(request: NextRequest) {
   try {
@@ -22,7 +100,47 @@ export async function POST(request: NextRequest) {
       )
     }
 
-    const body = await request.json()
+    // Batches and backlog arrive gzip-compressed (APIManager::compressMinBytes)
+    const contentEncoding = (request.headers.get('content-encoding') || 'identity').trim().toLowerCase()
+    if (!ACCEPTED_ENCODINGS.includes(contentEncoding)) {
+      return NextResponse.json(
+        { error: 'Unsupported content encoding', accepted_encodings: ACCEPTED_ENCODINGS },
+        { status: 415 }
+      )
+    }
+
+    let payload: Buffer = Buffer.from(await request.arrayBuffer())
+    if (contentEncoding === 'gzip') {
+      try {
+        payload = gunzipSync(payload, { maxOutputLength: MAX_INFLATED_BYTES })
+      } catch (error) {
+        return NextResponse.json(
+          { error: `Invalid gzip body: ${(error as Error).message}` },
+          { status: 400 }
+        )
+      }
+    }
+
+    // Devices upload JSON or the compact MessagePack encoding
+    const contentType = (request.headers.get('content-type') || 'application/json').split(';')[0].trim().toLowerCase()
+    let body: any
+    if (contentType === MSGPACK_CONTENT_TYPE) {
+      try {
+        body = decodeTelemetry(new Uint8Array(payload))
+      } catch (error) {
+        return NextResponse.json(
+          { error: `Invalid telemetry payload: ${(error as Error).message}` },
+          { status: 400 }
+        )
+      }
+    } else if (contentType === 'application/json') {
+      body = JSON.parse(payload.toString('utf8'))
+    } else {
+      return NextResponse.json(
+        { error: 'Unsupported content type', accepted: ['application/json', MSGPACK_CONTENT_TYPE] },
+        { status: 415 }
+      )
+    }
     
     // Validate required fields
     if (!body.device_id || !body.sensor_data) {
@@ -42,33 +160,55 @@ export async function POST(request: NextRequest) {
       sensorData.set(stationId, [])
     }
     
-    const dataEntry: SensorDataEntry = {
+    // A batch stores every frame; a single upload stores its snapshot
+    const received = Date.now()
+    const samples = Array.isArray(body.frames)
+      ? expandFrames(body, received)
+      : [{ sensor_data: body.sensor_data, timestamp: new Date(received).toISOString() }]
+    
+    const entries: SensorDataEntry[] = samples.map(sample => ({
       device_id: body.device_id,
-      sensor_data: body.sensor_data,
-      timestamp: new Date().toISOString(),
+      sensor_data: sample.sensor_data,
+      timestamp: sample.timestamp,
       stationId,
       apiKey: apiKey.substring(0, 10) + '...' // Partial key for logging
-    }
-    
-    sensorData.get(stationId)!.push(dataEntry)
+    }))
+    const dataEntry = entries[entries.length - 1]
     
-    // Keep only last 100 entries per station
-    const stationData = sensorData.get(stationId)!
-    if (stationData.length > 100) {
-      stationData.splice(0, stationData.length - 100)
+    // Backlog from the station's SD spool is older than the live data: it goes
+    // to the replay history so it neither hides nor is trimmed by live samples
+    if (body.spooled !== undefined) {
+      storeSpooled(stationId, entries, received)
+    } else {
+      const stationData = sensorData.get(stationId)!
+      stationData.push(...entries)
+      if (stationData.length > MAX_LIVE_ENTRIES) {
+        stationData.splice(0, stationData.length - MAX_LIVE_ENTRIES)
+      }
     }
 
     console.log(`Data received from ${stationId}:`, {
       device_id: body.device_id,
-      timestamp: dataEntry.timestamp,
-      sensor_count: Object.keys(body.sensor_data || {}).length
+      timestamp: dataEntry?.timestamp,
+      sensor_count: Object.keys(body.sensor_data || {}).length,
+      frames: entries.length,
+      ...(body.spooled !== undefined && { spooled: body.spooled })
     })
 
+    // Pending commands ride back on the response, saving the station a poll;
+    // they stay queued until the station acknowledges them (see command-queue)
+    const commands = takeCommands(stationId, MAX_PIGGYBACK_COMMANDS, MAX_PIGGYBACK_BYTES)
+    if (commands.length > 0) {
+      console.log(`Commands sent to ${stationId} with data response:`, commands.map(cmd => cmd.id))
+    }
+
     return NextResponse.json({
       success: true,
       message: 'Data received successfully',
       stationId,
-      timestamp: dataEntry.timestamp
+      timestamp: dataEntry?.timestamp,
+      frames_received: entries.length,
+      ...(commands.length > 0 && { commands })
     })
 
   } catch (error) {
@@ -101,13 +241,16 @@ export async function GET(request: NextRequest) {
       )
     }
 
+    // ?source=spooled reads the replayed backlog instead of the live data
     const stationId = keyData.stationId
-    const data = sensorData.get(stationId) || []
+    const spooled = request.nextUrl.searchParams.get('source') === 'spooled'
+    const data = (spooled ? spooledData.get(stationId) : sensorData.get(stationId)) || []
 
     return NextResponse.json({
       success: true,
       stationId,
-      data: data.slice(-10), // Return last 10 entries
+      source: spooled ? 'spooled' : 'live',
+      data: data.slice(spooled ? -MAX_LIVE_ENTRIES : -10), // Return the latest entries
       totalEntries: data.length
     })
 
@@ -0,0 +1,189 @@
+// Per-station command queue shared by the command endpoints
+// Commands go out by a GET /api/commands poll, a held long-poll, the
+// /api/commands/stream push channel, or the response to a telemetry upload
+// (POST /api/data), whichever asks first. A command stays pending until the
+// station acknowledges it: a COMMAND_EXECUTED or COMMAND_ERROR alert carrying
+// its id (POST /api/alerts), and is then dropped from the queue. One not
+// acknowledged within ACK_TIMEOUT_MS is sent again; the station does not rerun
+// ids it has already run, it repeats their result.
+
+export interface StationCommand {
+  id: string
+  command: string
+  parameters: Record<string, unknown>
+  timestamp: string
+  processed: boolean
+  processedAt?: string
+  deliveredAt?: string
+  deliveries: number
+  createdBy: string
+}
+
+type CommandListener = () => void
+
+// Time the station has to acknowledge a command before it is sent again
+// (model downloads acknowledge after staging, so this is not a round trip)
+export const ACK_TIMEOUT_MS = 60000
+
+// Unacknowledged commands kept per station (a station that never comes back);
+// past this the oldest are dropped
+export const MAX_QUEUED_COMMANDS = 100
+
+const commandQueue = new Map<string, StationCommand[]>()
+const listeners = new Map<string, Set<CommandListener>>()
+
+function notify(stationId: string) {
+  listeners.get(stationId)?.forEach(listener => listener())
+}
+
+export function queueCommand(stationId: string, command: string, parameters: Record<string, unknown> = {}): StationCommand {
+  if (!commandQueue.has(stationId)) {
+    commandQueue.set(stationId, [])
+  }
+
+  const entry: StationCommand = {
+    id: `cmd_${Date.now()}_${Math.random().toString(36).substr(2, 9)}`,
+    command,
+    parameters,
+    timestamp: new Date().toISOString(),
+    processed: false,
+    deliveries: 0,
+    createdBy: 'dashboard'
+  }
+  const commands = commandQueue.get(stationId)!
+  commands.push(entry)
+  if (commands.length > MAX_QUEUED_COMMANDS) {
+    commands.splice(0, commands.length - MAX_QUEUED_COMMANDS)
+  }
+
+  // Wake held long-polls and open streams for this station
+  notify(stationId)
+  return entry
+}
+
+function awaitingAck(command: StationCommand, now: number): boolean {
+  return command.deliveredAt !== undefined && now - Date.parse(command.deliveredAt) < ACK_TIMEOUT_MS
+}
+
+function nextCommand(stationId: string, now: number): StationCommand | undefined {
+  return (commandQueue.get(stationId) || []).find(cmd => !cmd.processed && !awaitingAck(cmd, now))
+}
+
+function markDelivered(stationId: string, command: StationCommand, now: number) {
+  command.deliveredAt = new Date(now).toISOString()
+  command.deliveries++
+
+  // Wake the station's listeners when the acknowledgement is overdue
+  setTimeout(() => {
+    if (!command.processed) {
+      notify(stationId)
+    }
+  }, ACK_TIMEOUT_MS + 10)
+}
+
+// Oldest unacknowledged command not already out with the station; it stays
+// queued until ackCommand() and is offered again after ACK_TIMEOUT_MS
+export function takeCommand(stationId: string): StationCommand | null {
+  const now = Date.now()
+  const pending = nextCommand(stationId, now)
+  if (!pending) {
+    return null
+  }
+
+  markDelivered(stationId, pending, now)
+  return pending
+}
+
+// Up to limit pending commands, oldest first, together at most maxBytes of
+// JSON; a command that does not fit is left for the next request
+export function takeCommands(stationId: string, limit: number, maxBytes = Infinity): StationCommand[] {
+  const now = Date.now()
+  const commands: StationCommand[] = []
+  let bytes = 0
+  while (commands.length < limit) {
+    const command = nextCommand(stationId, now)
+    if (!command) break
+    bytes += JSON.stringify(command).length + 1
+    if (bytes > maxBytes) break
+    markDelivered(stationId, command, now)
+    commands.push(command)
+  }
+  return commands
+}
+
+// The station ran (or refused) the command: it leaves the queue. False for an
+// unknown id, including one already acknowledged
+export function ackCommand(stationId: string, commandId: string): boolean {
+  const commands = commandQueue.get(stationId) || []
+  const index = commands.findIndex(cmd => cmd.id === commandId)
+  if (index < 0) {
+    return false
+  }
+
+  const [command] = commands.splice(index, 1)
+  command.processed = true
+  command.processedAt = new Date().toISOString()
+  if (commands.length === 0) {
+    commandQueue.delete(stationId)
+  }
+  return true
+}
+
+// A reconnecting stream names the last command it received (Last-Event-ID):
+// unacknowledged commands sent after that one never arrived and are offered
+// again at once. Without the header, or when that command has been
+// acknowledged (and dropped) since, every unacknowledged command is.
+export function resendAfter(stationId: string, lastEventId: string | null) {
+  const commands = commandQueue.get(stationId) || []
+  const last = lastEventId ? commands.findIndex(cmd => cmd.id === lastEventId) : -1
+  commands.slice(last + 1).forEach(cmd => {
+    if (!cmd.processed) {
+      cmd.deliveredAt = undefined
+    }
+  })
+}
+
+export function onCommandQueued(stationId: string, listener: CommandListener): () => void {
+  if (!listeners.has(stationId)) {
+    listeners.set(stationId, new Set())
+  }
+  listeners.get(stationId)!.add(listener)
+
+  return () => {
+    const set = listeners.get(stationId)
+    set?.delete(listener)
+    if (set && set.size === 0) {
+      listeners.delete(stationId)
+    }
+  }
+}
+
+// Resolves with the next command, or null after timeoutMs or when the client goes away
+export function waitForCommand(stationId: string, timeoutMs: number, signal?: AbortSignal): Promise<StationCommand | null> {
+  const ready = takeCommand(stationId)
+  if (ready || timeoutMs <= 0) {
+    return Promise.resolve(ready)
+  }
+
+  return new Promise(resolve => {
+    const finish = (command: StationCommand | null) => {
+      clearTimeout(timer)
+      unsubscribe()
+      signal?.removeEventListener('abort', abort)
+      resolve(command)
+    }
+    const abort = () => finish(null)
+    const unsubscribe = onCommandQueued(stationId, () => {
+      const command = takeCommand(stationId)
+      if (command) {
+        finish(command)
+      }
+    })
+    const timer = setTimeout(() => finish(null), timeoutMs)
+    signal?.addEventListener('abort', abort)
+  })
+}
+
+export function hasListeners(stationId: string): boolean {
+  return (listeners.get(stationId)?.size ?? 0) > 0
+}
@@ -32,6 +32,8 @@ export interface SensorDataEntry {
 // Shared in-memory storage
 export const apiKeys = new Map<string, ApiKeyData>()
 export const sensorData = new Map<string, SensorDataEntry[]>()
+// Frames replayed from a station's SD spool after an outage, in time order
+export const spooledData = new Map<string, SensorDataEntry[]>()
 
 // Initialize with default API keys for all 6 stations
 apiKeys.set('vsr_st001_abc123def456', { 
@@ -0,0 +1,196 @@
+// Decoder for the ESP32 binary telemetry upload (Content-Type application/msgpack)
+// Mirrors TelemetryBatcher.h: a MessagePack map with integer keys, frames as
+// delta/zig-zag varint columns. Returns the same body shape as the JSON upload.
+
+export const MSGPACK_CONTENT_TYPE = 'application/msgpack'
+
+export const FRAME_FIELDS = [
+  'timestamp', 'current', 'voltage', 'power', 'frequency', 'temperature',
+  'state', 'flags', 'prediction', 'confidence', 'enhanced_prediction', 'attack_type'
+]
+
+// Payload keys (TELEMETRY_KEY_* in TelemetryBatcher.h)
+const KEY_DEVICE_ID = 0
+const KEY_SESSION_ID = 1
+const KEY_TIMESTAMP = 2
+const KEY_STATE = 3
+const KEY_CHARGING = 4
+const KEY_THREAT = 5
+const KEY_SYSTEM = 6
+const KEY_ML = 7
+const KEY_FRAME_COUNT = 8
+const KEY_FRAME_SCALES = 9
+const KEY_FRAMES = 10
+const KEY_SPOOLED = 11   // Journal sequence number of a backlog upload
+
+const SYSTEM_FIELDS = ['wifi_rssi', 'uptime', 'free_heap', 'cpu_freq']
+const ML_FIELDS = [
+  'standard_prediction', 'standard_confidence', 'enhanced_prediction',
+  'enhanced_confidence', 'enhanced_uncertainty', 'attack_type',
+  'attack_confidence', 'is_anomaly', 'early_exit_rate'
+]
+
+class Reader {
+  private offset = 0
+  private view: DataView
+
+  constructor(private bytes: Uint8Array) {
+    this.view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength)
+  }
+
+  get done(): boolean {
+    return this.offset >= this.bytes.length
+  }
+
+  private take(length: number): number {
+    if (this.offset + length > this.bytes.length) {
+      throw new Error('Truncated telemetry payload')
+    }
+    const start = this.offset
+    this.offset += length
+    return start
+  }
+
+  private u8(): number { return this.view.getUint8(this.take(1)) }
+  private u16(): number { return this.view.getUint16(this.take(2)) }
+  private u32(): number { return this.view.getUint32(this.take(4)) }
+
+  private str(length: number): string {
+    const start = this.take(length)
+    return new TextDecoder().decode(this.bytes.subarray(start, start + length))
+  }
+
+  private bin(length: number): Uint8Array {
+    const start = this.take(length)
+    return this.bytes.subarray(start, start + length)
+  }
+
+  private array(length: number): unknown[] {
+    return Array.from({ length }, () => this.value())
+  }
+
+  private map(length: number): Map<unknown, unknown> {
+    const entries = new Map<unknown, unknown>()
+    for (let i = 0; i < length; i++) {
+      const key = this.value()
+      entries.set(key, this.value())
+    }
+    return entries
+  }
+
+  // The subset MsgPackWriter.h produces, plus the remaining fixed-size types
+  value(): unknown {
+    const type = this.u8()
+    if (type < 0x80) return type
+    if (type < 0x90) return this.map(type & 0x0f)
+    if (type < 0xa0) return this.array(type & 0x0f)
+    if (type < 0xc0) return this.str(type & 0x1f)
+    if (type >= 0xe0) return type - 0x100
+
+    switch (type) {
+      case 0xc0: return null
+      case 0xc2: return false
+      case 0xc3: return true
+      case 0xc4: return this.bin(this.u8())
+      case 0xc5: return this.bin(this.u16())
+      case 0xc6: return this.bin(this.u32())
+      case 0xca: return this.view.getFloat32(this.take(4))
+      case 0xcb: return this.view.getFloat64(this.take(8))
+      case 0xcc: return this.u8()
+      case 0xcd: return this.u16()
+      case 0xce: return this.u32()
+      case 0xd0: return this.view.getInt8(this.take(1))
+      case 0xd1: return this.view.getInt16(this.take(2))
+      case 0xd2: return this.view.getInt32(this.take(4))
+      case 0xd9: return this.str(this.u8())
+      case 0xda: return this.str(this.u16())
+      case 0xdb: return this.str(this.u32())
+      case 0xdc: return this.array(this.u16())
+      case 0xdd: return this.array(this.u32())
+      case 0xde: return this.map(this.u16())
+      case 0xdf: return this.map(this.u32())
+      default: throw new Error(`Unsupported MessagePack type 0x${type.toString(16)}`)
+    }
+  }
+}
+
+// Columns of zig-zag varint deltas back to frames of scaled values
+function decodeFrames(data: Uint8Array, count: number, scales: number[]): number[][] {
+  const frames: number[][] = Array.from({ length: count }, () => [])
+  let offset = 0
+
+  const varint = (): number => {
+    let value = 0
+    for (let shift = 0; shift < 35; shift += 7) {
+      if (offset >= data.length) throw new Error('Truncated frame data')
+      const byte = data[offset++]
+      value |= (byte & 0x7f) << shift
+      if (!(byte & 0x80)) return value >>> 0
+    }
+    throw new Error('Invalid varint in frame data')
+  }
+
+  scales.forEach((scale, field) => {
+    let previous = 0
+    for (let i = 0; i < count; i++) {
+      const zigzag = varint()
+      // Same 32-bit wrap arithmetic as the encoder
+      previous = (previous + ((zigzag >>> 1) ^ -(zigzag & 1))) | 0
+      // timestamp is millis(), unsigned on the device
+      frames[i][field] = field === 0 ? previous >>> 0 : previous / scale
+    }
+  })
+
+  return frames
+}
+
+function record(names: string[], values: unknown): Record<string, unknown> {
+  const result: Record<string, unknown> = {}
+  if (Array.isArray(values)) {
+    names.forEach((name, i) => { result[name] = values[i] })
+  }
+  return result
+}
+
+export function decodeTelemetry(bytes: Uint8Array): any {
+  const root = new Reader(bytes).value()
+  if (!(root instanceof Map)) {
+    throw new Error('Telemetry payload is not a map')
+  }
+
+  const count = Number(root.get(KEY_FRAME_COUNT) ?? 0)
+  const scales = root.get(KEY_FRAME_SCALES)
+  const data = root.get(KEY_FRAMES)
+  if (!Array.isArray(scales) || scales.length !== FRAME_FIELDS.length || !(data instanceof Uint8Array)) {
+    throw new Error('Telemetry payload has no frames')
+  }
+
+  const frames = decodeFrames(data, count, scales.map(Number))
+  const latest = record(FRAME_FIELDS, frames[frames.length - 1])
+  const threat = Boolean(root.get(KEY_THREAT))
+  const ml = record(ML_FIELDS, root.get(KEY_ML))
+  ml.threat_level = threat ? 'HIGH' : 'NORMAL'
+
+  return {
+    device_id: root.get(KEY_DEVICE_ID),
+    session_id: root.get(KEY_SESSION_ID),
+    timestamp: root.get(KEY_TIMESTAMP),
+    spooled: root.get(KEY_SPOOLED),
+    state: root.get(KEY_STATE),
+    is_charging: root.get(KEY_CHARGING),
+    threat_detected: threat,
+    // The binary upload has no separate snapshot; the newest frame stands in
+    sensor_data: frames.length ? {
+      current: latest.current,
+      voltage: latest.voltage,
+      power: latest.power,
+      frequency: latest.frequency,
+      temperature: latest.temperature,
+      timestamp: latest.timestamp
+    } : undefined,
+    system_data: record(SYSTEM_FIELDS, root.get(KEY_SYSTEM)),
+    ml_prediction: ml,
+    frame_fields: FRAME_FIELDS,
+    frames
+  }
+}
@@ -7,6 +7,8 @@ This script tests all the API endpoints to ensure they're working correctly
 import requests
 import json
 import time
+import struct
+import gzip
 from datetime import datetime
 
 # Configuration
@@ -31,6 +33,71 @@ test_sensor_data = {
     }
 }
 
+# Batched upload (TelemetryBatcher.h): latest snapshot plus one array per frame
+now_ms = int(time.time() * 1000)
+test_batch_data = {
+    **test_sensor_data,
+    "timestamp": now_ms,
+    "frame_fields": ["timestamp", "current", "voltage", "power", "frequency", "temperature",
+                     "state", "flags", "prediction", "confidence", "enhanced_prediction", "attack_type"],
+    "frames": [
+        [now_ms - 2000 * (5 - i), 15.5 + i, 220.0, 3410.0 + 220 * i, 50.0, 25.5, 2, 1, 0.1, 0.9, 0.12, 0]
+        for i in range(5)
+    ]
+}
+
+# Backlog from the SD spool (TelemetrySpool.h): frames from an hour ago, sent after the outage
+test_spooled_data = {
+    "device_id": test_sensor_data["device_id"],
+    "sensor_data": test_sensor_data["sensor_data"],
+    "timestamp": 3600000 + 10000,
+    "spooled": 42,
+    "frame_fields": test_batch_data["frame_fields"],
+    "frames": [[10000 - 2000 * (5 - i)] + frame[1:] for i, frame in enumerate(test_batch_data["frames"])]
+}
+
+# Binary upload (application/msgpack): integer keys, frames as delta/zig-zag varint columns
+FRAME_SCALES = [1, 100, 10, 1, 100, 10, 1, 1, 1000, 1000, 1000, 1]
+
+def encode_msgpack_batch(batch):
+    """Encode a batch the way TelemetryBatcher.h does (uint32 timestamps wrap like millis())"""
+    def uint(v):
+        if v < 0x80: return bytes([v])
+        if v <= 0xFF: return b"\xcc" + struct.pack(">B", v)
+        if v <= 0xFFFF: return b"\xcd" + struct.pack(">H", v)
+        return b"\xce" + struct.pack(">I", v & 0xFFFFFFFF)
+    def string(s):
+        return bytes([0xA0 | len(s)]) + s.encode()
+    def varint(v):
+        out = b""
+        while v >= 0x80:
+            out += bytes([(v & 0x7F) | 0x80])
+            v >>= 7
+        return out + bytes([v])
+    
+    frames = batch["frames"]
+    columns = b""
+    for field, scale in enumerate(FRAME_SCALES):
+        previous = 0
+        for frame in frames:
+            value = (int(frame[field]) & 0xFFFFFFFF) if field == 0 else round(frame[field] * scale)
+            value = struct.unpack("<i", struct.pack("<I", value & 0xFFFFFFFF))[0]
+            delta = struct.unpack("<i", struct.pack("<I", (value - previous) & 0xFFFFFFFF))[0]
+            columns += varint(((delta << 1) ^ (delta >> 31)) & 0xFFFFFFFF)
+            previous = value
+    
+    payload = b"\x89"  # map of 9 entries (system and ML blocks left out)
+    payload += uint(0) + string(batch["device_id"])
+    payload += uint(1) + string("test_session")
+    payload += uint(2) + uint(batch["timestamp"] & 0xFFFFFFFF)
+    payload += uint(3) + uint(2)
+    payload += uint(4) + b"\xc3"
+    payload += uint(5) + b"\xc2"
+    payload += uint(8) + uint(len(frames))
+    payload += uint(9) + bytes([0x90 | len(FRAME_SCALES)]) + b"".join(uint(s) for s in FRAME_SCALES)
+    payload += uint(10) + b"\xc6" + struct.pack(">I", len(columns)) + columns
+    return payload
+
 test_alert_data = {
     "device_id": "EV_SORA_001",
     "alert_type": "current_spike",
@@ -39,13 +106,16 @@ test_alert_data = {
     "timestamp": int(time.time() * 1000)
 }
 
-def test_api_endpoint(endpoint, method="GET", data=None, description=""):
+def test_api_endpoint(endpoint, method="GET", data=None, description="", content_type="application/json",
+                      content_encoding=None):
     """Test a single API endpoint"""
     url = f"{BASE_URL}{endpoint}"
     headers = {
         "Authorization": f"Bearer {API_KEY}",
-        "Content-Type": "application/json"
+        "Content-Type": content_type
     }
+    if content_encoding:
+        headers["Content-Encoding"] = content_encoding
     
     print(f"\n{'='*60}")
     print(f"Testing: {description}")
@@ -55,6 +125,8 @@ def test_api_endpoint(endpoint, method="GET", data=None, description=""):
     try:
         if method == "GET":
             response = requests.get(url, headers=headers, timeout=10)
+        elif method == "POST" and isinstance(data, bytes):
+            response = requests.post(url, headers=headers, data=data, timeout=10)
         elif method == "POST":
             response = requests.post(url, headers=headers, json=data, timeout=10)
         elif method == "DELETE":
@@ -90,6 +162,33 @@ def main():
     # Test 2: Send sensor data
     test_api_endpoint("/api/data", "POST", test_sensor_data, description="Send Sensor Data")
     
+    # Test 2b: Send a telemetry batch (expect frames_received: 5)
+    test_api_endpoint("/api/data", "POST", test_batch_data, description="Send Telemetry Batch")
+    
+    # Test 2c: Same batch as MessagePack (expect frames_received: 5)
+    test_api_endpoint("/api/data", "POST", encode_msgpack_batch(test_batch_data),
+                      description="Send Binary Telemetry Batch", content_type="application/msgpack")
+    
+    # Test 2d: Unknown body type (expect 415 listing the accepted types)
+    test_api_endpoint("/api/data", "POST", b"<data/>", description="Send Unsupported Type",
+                      content_type="application/xml")
+    
+    # Test 2e: Queued command returned with the next upload (expect "commands": [STOP])
+    test_api_endpoint("/api/commands", "POST", {"stationId": "ST001", "command": "STOP"},
+                      description="Queue Command")
+    test_api_endpoint("/api/data", "POST", test_sensor_data, description="Send Data (Command Piggyback)")
+    
+    # Test 2f: Spooled backlog (expect frames_received: 5, dated about an hour ago)
+    test_api_endpoint("/api/data", "POST", test_spooled_data, description="Send Spooled Backlog")
+    
+    # Test 2g: gzip-compressed batch, as the station sends large ones (expect frames_received: 5)
+    test_api_endpoint("/api/data", "POST", gzip.compress(json.dumps(test_batch_data).encode()),
+                      description="Send Compressed Telemetry Batch", content_encoding="gzip")
+    
+    # Test 2h: Unknown encoding (expect 415 listing the accepted encodings)
+    test_api_endpoint("/api/data", "POST", json.dumps(test_batch_data).encode(),
+                      description="Send Unsupported Encoding", content_encoding="br")
+    
     # Test 3: Get sensor data
     test_api_endpoint("/api/data", "GET", description="Get Sensor Data")
     
@@ -102,6 +201,32 @@ def main():
     # Test 6: Get commands (should return empty)
     test_api_endpoint("/api/commands", "GET", description="Get Commands")
     
+    # Test 6b: Long-poll for commands (held ~2 s, then returns command: null)
+    test_api_endpoint("/api/commands?wait=2", "GET", description="Long-Poll Commands")
+    
+    # Test 6c: Command push stream (expect a "ready" event)
+    print(f"\n{'='*60}")
+    print("Testing: Command Stream")
+    url = f"{BASE_URL}/api/commands/stream"
+    headers = {
+        "Authorization": f"Bearer {API_KEY}",
+        "Accept": "text/event-stream"
+    }
+    try:
+        with requests.get(url, headers=headers, stream=True, timeout=10) as response:
+            print(f"Status Code: {response.status_code}")
+            print(f"Content-Type: {response.headers.get('Content-Type')}")
+            for line in response.iter_lines(decode_unicode=True):
+                if line.startswith("event:"):
+                    print(f"First event: {line[6:].strip()}")
+                    break
+        if response.status_code == 200:
+            print("✅ SUCCESS")
+        else:
+            print("❌ FAILED")
+    except Exception as e:
+        print(f"❌ ERROR: {e}")
+    
     # Test 7: Test invalid API key
     print(f"\n{'='*60}")
     print("Testing: Invalid API Key")